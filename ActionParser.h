@@ -0,0 +1,214 @@
+#ifndef ACTIONPARSER_H
+#define ACTIONPARSER_H
+
+#include <stdexcept>
+
+#include "Parsing2.h"
+
+namespace basis {
+
+    // Runs a combinator graph as parse() does, but reports what it recognizes to
+    // build actions instead of making a ParseTree. Actions provides
+    //
+    //     Mark mark();                        where the actions stand
+    //     void rollback(const Mark&);         undo everything since a mark
+    //     void token(Production, const Token*);         a leaf: Match, Dispatch, Defer,
+    //                                                   or the node As makes of a span
+    //     void group(Production, const Mark&);          Group and BoundedGroup: what was
+    //                                                   reported since the mark is one node
+    //     bool rename(Production, const Mark&);         As: the first node reported since
+    //                                                   the mark is a prod; false if none
+    //
+    // and sees the nodes in the order parse() would link them, each group's after
+    // its children. A combinator that fails rolls back what it reported, so the
+    // actions only ever keep what the parse keeps. Positions and furthest failures
+    // are those of parse(). ParseFn subclasses of Kind::Custom are not supported.
+    template<typename Actions>
+    class ActionParser {
+    public:
+        ActionParser(const TokenIndex& tokens, Actions& actions, size_t maxDepth)
+            : tokens(tokens), actions(actions), maxDepth(maxDepth) {}
+
+        // Same contract as ParseFn::parse. Fails if combinators would nest deeper
+        // than maxDepth.
+        bool run(const ParseFn* fn, TokenPos* pPos, TokenPos limit,
+                 TokenPos* pFurthest, const ParseFn** ppFurthestParser) {
+            this->pPos = pPos;
+            this->pFurthest = pFurthest;
+            this->ppFurthestParser = ppFurthestParser;
+            depth = 0;
+            exceeded = false;
+            exceededAt = nullptr;
+            return parse(fn, limit);
+        }
+
+        bool depthExceeded() const { return exceeded; }
+        // token at which the limit was hit, or nullptr at end of input
+        const Token* depthExceededAt() const { return exceededAt; }
+
+    private:
+        // Each case mirrors the parse() of its combinator in Parsing2.cpp.
+        bool parse(const ParseFn* fn, TokenPos limit) {
+            if (exceeded) return false;
+            if (depth == maxDepth) {
+                exceeded = true;
+                exceededAt = *pPos == tokens.end() ? nullptr : tokens[*pPos];
+                return false;
+            }
+            ++depth;
+            bool ok = step(fn, fn->parts(), limit);
+            --depth;
+            return ok;
+        }
+
+        bool fail(const ParseFn* fn) {
+            ParseFn::updateFurthest(*pPos, pFurthest, ppFurthestParser, fn);
+            return false;
+        }
+
+        // Back to the position and the actions' state of before an attempt.
+        bool undo(TokenPos saved, const typename Actions::Mark& mark) {
+            *pPos = saved;
+            actions.rollback(mark);
+            return false;
+        }
+
+        bool step(const ParseFn* fn, const ParseFn::Parts& parts, TokenPos limit) {
+            switch (parts.kind) {
+            case ParseFn::Kind::Discard:
+                if (ParseFn::atLimit(tokens, *pPos, limit) || tokens[*pPos]->type != parts.type) return fail(fn);
+                ++(*pPos);
+                return true;
+            case ParseFn::Kind::Match:
+                if (ParseFn::atLimit(tokens, *pPos, limit) || tokens[*pPos]->type != parts.type) return fail(fn);
+                actions.token(parts.prod, tokens[(*pPos)++]);
+                return true;
+            case ParseFn::Kind::Dispatch: {
+                if (ParseFn::atLimit(tokens, *pPos, limit)) return fail(fn);
+                size_t type = static_cast<size_t>(tokens[*pPos]->type);
+                if (!parts.matches[type]) return fail(fn);
+                actions.token(parts.productions[type], tokens[(*pPos)++]);
+                return true;
+            }
+            case ParseFn::Kind::Maybe:
+                parse(parts.children[0].get(), limit);
+                return true;
+            case ParseFn::Kind::Prefix: {
+                if (parts.children.empty()) return true;
+                TokenPos saved = *pPos;
+                auto mark = actions.mark();
+                if (!parse(parts.children[0].get(), limit)) return true;
+                for (size_t i = 1; i < parts.children.size(); ++i) {
+                    if (!parse(parts.children[i].get(), limit)) return undo(saved, mark);
+                }
+                return true;
+            }
+            case ParseFn::Kind::Any: {
+                TokenPos saved = *pPos;
+                for (const SPPF& alt : parts.children) {
+                    if (parse(alt.get(), limit)) return true;
+                    *pPos = saved;
+                }
+                return false;
+            }
+            case ParseFn::Kind::All: {
+                TokenPos saved = *pPos;
+                auto mark = actions.mark();
+                for (const SPPF& child : parts.children) {
+                    if (!parse(child.get(), limit)) return undo(saved, mark);
+                }
+                return true;
+            }
+            case ParseFn::Kind::OneOrMore:
+                if (!parse(parts.children[0].get(), limit)) return false;
+                while (parse(parts.children[0].get(), limit)) {}
+                return true;
+            case ParseFn::Kind::Separated: {
+                const ParseFn* element = parts.children[0].get();
+                const ParseFn* separator = parts.children[1].get();
+                TokenPos start = *pPos;
+                auto first = actions.mark();
+                if (!parse(element, limit)) return false;
+                bool foundSeparator = false;
+                while (true) {
+                    TokenPos saved = *pPos;
+                    auto mark = actions.mark();
+                    if (!parse(separator, limit)) {
+                        undo(saved, mark);
+                        if (parts.optionalSeparator || foundSeparator) return true;
+                        return undo(start, first);
+                    }
+                    foundSeparator = true;
+                    if (!parse(element, limit)) return undo(start, first);
+                }
+            }
+            case ParseFn::Kind::Bound:
+                if (ParseFn::atLimit(tokens, *pPos, limit)) return fail(fn);
+                return parse(parts.children[0].get(), tokens.bound(*pPos));
+            case ParseFn::Kind::Group: {
+                TokenPos saved = *pPos;
+                auto mark = actions.mark();
+                if (!parse(parts.children[0].get(), limit)) return undo(saved, mark);
+                actions.group(parts.prod, mark);
+                return true;
+            }
+            case ParseFn::Kind::BoundedGroup: {
+                if (ParseFn::atLimit(tokens, *pPos, limit)) return fail(fn);
+                TokenPos boundLimit = ParseFn::getBoundLimit(tokens, *pPos, limit);
+                TokenPos saved = *pPos;
+                auto mark = actions.mark();
+                for (const SPPF& child : parts.children) {
+                    if (!parse(child.get(), boundLimit)) return undo(saved, mark);
+                }
+                if ((!parts.strict && boundLimit == tokens.end()) || ParseFn::atLimit(tokens, *pPos, boundLimit)) {
+                    actions.group(parts.prod, mark);
+                    return true;
+                }
+                return undo(saved, mark);
+            }
+            case ParseFn::Kind::Forward:
+                return parse(parts.children[0].get(), limit);
+            case ParseFn::Kind::As: {
+                TokenPos start = *pPos;
+                auto mark = actions.mark();
+                if (!parse(parts.children[0].get(), limit)) return false;
+                if (!actions.rename(parts.prod, mark) && start != *pPos) actions.token(parts.prod, tokens[start]);
+                return true;
+            }
+            case ParseFn::Kind::Recover: {
+                if (ParseFn::atLimit(tokens, *pPos, limit)) return fail(fn);
+                if (parse(parts.children[0].get(), limit)) return true;
+                if (exceeded) return false;
+                actions.token(Production::PARSE_ERROR, tokens[*pPos]);
+                TokenPos resume = tokens.bound(*pPos);
+                do {
+                    ++(*pPos);
+                } while (!ParseFn::atLimit(tokens, *pPos, limit) && *pPos != resume);
+                return true;
+            }
+            case ParseFn::Kind::Defer: {
+                if (ParseFn::atLimit(tokens, *pPos, limit) || tokens[*pPos]->type != parts.type) return fail(fn);
+                actions.token(parts.prod, tokens[*pPos]);
+                *pPos = limit < tokens.end() ? limit : tokens.end();
+                return true;
+            }
+            case ParseFn::Kind::Custom:
+                break;
+            }
+            throw std::logic_error("ActionParser: a custom combinator has no parts to run");
+        }
+
+        const TokenIndex& tokens;
+        Actions& actions;
+        size_t maxDepth;
+        size_t depth = 0;
+        TokenPos* pPos = nullptr;
+        TokenPos* pFurthest = nullptr;
+        const ParseFn** ppFurthestParser = nullptr;
+        bool exceeded = false;
+        const Token* exceededAt = nullptr;
+    };
+
+}
+
+#endif // ACTIONPARSER_H
@@ -1,13 +1,16 @@
 #ifndef AST_H
 #define AST_H
 
-#include <memory>
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <tuple>
 #include <variant>
 #include <vector>
 #include <cstddef>
 
+#include "AstArena.h"
+
 namespace basis {
 
 // ========================================================================
@@ -16,8 +19,15 @@ namespace basis {
 struct TypeNode;
 struct ExprNode;
 
-using TypeNodePtr = std::shared_ptr<TypeNode>;
-using ExprNodePtr = std::shared_ptr<ExprNode>;
+// Nodes live in the arena of the AstContext that built them and point at one
+// another without owning; child lists are AstLists in the same arena.
+using TypeNodePtr = TypeNode*;
+using ExprNodePtr = ExprNode*;
+
+// Dense index of a TypeNode or ExprNode within its unit, one numbering per kind
+// (see AstContext.h and NodeTable.h).
+using NodeId = uint32_t;
+constexpr NodeId noNodeId = ~NodeId(0);
 
 struct Located {
     size_t line = 0;
@@ -33,17 +43,17 @@ struct EnumItem : Located {
 };
 
 struct FieldDecl : Located {
-    TypeNodePtr type;
+    TypeNodePtr type = nullptr;
     std::string name;
 };
 
 struct UnionCandidate : Located {
-    TypeNodePtr domain;
+    TypeNodePtr domain = nullptr;
     std::string name;
 };
 
 struct VariantCandidate : Located {
-    TypeNodePtr type;
+    TypeNodePtr type = nullptr;
     std::string name;
 };
 
@@ -52,78 +62,78 @@ struct InstanceType : Located {
     std::string delegate;   // identifier inside (...), empty if absent
 };
 
-struct CmdParam {
-    TypeNodePtr type;
+struct CmdParam : Located {
+    TypeNodePtr type = nullptr;
     std::string name;
     bool        isTypeVar   = false;
     std::string typeVarName;   // the T in (T : SomeType)
 };
 
-struct CmdReceiver {
-    TypeNodePtr type;
+struct CmdReceiver : Located {
+    TypeNodePtr type = nullptr;
     std::string name;
 };
 
 struct CallParam : Located {
     bool        isEmpty = false;
-    ExprNodePtr expr;   // null when isEmpty
+    ExprNodePtr expr = nullptr;   // null when isEmpty
 };
 
 struct SuffixOp {
     enum class Kind { Deref, Index, Addr };
     Kind        kind = Kind::Deref;
-    ExprNodePtr indexLoc;   // Index: location expression
-    ExprNodePtr indexExt;   // Index: optional extent expression
+    ExprNodePtr indexLoc = nullptr;   // Index: location expression
+    ExprNodePtr indexExt = nullptr;   // Index: optional extent expression
 };
 
 // ========================================================================
 // TypeNode alternatives
 // ========================================================================
-struct NamedType : Located {
+struct NamedType {
     std::string              name;
-    std::vector<TypeNodePtr> typeArgs;
+    AstList<TypeNodePtr>     typeArgs;
     bool                     writeable = false;
 };
 
-struct PtrType : Located {
+struct PtrType {
     int         depth = 1;
-    TypeNodePtr inner;
+    TypeNodePtr inner = nullptr;
 };
 
-struct RangeType : Located {
+struct RangeType {
     std::string size;       // empty = unbounded
-    TypeNodePtr element;    // optional element type
+    TypeNodePtr element = nullptr;   // optional element type
 };
 
 struct CmdTypeArg {
-    TypeNodePtr type;
+    TypeNodePtr type = nullptr;
     bool        writeable = false;
 };
 
-struct CmdType : Located {
+struct CmdType {
     enum class Kind { NoFail, MayFail, Fails };
     Kind                     kind = Kind::NoFail;
-    std::vector<CmdTypeArg>  args;
+    AstList<CmdTypeArg>      args;
 };
 
-struct InlineRecordType : Located {
+struct InlineRecordType {
     std::string              scopeName;   // optional
-    std::vector<FieldDecl>   fields;
+    AstList<FieldDecl>       fields;
 };
 
-struct InlineObjectType : Located {
+struct InlineObjectType {
     std::string              scopeName;
-    std::vector<FieldDecl>   fields;
+    AstList<FieldDecl>       fields;
 };
 
-struct InlineUnionType : Located {
+struct InlineUnionType {
     std::string                  scopeName;
-    std::vector<UnionCandidate>  candidates;
+    AstList<UnionCandidate>      candidates;
 };
 
-struct InlineVariantType : Located {
+struct InlineVariantType {
     std::string                    scopeName;
-    std::vector<VariantCandidate>  candidates;
+    AstList<VariantCandidate>      candidates;
 };
 
 // ---- TypeNode wrapper ----
@@ -131,7 +141,9 @@ struct TypeNode {
     using Variant = std::variant<
         NamedType, PtrType, RangeType, CmdType,
         InlineRecordType, InlineObjectType, InlineUnionType, InlineVariantType>;
-    Variant v;
+    Variant  v;
+    NodeId   id   = noNodeId;
+    uint64_t hash = 0;      // structural; see TypeInterner.h
     template<typename T> TypeNode(T&& alt) : v(std::forward<T>(alt)) {}
 };
 
@@ -145,7 +157,7 @@ struct LiteralExpr : Located {
 // Qualified or unqualified identifier reference. `qualifiers` holds any
 // `Std::Core::` prefix segments in order; `name` is the trailing identifier.
 struct Identifier {
-    std::vector<std::string> qualifiers;
+    AstList<std::string>     qualifiers;
     std::string              name;
 };
 
@@ -160,37 +172,40 @@ struct EnumDerefExpr : Located {
 };
 
 struct CallCommandExpr : Located {
-    ExprNodePtr                target;    // IdentifierExpr or QuoteExpr
-    std::vector<CallParam>     params;
+    ExprNodePtr                target = nullptr;   // IdentifierExpr or QuoteExpr
+    AstList<CallParam>         params;
 };
 
 struct CallConstructorExpr : Located {
-    TypeNodePtr                typeName;
-    std::vector<CallParam>     params;
+    TypeNodePtr                typeName = nullptr;
+    AstList<CallParam>         params;
 };
 
 struct CallVCommandExpr : Located {
-    std::vector<std::string>   receivers;
+    AstList<std::string>       receivers;
     std::string                name;
-    std::vector<CallParam>     params;
+    AstList<CallParam>         params;
 };
 
 struct CallFailExpr : Located {
-    ExprNodePtr expr;
+    ExprNodePtr expr = nullptr;
 };
 
 struct SuffixExpr : Located {
-    ExprNodePtr            base;
-    std::vector<SuffixOp>  suffixes;
+    ExprNodePtr            base = nullptr;
+    AstList<SuffixOp>      suffixes;
 };
 
+// A run of infix operators of one precedence level (see Operators.h), applied
+// left to right: `a + b - c` is first=a, rest=[+b, -c]. Operands bound by
+// tighter operators are nested BinaryExprs, so `a + b * c` has rest=[+(b * c)].
 struct BinaryExpr : Located {
     struct OpTerm {
         std::string op;
-        ExprNodePtr term;
+        ExprNodePtr term = nullptr;
     };
-    ExprNodePtr          first;
-    std::vector<OpTerm>  rest;
+    ExprNodePtr          first = nullptr;
+    AstList<OpTerm>      rest;
 };
 
 // Forward-declare CallGroup so QuoteExpr / CmdLiteralExpr can reference it
@@ -199,15 +214,15 @@ struct CallGroup;
 struct QuoteExpr : Located {
     enum class Kind { Subquote, BlockNoFail, BlockMayFail, BlockFail };
     Kind                         kind = Kind::Subquote;
-    ExprNodePtr                  invoke;   // Subquote: optional invoke
-    std::shared_ptr<CallGroup>   group;    // Block quotes: body group
+    ExprNodePtr                  invoke = nullptr;   // Subquote: optional invoke
+    CallGroup*                   group  = nullptr;   // Block quotes: body group
 };
 
 struct CmdLiteralExpr : Located {
     enum class Kind { NoFail, MayFail, MustFail };
     Kind                         kind = Kind::NoFail;
-    std::vector<CmdParam>        params;
-    std::shared_ptr<CallGroup>   body;
+    AstList<CmdParam>            params;
+    CallGroup*                   body = nullptr;
 };
 
 // ---- ExprNode wrapper ----
@@ -217,6 +232,7 @@ struct ExprNode {
         CallCommandExpr, CallConstructorExpr, CallVCommandExpr, CallFailExpr,
         SuffixExpr, BinaryExpr, QuoteExpr, CmdLiteralExpr>;
     Variant v;
+    NodeId  id = noNodeId;
     template<typename T> ExprNode(T&& alt) : v(std::forward<T>(alt)) {}
 };
 
@@ -224,12 +240,12 @@ struct ExprNode {
 // Statement-level types
 // ========================================================================
 struct AssignStat : Located {
-    ExprNodePtr target;   // IdentifierExpr (possibly alloc)
-    ExprNodePtr value;    // the RHS subcall expression
+    ExprNodePtr target = nullptr;   // IdentifierExpr (possibly alloc)
+    ExprNodePtr value  = nullptr;   // the RHS subcall expression
 };
 
 struct ExprStat : Located {
-    ExprNodePtr expr;     // wraps a BinaryExpr or single-term expression
+    ExprNodePtr expr = nullptr;   // wraps a BinaryExpr or single-term expression
 };
 
 struct Block : Located {
@@ -241,10 +257,10 @@ struct Block : Located {
     };
     Kind                         kind = Kind::DoBlock;
     // DoRecoverSpec fields
-    TypeNodePtr                  recoverType;   // optional TYPE_NAME_Q
+    TypeNodePtr                  recoverType = nullptr;   // optional TYPE_NAME_Q
     std::string                  recoverIdent;  // bound identifier
-    ExprNodePtr                  recoverExpr;   // or CALL_EXPR_TERM fallback
-    std::shared_ptr<CallGroup>   body;
+    ExprNodePtr                  recoverExpr = nullptr;   // or CALL_EXPR_TERM fallback
+    CallGroup*                   body = nullptr;
 };
 
 // StatNode: one element of a CallGroup
@@ -256,18 +272,19 @@ struct StatNode {
 
 // CALL_GROUP: sequence of statements
 struct CallGroup : Located {
-    std::vector<StatNode> statements;
+    AstList<StatNode>     statements;
 };
 
-// Forward declaration so CmdBody can hold a vector<CmdDef> for nested .sub
-// definitions. CmdDef (defined further down) holds a shared_ptr<CmdBody>.
+// Forward declaration so CmdBody can hold a list of CmdDef for nested .sub
+// definitions. CmdDef (defined further down) points at its CmdBody.
 struct CmdDef;
 
 // DEF_CMD_BODY: `= maybe(.sub ...) (_ | call-group)`
 struct CmdBody : Located {
-    std::vector<CmdDef>        subs;     // subs that follow `=` and precede the call group
+    AstList<CmdDef>            subs;     // subs that follow `=` and precede the call group
     bool                       isEmpty = false;
-    std::shared_ptr<CallGroup> group;   // null when isEmpty
+    CallGroup*                 group = nullptr;   // null when isEmpty
+    uint64_t                   hash = 0;          // structural, set by hashDefinitions (AstHash.h)
 };
 
 // ========================================================================
@@ -278,23 +295,23 @@ enum class FailMode { NoFail, MayFail, Fails };
 struct RegularSig {
     std::string            name;
     FailMode               failMode = FailMode::NoFail;
-    std::vector<CmdParam>  params;
-    std::vector<CmdParam>  implicitParams;
+    AstList<CmdParam>      params;
+    AstList<CmdParam>      implicitParams;
     std::string            returnVal;
 };
 
 struct VCommandSig {
-    std::vector<CmdReceiver> receivers;
+    AstList<CmdReceiver>     receivers;
     std::string              name;
     FailMode                 failMode = FailMode::NoFail;
-    std::vector<CmdParam>    params;
-    std::vector<CmdParam>    implicitParams;
+    AstList<CmdParam>        params;
+    AstList<CmdParam>        implicitParams;
     std::string              returnVal;
 };
 
 struct ConstructorSig {
     CmdReceiver            receiver;
-    std::vector<CmdParam>  params;
+    AstList<CmdParam>      params;
 };
 
 struct DestructorSig {
@@ -325,43 +342,43 @@ struct ImportDecl : Located {
 
 struct AliasDecl : Located {
     std::string name;
-    TypeNodePtr type;
+    TypeNodePtr type = nullptr;
 };
 
 struct DomainDecl : Located {
     std::string name;
-    TypeNodePtr parent;
+    TypeNodePtr parent = nullptr;
 };
 
 struct EnumDecl : Located {
     std::string            enumTypeName;   // optional constraining typename
     std::string            enumName;
-    std::vector<EnumItem>  items;
+    AstList<EnumItem>      items;
 };
 
 struct RecordDecl : Located {
     std::string            name;
-    std::vector<FieldDecl> fields;
+    AstList<FieldDecl>     fields;
 };
 
 struct ObjectDecl : Located {
     std::string            name;
-    std::vector<FieldDecl> fields;
+    AstList<FieldDecl>     fields;
 };
 
 struct UnionDecl : Located {
     std::string                  name;
-    std::vector<UnionCandidate>  candidates;
+    AstList<UnionCandidate>      candidates;
 };
 
 struct VariantDecl : Located {
     std::string                    name;
-    std::vector<VariantCandidate>  candidates;
+    AstList<VariantCandidate>      candidates;
 };
 
 struct InstanceDecl : Located {
     std::string                  name;
-    std::vector<InstanceType>    types;
+    AstList<InstanceType>        types;
 };
 
 struct CmdDecl : Located {
@@ -374,7 +391,7 @@ struct IntrinsicDecl : Located {
 
 struct CmdDef : Located {
     CmdSignature              signature;
-    std::shared_ptr<CmdBody>  body;     // body holds any nested subs (in CmdBody::subs)
+    CmdBody*                  body = nullptr;   // body holds any nested subs (in CmdBody::subs)
 };
 
 // ClassMember variant
@@ -382,16 +399,16 @@ using ClassMember = std::variant<CmdDecl, CmdDef>;
 
 struct ClassDecl : Located {
     std::string                name;
-    std::vector<ClassMember>   members;
+    AstList<ClassMember>       members;
 };
 
 struct ProgramDecl : Located {
-    ExprNodePtr entryPoint;   // a call invoke expression
+    ExprNodePtr entryPoint = nullptr;   // a call invoke expression
 };
 
 struct TestDecl : Located {
     std::string                label;
-    std::shared_ptr<CallGroup> body;
+    CallGroup*                 body = nullptr;
 };
 
 // TopLevelDef variant
@@ -404,121 +421,26 @@ using TopLevelDef = std::variant<
 // ========================================================================
 // Compilation unit (root)
 // ========================================================================
+struct AstContext;   // AstContext.h
+
 struct CompilationUnit : Located {
-    std::shared_ptr<ModuleDecl>              module;
-    std::vector<std::shared_ptr<ImportDecl>> imports;
-    std::vector<TopLevelDef>                 definitions;
+    AstContext*             context = nullptr;    // owns this unit and every node below it
+    ModuleDecl*             module  = nullptr;
+    AstList<ImportDecl*>    imports;
+    AstList<TopLevelDef>    definitions;
+    AstList<uint64_t>       definitionHashes;     // one per definition once hashDefinitions has run
 };
 
 // ========================================================================
-// Traverser base class
+// StaticTraverser: the walk, with hooks resolved at compile time
 // ========================================================================
-struct Traverser {
-    virtual ~Traverser() = default;
-
-    // ---- virtual visit hooks (override in subclasses) ----
-    virtual void visit(CompilationUnit&) {}
-    virtual void visit(ModuleDecl&)      {}
-    virtual void visit(ImportDecl&)      {}
-    // type nodes
-    virtual void visit(NamedType&)         {}
-    virtual void visit(PtrType&)           {}
-    virtual void visit(RangeType&)         {}
-    virtual void visit(CmdType&)           {}
-    virtual void visit(InlineRecordType&)  {}
-    virtual void visit(InlineObjectType&)  {}
-    virtual void visit(InlineUnionType&)   {}
-    virtual void visit(InlineVariantType&) {}
-    // expression nodes
-    virtual void visit(LiteralExpr&)         {}
-    virtual void visit(IdentifierExpr&)      {}
-    virtual void visit(EnumDerefExpr&)       {}
-    virtual void visit(CallCommandExpr&)     {}
-    virtual void visit(CallConstructorExpr&) {}
-    virtual void visit(CallVCommandExpr&)    {}
-    virtual void visit(CallFailExpr&)        {}
-    virtual void visit(SuffixExpr&)          {}
-    virtual void visit(BinaryExpr&)          {}
-    virtual void visit(QuoteExpr&)           {}
-    virtual void visit(CmdLiteralExpr&)      {}
-    // statement nodes
-    virtual void visit(AssignStat&)  {}
-    virtual void visit(ExprStat&)    {}
-    virtual void visit(Block&)       {}
-    // structure nodes
-    virtual void visit(CallGroup&)   {}
-    virtual void visit(CmdBody&)     {}
-    // declaration nodes
-    virtual void visit(AliasDecl&)     {}
-    virtual void visit(DomainDecl&)    {}
-    virtual void visit(EnumDecl&)      {}
-    virtual void visit(RecordDecl&)    {}
-    virtual void visit(ObjectDecl&)    {}
-    virtual void visit(UnionDecl&)     {}
-    virtual void visit(VariantDecl&)   {}
-    virtual void visit(InstanceDecl&)  {}
-    virtual void visit(CmdDecl&)       {}
-    virtual void visit(IntrinsicDecl&) {}
-    virtual void visit(CmdDef&)        {}
-    virtual void visit(ClassDecl&)     {}
-    virtual void visit(ProgramDecl&)   {}
-    virtual void visit(TestDecl&)      {}
-    // signature nodes
-    virtual void visit(RegularSig&)     {}
-    virtual void visit(VCommandSig&)    {}
-    virtual void visit(ConstructorSig&) {}
-    virtual void visit(DestructorSig&)  {}
-    virtual void visit(FailHandlerSig&) {}
-
-    // ---- virtual revisit hooks: called after child traversal (override in subclasses) ----
-    virtual void revisit(CompilationUnit&) {}
-    // type nodes
-    virtual void revisit(NamedType&)         {}
-    virtual void revisit(PtrType&)           {}
-    virtual void revisit(RangeType&)         {}
-    virtual void revisit(CmdType&)           {}
-    virtual void revisit(InlineRecordType&)  {}
-    virtual void revisit(InlineObjectType&)  {}
-    virtual void revisit(InlineUnionType&)   {}
-    virtual void revisit(InlineVariantType&) {}
-    // expression nodes
-    virtual void revisit(CallCommandExpr&)     {}
-    virtual void revisit(CallConstructorExpr&) {}
-    virtual void revisit(CallVCommandExpr&)    {}
-    virtual void revisit(CallFailExpr&)        {}
-    virtual void revisit(SuffixExpr&)          {}
-    virtual void revisit(BinaryExpr&)          {}
-    virtual void revisit(QuoteExpr&)           {}
-    virtual void revisit(CmdLiteralExpr&)      {}
-    // statement nodes
-    virtual void revisit(AssignStat&)  {}
-    virtual void revisit(ExprStat&)    {}
-    virtual void revisit(Block&)       {}
-    // structure nodes
-    virtual void revisit(CallGroup&)   {}
-    virtual void revisit(CmdBody&)     {}
-    // declaration nodes
-    virtual void revisit(AliasDecl&)     {}
-    virtual void revisit(DomainDecl&)    {}
-    virtual void revisit(RecordDecl&)    {}
-    virtual void revisit(ObjectDecl&)    {}
-    virtual void revisit(UnionDecl&)     {}
-    virtual void revisit(VariantDecl&)   {}
-    virtual void revisit(CmdDecl&)       {}
-    virtual void revisit(IntrinsicDecl&) {}
-    virtual void revisit(CmdDef&)        {}
-    virtual void revisit(ClassDecl&)     {}
-    virtual void revisit(ProgramDecl&)   {}
-    virtual void revisit(TestDecl&)      {}
-    // signature nodes
-    virtual void revisit(RegularSig&)     {}
-    virtual void revisit(VCommandSig&)    {}
-    virtual void revisit(ConstructorSig&) {}
-    virtual void revisit(DestructorSig&)  {}
-    virtual void revisit(FailHandlerSig&) {}
-
-
-    // ---- non-virtual traverse: encode child walking ----
+// Derived defines visit(Node&) for the nodes it wants to see before their
+// children and revisit(Node&) for those it wants to see after; the walk calls a
+// hook only where Derived has one that accepts the node, so a pass pays nothing
+// for the nodes it ignores. Hooks must be public and must not be templates that
+// accept every node unless that is what is meant.
+template<typename Derived>
+struct StaticTraverser {
     // variant dispatchers
     void traverse(TypeNode& n)    { std::visit([this](auto& a){ traverse(a); }, n.v); }
     void traverse(ExprNode& n)    { std::visit([this](auto& a){ traverse(a); }, n.v); }
@@ -533,237 +455,382 @@ struct Traverser {
 
     // ---- per-type traverse methods ----
     void traverse(CompilationUnit& n) {
-        visit(n);
+        enter(n);
         if (n.module) traverse(*n.module);
         for (auto& i : n.imports) if (i) traverse(*i);
         for (auto& d : n.definitions) traverse(d);
-        revisit(n);
+        leave(n);
     }
-    void traverse(ModuleDecl& n)  { visit(n); }
-    void traverse(ImportDecl& n)  { visit(n); }
+    void traverse(ModuleDecl& n)  { enter(n); }
+    void traverse(ImportDecl& n)  { enter(n); }
 
     // type nodes
     void traverse(NamedType& n) {
-        visit(n);
+        enter(n);
         for (auto& a : n.typeArgs) traverse(a);
-        revisit(n);
+        leave(n);
     }
     void traverse(PtrType& n) {
-        visit(n);
+        enter(n);
         traverse(n.inner);
-        revisit(n);
+        leave(n);
     }
     void traverse(RangeType& n) {
-        visit(n);
+        enter(n);
         traverse(n.element);
-        revisit(n);
+        leave(n);
     }
     void traverse(CmdType& n) {
-        visit(n);
+        enter(n);
         for (auto& a : n.args) traverse(a.type);
-        revisit(n);
+        leave(n);
     }
     void traverse(InlineRecordType& n) {
-        visit(n);
+        enter(n);
         for (auto& f : n.fields) traverse(f.type);
-        revisit(n);
+        leave(n);
     }
     void traverse(InlineObjectType& n) {
-        visit(n);
+        enter(n);
         for (auto& f : n.fields) traverse(f.type);
-        revisit(n);
+        leave(n);
     }
     void traverse(InlineUnionType& n) {
-        visit(n);
+        enter(n);
         for (auto& c : n.candidates) traverse(c.domain);
-        revisit(n);
+        leave(n);
     }
     void traverse(InlineVariantType& n) {
-        visit(n);
+        enter(n);
         for (auto& c : n.candidates) traverse(c.type);
-        revisit(n);
+        leave(n);
     }
 
     // expression nodes
-    void traverse(LiteralExpr& n)    { visit(n); }
-    void traverse(IdentifierExpr& n) { visit(n); }
-    void traverse(EnumDerefExpr& n)  { visit(n); }
+    void traverse(LiteralExpr& n)    { enter(n); }
+    void traverse(IdentifierExpr& n) { enter(n); }
+    void traverse(EnumDerefExpr& n)  { enter(n); }
     void traverse(CallCommandExpr& n) {
-        visit(n);
+        enter(n);
         traverse(n.target);
         for (auto& p : n.params) traverse(p.expr);
-        revisit(n);
+        leave(n);
     }
     void traverse(CallConstructorExpr& n) {
-        visit(n);
+        enter(n);
         traverse(n.typeName);
         for (auto& p : n.params) traverse(p.expr);
-        revisit(n);
+        leave(n);
     }
     void traverse(CallVCommandExpr& n) {
-        visit(n);
+        enter(n);
         for (auto& p : n.params) traverse(p.expr);
-        revisit(n);
+        leave(n);
     }
     void traverse(CallFailExpr& n) {
-        visit(n);
+        enter(n);
         traverse(n.expr);
-        revisit(n);
+        leave(n);
     }
     void traverse(SuffixExpr& n) {
-        visit(n);
+        enter(n);
         traverse(n.base);
         for (auto& s : n.suffixes) {
             traverse(s.indexLoc);
             traverse(s.indexExt);
         }
-        revisit(n);
+        leave(n);
     }
     void traverse(BinaryExpr& n) {
-        visit(n);
+        enter(n);
         traverse(n.first);
         for (auto& ot : n.rest) traverse(ot.term);
-        revisit(n);
+        leave(n);
     }
     void traverse(QuoteExpr& n) {
-        visit(n);
+        enter(n);
         traverse(n.invoke);
         if (n.group) traverse(*n.group);
-        revisit(n);
+        leave(n);
     }
     void traverse(CmdLiteralExpr& n) {
-        visit(n);
+        enter(n);
         for (auto& p : n.params) traverse(p.type);
         if (n.body) traverse(*n.body);
-        revisit(n);
+        leave(n);
     }
 
     // statement nodes
     void traverse(AssignStat& n) {
-        visit(n);
+        enter(n);
         traverse(n.target);
         traverse(n.value);
-        revisit(n);
+        leave(n);
     }
     void traverse(ExprStat& n) {
-        visit(n);
+        enter(n);
         traverse(n.expr);
-        revisit(n);
+        leave(n);
     }
     void traverse(Block& n) {
-        visit(n);
+        enter(n);
         traverse(n.recoverType);
         traverse(n.recoverExpr);
         if (n.body) traverse(*n.body);
-        revisit(n);
+        leave(n);
     }
     void traverse(CallGroup& n) {
-        visit(n);
+        enter(n);
         for (auto& s : n.statements) traverse(s);
-        revisit(n);
+        leave(n);
     }
     void traverse(CmdBody& n) {
-        visit(n);
+        enter(n);
         for (auto& sub : n.subs) traverse(sub);
         if (n.group) traverse(*n.group);
-        revisit(n);
+        leave(n);
     }
 
     // declaration nodes
     void traverse(AliasDecl& n) {
-        visit(n);
+        enter(n);
         traverse(n.type);
-        revisit(n);
+        leave(n);
     }
     void traverse(DomainDecl& n) {
-        visit(n);
+        enter(n);
         traverse(n.parent);
-        revisit(n);
+        leave(n);
     }
-    void traverse(EnumDecl& n) { visit(n); }
+    void traverse(EnumDecl& n) { enter(n); }
     void traverse(RecordDecl& n) {
-        visit(n);
+        enter(n);
         for (auto& f : n.fields) traverse(f.type);
-        revisit(n);
+        leave(n);
     }
     void traverse(ObjectDecl& n) {
-        visit(n);
+        enter(n);
         for (auto& f : n.fields) traverse(f.type);
-        revisit(n);
+        leave(n);
     }
     void traverse(UnionDecl& n) {
-        visit(n);
+        enter(n);
         for (auto& c : n.candidates) traverse(c.domain);
-        revisit(n);
+        leave(n);
     }
     void traverse(VariantDecl& n) {
-        visit(n);
+        enter(n);
         for (auto& c : n.candidates) traverse(c.type);
-        revisit(n);
+        leave(n);
     }
-    void traverse(InstanceDecl& n) { visit(n); }
+    void traverse(InstanceDecl& n) { enter(n); }
     void traverse(CmdDecl& n) {
-        visit(n);
+        enter(n);
         traverse(n.signature);
-        revisit(n);
+        leave(n);
     }
     void traverse(IntrinsicDecl& n) {
-        visit(n);
+        enter(n);
         traverse(n.signature);
-        revisit(n);
+        leave(n);
     }
     void traverse(CmdDef& n) {
-        visit(n);
+        enter(n);
         traverse(n.signature);
         if (n.body) traverse(*n.body);
-        revisit(n);
+        leave(n);
     }
     void traverse(ClassDecl& n) {
-        visit(n);
+        enter(n);
         for (auto& m : n.members) traverse(m);
-        revisit(n);
+        leave(n);
     }
     void traverse(ProgramDecl& n) {
-        visit(n);
+        enter(n);
         traverse(n.entryPoint);
-        revisit(n);
+        leave(n);
     }
     void traverse(TestDecl& n) {
-        visit(n);
+        enter(n);
         if (n.body) traverse(*n.body);
-        revisit(n);
+        leave(n);
     }
 
     // signature nodes
     void traverse(RegularSig& n) {
-        visit(n);
+        enter(n);
         for (auto& p : n.params) traverse(p.type);
         for (auto& p : n.implicitParams) traverse(p.type);
-        revisit(n);
+        leave(n);
     }
     void traverse(VCommandSig& n) {
-        visit(n);
+        enter(n);
         for (auto& r : n.receivers) traverse(r.type);
         for (auto& p : n.params) traverse(p.type);
         for (auto& p : n.implicitParams) traverse(p.type);
-        revisit(n);
+        leave(n);
     }
     void traverse(ConstructorSig& n) {
-        visit(n);
+        enter(n);
         traverse(n.receiver.type);
         for (auto& p : n.params) traverse(p.type);
-        revisit(n);
+        leave(n);
     }
     void traverse(DestructorSig& n) {
-        visit(n);
+        enter(n);
         traverse(n.receiver.type);
-        revisit(n);
+        leave(n);
     }
     void traverse(FailHandlerSig& n) {
-        visit(n);
+        enter(n);
         traverse(n.receiver.type);
-        revisit(n);
+        leave(n);
+    }
+
+private:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+    template<typename N> void enter(N& n) {
+        if constexpr (requires { derived().visit(n); }) derived().visit(n);
     }
+    template<typename N> void leave(N& n) {
+        if constexpr (requires { derived().revisit(n); }) derived().revisit(n);
+    }
+};
+
+// ========================================================================
+// FusedTraverser: several passes in one walk
+// ========================================================================
+// Walks once and, at each node, calls the hooks of every pass in the order the
+// passes were given, so each pass sees exactly the calls a walk of its own would
+// make. The passes are any types with visit/revisit hooks as StaticTraverser
+// takes them; they are held by reference.
+template<typename... Passes>
+struct FusedTraverser : StaticTraverser<FusedTraverser<Passes...>> {
+    explicit FusedTraverser(Passes&... passes) : passes(passes...) {}
+
+    template<typename N> void visit(N& n) {
+        std::apply([&n](auto&... pass) {
+            ([&] { if constexpr (requires { pass.visit(n); }) pass.visit(n); }(), ...);
+        }, passes);
+    }
+    template<typename N> void revisit(N& n) {
+        std::apply([&n](auto&... pass) {
+            ([&] { if constexpr (requires { pass.revisit(n); }) pass.revisit(n); }(), ...);
+        }, passes);
+    }
+
+private:
+    std::tuple<Passes&...> passes;
+};
+
+// ========================================================================
+// Traverser base class
+// ========================================================================
+// The walk of StaticTraverser with virtual hooks, for passes that would rather
+// override than be templates.
+struct Traverser : StaticTraverser<Traverser> {
+    virtual ~Traverser() = default;
+
+    // ---- virtual visit hooks (override in subclasses) ----
+    virtual void visit(CompilationUnit&) {}
+    virtual void visit(ModuleDecl&)      {}
+    virtual void visit(ImportDecl&)      {}
+    // type nodes
+    virtual void visit(NamedType&)         {}
+    virtual void visit(PtrType&)           {}
+    virtual void visit(RangeType&)         {}
+    virtual void visit(CmdType&)           {}
+    virtual void visit(InlineRecordType&)  {}
+    virtual void visit(InlineObjectType&)  {}
+    virtual void visit(InlineUnionType&)   {}
+    virtual void visit(InlineVariantType&) {}
+    // expression nodes
+    virtual void visit(LiteralExpr&)         {}
+    virtual void visit(IdentifierExpr&)      {}
+    virtual void visit(EnumDerefExpr&)       {}
+    virtual void visit(CallCommandExpr&)     {}
+    virtual void visit(CallConstructorExpr&) {}
+    virtual void visit(CallVCommandExpr&)    {}
+    virtual void visit(CallFailExpr&)        {}
+    virtual void visit(SuffixExpr&)          {}
+    virtual void visit(BinaryExpr&)          {}
+    virtual void visit(QuoteExpr&)           {}
+    virtual void visit(CmdLiteralExpr&)      {}
+    // statement nodes
+    virtual void visit(AssignStat&)  {}
+    virtual void visit(ExprStat&)    {}
+    virtual void visit(Block&)       {}
+    // structure nodes
+    virtual void visit(CallGroup&)   {}
+    virtual void visit(CmdBody&)     {}
+    // declaration nodes
+    virtual void visit(AliasDecl&)     {}
+    virtual void visit(DomainDecl&)    {}
+    virtual void visit(EnumDecl&)      {}
+    virtual void visit(RecordDecl&)    {}
+    virtual void visit(ObjectDecl&)    {}
+    virtual void visit(UnionDecl&)     {}
+    virtual void visit(VariantDecl&)   {}
+    virtual void visit(InstanceDecl&)  {}
+    virtual void visit(CmdDecl&)       {}
+    virtual void visit(IntrinsicDecl&) {}
+    virtual void visit(CmdDef&)        {}
+    virtual void visit(ClassDecl&)     {}
+    virtual void visit(ProgramDecl&)   {}
+    virtual void visit(TestDecl&)      {}
+    // signature nodes
+    virtual void visit(RegularSig&)     {}
+    virtual void visit(VCommandSig&)    {}
+    virtual void visit(ConstructorSig&) {}
+    virtual void visit(DestructorSig&)  {}
+    virtual void visit(FailHandlerSig&) {}
+
+    // ---- virtual revisit hooks: called after child traversal (override in subclasses) ----
+    virtual void revisit(CompilationUnit&) {}
+    // type nodes
+    virtual void revisit(NamedType&)         {}
+    virtual void revisit(PtrType&)           {}
+    virtual void revisit(RangeType&)         {}
+    virtual void revisit(CmdType&)           {}
+    virtual void revisit(InlineRecordType&)  {}
+    virtual void revisit(InlineObjectType&)  {}
+    virtual void revisit(InlineUnionType&)   {}
+    virtual void revisit(InlineVariantType&) {}
+    // expression nodes
+    virtual void revisit(CallCommandExpr&)     {}
+    virtual void revisit(CallConstructorExpr&) {}
+    virtual void revisit(CallVCommandExpr&)    {}
+    virtual void revisit(CallFailExpr&)        {}
+    virtual void revisit(SuffixExpr&)          {}
+    virtual void revisit(BinaryExpr&)          {}
+    virtual void revisit(QuoteExpr&)           {}
+    virtual void revisit(CmdLiteralExpr&)      {}
+    // statement nodes
+    virtual void revisit(AssignStat&)  {}
+    virtual void revisit(ExprStat&)    {}
+    virtual void revisit(Block&)       {}
+    // structure nodes
+    virtual void revisit(CallGroup&)   {}
+    virtual void revisit(CmdBody&)     {}
+    // declaration nodes
+    virtual void revisit(AliasDecl&)     {}
+    virtual void revisit(DomainDecl&)    {}
+    virtual void revisit(RecordDecl&)    {}
+    virtual void revisit(ObjectDecl&)    {}
+    virtual void revisit(UnionDecl&)     {}
+    virtual void revisit(VariantDecl&)   {}
+    virtual void revisit(CmdDecl&)       {}
+    virtual void revisit(IntrinsicDecl&) {}
+    virtual void revisit(CmdDef&)        {}
+    virtual void revisit(ClassDecl&)     {}
+    virtual void revisit(ProgramDecl&)   {}
+    virtual void revisit(TestDecl&)      {}
+    // signature nodes
+    virtual void revisit(RegularSig&)     {}
+    virtual void revisit(VCommandSig&)    {}
+    virtual void revisit(ConstructorSig&) {}
+    virtual void revisit(DestructorSig&)  {}
+    virtual void revisit(FailHandlerSig&) {}
 };
 
 } // namespace basis
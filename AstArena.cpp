@@ -0,0 +1,58 @@
+#include "AstArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace basis;
+
+namespace {
+    thread_local AstArena* currentArena = nullptr;
+
+    constexpr size_t maxBlockSize = 1 << 20;
+}
+
+AstArena::~AstArena() {
+    for (Teardown* t = teardown; t; t = t->next) t->destroy(t->object);
+}
+
+void* AstArena::allocate(size_t bytes, size_t alignment) {
+    auto fits = [&] {
+        if (!cursor) return false;
+        auto address = reinterpret_cast<uintptr_t>(cursor);
+        size_t padding = (alignment - address % alignment) % alignment;
+        if (static_cast<size_t>(limit - cursor) < padding + bytes) return false;
+        cursor += padding;
+        allocated += padding;
+        return true;
+    };
+    if (!fits()) {
+        // an allocation larger than a block gets one of its own
+        size_t size = std::max(nextBlockSize, bytes + alignment);
+        blocks.emplace_back(new std::byte[size]);
+        cursor = blocks.back().get();
+        limit = cursor + size;
+        reserved += size;
+        nextBlockSize = std::min(nextBlockSize * 2, maxBlockSize);
+        fits();
+    }
+    void* p = cursor;
+    cursor += bytes;
+    allocated += bytes;
+    return p;
+}
+
+void AstArena::atTeardown(void* object, void (*destroy)(void*)) {
+    teardown = make<Teardown>(Teardown{destroy, object, teardown});
+}
+
+AstArena* AstArena::current() {
+    return currentArena;
+}
+
+AstArena::Scope::Scope(AstArena& arena) : previous(currentArena) {
+    currentArena = &arena;
+}
+
+AstArena::Scope::~Scope() {
+    currentArena = previous;
+}
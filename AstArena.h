@@ -0,0 +1,106 @@
+#ifndef ASTARENA_H
+#define ASTARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace basis {
+
+// Bump allocator for AST nodes. Memory is handed out from a chain of blocks and
+// released all at once when the arena goes; nothing is freed piecemeal. Objects
+// made with make() that are not trivially destructible have their destructors run
+// at that point, newest first.
+class AstArena {
+public:
+    AstArena() = default;
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+    ~AstArena();
+
+    void* allocate(size_t bytes, size_t alignment);
+
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            atTeardown(object, [](void* p) { static_cast<T*>(p)->~T(); });
+        return object;
+    }
+
+    size_t bytesAllocated() const { return allocated; }   // handed out, including padding
+    size_t bytesReserved() const { return reserved; }     // held in blocks
+
+    // The arena that ArenaAllocators constructed on this thread draw from, while
+    // a Scope is alive; null otherwise, and they fall back to the heap.
+    static AstArena* current();
+
+    class Scope {
+    public:
+        explicit Scope(AstArena& arena);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        AstArena* previous;
+    };
+
+private:
+    struct Teardown {
+        void (*destroy)(void*);
+        void* object;
+        Teardown* next;
+    };
+
+    void atTeardown(void* object, void (*destroy)(void*));
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks;
+    std::byte* cursor = nullptr;
+    std::byte* limit = nullptr;
+    size_t nextBlockSize = 4096;
+    size_t allocated = 0;
+    size_t reserved = 0;
+    Teardown* teardown = nullptr;
+};
+
+// Standard allocator over an AstArena, so that containers inside AST nodes keep
+// their elements in the arena too. A default-constructed allocator binds to
+// AstArena::current(); deallocation is a no-op unless it fell back to the heap.
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() noexcept : arena(AstArena::current()) {}
+    explicit ArenaAllocator(AstArena* arena) noexcept : arena(arena) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        if (arena) return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        if (!arena) std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena == other.arena; }
+
+private:
+    template<typename U> friend class ArenaAllocator;
+    AstArena* arena;
+};
+
+// Child lists of AST nodes.
+template<typename T>
+using AstList = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace basis
+
+#endif // ASTARENA_H
@@ -0,0 +1,316 @@
+#include "AstBinary.h"
+#include "AstFields.h"
+#include "MappedFile.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+
+using namespace basis;
+
+namespace {
+
+    constexpr unsigned char magic[4] = {'B', 'A', 'S', 'T'};
+    enum Section : uint32_t { Strings, Types, Exprs, Unit, SectionCount };
+    constexpr size_t headerBytes = 16 + 8 * SectionCount;
+    // inline structures (call groups, command bodies) nested deeper than this are
+    // taken for a corrupt image rather than recursed into
+    constexpr unsigned maxNesting = 4096;
+
+    uint32_t le32(const unsigned char* p) {
+        return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+    }
+    void putLe32(std::vector<unsigned char>& out, uint32_t w) {
+        for (int i = 0; i < 4; ++i) out.push_back(static_cast<unsigned char>(w >> (8 * i)));
+    }
+
+    template<typename T>
+    concept Scalar = std::is_integral_v<T> || std::is_enum_v<T>;
+
+    class Writer {
+    public:
+        explicit Writer(const AstContext& context) : context(context) {}
+
+        // A section of the records of one kind of node, in NodeId order.
+        template<typename Node>
+        std::vector<uint32_t> nodes(const std::vector<Node*>& all) {
+            std::vector<uint32_t> records;
+            std::vector<uint32_t> offsets;
+            out = &records;
+            for (Node* node : all) {
+                offsets.push_back(static_cast<uint32_t>(records.size()));
+                limit<Node>() = node->id;
+                (*this)(node->v);
+            }
+            std::vector<uint32_t> section{static_cast<uint32_t>(all.size())};
+            for (uint32_t offset : offsets) section.push_back(offset + 1 + static_cast<uint32_t>(all.size()));
+            section.insert(section.end(), records.begin(), records.end());
+            return section;
+        }
+
+        std::vector<uint32_t> unit(CompilationUnit& cu) {
+            std::vector<uint32_t> words;
+            out = &words;
+            typeLimit = static_cast<NodeId>(context.typeNodes.size());
+            exprLimit = static_cast<NodeId>(context.exprNodes.size());
+            visitFields(*this, cu);
+            return words;
+        }
+
+        std::string strings;
+
+        template<Scalar T> void operator()(T& v) { word(static_cast<uint32_t>(v)); }
+        void operator()(std::string& s) {
+            if (s.empty()) { word(0); word(0); return; }
+            auto [it, added] = offsets.try_emplace(s, static_cast<uint32_t>(strings.size()));
+            if (added) strings += s;
+            word(it->second);
+            word(static_cast<uint32_t>(s.size()));
+        }
+        void operator()(std::optional<std::string>& s) {
+            word(s.has_value());
+            if (s) (*this)(*s);
+        }
+        void operator()(TypeNode*& p) { word(reference(p, context.typeNodes, typeLimit)); }
+        void operator()(ExprNode*& p) { word(reference(p, context.exprNodes, exprLimit)); }
+        template<typename T> void operator()(T*& p) {
+            word(p != nullptr);
+            if (p) visitFields(*this, *p);
+        }
+        template<typename T> void operator()(AstList<T>& list) {
+            word(static_cast<uint32_t>(list.size()));
+            for (auto& element : list) (*this)(element);
+        }
+        template<typename... Ts> void operator()(std::variant<Ts...>& v) {
+            word(static_cast<uint32_t>(v.index()));
+            std::visit([&](auto& alt) { visitFields(*this, alt); }, v);
+        }
+        template<typename T> requires std::is_class_v<T> void operator()(T& n) { visitFields(*this, n); }
+
+    private:
+        void word(uint32_t w) { out->push_back(w); }
+
+        // Records only refer back, so that reading them in order finds every
+        // reference made already; the builder makes children before parents.
+        template<typename Node>
+        uint32_t reference(Node* p, const std::vector<Node*>& all, NodeId limit) {
+            if (!p) return 0;
+            if (p->id >= all.size() || all[p->id] != p)
+                throw std::logic_error("AstBinary: node is not in the unit's context");
+            if (p->id >= limit)
+                throw std::logic_error("AstBinary: node refers to a later node");
+            return p->id + 1;
+        }
+
+        template<typename Node> NodeId& limit() {
+            if constexpr (std::is_same_v<Node, TypeNode>) { exprLimit = 0; return typeLimit; }
+            else { typeLimit = static_cast<NodeId>(context.typeNodes.size()); return exprLimit; }
+        }
+
+        const AstContext& context;
+        std::vector<uint32_t>* out = nullptr;
+        std::unordered_map<std::string, uint32_t> offsets;
+        NodeId typeLimit = 0;
+        NodeId exprLimit = 0;
+    };
+
+    class Reader {
+    public:
+        Reader(AstContext& context, const unsigned char* strings, size_t stringBytes)
+            : context(context), strings(strings), stringBytes(stringBytes) {}
+
+        void section(const unsigned char* data, size_t bytes) {
+            words = data;
+            pos = 0;
+            end = bytes / 4;
+        }
+        bool ok() const { return good; }
+        bool consumed() const { return pos == end; }
+
+        // Read the records of a node section, making each node as it is read.
+        template<typename Node>
+        bool nodes(std::vector<Node*>& made, Node* (AstContext::*make)(typename Node::Variant&&)) {
+            uint32_t count = word();
+            if (count > end - pos) return false;
+            size_t offsets = pos;
+            pos += count;
+            for (uint32_t i = 0; i < count && good; ++i) {
+                if (le32(words + 4 * (offsets + i)) != pos) return false;
+                typeLimit = static_cast<uint32_t>(context.typeNodes.size());
+                exprLimit = std::is_same_v<Node, ExprNode> ? i : 0;
+                typename Node::Variant v;
+                (*this)(v);
+                // an image written from an interned context holds no type twice
+                if (good && ((context.*make)(std::move(v)), made.size() != i + 1)) return false;
+            }
+            return good;
+        }
+
+        void unit(CompilationUnit& cu) {
+            typeLimit = static_cast<uint32_t>(context.typeNodes.size());
+            exprLimit = static_cast<uint32_t>(context.exprNodes.size());
+            visitFields(*this, cu);
+        }
+
+        template<Scalar T> void operator()(T& v) { v = static_cast<T>(word()); }
+        void operator()(std::string& s) {
+            uint32_t offset = word();
+            uint32_t length = word();
+            if (size_t(offset) + length > stringBytes) { good = false; return; }
+            s.assign(reinterpret_cast<const char*>(strings) + offset, length);
+        }
+        void operator()(std::optional<std::string>& s) {
+            if (word()) (*this)(s.emplace());
+            else s.reset();
+        }
+        void operator()(TypeNode*& p) { p = reference(context.typeNodes, typeLimit); }
+        void operator()(ExprNode*& p) { p = reference(context.exprNodes, exprLimit); }
+        template<typename T> void operator()(T*& p) {
+            p = nullptr;
+            if (!word() || !good) return;
+            if (nesting == maxNesting) { good = false; return; }
+            ++nesting;
+            p = context.arena.make<T>();
+            visitFields(*this, *p);
+            --nesting;
+        }
+        template<typename T> void operator()(AstList<T>& list) {
+            uint32_t count = word();
+            // every element takes at least one word
+            if (count > end - pos) { good = false; return; }
+            list.clear();
+            list.reserve(count);
+            for (uint32_t i = 0; i < count && good; ++i) list.push_back(element<T>());
+        }
+        template<typename... Ts> void operator()(std::variant<Ts...>& v) {
+            uint32_t index = word();
+            if (index >= sizeof...(Ts)) { good = false; return; }
+            alternative<0>(v, index);
+        }
+        template<typename T> requires std::is_class_v<T> void operator()(T& n) { visitFields(*this, n); }
+
+    private:
+        uint32_t word() {
+            if (pos >= end) { good = false; return 0; }
+            return le32(words + 4 * pos++);
+        }
+
+        template<typename Node>
+        Node* reference(const std::vector<Node*>& made, uint32_t limit) {
+            uint32_t ref = word();
+            if (ref > limit) { good = false; return nullptr; }
+            return ref ? made[ref - 1] : nullptr;
+        }
+
+        template<typename T> T element() {
+            if constexpr (std::is_same_v<T, StatNode>) {
+                StatNode::Variant v;
+                (*this)(v);
+                return StatNode(std::move(v));
+            } else {
+                T value{};
+                (*this)(value);
+                return value;
+            }
+        }
+
+        template<size_t I, typename V> void alternative(V& v, uint32_t index) {
+            if constexpr (I < std::variant_size_v<V>) {
+                if (index == I) visitFields(*this, v.template emplace<I>());
+                else alternative<I + 1>(v, index);
+            }
+        }
+
+        AstContext& context;
+        const unsigned char* strings;
+        size_t stringBytes;
+        const unsigned char* words = nullptr;
+        size_t pos = 0;
+        size_t end = 0;
+        uint32_t typeLimit = 0;
+        uint32_t exprLimit = 0;
+        unsigned nesting = 0;
+        bool good = true;
+    };
+
+}
+
+std::vector<unsigned char> basis::writeAstBinary(const CompilationUnit& unit) {
+    if (!unit.context) throw std::logic_error("AstBinary: unit has no AstContext");
+    // the archive walks the AST by reference, but only reads it
+    auto& cu = const_cast<CompilationUnit&>(unit);
+    Writer writer(*cu.context);
+    std::vector<uint32_t> sections[SectionCount];
+    sections[Types] = writer.nodes(cu.context->typeNodes);
+    sections[Exprs] = writer.nodes(cu.context->exprNodes);
+    sections[Unit] = writer.unit(cu);
+
+    size_t stringBytes = (writer.strings.size() + 3) & ~size_t(3);
+    uint32_t offsets[SectionCount];
+    uint32_t sizes[SectionCount];
+    size_t at = headerBytes;
+    for (uint32_t s = 0; s < SectionCount; ++s) {
+        offsets[s] = static_cast<uint32_t>(at);
+        sizes[s] = static_cast<uint32_t>(s == Strings ? stringBytes : sections[s].size() * 4);
+        at += sizes[s];
+    }
+
+    std::vector<unsigned char> image(magic, magic + 4);
+    image.reserve(at);
+    putLe32(image, astBinaryVersion);
+    putLe32(image, SectionCount);
+    putLe32(image, 0);
+    for (uint32_t s = 0; s < SectionCount; ++s) {
+        putLe32(image, offsets[s]);
+        putLe32(image, sizes[s]);
+    }
+    image.insert(image.end(), writer.strings.begin(), writer.strings.end());
+    image.resize(headerBytes + stringBytes);
+    for (uint32_t s = Types; s < SectionCount; ++s) {
+        for (uint32_t w : sections[s]) putLe32(image, w);
+    }
+    return image;
+}
+
+std::shared_ptr<CompilationUnit> basis::readAstBinary(const unsigned char* data, size_t size) {
+    if (size < headerBytes || !std::equal(magic, magic + 4, data)) return nullptr;
+    if (le32(data + 4) != astBinaryVersion || le32(data + 8) != SectionCount) return nullptr;
+    const unsigned char* starts[SectionCount];
+    size_t sizes[SectionCount];
+    for (uint32_t s = 0; s < SectionCount; ++s) {
+        size_t offset = le32(data + 16 + 8 * s);
+        sizes[s] = le32(data + 20 + 8 * s);
+        if (offset % 4 || sizes[s] % 4 || offset > size || sizes[s] > size - offset) return nullptr;
+        starts[s] = data + offset;
+    }
+
+    auto context = std::make_shared<AstContext>();
+    AstArena::Scope scope(context->arena);
+    Reader reader(*context, starts[Strings], sizes[Strings]);
+    reader.section(starts[Types], sizes[Types]);
+    if (!reader.nodes(context->typeNodes, &AstContext::makeType) || !reader.consumed()) return nullptr;
+    reader.section(starts[Exprs], sizes[Exprs]);
+    if (!reader.nodes(context->exprNodes, &AstContext::makeExpr) || !reader.consumed()) return nullptr;
+
+    reader.section(starts[Unit], sizes[Unit]);
+    auto cu = context->arena.make<CompilationUnit>();
+    cu->context = context.get();
+    reader.unit(*cu);
+    if (!reader.ok() || !reader.consumed()) return nullptr;
+    return std::shared_ptr<CompilationUnit>(context, cu);
+}
+
+bool basis::saveAstBinary(const CompilationUnit& cu, const std::string& path) {
+    auto image = writeAstBinary(cu);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+    return static_cast<bool>(out.flush());
+}
+
+std::shared_ptr<CompilationUnit> basis::loadAstBinary(const std::string& path) {
+    MappedFile file(path);
+    if (!file.isOpen()) return nullptr;
+    return readAstBinary(file.data(), file.size());
+}
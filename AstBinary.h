@@ -0,0 +1,44 @@
+#ifndef ASTBINARY_H
+#define ASTBINARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AstContext.h"
+
+namespace basis {
+
+// Binary image of a CompilationUnit, for build caches and for handing parsed
+// modules between processes. The image holds no pointers: it is a header and
+// four sections of little-endian 32-bit words, all addressed by offset.
+//
+//   header    "BAST", version, section count, 0, then {offset, size} in bytes
+//             for each section
+//   strings   the bytes of every distinct string; a string is {offset, length}
+//   types     record count, the word offset of each record, then the records
+//   exprs     the same, for expressions
+//   unit      the CompilationUnit: module, imports and definitions inline
+//
+// Type and expression records are in NodeId order and refer to other nodes by
+// NodeId + 1 (0 for none), always to an earlier record, so reading them in order
+// rebuilds the nodes with the same NodeIds. Reading is one sequential pass that
+// makes the nodes in a fresh AstContext; there is nothing to parse or look up.
+constexpr uint32_t astBinaryVersion = 3;
+
+// Encode a unit made by buildAst, parseAst or readAstBinary.
+std::vector<unsigned char> writeAstBinary(const CompilationUnit& cu);
+
+// Rebuild the unit from an image. Returns nullptr if the image is truncated or
+// malformed, or of another version.
+std::shared_ptr<CompilationUnit> readAstBinary(const unsigned char* data, size_t size);
+
+bool saveAstBinary(const CompilationUnit& cu, const std::string& path);
+// Map the file read-only and read the image from the mapping.
+std::shared_ptr<CompilationUnit> loadAstBinary(const std::string& path);
+
+} // namespace basis
+
+#endif // ASTBINARY_H
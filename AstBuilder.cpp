@@ -1,6 +1,13 @@
 #include "AstBuilder.h"
+#include "ActionParser.h"
+#include "AstFields.h"
+#include "Grammar2.h"
+#include "Operators.h"
 #include <stdexcept>
 #include <cassert>
+#include <span>
+#include <type_traits>
+#include <variant>
 
 namespace basis {
 
@@ -11,6 +18,49 @@ namespace basis {
 #define BUILD_ASSERT(cond, msg) \
     do { if (!(cond)) throw std::logic_error(std::string("AstBuilder: ") + (msg)); } while (0)
 
+// The AstContext being built on this thread, and the arena scope that child
+// lists reach it through with their default-constructed allocators.
+static thread_local AstContext* building = nullptr;
+
+struct Building {
+    explicit Building(AstContext& context) : scope(context.arena), previous(building) {
+        building = &context;
+    }
+    ~Building() { building = previous; }
+    AstArena::Scope scope;
+    AstContext* previous;
+};
+
+// Make a node in the arena of the context being built; ExprNodes get the next
+// NodeId, and types are interned.
+template<typename T, typename... Args>
+static T* make(Args&&... args) {
+    if constexpr (std::is_same_v<T, ExprNode>) return building->makeExpr(std::forward<Args>(args)...);
+    else return building->arena.make<T>(std::forward<Args>(args)...);
+}
+
+static TypeNode* makeType(TypeNode::Variant&& type) {
+    return building->makeType(std::move(type));
+}
+
+// How deep the builders on this thread are in nested expressions, types and
+// blocks. Each level is a few C++ frames here and in the passes that walk the AST
+// after it, so past maxBuildNesting the build fails instead of the stack.
+static thread_local size_t nesting = 0;
+
+struct Nested {
+    Nested() {
+        if (++nesting > maxBuildNesting) {
+            --nesting;
+            throw std::logic_error("AstBuilder: nesting exceeds the depth limit of " +
+                                   std::to_string(maxBuildNesting));
+        }
+    }
+    ~Nested() { --nesting; }
+    Nested(const Nested&) = delete;
+    Nested& operator=(const Nested&) = delete;
+};
+
 // ========================================================================
 // Parse-tree navigation helpers
 // ========================================================================
@@ -43,12 +93,6 @@ static spParseTree findChild(const spParseTree& pt, Production p) {
         if (c->production == p) return c;
     return nullptr;
 }
-static std::vector<spParseTree> allChildren(const spParseTree& pt) {
-    std::vector<spParseTree> v;
-    for (auto c = down(pt); c; c = nxt(c)) v.push_back(c);
-    return v;
-}
-
 static int countChildren(const spParseTree& pt, Production p) {
     int count = 0;
     for (auto c = down(pt); c; c = nxt(c))
@@ -180,13 +224,13 @@ static ExprNodePtr buildPrimaryExpr(const spParseTree& pt);
 static ExprNodePtr buildCallExpression(const spParseTree& pt);
 static ExprNodePtr buildSubcallExpr(const spParseTree& pt);
 static ExprNodePtr buildInvokeExpr(const spParseTree& pt);
-static std::shared_ptr<CallGroup> buildCallGroup(const spParseTree& pt);
+static CallGroup* buildCallGroup(const spParseTree& pt);
 static CmdParam buildCmdParm(const spParseTree& pt);
 static CmdReceiver buildCmdReceiver(const spParseTree& pt);
 static CmdSignature buildSignature(const spParseTree& pt);
 static CmdDef buildCmdDefFromNode(const spParseTree& pt);
-static std::vector<FieldDecl> buildRecordFields(const spParseTree& pt);
-static std::vector<FieldDecl> buildObjectFields(const spParseTree& pt);
+static AstList<FieldDecl> buildRecordFields(const spParseTree& pt);
+static AstList<FieldDecl> buildObjectFields(const spParseTree& pt);
 
 // ========================================================================
 // Type expression builders
@@ -194,7 +238,6 @@ static std::vector<FieldDecl> buildObjectFields(const spParseTree& pt);
 static TypeNodePtr buildTypeNameQ(const spParseTree& pt) {
     if (!pt) return nullptr;
     NamedType nt;
-    nt.line = locL(pt); nt.col = locC(pt);
     auto c = down(pt); // first child: TYPENAME or QUALIFIED_TYPENAME
     nt.name = collectTypeName(c);
     auto args = findChild(pt, Production::TYPE_NAME_ARGS);
@@ -204,17 +247,15 @@ static TypeNodePtr buildTypeNameQ(const spParseTree& pt) {
                 nt.typeArgs.push_back(buildTypeNameQ(findChild(a, Production::TYPE_NAME_Q)));
             } else if (is(a, Production::TYPE_ARG_VALUE)) {
                 NamedType val; val.name = txt(down(a));
-                val.line = locL(a); val.col = locC(a);
-                nt.typeArgs.push_back(std::make_shared<TypeNode>(std::move(val)));
+                nt.typeArgs.push_back(makeType(std::move(val)));
             }
         }
     }
-    return std::make_shared<TypeNode>(std::move(nt));
+    return makeType(std::move(nt));
 }
 
 static CmdType buildCmdTypeNode(const spParseTree& pt) {
     CmdType ct;
-    ct.line = locL(pt); ct.col = locC(pt);
     ct.kind = cmdTypeKind(pt);
     for (auto c = down(pt); c; c = nxt(c)) {
         if (is(c, Production::TYPE_CMDEXPR_ARG)) {
@@ -233,32 +274,31 @@ static TypeNodePtr buildCmdExprArgType(const spParseTree& pt) {
     if (is(c, Production::TYPE_EXPR_PTR)) {
         PtrType ptr;
         ptr.depth = countChildren(pt, Production::TYPE_EXPR_PTR);
-        ptr.line = locL(pt); ptr.col = locC(pt);
         while (c && is(c, Production::TYPE_EXPR_PTR)) c = nxt(c);
         ptr.inner = buildCmdExprArgType(c);
-        return std::make_shared<TypeNode>(std::move(ptr));
+        return makeType(std::move(ptr));
     }
     if (is(c, Production::TYPE_NAME_Q))
         return buildTypeNameQ(c);
     if (is(c, Production::TYPE_EXPR_CMD)) {
         auto ct = buildCmdTypeNode(c);
-        return std::make_shared<TypeNode>(std::move(ct));
+        return makeType(std::move(ct));
     }
     if (is(c, Production::TYPE_EXPR_RANGE)) {
-        RangeType rt; rt.line = locL(c); rt.col = locC(c);
+        RangeType rt;
         auto sizeNode = down(c);
         rt.size = rangeSizeText(sizeNode);
         auto elemNode = nxt(c); // optional TYPE_CMDEXPR_ARG sibling
         if (elemNode && is(elemNode, Production::TYPE_CMDEXPR_ARG))
             rt.element = buildCmdExprArgType(elemNode);
-        return std::make_shared<TypeNode>(std::move(rt));
+        return makeType(std::move(rt));
     }
     return nullptr;
 }
 
-static std::vector<FieldDecl> buildRecordFields(const spParseTree& pt) {
+static AstList<FieldDecl> buildRecordFields(const spParseTree& pt) {
     // DEF_RECORD_FIELDS: children are DEF_RECORD_FIELD groups
-    std::vector<FieldDecl> fields;
+    AstList<FieldDecl> fields;
     for (auto c = down(pt); c; c = nxt(c)) {
         if (!is(c, Production::DEF_RECORD_FIELD)) continue;
         FieldDecl f;
@@ -272,8 +312,8 @@ static std::vector<FieldDecl> buildRecordFields(const spParseTree& pt) {
     return fields;
 }
 
-static std::vector<FieldDecl> buildObjectFields(const spParseTree& pt) {
-    std::vector<FieldDecl> fields;
+static AstList<FieldDecl> buildObjectFields(const spParseTree& pt) {
+    AstList<FieldDecl> fields;
     for (auto c = down(pt); c; c = nxt(c)) {
         if (!is(c, Production::DEF_OBJECT_FIELD)) continue;
         FieldDecl f;
@@ -287,8 +327,8 @@ static std::vector<FieldDecl> buildObjectFields(const spParseTree& pt) {
     return fields;
 }
 
-static std::vector<UnionCandidate> buildUnionCandidates(const spParseTree& pt) {
-    std::vector<UnionCandidate> cands;
+static AstList<UnionCandidate> buildUnionCandidates(const spParseTree& pt) {
+    AstList<UnionCandidate> cands;
     for (auto c = down(pt); c; c = nxt(c)) {
         if (!is(c, Production::DEF_UNION_CANDIDATE)) continue;
         UnionCandidate uc;
@@ -302,8 +342,8 @@ static std::vector<UnionCandidate> buildUnionCandidates(const spParseTree& pt) {
     return cands;
 }
 
-static std::vector<VariantCandidate> buildVariantCandidates(const spParseTree& pt) {
-    std::vector<VariantCandidate> cands;
+static AstList<VariantCandidate> buildVariantCandidates(const spParseTree& pt) {
+    AstList<VariantCandidate> cands;
     for (auto c = down(pt); c; c = nxt(c)) {
         if (!is(c, Production::DEF_VARIANT_CANDIDATE)) continue;
         VariantCandidate vc;
@@ -317,6 +357,14 @@ static std::vector<VariantCandidate> buildVariantCandidates(const spParseTree& p
     return cands;
 }
 
+// The members of an inline type are part of its interned node, which every use
+// of the type shares, so they carry no position; the use of the type does.
+template<typename Members>
+static Members unplaced(Members members) {
+    for (auto& m : members) m.line = m.col = 0;
+    return members;
+}
+
 static TypeNodePtr buildInlineType(const spParseTree& pt) {
     if (!pt) return nullptr;
     auto scopeNode = findChild(pt, Production::DEF_INLINE_SCOPE_NAME);
@@ -326,34 +374,30 @@ static TypeNodePtr buildInlineType(const spParseTree& pt) {
     if (is(pt, Production::DEF_INLINE_RECORD)) {
         InlineRecordType irt;
         irt.scopeName = scopeName;
-        irt.line = locL(pt); irt.col = locC(pt);
         auto flds = findChild(pt, Production::DEF_RECORD_FIELDS);
-        if (flds) irt.fields = buildRecordFields(flds);
-        return std::make_shared<TypeNode>(std::move(irt));
+        if (flds) irt.fields = unplaced(buildRecordFields(flds));
+        return makeType(std::move(irt));
     }
     if (is(pt, Production::DEF_INLINE_OBJECT)) {
         InlineObjectType iot;
         iot.scopeName = scopeName;
-        iot.line = locL(pt); iot.col = locC(pt);
         auto flds = findChild(pt, Production::DEF_OBJECT_FIELDS);
-        if (flds) iot.fields = buildObjectFields(flds);
-        return std::make_shared<TypeNode>(std::move(iot));
+        if (flds) iot.fields = unplaced(buildObjectFields(flds));
+        return makeType(std::move(iot));
     }
     if (is(pt, Production::DEF_INLINE_UNION)) {
         InlineUnionType iut;
         iut.scopeName = scopeName;
-        iut.line = locL(pt); iut.col = locC(pt);
         auto cands = findChild(pt, Production::DEF_UNION_CANDIDATES);
-        if (cands) iut.candidates = buildUnionCandidates(cands);
-        return std::make_shared<TypeNode>(std::move(iut));
+        if (cands) iut.candidates = unplaced(buildUnionCandidates(cands));
+        return makeType(std::move(iut));
     }
     if (is(pt, Production::DEF_INLINE_VARIANT)) {
         InlineVariantType ivt;
         ivt.scopeName = scopeName;
-        ivt.line = locL(pt); ivt.col = locC(pt);
         auto cands = findChild(pt, Production::DEF_VARIANT_CANDIDATES);
-        if (cands) ivt.candidates = buildVariantCandidates(cands);
-        return std::make_shared<TypeNode>(std::move(ivt));
+        if (cands) ivt.candidates = unplaced(buildVariantCandidates(cands));
+        return makeType(std::move(ivt));
     }
     return nullptr;
 }
@@ -364,46 +408,43 @@ static TypeNodePtr buildTypeExpr(const spParseTree& pt) {
     // If pt IS a TYPE_EXPR group, look at its first child
     spParseTree c = is(pt, Production::TYPE_EXPR) ? down(pt) : pt;
     if (!c) return nullptr;
+    Nested level;
 
     if (is(c, Production::TYPEDEF_NAME_Q)) {
         // Named type with parameters: TYPEDEF_NAME_Q(TYPENAME, TYPEDEF_PARMS)
         NamedType nt;
-        nt.line = locL(c); nt.col = locC(c);
         auto tn = down(c); // TYPENAME or QUALIFIED_TYPENAME
         nt.name = collectTypeName(tn);
         // TYPEDEF_PARMS not used here (definition-side only)
-        return std::make_shared<TypeNode>(std::move(nt));
+        return makeType(std::move(nt));
     }
     // Bare TYPENAME or QUALIFIED_TYPENAME: TYPEDEF_NAME_Q with no parms passes through.
     if (is(c, Production::TYPENAME) || is(c, Production::QUALIFIED_TYPENAME)) {
         NamedType nt;
-        nt.line = locL(c); nt.col = locC(c);
         nt.name = collectTypeName(c);
-        return std::make_shared<TypeNode>(std::move(nt));
+        return makeType(std::move(nt));
     }
     if (is(c, Production::TYPE_NAME_Q))
         return buildTypeNameQ(c);
     if (is(c, Production::TYPE_EXPR_CMD)) {
         auto ct = buildCmdTypeNode(c);
-        return std::make_shared<TypeNode>(std::move(ct));
+        return makeType(std::move(ct));
     }
     if (is(c, Production::TYPE_EXPR_RANGE)) {
         RangeType rt;
-        rt.line = locL(c); rt.col = locC(c);
         auto sizeNode = down(c);
         rt.size = rangeSizeText(sizeNode);
         auto elemSibling = nxt(c);
         if (elemSibling && is(elemSibling, Production::TYPE_EXPR))
             rt.element = buildTypeExpr(elemSibling);
-        return std::make_shared<TypeNode>(std::move(rt));
+        return makeType(std::move(rt));
     }
     if (is(c, Production::TYPE_EXPR_PTR)) {
         PtrType ptr;
         ptr.depth = countChildren(pt, Production::TYPE_EXPR_PTR);
-        ptr.line = locL(pt); ptr.col = locC(pt);
         while (c && is(c, Production::TYPE_EXPR_PTR)) c = nxt(c);
         ptr.inner = buildTypeExpr(c);
-        return std::make_shared<TypeNode>(std::move(ptr));
+        return makeType(std::move(ptr));
     }
     if (is(c, Production::DEF_INLINE_RECORD) || is(c, Production::DEF_INLINE_OBJECT) ||
         is(c, Production::DEF_INLINE_UNION) || is(c, Production::DEF_INLINE_VARIANT))
@@ -416,24 +457,23 @@ static TypeNodePtr buildTypeExprDomain(const spParseTree& pt) {
     if (!pt) return nullptr;
     spParseTree c = is(pt, Production::TYPE_EXPR_DOMAIN) ? down(pt) : pt;
     if (!c) return nullptr;
+    Nested level;
 
     if (is(c, Production::TYPE_NAME_Q))
         return buildTypeNameQ(c);
     if (is(c, Production::TYPEDEF_NAME_Q)) {
         NamedType nt;
-        nt.line = locL(c); nt.col = locC(c);
         nt.name = collectTypeName(down(c));
-        return std::make_shared<TypeNode>(std::move(nt));
+        return makeType(std::move(nt));
     }
     if (is(c, Production::TYPE_EXPR_RANGE)) {
         RangeType rt;
-        rt.line = locL(c); rt.col = locC(c);
         auto sizeNode = down(c);
         rt.size = rangeSizeText(sizeNode);
         auto elemSibling = nxt(c);
         if (elemSibling && is(elemSibling, Production::TYPE_EXPR_DOMAIN))
             rt.element = buildTypeExprDomain(elemSibling);
-        return std::make_shared<TypeNode>(std::move(rt));
+        return makeType(std::move(rt));
     }
     if (is(c, Production::DEF_INLINE_RECORD) || is(c, Production::DEF_INLINE_UNION))
         return buildInlineType(c);
@@ -467,7 +507,7 @@ static ExprNodePtr buildQuoteExpr(const spParseTree& pt) {
         auto body = findChild(pt, Production::CALL_GROUP);
         if (body) q.group = buildCallGroup(body);
     }
-    return std::make_shared<ExprNode>(std::move(q));
+    return make<ExprNode>(std::move(q));
 }
 
 // Build a CmdLiteralExpr from CALL_CMD_LITERAL
@@ -481,19 +521,20 @@ static ExprNodePtr buildCmdLiteral(const spParseTree& pt) {
         else if (is(c, Production::CALL_GROUP))
             lit.body = buildCallGroup(c);
     }
-    return std::make_shared<ExprNode>(std::move(lit));
+    return make<ExprNode>(std::move(lit));
 }
 
 // Build an ExprNode from a single primary child (leaf or invoke)
 static ExprNodePtr buildPrimaryExpr(const spParseTree& pt) {
     if (!pt) return nullptr;
+    Nested level;
     auto p = pt->production;
     // Literals
     if (p == Production::DECIMAL || p == Production::HEXNUMBER ||
         p == Production::BINARY || p == Production::NUMBER || p == Production::STRING) {
         LiteralExpr le; le.text = txt(pt);
         le.line = locL(pt); le.col = locC(pt);
-        return std::make_shared<ExprNode>(std::move(le));
+        return make<ExprNode>(std::move(le));
     }
     if (p == Production::LITERAL) {
         return buildPrimaryExpr(down(pt));
@@ -502,12 +543,12 @@ static ExprNodePtr buildPrimaryExpr(const spParseTree& pt) {
     if (p == Production::IDENTIFIER) {
         IdentifierExpr ie; ie.ident = collectIdentifier(pt);
         ie.line = locL(pt); ie.col = locC(pt);
-        return std::make_shared<ExprNode>(std::move(ie));
+        return make<ExprNode>(std::move(ie));
     }
     if (p == Production::ALLOC_IDENTIFIER) {
         IdentifierExpr ie; ie.ident = collectIdentifier(pt); ie.isAlloc = true;
         ie.line = locL(pt); ie.col = locC(pt);
-        return std::make_shared<ExprNode>(std::move(ie));
+        return make<ExprNode>(std::move(ie));
     }
     // Enum deref
     if (p == Production::ENUM_DEREF) {
@@ -516,7 +557,7 @@ static ExprNodePtr buildPrimaryExpr(const spParseTree& pt) {
         auto c = down(pt);
         ed.typeName = collectTypeName(c);
         ed.memberName = collectIdent(nxt(c)); // IDENTIFIER
-        return std::make_shared<ExprNode>(std::move(ed));
+        return make<ExprNode>(std::move(ed));
     }
     // Invocations
     if (p == Production::CALL_COMMAND || p == Production::CALL_CONSTRUCTOR ||
@@ -539,9 +580,9 @@ static ExprNodePtr buildPrimaryExpr(const spParseTree& pt) {
 }
 
 // Build invoke expressions (CALL_COMMAND, CALL_CONSTRUCTOR, CALL_VCOMMAND, CALL_FAIL)
-static std::vector<CallParam> buildCallParams(const spParseTree& pt) {
+static AstList<CallParam> buildCallParams(const spParseTree& pt) {
     // Collect CALL_PARAMETER children from any parent
-    std::vector<CallParam> params;
+    AstList<CallParam> params;
     for (auto c = down(pt); c; c = nxt(c)) {
         if (!is(c, Production::CALL_PARAMETER)) continue;
         CallParam cp;
@@ -565,7 +606,7 @@ static ExprNodePtr buildInvokeExpr(const spParseTree& pt) {
         auto tgt = findChild(pt, Production::CALL_CMD_TARGET);
         if (tgt) cc.target = buildPrimaryExpr(down(tgt));
         cc.params = buildCallParams(pt);
-        return std::make_shared<ExprNode>(std::move(cc));
+        return make<ExprNode>(std::move(cc));
     }
     if (is(pt, Production::CALL_CONSTRUCTOR)) {
         CallConstructorExpr ce;
@@ -573,34 +614,30 @@ static ExprNodePtr buildInvokeExpr(const spParseTree& pt) {
         auto tn = findChild(pt, Production::TYPE_NAME_Q);
         if (tn) ce.typeName = buildTypeNameQ(tn);
         ce.params = buildCallParams(pt);
-        return std::make_shared<ExprNode>(std::move(ce));
+        return make<ExprNode>(std::move(ce));
     }
     if (is(pt, Production::CALL_VCOMMAND)) {
         CallVCommandExpr vc;
         vc.line = locL(pt); vc.col = locC(pt);
         // Children: IDENTIFIER* (receivers), IDENTIFIER (name), CALL_PARAMETER*
-        auto kids = allChildren(pt);
         // Collect receivers (IDENTIFIERs before the command name)
         // The last IDENTIFIER before any CALL_PARAMETER is the name
-        std::vector<size_t> identIdxs;
-        for (size_t i = 0; i < kids.size(); ++i)
-            if (is(kids[i], Production::IDENTIFIER)) identIdxs.push_back(i);
-        if (identIdxs.size() >= 2) {
-            for (size_t i = 0; i + 1 < identIdxs.size(); ++i)
-                vc.receivers.push_back(collectIdent(kids[identIdxs[i]]));
-            vc.name = collectIdent(kids[identIdxs.back()]);
-        } else if (identIdxs.size() == 1) {
-            vc.name = collectIdent(kids[identIdxs[0]]);
+        spParseTree last;
+        for (auto c = down(pt); c; c = nxt(c)) {
+            if (!is(c, Production::IDENTIFIER)) continue;
+            if (last) vc.receivers.push_back(collectIdent(last));
+            last = c;
         }
+        if (last) vc.name = collectIdent(last);
         vc.params = buildCallParams(pt);
-        return std::make_shared<ExprNode>(std::move(vc));
+        return make<ExprNode>(std::move(vc));
     }
     if (is(pt, Production::CALL_FAIL)) {
         CallFailExpr cf;
         cf.line = locL(pt); cf.col = locC(pt);
         auto expr = findChild(pt, Production::CALL_EXPRESSION);
         if (expr) cf.expr = buildCallExpression(expr);
-        return std::make_shared<ExprNode>(std::move(cf));
+        return make<ExprNode>(std::move(cf));
     }
     return buildPrimaryExpr(pt);
 }
@@ -612,72 +649,78 @@ static ExprNodePtr buildSubcallExpr(const spParseTree& pt) {
     return buildPrimaryExpr(c);
 }
 
-static ExprNodePtr buildCallExpression(const spParseTree& pt) {
-    // CALL_EXPRESSION: flattened children = term-parts (CALL_OPERATOR term-parts)*
-    if (!pt) return nullptr;
-    auto kids = allChildren(pt);
-    if (kids.empty()) return nullptr;
-
-    // Split into segments at CALL_OPERATOR boundaries
-    std::vector<std::vector<spParseTree>> segments;
-    std::vector<spParseTree> operators;
-    segments.emplace_back();
-    for (auto& k : kids) {
-        if (is(k, Production::CALL_OPERATOR)) {
-            operators.push_back(k);
-            segments.emplace_back();
-        } else {
-            segments.back().push_back(k);
+// Build one operand of a CALL_EXPRESSION from the sibling slots starting at pos:
+// a primary plus any suffix nodes, up to the next CALL_OPERATOR. Leaves pos on
+// that operator, or on the empty slot past the last child.
+static ExprNodePtr buildExprTerm(const spParseTree*& pos) {
+    const spParseTree* start = pos;
+    ExprNodePtr primary = nullptr;
+    AstList<SuffixOp> suffixes;
+    for (; *pos && !is(*pos, Production::CALL_OPERATOR); pos = &(*pos)->spNext) {
+        const spParseTree& n = *pos;
+        if (is(n, Production::CALL_EXPR_DEREF)) {
+            SuffixOp sop; sop.kind = SuffixOp::Kind::Deref;
+            suffixes.push_back(std::move(sop));
+        } else if (is(n, Production::CALL_EXPR_INDEX)) {
+            SuffixOp sop; sop.kind = SuffixOp::Kind::Index;
+            auto loc = findChild(n, Production::CALL_EXPRINDEX_LOC);
+            if (loc) sop.indexLoc = buildSubcallExpr(down(loc));
+            auto ext = findChild(n, Production::CALL_EXPRINDEX_EXT);
+            if (ext) sop.indexExt = buildSubcallExpr(down(ext));
+            suffixes.push_back(std::move(sop));
+        } else if (is(n, Production::CALL_EXPR_ADDR)) {
+            SuffixOp sop; sop.kind = SuffixOp::Kind::Addr;
+            suffixes.push_back(std::move(sop));
+        } else if (!primary) {
+            primary = buildPrimaryExpr(n);
         }
     }
+    if (!suffixes.empty() && primary) {
+        SuffixExpr se;
+        se.line = locL(*start); se.col = locC(*start);
+        se.base = primary;
+        se.suffixes = std::move(suffixes);
+        return make<ExprNode>(std::move(se));
+    }
+    return primary;
+}
 
-    // Build a term from a segment: primary + optional CALL_EXPR_INDEX suffixes
-    auto buildTerm = [](const std::vector<spParseTree>& seg) -> ExprNodePtr {
-        if (seg.empty()) return nullptr;
-        ExprNodePtr primary;
-        std::vector<SuffixOp> suffixes;
-        for (auto& n : seg) {
-            if (is(n, Production::CALL_EXPR_DEREF)) {
-                SuffixOp sop; sop.kind = SuffixOp::Kind::Deref;
-                suffixes.push_back(std::move(sop));
-            } else if (is(n, Production::CALL_EXPR_INDEX)) {
-                SuffixOp sop; sop.kind = SuffixOp::Kind::Index;
-                auto loc = findChild(n, Production::CALL_EXPRINDEX_LOC);
-                if (loc) sop.indexLoc = buildSubcallExpr(down(loc));
-                auto ext = findChild(n, Production::CALL_EXPRINDEX_EXT);
-                if (ext) sop.indexExt = buildSubcallExpr(down(ext));
-                suffixes.push_back(std::move(sop));
-            } else if (is(n, Production::CALL_EXPR_ADDR)) {
-                SuffixOp sop; sop.kind = SuffixOp::Kind::Addr;
-                suffixes.push_back(std::move(sop));
-            } else if (!primary) {
-                primary = buildPrimaryExpr(n);
-            }
-        }
-        if (!suffixes.empty() && primary) {
-            SuffixExpr se;
-            se.line = locL(seg[0]); se.col = locC(seg[0]);
-            se.base = primary;
-            se.suffixes = std::move(suffixes);
-            return std::make_shared<ExprNode>(std::move(se));
-        }
-        return primary;
-    };
-
-    if (segments.size() == 1)
-        return buildTerm(segments[0]);
+static const OperatorInfo* operatorAt(const spParseTree* pos) {
+    if (!*pos || !is(*pos, Production::CALL_OPERATOR) || !(*pos)->spDown) return nullptr;
+    auto* t = (*pos)->spDown->pToken;
+    return t ? findOperator(t->type) : nullptr;
+}
 
-    // Multiple segments → BinaryExpr
-    BinaryExpr be;
-    be.line = locL(pt); be.col = locC(pt);
-    be.first = buildTerm(segments[0]);
-    for (size_t i = 0; i < operators.size(); ++i) {
-        BinaryExpr::OpTerm ot;
-        ot.op = firstTxt(operators[i]);
-        ot.term = buildTerm(segments[i + 1]);
-        be.rest.push_back(std::move(ot));
+// Precedence climbing over the flat term (CALL_OPERATOR term)* slots of a
+// CALL_EXPRESSION, starting at pos. Consecutive operators of one precedence
+// level form one BinaryExpr, applied left to right (comparatives chain);
+// tighter operands nest below it. Stops before an operator looser than minPrec.
+static ExprNodePtr buildOperatorExpr(const spParseTree*& pos, int minPrec) {
+    const spParseTree& start = *pos;
+    ExprNodePtr lhs = buildExprTerm(pos);
+    for (auto op = operatorAt(pos); op && op->precedence >= minPrec; op = operatorAt(pos)) {
+        int level = op->precedence;
+        BinaryExpr be;
+        be.line = locL(start); be.col = locC(start);
+        be.first = lhs;
+        for (; op && op->precedence == level; op = operatorAt(pos)) {
+            BinaryExpr::OpTerm ot;
+            ot.op = firstTxt(*pos);
+            pos = &(*pos)->spNext;
+            // a right-associative operand absorbs the rest of its level
+            ot.term = buildOperatorExpr(pos, op->associativity == Associativity::Right ? level : level + 1);
+            be.rest.push_back(std::move(ot));
+        }
+        lhs = make<ExprNode>(std::move(be));
     }
-    return std::make_shared<ExprNode>(std::move(be));
+    return lhs;
+}
+
+static ExprNodePtr buildCallExpression(const spParseTree& pt) {
+    // CALL_EXPRESSION: flattened children = term-parts (CALL_OPERATOR term-parts)*
+    if (!pt || !pt->spDown) return nullptr;
+    const spParseTree* pos = &pt->spDown;
+    return buildOperatorExpr(pos, 0);
 }
 
 // ========================================================================
@@ -739,19 +782,18 @@ static StatNode buildStatement(const spParseTree& pt) {
     if (is(pt, Production::CALL_ASSIGNMENT)) {
         AssignStat as;
         as.line = locL(pt); as.col = locC(pt);
-        auto kids = allChildren(pt);
-        if (!kids.empty()) {
+        auto tgt = down(pt);
+        if (tgt) {
             // First child: ALLOC_IDENTIFIER or IDENTIFIER
-            auto& tgt = kids[0];
             IdentifierExpr ie;
             ie.ident = collectIdentifier(tgt);
             ie.isAlloc = isAllocIdent(tgt);
             ie.line = locL(tgt); ie.col = locC(tgt);
-            as.target = std::make_shared<ExprNode>(std::move(ie));
+            as.target = make<ExprNode>(std::move(ie));
         }
         // Second child: SUBCALL_EXPRESSION
-        if (kids.size() > 1)
-            as.value = buildSubcallExpr(kids[1]);
+        if (auto val = nxt(tgt))
+            as.value = buildSubcallExpr(val);
         return StatNode(std::move(as));
     }
     if (is(pt, Production::CALL_EXPRESSION)) {
@@ -769,18 +811,19 @@ static StatNode buildStatement(const spParseTree& pt) {
     return StatNode(std::move(es));
 }
 
-static std::shared_ptr<CallGroup> buildCallGroup(const spParseTree& pt) {
+static CallGroup* buildCallGroup(const spParseTree& pt) {
     if (!pt) return nullptr;
-    auto cg = std::make_shared<CallGroup>();
+    Nested level;
+    auto cg = make<CallGroup>();
     cg->line = locL(pt); cg->col = locC(pt);
     for (auto c = down(pt); c; c = nxt(c))
         cg->statements.push_back(buildStatement(c));
     return cg;
 }
 
-static std::shared_ptr<CmdBody> buildCmdBody(const spParseTree& pt) {
+static CmdBody* buildCmdBody(const spParseTree& pt) {
     if (!pt) return nullptr;
-    auto body = std::make_shared<CmdBody>();
+    auto body = make<CmdBody>();
     body->line = locL(pt); body->col = locC(pt);
     // Optional DEF_SUBS appears between the `=` and the body's content.
     if (auto subs = findChild(pt, Production::DEF_SUBS)) {
@@ -805,6 +848,7 @@ static std::shared_ptr<CmdBody> buildCmdBody(const spParseTree& pt) {
 static CmdParam buildCmdParm(const spParseTree& pt) {
     // DEF_CMD_PARM: children = DEF_CMD_PARMTYPE_NAME or DEF_CMD_PARMTYPE_VAR, then DEF_CMD_PARM_NAME
     CmdParam cp;
+    cp.line = locL(pt); cp.col = locC(pt);
     auto nameNode = findChild(pt, Production::DEF_CMD_PARM_NAME);
     cp.name = txt(nameNode);
     auto typeNameNode = findChild(pt, Production::DEF_CMD_PARMTYPE_NAME);
@@ -824,6 +868,7 @@ static CmdParam buildCmdParm(const spParseTree& pt) {
 static CmdReceiver buildCmdReceiver(const spParseTree& pt) {
     // DEF_CMD_RECEIVER: DEF_CMD_PARMTYPE_NAME + DEF_CMD_PARM_NAME
     CmdReceiver cr;
+    cr.line = locL(pt); cr.col = locC(pt);
     auto typeNode = findChild(pt, Production::DEF_CMD_PARMTYPE_NAME);
     if (typeNode) cr.type = buildTypeExpr(down(typeNode));
     auto nameNode = findChild(pt, Production::DEF_CMD_PARM_NAME);
@@ -840,8 +885,8 @@ static void parseNameSpec(const spParseTree& pt, std::string& name, FailMode& fa
     name = txt(nm);
 }
 
-static std::vector<CmdParam> buildParmList(const spParseTree& pt) {
-    std::vector<CmdParam> parms;
+static AstList<CmdParam> buildParmList(const spParseTree& pt) {
+    AstList<CmdParam> parms;
     for (auto c = down(pt); c; c = nxt(c))
         if (is(c, Production::DEF_CMD_PARM)) parms.push_back(buildCmdParm(c));
     return parms;
@@ -960,6 +1005,8 @@ static CmdDef buildCmdDefFromNode(const spParseTree& pt) {
         BUILD_ASSERT(sig, "DEF_CMD missing signature child");
         cd.signature = buildSignature(sig);
     }
+    // a signatures-only parse leaves the body unparsed: build no body for it
+    if (findChild(pt, Production::DEF_CMD_BODY_DEFERRED)) return cd;
     auto body = findChild(pt, Production::DEF_CMD_BODY);
     BUILD_ASSERT(body, "DEF_CMD/DEF_SUB missing DEF_CMD_BODY");
     cd.body = buildCmdBody(body);
@@ -997,19 +1044,17 @@ static TopLevelDef buildTopLevel(const spParseTree& pt) {
             auto tn = down(par);
             if (tn && isAnyTypename(tn))  {
                 NamedType nt; nt.name = collectTypeName(tn);
-                nt.line = locL(tn); nt.col = locC(tn);
-                dd.parent = std::make_shared<TypeNode>(std::move(nt));
+                dd.parent = makeType(std::move(nt));
             } else if (tn && is(tn, Production::DEF_DOMAIN_PARENT_RANGE)) {
-                RangeType rt; rt.line = locL(tn); rt.col = locC(tn);
+                RangeType rt;
                 auto sz = findChild(tn, Production::DEF_DOMAIN_PARENT_RANGE_SIZE);
                 if (sz) rt.size = txt(down(sz));
                 auto et = findChild(tn, Production::DEF_DOMAIN_PARENT_RANGE_TYPE);
                 if (et) {
                     NamedType elem; elem.name = collectTypeName(down(et));
-                    elem.line = locL(et); elem.col = locC(et);
-                    rt.element = std::make_shared<TypeNode>(std::move(elem));
+                    rt.element = makeType(std::move(elem));
                 }
-                dd.parent = std::make_shared<TypeNode>(std::move(rt));
+                dd.parent = makeType(std::move(rt));
             }
         }
         return dd;
@@ -1025,14 +1070,13 @@ static TopLevelDef buildTopLevel(const spParseTree& pt) {
         // literal sibling (one of DECIMAL/HEXNUMBER/BINARY/NUMBER/STRING).
         // The `= <literal>` part is optional in the grammar, so a name may be
         // followed by another DEF_ENUM_ITEM_NAME instead — guard accordingly.
-        auto kids = allChildren(pt);
-        for (size_t i = 0; i < kids.size(); ++i) {
-            if (!is(kids[i], Production::DEF_ENUM_ITEM_NAME)) continue;
+        for (auto c = down(pt); c; c = nxt(c)) {
+            if (!is(c, Production::DEF_ENUM_ITEM_NAME)) continue;
             EnumItem item;
-            item.name = txt(kids[i]);
-            item.line = locL(kids[i]); item.col = locC(kids[i]);
-            if (i + 1 < kids.size() && isLiteralProd(kids[i + 1]->production)) {
-                item.value = txt(kids[i + 1]);
+            item.name = txt(c);
+            item.line = locL(c); item.col = locC(c);
+            if (c->spNext && isLiteralProd(c->spNext->production)) {
+                item.value = txt(c->spNext);
             }
             ed.items.push_back(std::move(item));
         }
@@ -1182,50 +1226,1323 @@ static TopLevelDef buildTopLevel(const spParseTree& pt) {
 // Entry point
 // ========================================================================
 
+// Add one child of COMPILATION_UNIT to cu.
+static void addTopLevel(CompilationUnit& cu, const spParseTree& c) {
+    auto p = c->production;
+
+    if (p == Production::DEF_MODULE) {
+        auto mod = make<ModuleDecl>();
+        mod->line = locL(c); mod->col = locC(c);
+        auto mn = findChild(c, Production::DEF_MODULE_NAME);
+        if (mn) mod->name = collectTypeName(down(mn));
+        cu.module = mod;
+        return;
+    }
+    if (p == Production::DEF_IMPORT) {
+        auto imp = make<ImportDecl>();
+        imp->line = locL(c); imp->col = locC(c);
+        // Walk direct children of DEF_IMPORT (flat structure after grammar refactoring).
+        // DEF_IMPORT_ALIAS  — leaf, renamed TYPENAME_UNQUALIFIED
+        // DEF_IMPORT_FILENAME — leaf, renamed STRING  (file import)
+        // DEF_IMPORT_STANDARD — leaf (simple name) or group (qualified name, children are TYPENAME leaves)
+        for (auto sc = down(c); sc; sc = nxt(sc)) {
+            if (is(sc, Production::DEF_IMPORT_ALIAS)) {
+                imp->alias = txt(down(sc)); // group node; child is the TYPENAME leaf
+            } else if (is(sc, Production::DEF_IMPORT_FILENAME)) {
+                imp->kind = ImportDecl::Kind::File;
+                imp->path = txt(sc);
+            } else if (is(sc, Production::DEF_IMPORT_STANDARD)) {
+                imp->kind = ImportDecl::Kind::Standard;
+                imp->name = collectTypeName(down(sc)); // child is TYPENAME or QUALIFIED_TYPENAME
+            }
+        }
+        cu.imports.push_back(imp);
+        return;
+    }
+    // Definitions the parser recovered from have already been reported
+    if (p == Production::PARSE_ERROR) return;
+    // All other top-level definitions
+    cu.definitions.push_back(buildTopLevel(c));
+}
+
 std::shared_ptr<CompilationUnit> buildAst(const spParseTree& pt) {
     if (!pt || !is(pt, Production::COMPILATION_UNIT))
         return nullptr;
 
-    auto cu = std::make_shared<CompilationUnit>();
+    auto context = std::make_shared<AstContext>();
+    Building scope(*context);
+    auto cu = make<CompilationUnit>();
+    cu->context = context.get();
     cu->line = locL(pt); cu->col = locC(pt);
 
+    for (auto c = down(pt); c; c = nxt(c))
+        addTopLevel(*cu, c);
+
+    // the unit keeps its context, and so every node, alive
+    return std::shared_ptr<CompilationUnit>(context, cu);
+}
+
+// ========================================================================
+// Parallel build
+// ========================================================================
+
+// Where a definition built in parallel left its nodes: the part of the worker
+// that built it, and the ranges of the part's NodeIds it made.
+struct DefinitionSpan {
+    unsigned part = 0;
+    size_t typesBegin = 0, typesEnd = 0;
+    size_t exprsBegin = 0, exprsEnd = 0;
+};
+
+// Points the TypeNode fields of whatever it visits at canonical nodes, looked up
+// by the part-local NodeId of the node they point at now. ExprNodes are not
+// followed; each one is visited as a node of its own.
+struct TypeRemap {
+    const std::vector<TypeNode*>& canonical;
+
+    void operator()(TypeNode*& p) { if (p) p = canonical[p->id]; }
+    void operator()(ExprNode*&) {}
+    template<typename T> void operator()(T*& p) { if (p) visitFields(*this, *p); }
+    template<typename T> void operator()(AstList<T>& list) { for (auto& e : list) (*this)(e); }
+    template<typename... Ts> void operator()(std::variant<Ts...>& v) {
+        std::visit([this](auto& alt) { visitFields(*this, alt); }, v);
+    }
+    void operator()(std::string&) {}
+    void operator()(std::optional<std::string>&) {}
+    template<typename T> requires std::is_class_v<T> void operator()(T& n) { visitFields(*this, n); }
+    template<typename T> requires (!std::is_class_v<T>) void operator()(T&) {}
+};
+
+// Move the nodes of one definition from its part into the unit's context, as if
+// the definition had been built there: its types are interned and numbered, in
+// the order it made them, after those of the definitions before it, and so are
+// its expressions. A part interns the types of each definition afresh, so they
+// only refer to types of the same definition.
+static void adoptDefinition(AstContext& context, AstContext& part, const DefinitionSpan& span,
+                            std::vector<TypeNode*>& canonical, TopLevelDef& definition) {
+    canonical.resize(part.typeNodes.size());
+    TypeRemap remap{canonical};
+    std::vector<TypeNode*> adopted;
+    for (size_t k = span.typesBegin; k < span.typesEnd; ++k) {
+        TypeNode* node = part.typeNodes[k];
+        remap(node->v);
+        // hashes are made from the children's hashes, which do not change
+        canonical[k] = context.types.find(node->v, node->hash);
+        if (!canonical[k]) {
+            canonical[k] = node;
+            context.types.insert(node);
+            context.typeNodes.push_back(node);
+            adopted.push_back(node);
+        }
+    }
+    for (size_t k = span.exprsBegin; k < span.exprsEnd; ++k) {
+        ExprNode* node = part.exprNodes[k];
+        remap(node->v);
+        node->id = static_cast<NodeId>(context.exprNodes.size());
+        context.exprNodes.push_back(node);
+    }
+    remap(definition);
+    // renumber last, as the remapping looks nodes up by their part-local ids
+    NodeId id = static_cast<NodeId>(context.typeNodes.size() - adopted.size());
+    for (TypeNode* node : adopted) node->id = id++;
+}
+
+std::shared_ptr<CompilationUnit> buildAst(const spParseTree& pt, WorkStealingPool& pool) {
+    if (!pt || !is(pt, Production::COMPILATION_UNIT))
+        return nullptr;
+
+    auto context = std::make_shared<AstContext>();
+    Building scope(*context);
+    auto cu = make<CompilationUnit>();
+    cu->context = context.get();
+    cu->line = locL(pt); cu->col = locC(pt);
+
+    std::vector<spParseTree> definitions;
     for (auto c = down(pt); c; c = nxt(c)) {
-        auto p = c->production;
+        if (is(c, Production::DEF_MODULE) || is(c, Production::DEF_IMPORT) || is(c, Production::PARSE_ERROR))
+            addTopLevel(*cu, c);
+        else
+            definitions.push_back(c);
+    }
+
+    cu->definitions.resize(definitions.size());
+    std::vector<DefinitionSpan> spans(definitions.size());
+    for (unsigned w = 0; w < pool.workers(); ++w)
+        context->parts.push_back(std::make_unique<AstContext>());
+    pool.run(definitions.size(), [&](size_t i, unsigned worker) {
+        AstContext& part = *context->parts[worker];
+        Building building(part);
+        part.types.clear();
+        DefinitionSpan& span = spans[i];
+        span.part = worker;
+        span.typesBegin = part.typeNodes.size();
+        span.exprsBegin = part.exprNodes.size();
+        cu->definitions[i] = buildTopLevel(definitions[i]);
+        span.typesEnd = part.typeNodes.size();
+        span.exprsEnd = part.exprNodes.size();
+    });
+
+    std::vector<std::vector<TypeNode*>> canonical(context->parts.size());
+    for (size_t i = 0; i < definitions.size(); ++i) {
+        const DefinitionSpan& span = spans[i];
+        adoptDefinition(*context, *context->parts[span.part], span, canonical[span.part],
+                        cu->definitions[i]);
+    }
+    return std::shared_ptr<CompilationUnit>(context, cu);
+}
+
+// ========================================================================
+// Build actions
+// ========================================================================
+
+// parseAst builds while it parses: ActionParser reports each node the grammar
+// recognizes, and the action of a group makes its AST from what its children
+// built, in place of a builder walking the parse tree. The children of a group
+// are the top of a stack of values, so no node of a parse tree is ever made.
+// Each action builds what the builder above does for the same node, so the two
+// make the same AST.
+
+struct NameSpec {
+    std::string name;
+    FailMode    failMode = FailMode::NoFail;
+};
+
+struct ParamList {
+    AstList<CmdParam> params;
+    std::string       returnVal;
+};
+
+// What a node built, for the action of the group around it to take
+using Built = std::variant<
+    std::monostate, std::string, Identifier, TypeNodePtr, ExprNodePtr, CmdTypeArg,
+    AstList<TypeNodePtr>, FieldDecl, AstList<FieldDecl>, UnionCandidate, AstList<UnionCandidate>,
+    VariantCandidate, AstList<VariantCandidate>, AstList<InstanceType>, CallParam, SuffixOp,
+    AssignStat, Block, CallGroup*, CmdBody*, CmdParam, ParamList, CmdReceiver, AstList<CmdReceiver>,
+    NameSpec, CmdSignature, AstList<CmdDef>, AstList<ClassMember>, TopLevelDef,
+    ModuleDecl*, ImportDecl*, CompilationUnit*>;
+
+// A node of the parse. token and first are the pToken and firstTok() its
+// ParseTree node would have; built stands in for its children.
+struct Value {
+    Production   prod = Production::PARSE_ERROR;
+    const Token* token = nullptr;
+    const Token* first = nullptr;
+    Built        built;
+};
+
+using Values = std::span<Value>;
+
+static std::string text(const Value* v) {
+    return (v && v->token) ? v->token->text : std::string{};
+}
+
+template<typename Node>
+static void place(Node& node, const Value& v) {
+    node.line = v.first ? v.first->lineNumber : 0;
+    node.col  = v.first ? v.first->columnNumber : 0;
+}
+
+static Value* child(Values children, Production p) {
+    for (Value& c : children)
+        if (c.prod == p) return &c;
+    return nullptr;
+}
+
+static int count(Values children, Production p) {
+    int n = 0;
+    for (const Value& c : children)
+        if (c.prod == p) ++n;
+    return n;
+}
+
+// What `v` built, which must be a T
+template<typename T>
+static T& built(Value& v) {
+    T* p = std::get_if<T>(&v.built);
+    BUILD_ASSERT(p, std::string("nothing built for ") + productionName(v.prod));
+    return *p;
+}
+
+static TypeNodePtr typeOf(Value* v) {
+    return v ? built<TypeNodePtr>(*v) : nullptr;
+}
+
+// collectTypeName
+static std::string typeName(Value* v) {
+    if (v && v->prod == Production::QUALIFIED_TYPENAME) return built<std::string>(*v);
+    return text(v);
+}
+
+// collectIdentifier
+static Identifier identifier(Value* v) {
+    if (v && (v->prod == Production::IDENTIFIER || v->prod == Production::ALLOC_IDENTIFIER))
+        return built<Identifier>(*v);
+    Identifier id;
+    id.name = text(v);
+    return id;
+}
+
+// collectIdent
+static std::string identText(Value* v) {
+    Identifier id = identifier(v);
+    std::string r;
+    for (auto& q : id.qualifiers) r += q + "::";
+    r += id.name;
+    return r;
+}
+
+// parseAst numbers its expressions once the unit is whole (see NumberExpressions):
+// the parse makes some that it then backs out of.
+static ExprNode* makeExpr(ExprNode::Variant&& expr) {
+    return building->arena.make<ExprNode>(std::move(expr));
+}
+
+// buildPrimaryExpr: leaves make their expression here, groups made theirs already
+static ExprNodePtr primary(Value* v) {
+    if (!v) return nullptr;
+    if (isLiteralProd(v->prod)) {
+        LiteralExpr le; le.text = text(v);
+        place(le, *v);
+        return makeExpr(std::move(le));
+    }
+    if (v->prod == Production::IDENTIFIER || v->prod == Production::ALLOC_IDENTIFIER) {
+        IdentifierExpr ie; ie.ident = identifier(v);
+        ie.isAlloc = v->prod == Production::ALLOC_IDENTIFIER;
+        place(ie, *v);
+        return makeExpr(std::move(ie));
+    }
+    auto* expr = std::get_if<ExprNodePtr>(&v->built);
+    return expr ? *expr : nullptr;
+}
+
+static Value* first(Values children) {
+    return children.empty() ? nullptr : &children[0];
+}
+
+// ---- types
+
+static TypeNodePtr namedType(std::string name) {
+    NamedType nt;
+    nt.name = std::move(name);
+    return makeType(std::move(nt));
+}
+
+static TypeNodePtr typeNameQ(Values c) {
+    NamedType nt;
+    nt.name = typeName(first(c));
+    if (auto args = child(c, Production::TYPE_NAME_ARGS))
+        nt.typeArgs = std::move(built<AstList<TypeNodePtr>>(*args));
+    return makeType(std::move(nt));
+}
+
+static AstList<TypeNodePtr> typeNameArgs(Values c) {
+    AstList<TypeNodePtr> args;
+    for (Value& a : c) {
+        if (a.prod == Production::TYPE_ARG_TYPE || a.prod == Production::TYPE_ARG_VALUE)
+            args.push_back(built<TypeNodePtr>(a));
+    }
+    return args;
+}
+
+static std::string rangeSize(Values c) {
+    Value* size = first(c);
+    if (size && size->prod == Production::IDENTIFIER) return identText(size);
+    return text(size);
+}
 
-        if (p == Production::DEF_MODULE) {
-            auto mod = std::make_shared<ModuleDecl>();
-            mod->line = locL(c); mod->col = locC(c);
-            auto mn = findChild(c, Production::DEF_MODULE_NAME);
-            if (mn) mod->name = collectTypeName(down(mn));
-            cu->module = mod;
-            continue;
+static CmdTypeArg cmdExprArg(Values c) {
+    CmdTypeArg arg;
+    size_t i = 0;
+    if (i < c.size() && c[i].prod == Production::TYPE_EXPR_PTR) {
+        PtrType ptr;
+        ptr.depth = count(c, Production::TYPE_EXPR_PTR);
+        while (i < c.size() && c[i].prod == Production::TYPE_EXPR_PTR) ++i;
+        if (i < c.size() && c[i].prod == Production::TYPE_CMDEXPR_ARG) {
+            CmdTypeArg& inner = built<CmdTypeArg>(c[i]);
+            ptr.inner = inner.type;
+            arg.writeable = inner.writeable;
         }
-        if (p == Production::DEF_IMPORT) {
-            auto imp = std::make_shared<ImportDecl>();
-            imp->line = locL(c); imp->col = locC(c);
-            // Walk direct children of DEF_IMPORT (flat structure after grammar refactoring).
-            // DEF_IMPORT_ALIAS  — leaf, renamed TYPENAME_UNQUALIFIED
-            // DEF_IMPORT_FILENAME — leaf, renamed STRING  (file import)
-            // DEF_IMPORT_STANDARD — leaf (simple name) or group (qualified name, children are TYPENAME leaves)
-            for (auto sc = down(c); sc; sc = nxt(sc)) {
-                if (is(sc, Production::DEF_IMPORT_ALIAS)) {
-                    imp->alias = txt(down(sc)); // group node; child is the TYPENAME leaf
-                } else if (is(sc, Production::DEF_IMPORT_FILENAME)) {
-                    imp->kind = ImportDecl::Kind::File;
-                    imp->path = txt(sc);
-                } else if (is(sc, Production::DEF_IMPORT_STANDARD)) {
-                    imp->kind = ImportDecl::Kind::Standard;
-                    imp->name = collectTypeName(down(sc)); // child is TYPENAME or QUALIFIED_TYPENAME
-                }
+        arg.type = makeType(std::move(ptr));
+    } else if (i < c.size() &&
+               (c[i].prod == Production::TYPE_NAME_Q || c[i].prod == Production::TYPE_EXPR_CMD)) {
+        arg.type = built<TypeNodePtr>(c[i]);
+    } else if (i < c.size() && c[i].prod == Production::TYPE_EXPR_RANGE) {
+        RangeType rt;
+        rt.size = std::move(built<std::string>(c[i]));
+        if (i + 1 < c.size() && c[i + 1].prod == Production::TYPE_CMDEXPR_ARG) {
+            CmdTypeArg& inner = built<CmdTypeArg>(c[i + 1]);
+            rt.element = inner.type;
+            arg.writeable = inner.writeable;
+        }
+        arg.type = makeType(std::move(rt));
+    }
+    if (child(c, Production::TYPE_ARG_WRITEABLE)) arg.writeable = true;
+    return arg;
+}
+
+static TypeNodePtr cmdType(Values c) {
+    CmdType ct;
+    if      (child(c, Production::TYPE_CMD_MAYFAIL)) ct.kind = CmdType::Kind::MayFail;
+    else if (child(c, Production::TYPE_CMD_FAILS))   ct.kind = CmdType::Kind::Fails;
+    for (Value& a : c) {
+        if (a.prod == Production::TYPE_CMDEXPR_ARG) ct.args.push_back(built<CmdTypeArg>(a));
+    }
+    return makeType(std::move(ct));
+}
+
+// buildTypeExpr and buildTypeExprDomain: `element` is the production of the
+// element of a range, TYPE_EXPR or TYPE_EXPR_DOMAIN
+static TypeNodePtr typeExpr(Values c, Production element) {
+    Value* head = first(c);
+    if (!head) return nullptr;
+    switch (head->prod) {
+    case Production::TYPEDEF_NAME_Q:
+        return namedType(built<std::string>(*head));
+    case Production::TYPENAME:
+    case Production::QUALIFIED_TYPENAME:
+        return namedType(typeName(head));
+    case Production::TYPE_NAME_Q:
+    case Production::TYPE_EXPR_CMD:
+    case Production::DEF_INLINE_RECORD:
+    case Production::DEF_INLINE_OBJECT:
+    case Production::DEF_INLINE_UNION:
+    case Production::DEF_INLINE_VARIANT:
+        return built<TypeNodePtr>(*head);
+    case Production::TYPE_EXPR_RANGE: {
+        RangeType rt;
+        rt.size = std::move(built<std::string>(*head));
+        if (c.size() > 1 && c[1].prod == element) rt.element = built<TypeNodePtr>(c[1]);
+        return makeType(std::move(rt));
+    }
+    case Production::TYPE_EXPR_PTR: {
+        PtrType ptr;
+        ptr.depth = count(c, Production::TYPE_EXPR_PTR);
+        size_t i = 0;
+        while (i < c.size() && c[i].prod == Production::TYPE_EXPR_PTR) ++i;
+        if (i < c.size()) ptr.inner = typeOf(&c[i]);
+        return makeType(std::move(ptr));
+    }
+    default:
+        return nullptr;
+    }
+}
+
+template<typename Member>
+static AstList<Member> members(Values c, Production p) {
+    AstList<Member> list;
+    for (Value& m : c)
+        if (m.prod == p) list.push_back(std::move(built<Member>(m)));
+    return list;
+}
+
+template<typename Member>
+static Member member(Value& self, Values c, Production typeProd, Production nameProd) {
+    Member m;
+    place(m, self);
+    TypeNodePtr type = typeOf(child(c, typeProd));
+    if constexpr (std::is_same_v<Member, UnionCandidate>) m.domain = type;
+    else m.type = type;
+    m.name = text(child(c, nameProd));
+    return m;
+}
+
+static TypeNodePtr inlineType(Value& self, Values c) {
+    std::string scopeName;
+    if (auto scope = child(c, Production::DEF_INLINE_SCOPE_NAME)) scopeName = built<std::string>(*scope);
+    switch (self.prod) {
+    case Production::DEF_INLINE_RECORD: {
+        InlineRecordType irt;
+        irt.scopeName = scopeName;
+        if (auto f = child(c, Production::DEF_RECORD_FIELDS))
+            irt.fields = unplaced(built<AstList<FieldDecl>>(*f));
+        return makeType(std::move(irt));
+    }
+    case Production::DEF_INLINE_OBJECT: {
+        InlineObjectType iot;
+        iot.scopeName = scopeName;
+        if (auto f = child(c, Production::DEF_OBJECT_FIELDS))
+            iot.fields = unplaced(built<AstList<FieldDecl>>(*f));
+        return makeType(std::move(iot));
+    }
+    case Production::DEF_INLINE_UNION: {
+        InlineUnionType iut;
+        iut.scopeName = scopeName;
+        if (auto u = child(c, Production::DEF_UNION_CANDIDATES))
+            iut.candidates = unplaced(built<AstList<UnionCandidate>>(*u));
+        return makeType(std::move(iut));
+    }
+    default: {
+        InlineVariantType ivt;
+        ivt.scopeName = scopeName;
+        if (auto v = child(c, Production::DEF_VARIANT_CANDIDATES))
+            ivt.candidates = unplaced(built<AstList<VariantCandidate>>(*v));
+        return makeType(std::move(ivt));
+    }
+    }
+}
+
+// ---- expressions
+
+static AstList<CallParam> callParams(Values c) {
+    return members<CallParam>(c, Production::CALL_PARAMETER);
+}
+
+static ExprNodePtr quote(Value& self, Values c) {
+    QuoteExpr q;
+    place(q, self);
+    switch (self.prod) {
+    case Production::CALL_QUOTE:
+        q.kind = QuoteExpr::Kind::Subquote;
+        q.invoke = primary(first(c));
+        break;
+    case Production::CALL_BLOCK_NOFAIL:  q.kind = QuoteExpr::Kind::BlockNoFail; break;
+    case Production::CALL_BLOCK_MAYFAIL: q.kind = QuoteExpr::Kind::BlockMayFail; break;
+    default:                             q.kind = QuoteExpr::Kind::BlockFail; break;
+    }
+    if (self.prod != Production::CALL_QUOTE) {
+        if (auto body = child(c, Production::CALL_GROUP)) q.group = built<CallGroup*>(*body);
+    }
+    return makeExpr(std::move(q));
+}
+
+// buildExprTerm, over values
+static ExprNodePtr exprTerm(Value*& pos, Value* end) {
+    Value* start = pos;
+    ExprNodePtr base = nullptr;
+    AstList<SuffixOp> suffixes;
+    for (; pos != end && pos->prod != Production::CALL_OPERATOR; ++pos) {
+        if (pos->prod == Production::CALL_EXPR_DEREF) {
+            SuffixOp sop; sop.kind = SuffixOp::Kind::Deref;
+            suffixes.push_back(std::move(sop));
+        } else if (pos->prod == Production::CALL_EXPR_INDEX) {
+            suffixes.push_back(built<SuffixOp>(*pos));
+        } else if (pos->prod == Production::CALL_EXPR_ADDR) {
+            SuffixOp sop; sop.kind = SuffixOp::Kind::Addr;
+            suffixes.push_back(std::move(sop));
+        } else if (!base) {
+            base = primary(pos);
+        }
+    }
+    if (!suffixes.empty() && base) {
+        SuffixExpr se;
+        place(se, *start);
+        se.base = base;
+        se.suffixes = std::move(suffixes);
+        return makeExpr(std::move(se));
+    }
+    return base;
+}
+
+// the operator token is the only child of a CALL_OPERATOR, so its first token
+static const OperatorInfo* operatorAt(const Value* pos, const Value* end) {
+    if (pos == end || pos->prod != Production::CALL_OPERATOR || !pos->first) return nullptr;
+    return findOperator(pos->first->type);
+}
+
+// buildOperatorExpr, over values
+static ExprNodePtr operatorExpr(Value*& pos, Value* end, int minPrec) {
+    Value* start = pos;
+    ExprNodePtr lhs = exprTerm(pos, end);
+    for (auto op = operatorAt(pos, end); op && op->precedence >= minPrec; op = operatorAt(pos, end)) {
+        int level = op->precedence;
+        BinaryExpr be;
+        if (start != end) place(be, *start);
+        be.first = lhs;
+        for (; op && op->precedence == level; op = operatorAt(pos, end)) {
+            BinaryExpr::OpTerm ot;
+            ot.op = pos->first->text;
+            ++pos;
+            ot.term = operatorExpr(pos, end, op->associativity == Associativity::Right ? level : level + 1);
+            be.rest.push_back(std::move(ot));
+        }
+        lhs = makeExpr(std::move(be));
+    }
+    return lhs;
+}
+
+static ExprNodePtr invocation(Value& self, Values c) {
+    switch (self.prod) {
+    case Production::CALL_COMMAND: {
+        CallCommandExpr cc;
+        place(cc, self);
+        if (auto tgt = child(c, Production::CALL_CMD_TARGET)) cc.target = built<ExprNodePtr>(*tgt);
+        cc.params = callParams(c);
+        return makeExpr(std::move(cc));
+    }
+    case Production::CALL_CONSTRUCTOR: {
+        CallConstructorExpr ce;
+        place(ce, self);
+        ce.typeName = typeOf(child(c, Production::TYPE_NAME_Q));
+        ce.params = callParams(c);
+        return makeExpr(std::move(ce));
+    }
+    case Production::CALL_VCOMMAND: {
+        CallVCommandExpr vc;
+        place(vc, self);
+        Value* last = nullptr;
+        for (Value& v : c) {
+            if (v.prod != Production::IDENTIFIER) continue;
+            if (last) vc.receivers.push_back(identText(last));
+            last = &v;
+        }
+        if (last) vc.name = identText(last);
+        vc.params = callParams(c);
+        return makeExpr(std::move(vc));
+    }
+    default: {
+        CallFailExpr cf;
+        place(cf, self);
+        if (auto expr = child(c, Production::CALL_EXPRESSION)) cf.expr = built<ExprNodePtr>(*expr);
+        return makeExpr(std::move(cf));
+    }
+    }
+}
+
+// ---- statements
+
+static Block block(Value& self, Values c) {
+    Block blk;
+    place(blk, self);
+    blk.kind = blockKindFromProd(self.prod);
+    if (self.prod == Production::DO_RECOVER_SPEC) {
+        if (auto spec = child(c, Production::RECOVER_SPEC)) {
+            Block& recover = built<Block>(*spec);
+            blk.recoverType = recover.recoverType;
+            blk.recoverIdent = std::move(recover.recoverIdent);
+            blk.recoverExpr = recover.recoverExpr;
+        }
+    }
+    if (auto body = child(c, Production::CALL_GROUP)) blk.body = built<CallGroup*>(*body);
+    return blk;
+}
+
+static Block recoverSpec(Values c) {
+    Block spec;
+    if (auto tnq = child(c, Production::TYPE_NAME_Q)) {
+        spec.recoverType = built<TypeNodePtr>(*tnq);
+        for (Value& v : c)
+            if (v.prod == Production::IDENTIFIER) spec.recoverIdent = identText(&v);
+    } else {
+        spec.recoverExpr = primary(first(c));
+    }
+    return spec;
+}
+
+// buildStatement
+static StatNode statement(Value& v) {
+    if (auto as = std::get_if<AssignStat>(&v.built)) return StatNode(std::move(*as));
+    if (auto blk = std::get_if<Block>(&v.built)) return StatNode(std::move(*blk));
+    ExprStat es;
+    place(es, v);
+    es.expr = primary(&v);
+    return StatNode(std::move(es));
+}
+
+static AssignStat assignment(Value& self, Values c) {
+    AssignStat as;
+    place(as, self);
+    if (Value* tgt = first(c)) {
+        IdentifierExpr ie;
+        ie.ident = identifier(tgt);
+        ie.isAlloc = tgt->prod == Production::ALLOC_IDENTIFIER;
+        place(ie, *tgt);
+        as.target = makeExpr(std::move(ie));
+    }
+    if (c.size() > 1) as.value = primary(&c[1]);
+    return as;
+}
+
+static CallGroup* callGroup(Value& self, Values c) {
+    auto cg = make<CallGroup>();
+    place(*cg, self);
+    for (Value& v : c) cg->statements.push_back(statement(v));
+    return cg;
+}
+
+// ---- commands
+
+static CmdParam cmdParm(Value& self, Values c) {
+    CmdParam cp;
+    if (auto var = child(c, Production::DEF_CMD_PARMTYPE_VAR)) cp = std::move(built<CmdParam>(*var));
+    else cp.type = typeOf(child(c, Production::DEF_CMD_PARMTYPE_NAME));
+    place(cp, self);
+    cp.name = text(child(c, Production::DEF_CMD_PARM_NAME));
+    return cp;
+}
+
+static CmdReceiver cmdReceiver(Value& self, Values c) {
+    CmdReceiver cr;
+    place(cr, self);
+    cr.type = typeOf(child(c, Production::DEF_CMD_PARMTYPE_NAME));
+    cr.name = text(child(c, Production::DEF_CMD_PARM_NAME));
+    return cr;
+}
+
+static CmdReceiver& receiverOf(Value& self, Values c) {
+    auto recv = child(c, Production::DEF_CMD_RECEIVER);
+    BUILD_ASSERT(recv, std::string(productionName(self.prod)) + " missing DEF_CMD_RECEIVER");
+    return built<CmdReceiver>(*recv);
+}
+
+// The regular form: DEF_CMD_REGULAR, and inlined in DEF_SUB and DEF_CMD_INTRINSIC
+static RegularSig regularSig(Value& self, Values c) {
+    RegularSig rs;
+    auto ns = child(c, Production::DEF_CMD_NAME_SPEC);
+    BUILD_ASSERT(ns, std::string(productionName(self.prod)) + " missing DEF_CMD_NAME_SPEC");
+    NameSpec& spec = built<NameSpec>(*ns);
+    rs.name = std::move(spec.name);
+    rs.failMode = spec.failMode;
+    if (auto parms = child(c, Production::DEF_CMD_PARMS)) {
+        ParamList& list = built<ParamList>(*parms);
+        rs.params = std::move(list.params);
+        rs.returnVal = std::move(list.returnVal);
+    }
+    if (auto imparms = child(c, Production::DEF_CMD_IMPARMS))
+        rs.implicitParams = std::move(built<ParamList>(*imparms).params);
+    return rs;
+}
+
+static CmdSignature signature(Value& self, Values c) {
+    switch (self.prod) {
+    case Production::DEF_CMD_REGULAR:
+        return regularSig(self, c);
+    case Production::DEF_CMD_VCOMMAND: {
+        VCommandSig vs;
+        auto recvs = child(c, Production::DEF_CMD_RECEIVERS);
+        BUILD_ASSERT(recvs, "DEF_CMD_VCOMMAND missing DEF_CMD_RECEIVERS");
+        vs.receivers = std::move(built<AstList<CmdReceiver>>(*recvs));
+        auto ns = child(c, Production::DEF_CMD_NAME_SPEC);
+        BUILD_ASSERT(ns, "DEF_CMD_VCOMMAND missing DEF_CMD_NAME_SPEC");
+        vs.name = std::move(built<NameSpec>(*ns).name);
+        vs.failMode = built<NameSpec>(*ns).failMode;
+        if (auto parms = child(c, Production::DEF_CMD_PARMS))
+            vs.params = std::move(built<ParamList>(*parms).params);
+        if (auto retval = child(c, Production::DEF_CMD_RETVAL)) vs.returnVal = text(retval);
+        if (auto imparms = child(c, Production::DEF_CMD_IMPARMS))
+            vs.implicitParams = std::move(built<ParamList>(*imparms).params);
+        return vs;
+    }
+    case Production::DEF_CMD_CTOR: {
+        ConstructorSig cs;
+        cs.receiver = std::move(receiverOf(self, c));
+        cs.params = members<CmdParam>(c, Production::DEF_CMD_PARM);
+        return cs;
+    }
+    case Production::DEF_CMD_RECEIVER_ATSTACK: {
+        DestructorSig ds;
+        ds.receiver = std::move(receiverOf(self, c));
+        return ds;
+    }
+    default: {
+        FailHandlerSig fs;
+        fs.receiver = std::move(receiverOf(self, c));
+        return fs;
+    }
+    }
+}
+
+static CmdSignature& signatureOf(Value& self, Values c) {
+    for (Value& v : c) {
+        auto p = v.prod;
+        if (p == Production::DEF_CMD_REGULAR || p == Production::DEF_CMD_VCOMMAND ||
+            p == Production::DEF_CMD_CTOR || p == Production::DEF_CMD_RECEIVER_ATSTACK ||
+            p == Production::DEF_CMD_RECEIVER_ATSTACK_FAIL)
+            return built<CmdSignature>(v);
+    }
+    BUILD_ASSERT(false, std::string(productionName(self.prod)) + " missing signature child");
+    throw std::logic_error("unreachable");
+}
+
+// buildCmdDefFromNode
+static CmdDef cmdDef(Value& self, Values c) {
+    CmdDef cd;
+    place(cd, self);
+    if (self.prod == Production::DEF_SUB) cd.signature = regularSig(self, c);
+    else cd.signature = std::move(signatureOf(self, c));
+    if (child(c, Production::DEF_CMD_BODY_DEFERRED)) return cd;
+    auto body = child(c, Production::DEF_CMD_BODY);
+    BUILD_ASSERT(body, "DEF_CMD/DEF_SUB missing DEF_CMD_BODY");
+    cd.body = built<CmdBody*>(*body);
+    return cd;
+}
+
+static CmdBody* cmdBody(Value& self, Values c) {
+    auto body = make<CmdBody>();
+    place(*body, self);
+    if (auto subs = child(c, Production::DEF_SUBS)) body->subs = std::move(built<AstList<CmdDef>>(*subs));
+    if (child(c, Production::DEF_CMD_EMPTY)) {
+        body->isEmpty = true;
+    } else if (auto cg = child(c, Production::CALL_GROUP)) {
+        body->group = built<CallGroup*>(*cg);
+    }
+    return body;
+}
+
+// ---- definitions
+
+// The name of a DEF_*_NAME wrapper around a TYPEDEF_NAME_Q, a `name` action of its own
+static std::string& nameOf(Value& self, Values c, Production p) {
+    auto nm = child(c, p);
+    BUILD_ASSERT(nm, std::string(productionName(self.prod)) + " missing " + productionName(p));
+    return built<std::string>(*nm);
+}
+
+template<typename List>
+static List& listOf(Value& self, Values c, Production p) {
+    auto list = child(c, p);
+    BUILD_ASSERT(list, std::string(productionName(self.prod)) + " missing " + productionName(p));
+    return built<List>(*list);
+}
+
+static TopLevelDef definition(Value& self, Values c) {
+    switch (self.prod) {
+    case Production::DEF_ALIAS: {
+        AliasDecl ad;
+        place(ad, self);
+        for (Value& v : c) {
+            if (v.prod == Production::TYPEDEF_NAME_Q) { ad.name = built<std::string>(v); break; }
+            if (v.prod == Production::TYPENAME || v.prod == Production::QUALIFIED_TYPENAME) {
+                ad.name = typeName(&v);
+                break;
             }
-            cu->imports.push_back(imp);
-            continue;
         }
-        // All other top-level definitions
-        cu->definitions.push_back(buildTopLevel(c));
+        BUILD_ASSERT(!ad.name.empty(), "DEF_ALIAS missing name");
+        auto te = child(c, Production::TYPE_EXPR);
+        BUILD_ASSERT(te, "DEF_ALIAS missing TYPE_EXPR");
+        ad.type = built<TypeNodePtr>(*te);
+        return ad;
+    }
+    case Production::DEF_DOMAIN: {
+        DomainDecl dd;
+        place(dd, self);
+        dd.name = nameOf(self, c, Production::DEF_DOMAIN_NAME);
+        auto par = child(c, Production::DEF_DOMAIN_PARENT);
+        BUILD_ASSERT(par, "DEF_DOMAIN missing DEF_DOMAIN_PARENT");
+        dd.parent = built<TypeNodePtr>(*par);
+        return dd;
+    }
+    case Production::DEF_ENUM: {
+        EnumDecl ed;
+        place(ed, self);
+        if (auto etn = child(c, Production::DEF_ENUM_TYPENAME)) ed.enumTypeName = text(etn);
+        if (auto en = child(c, Production::DEF_ENUM_NAME)) ed.enumName = text(en);
+        for (size_t i = 0; i < c.size(); ++i) {
+            if (c[i].prod != Production::DEF_ENUM_ITEM_NAME) continue;
+            EnumItem item;
+            item.name = text(&c[i]);
+            place(item, c[i]);
+            if (i + 1 < c.size() && isLiteralProd(c[i + 1].prod)) item.value = text(&c[i + 1]);
+            ed.items.push_back(std::move(item));
+        }
+        return ed;
+    }
+    case Production::DEF_RECORD: {
+        RecordDecl rd;
+        place(rd, self);
+        rd.name = nameOf(self, c, Production::DEF_RECORD_NAME);
+        rd.fields = std::move(listOf<AstList<FieldDecl>>(self, c, Production::DEF_RECORD_FIELDS));
+        return rd;
+    }
+    case Production::DEF_OBJECT: {
+        ObjectDecl od;
+        place(od, self);
+        od.name = nameOf(self, c, Production::DEF_OBJECT_NAME);
+        od.fields = std::move(listOf<AstList<FieldDecl>>(self, c, Production::DEF_OBJECT_FIELDS));
+        return od;
+    }
+    case Production::DEF_UNION: {
+        UnionDecl ud;
+        place(ud, self);
+        ud.name = nameOf(self, c, Production::DEF_UNION_NAME);
+        ud.candidates = std::move(listOf<AstList<UnionCandidate>>(self, c, Production::DEF_UNION_CANDIDATES));
+        return ud;
+    }
+    case Production::DEF_VARIANT: {
+        VariantDecl vd;
+        place(vd, self);
+        vd.name = nameOf(self, c, Production::DEF_VARIANT_NAME);
+        vd.candidates =
+            std::move(listOf<AstList<VariantCandidate>>(self, c, Production::DEF_VARIANT_CANDIDATES));
+        return vd;
+    }
+    case Production::DEF_INSTANCE: {
+        InstanceDecl id;
+        place(id, self);
+        id.name = nameOf(self, c, Production::DEF_INSTANCE_NAME);
+        id.types = std::move(listOf<AstList<InstanceType>>(self, c, Production::DEF_INSTANCE_TYPES));
+        return id;
+    }
+    case Production::DEF_CMD_DECL: {
+        CmdDecl cd;
+        place(cd, self);
+        cd.signature = std::move(signatureOf(self, c));
+        return cd;
+    }
+    case Production::DEF_CMD_INTRINSIC: {
+        IntrinsicDecl intd;
+        place(intd, self);
+        intd.signature = regularSig(self, c);
+        return intd;
+    }
+    case Production::DEF_CMD:
+        return cmdDef(self, c);
+    case Production::DEF_CLASS: {
+        ClassDecl cls;
+        place(cls, self);
+        cls.name = nameOf(self, c, Production::DEF_CLASS_NAME);
+        cls.members = std::move(listOf<AstList<ClassMember>>(self, c, Production::DEF_CLASS_CMDS));
+        return cls;
+    }
+    case Production::DEF_PROGRAM: {
+        ProgramDecl pd;
+        place(pd, self);
+        BUILD_ASSERT(!c.empty(), "DEF_PROGRAM missing entry-point invoke child");
+        pd.entryPoint = primary(first(c));
+        return pd;
+    }
+    default: {
+        TestDecl td;
+        place(td, self);
+        auto str = child(c, Production::STRING);
+        BUILD_ASSERT(str, "DEF_TEST missing STRING label");
+        td.label = text(str);
+        auto cg = child(c, Production::CALL_GROUP);
+        BUILD_ASSERT(cg, "DEF_TEST missing CALL_GROUP body");
+        td.body = built<CallGroup*>(*cg);
+        return td;
+    }
+    }
+}
+
+static AstList<InstanceType> instanceTypes(Values c) {
+    AstList<InstanceType> types;
+    InstanceType cur;
+    for (Value& v : c) {
+        if (v.prod == Production::TYPENAME || v.prod == Production::QUALIFIED_TYPENAME) {
+            if (!cur.typeName.empty()) { types.push_back(std::move(cur)); cur = {}; }
+            cur.typeName = typeName(&v);
+            place(cur, v);
+        } else if (v.prod == Production::DEF_INSTANCE_DELEGATE) {
+            cur.delegate = built<std::string>(v);
+        }
+    }
+    if (!cur.typeName.empty()) types.push_back(std::move(cur));
+    return types;
+}
+
+static AstList<ClassMember> classMembers(Values c) {
+    AstList<ClassMember> list;
+    for (Value& v : c) {
+        if (v.prod == Production::DEF_CMD_DECL)
+            list.push_back(std::move(std::get<CmdDecl>(built<TopLevelDef>(v))));
+        else if (v.prod == Production::DEF_CMD)
+            list.push_back(std::move(std::get<CmdDef>(built<TopLevelDef>(v))));
     }
+    return list;
+}
 
+static CompilationUnit* unit(Value& self, Values c) {
+    auto cu = make<CompilationUnit>();
+    cu->context = building;
+    place(*cu, self);
+    for (Value& v : c) {
+        if (v.prod == Production::DEF_MODULE) cu->module = built<ModuleDecl*>(v);
+        else if (v.prod == Production::DEF_IMPORT) cu->imports.push_back(built<ImportDecl*>(v));
+        // definitions the parser recovered from have already been reported
+        else if (v.prod != Production::PARSE_ERROR)
+            cu->definitions.push_back(std::move(built<TopLevelDef>(v)));
+    }
     return cu;
 }
 
-} // namespace basis
\ No newline at end of file
+// The build action of every group production: what `self` builds from `c`, its
+// children. Groups without one build nothing, and their parent reads their
+// children's tokens as the builders do. typesBefore is how many types there were
+// when the group began.
+static Built reduce(Value& self, Values c, size_t typesBefore) {
+    switch (self.prod) {
+    // names
+    case Production::QUALIFIED_TYPENAME: {
+        std::string r;
+        for (Value& v : c) {
+            if (!r.empty()) r += "::";
+            r += text(&v);
+        }
+        return r;
+    }
+    case Production::IDENTIFIER: {
+        Identifier id;
+        for (Value& v : c) {
+            if (v.prod == Production::IDENTIFIER_QUALIFIER) id.qualifiers.push_back(text(&v));
+            else if (v.prod == Production::IDENTIFIER_NAME) id.name = text(&v);
+        }
+        return id;
+    }
+    case Production::ALLOC_IDENTIFIER:
+        return identifier(first(c));
+    case Production::TYPEDEF_NAME_Q:
+    case Production::DEF_DOMAIN_NAME:
+    case Production::DEF_MODULE_NAME:
+    case Production::DEF_IMPORT_STANDARD:
+        return typeName(first(c));
+    case Production::DEF_RECORD_NAME:
+    case Production::DEF_OBJECT_NAME:
+    case Production::DEF_UNION_NAME:
+    case Production::DEF_VARIANT_NAME:
+    case Production::DEF_INSTANCE_NAME: {
+        // collectDefName
+        Value* nm = first(c);
+        if (nm && nm->prod == Production::TYPEDEF_NAME_Q) return built<std::string>(*nm);
+        return typeName(nm);
+    }
+    case Production::DEF_INLINE_SCOPE_NAME:
+        return text(child(c, Production::IDENTIFIER_NAME));
+    case Production::DEF_CLASS_NAME:
+    case Production::DEF_IMPORT_ALIAS:
+    case Production::DEF_DOMAIN_PARENT_RANGE_SIZE:
+        return text(first(c));
+    case Production::DEF_INSTANCE_DELEGATE:
+        return identText(first(c));
+
+    // types
+    case Production::TYPEDEF_PARMS:
+        // a definition's parameters: buildAst builds no types for them
+        building->dropTypes(typesBefore);
+        return {};
+    case Production::TYPE_EXPR_RANGE:
+        return rangeSize(c);
+    case Production::TYPE_ARG_TYPE:
+        return typeOf(child(c, Production::TYPE_NAME_Q));
+    case Production::TYPE_ARG_VALUE: {
+        NamedType val;
+        val.name = text(first(c));
+        return makeType(std::move(val));
+    }
+    case Production::TYPE_NAME_ARGS:
+        return typeNameArgs(c);
+    case Production::TYPE_NAME_Q:
+        return typeNameQ(c);
+    case Production::TYPE_CMDEXPR_ARG:
+        return cmdExprArg(c);
+    case Production::TYPE_EXPR_CMD:
+        return cmdType(c);
+    case Production::TYPE_EXPR:
+        return typeExpr(c, Production::TYPE_EXPR);
+    case Production::TYPE_EXPR_DOMAIN:
+        return typeExpr(c, Production::TYPE_EXPR_DOMAIN);
+    case Production::DEF_INLINE_RECORD:
+    case Production::DEF_INLINE_OBJECT:
+    case Production::DEF_INLINE_UNION:
+    case Production::DEF_INLINE_VARIANT:
+        return inlineType(self, c);
+    case Production::DEF_RECORD_FIELD_DOMAIN:
+    case Production::DEF_OBJECT_FIELD_TYPE:
+    case Production::DEF_UNION_CANDIDATE_DOMAIN:
+    case Production::DEF_VARIANT_CANDIDATE_TYPE:
+    case Production::DEF_CMD_PARMTYPE_NAME:
+        return typeOf(first(c));
+    case Production::DEF_DOMAIN_PARENT_RANGE_TYPE:
+        return namedType(typeName(first(c)));
+    case Production::DEF_DOMAIN_PARENT_RANGE: {
+        RangeType rt;
+        if (auto sz = child(c, Production::DEF_DOMAIN_PARENT_RANGE_SIZE)) rt.size = built<std::string>(*sz);
+        if (auto et = child(c, Production::DEF_DOMAIN_PARENT_RANGE_TYPE))
+            rt.element = built<TypeNodePtr>(*et);
+        return makeType(std::move(rt));
+    }
+    case Production::DEF_DOMAIN_PARENT: {
+        Value* tn = first(c);
+        if (tn && (tn->prod == Production::TYPENAME || tn->prod == Production::QUALIFIED_TYPENAME))
+            return namedType(typeName(tn));
+        if (tn && tn->prod == Production::DEF_DOMAIN_PARENT_RANGE) return built<TypeNodePtr>(*tn);
+        return TypeNodePtr{};
+    }
+
+    // fields and candidates
+    case Production::DEF_RECORD_FIELD:
+        return member<FieldDecl>(self, c, Production::DEF_RECORD_FIELD_DOMAIN,
+                                 Production::DEF_RECORD_FIELD_NAME);
+    case Production::DEF_OBJECT_FIELD:
+        return member<FieldDecl>(self, c, Production::DEF_OBJECT_FIELD_TYPE,
+                                 Production::DEF_OBJECT_FIELD_NAME);
+    case Production::DEF_UNION_CANDIDATE:
+        return member<UnionCandidate>(self, c, Production::DEF_UNION_CANDIDATE_DOMAIN,
+                                      Production::DEF_UNION_CANDIDATE_NAME);
+    case Production::DEF_VARIANT_CANDIDATE:
+        return member<VariantCandidate>(self, c, Production::DEF_VARIANT_CANDIDATE_TYPE,
+                                        Production::DEF_VARIANT_CANDIDATE_NAME);
+    case Production::DEF_RECORD_FIELDS:
+        return members<FieldDecl>(c, Production::DEF_RECORD_FIELD);
+    case Production::DEF_OBJECT_FIELDS:
+        return members<FieldDecl>(c, Production::DEF_OBJECT_FIELD);
+    case Production::DEF_UNION_CANDIDATES:
+        return members<UnionCandidate>(c, Production::DEF_UNION_CANDIDATE);
+    case Production::DEF_VARIANT_CANDIDATES:
+        return members<VariantCandidate>(c, Production::DEF_VARIANT_CANDIDATE);
+    case Production::DEF_INSTANCE_TYPES:
+        return instanceTypes(c);
+
+    // commands
+    case Production::DEF_CMD_PARMTYPE_VAR: {
+        CmdParam var;
+        var.isTypeVar = true;
+        var.typeVarName = text(first(c));
+        var.type = typeOf(child(c, Production::DEF_CMD_PARMTYPE_NAME));
+        return var;
+    }
+    case Production::DEF_CMD_PARM:
+        return cmdParm(self, c);
+    case Production::DEF_CMD_RECEIVER:
+        return cmdReceiver(self, c);
+    case Production::DEF_CMD_RECEIVERS:
+        return members<CmdReceiver>(c, Production::DEF_CMD_RECEIVER);
+    case Production::DEF_CMD_PARMS:
+    case Production::DEF_CMD_IMPARMS: {
+        ParamList list;
+        list.params = members<CmdParam>(c, Production::DEF_CMD_PARM);
+        list.returnVal = text(child(c, Production::DEF_CMD_RETVAL));
+        return list;
+    }
+    case Production::DEF_CMD_NAME_SPEC: {
+        NameSpec spec;
+        if      (child(c, Production::DEF_CMD_MAYFAIL)) spec.failMode = FailMode::MayFail;
+        else if (child(c, Production::DEF_CMD_FAILS))   spec.failMode = FailMode::Fails;
+        spec.name = text(child(c, Production::DEF_CMD_NAME));
+        return spec;
+    }
+    case Production::DEF_CMD_REGULAR:
+    case Production::DEF_CMD_VCOMMAND:
+    case Production::DEF_CMD_CTOR:
+    case Production::DEF_CMD_RECEIVER_ATSTACK:
+    case Production::DEF_CMD_RECEIVER_ATSTACK_FAIL:
+        return signature(self, c);
+    case Production::DEF_SUB:
+        return TopLevelDef(cmdDef(self, c));
+    case Production::DEF_SUBS: {
+        AstList<CmdDef> subs;
+        for (Value& v : c)
+            if (v.prod == Production::DEF_SUB)
+                subs.push_back(std::move(std::get<CmdDef>(built<TopLevelDef>(v))));
+        return subs;
+    }
+    case Production::DEF_CMD_BODY:
+        return cmdBody(self, c);
+    case Production::DEF_CLASS_CMDS:
+        return classMembers(c);
+
+    // expressions
+    case Production::CALL_PARM_EXPR:
+    case Production::CALL_CMD_TARGET:
+    case Production::CALL_EXPRINDEX_LOC:
+    case Production::CALL_EXPRINDEX_EXT:
+    case Production::SUBCALL_EXPRESSION:
+        return primary(first(c));
+    case Production::CALL_PARAMETER: {
+        CallParam cp;
+        place(cp, self);
+        Value* inner = first(c);
+        if (inner && inner->prod == Production::CALL_PARM_EMPTY) cp.isEmpty = true;
+        else if (inner && inner->prod == Production::CALL_PARM_EXPR) cp.expr = built<ExprNodePtr>(*inner);
+        return cp;
+    }
+    case Production::CALL_EXPR_INDEX: {
+        SuffixOp sop;
+        sop.kind = SuffixOp::Kind::Index;
+        if (auto loc = child(c, Production::CALL_EXPRINDEX_LOC)) sop.indexLoc = built<ExprNodePtr>(*loc);
+        if (auto ext = child(c, Production::CALL_EXPRINDEX_EXT)) sop.indexExt = built<ExprNodePtr>(*ext);
+        return sop;
+    }
+    case Production::ENUM_DEREF: {
+        EnumDerefExpr ed;
+        place(ed, self);
+        ed.typeName = typeName(first(c));
+        ed.memberName = identText(c.size() > 1 ? &c[1] : nullptr);
+        return makeExpr(std::move(ed));
+    }
+    case Production::CALL_QUOTE:
+    case Production::CALL_BLOCK_NOFAIL:
+    case Production::CALL_BLOCK_MAYFAIL:
+    case Production::CALL_BLOCK_FAIL:
+        return quote(self, c);
+    case Production::CALL_CMD_LITERAL: {
+        CmdLiteralExpr lit;
+        place(lit, self);
+        if      (child(c, Production::CALL_CMDLIT_MAYFAIL))  lit.kind = CmdLiteralExpr::Kind::MayFail;
+        else if (child(c, Production::CALL_CMDLIT_MUSTFAIL)) lit.kind = CmdLiteralExpr::Kind::MustFail;
+        for (Value& v : c) {
+            if (v.prod == Production::DEF_CMD_PARM) lit.params.push_back(std::move(built<CmdParam>(v)));
+            else if (v.prod == Production::CALL_GROUP) lit.body = built<CallGroup*>(v);
+        }
+        return makeExpr(std::move(lit));
+    }
+    case Production::CALL_COMMAND:
+    case Production::CALL_CONSTRUCTOR:
+    case Production::CALL_VCOMMAND:
+    case Production::CALL_FAIL:
+        return invocation(self, c);
+    case Production::CALL_EXPRESSION: {
+        if (c.empty()) return ExprNodePtr{};
+        Value* pos = c.data();
+        return operatorExpr(pos, c.data() + c.size(), 0);
+    }
+
+    // statements
+    case Production::CALL_ASSIGNMENT:
+        return assignment(self, c);
+    case Production::RECOVER_SPEC:
+        return recoverSpec(c);
+    case Production::DO_WHEN:
+    case Production::DO_WHEN_MULTI:
+    case Production::DO_WHEN_FAIL:
+    case Production::DO_WHEN_SELECT:
+    case Production::DO_ELSE:
+    case Production::DO_BLOCK:
+    case Production::DO_REWIND:
+    case Production::DO_RECOVER:
+    case Production::DO_RECOVER_SPEC:
+    case Production::DO_ON_EXIT:
+    case Production::DO_ON_EXIT_FAIL:
+        return block(self, c);
+    case Production::CALL_GROUP:
+        return callGroup(self, c);
+
+    // the unit
+    case Production::DEF_MODULE: {
+        auto mod = make<ModuleDecl>();
+        place(*mod, self);
+        if (auto mn = child(c, Production::DEF_MODULE_NAME)) mod->name = built<std::string>(*mn);
+        return mod;
+    }
+    case Production::DEF_IMPORT: {
+        auto imp = make<ImportDecl>();
+        place(*imp, self);
+        for (Value& v : c) {
+            if (v.prod == Production::DEF_IMPORT_ALIAS) {
+                imp->alias = built<std::string>(v);
+            } else if (v.prod == Production::DEF_IMPORT_FILENAME) {
+                imp->kind = ImportDecl::Kind::File;
+                imp->path = text(&v);
+            } else if (v.prod == Production::DEF_IMPORT_STANDARD) {
+                imp->kind = ImportDecl::Kind::Standard;
+                imp->name = built<std::string>(v);
+            }
+        }
+        return imp;
+    }
+    case Production::DEF_ALIAS:
+    case Production::DEF_DOMAIN:
+    case Production::DEF_ENUM:
+    case Production::DEF_RECORD:
+    case Production::DEF_OBJECT:
+    case Production::DEF_UNION:
+    case Production::DEF_VARIANT:
+    case Production::DEF_INSTANCE:
+    case Production::DEF_CMD_DECL:
+    case Production::DEF_CMD_INTRINSIC:
+    case Production::DEF_CMD:
+    case Production::DEF_CLASS:
+    case Production::DEF_PROGRAM:
+    case Production::DEF_TEST:
+        return definition(self, c);
+    case Production::COMPILATION_UNIT:
+        return unit(self, c);
+    default:
+        return {};
+    }
+}
+
+// The actions ActionParser reports to: a stack of the values of the nodes parsed
+// so far, whose top a group reduces to its own value.
+class BuildActions {
+public:
+    struct Mark {
+        size_t values = 0;
+        size_t types = 0;
+    };
+
+    Mark mark() const { return {values.size(), building->typeNodes.size()}; }
+
+    void rollback(const Mark& mark) {
+        values.erase(values.begin() + static_cast<ptrdiff_t>(mark.values), values.end());
+        building->dropTypes(mark.types);
+    }
+
+    void token(Production prod, const Token* token) {
+        values.push_back({prod, token, token, {}});
+    }
+
+    void group(Production prod, const Mark& mark) {
+        Values children(values.data() + mark.values, values.size() - mark.values);
+        Value self{prod, nullptr, children.empty() ? nullptr : children[0].first, {}};
+        self.built = reduce(self, children, mark.types);
+        values.erase(values.begin() + static_cast<ptrdiff_t>(mark.values), values.end());
+        values.push_back(std::move(self));
+    }
+
+    // As renames only tokens in this grammar, never a group that built something
+    bool rename(Production prod, const Mark& mark) {
+        if (values.size() == mark.values) return false;
+        values[mark.values].prod = prod;
+        return true;
+    }
+
+    CompilationUnit* unit() {
+        BUILD_ASSERT(values.size() == 1, "parseAst: the parse left no single unit");
+        return built<CompilationUnit*>(values.front());
+    }
+
+private:
+    std::vector<Value> values;
+};
+
+// Numbers the expressions of what it visits as buildAst does, each one after the
+// expressions below it, in the order of the fields that hold them.
+struct NumberExpressions {
+    AstContext& context;
+
+    void operator()(ExprNode*& p) {
+        if (!p) return;
+        (*this)(p->v);
+        p->id = static_cast<NodeId>(context.exprNodes.size());
+        context.exprNodes.push_back(p);
+    }
+    void operator()(TypeNode*&) {}
+    template<typename T> void operator()(T*& p) { if (p) visitFields(*this, *p); }
+    template<typename T> void operator()(AstList<T>& list) { for (auto& e : list) (*this)(e); }
+    template<typename... Ts> void operator()(std::variant<Ts...>& v) {
+        std::visit([this](auto& alt) { visitFields(*this, alt); }, v);
+    }
+    void operator()(std::string&) {}
+    void operator()(std::optional<std::string>&) {}
+    template<typename T> requires std::is_class_v<T> void operator()(T& n) { visitFields(*this, n); }
+    template<typename T> requires (!std::is_class_v<T>) void operator()(T&) {}
+};
+
+std::shared_ptr<CompilationUnit> parseAst(const std::list<spToken>& tokens, Diagnostics& diags) {
+    auto context = std::make_shared<AstContext>();
+    Building scope(*context);
+    TokenIndex index(tokens);
+    BuildActions actions;
+    ActionParser<BuildActions> parser(index, actions, Parser::defaultMaxDepth);
+
+    TokenPos pos = 0;
+    TokenPos furthest = 0;
+    const ParseFn* furthestParser = nullptr;
+    bool parsed = parser.run(getGrammar().COMPILATION_UNIT.get(), &pos, index.end(),
+                             &furthest, &furthestParser);
+    if (parser.depthExceeded()) {
+        diags.report(nestingTooDeep(parser.depthExceededAt(), Parser::defaultMaxDepth));
+        return nullptr;
+    }
+    if (!parsed || pos != index.end()) {
+        diags.report(unexpectedToken(furthest == index.end() ? nullptr : index[furthest]));
+        return nullptr;
+    }
+
+    CompilationUnit* cu = actions.unit();
+    NumberExpressions number{*context};
+    number(*cu);
+    return std::shared_ptr<CompilationUnit>(context, cu);
+}
+
+} // namespace basis
@@ -1,15 +1,44 @@
 #ifndef ASTBUILDER_H
 #define ASTBUILDER_H
 
+#include <list>
+
 #include "Ast.h"
+#include "AstContext.h"
+#include "Diagnostic.h"
 #include "ParseObject.h"
+#include "WorkStealingPool.h"
 
 namespace basis {
 
+    // Expressions, types and blocks nested deeper than this fail to build with a
+    // std::logic_error rather than exhaust the stack of the builders or of the
+    // passes that walk the AST recursively. Parser::defaultMaxDepth keeps what the
+    // parser accepts within it.
+    constexpr size_t maxBuildNesting = 4096;
+
     // Convert the ParseTree rooted at a COMPILATION_UNIT node into an AST.
     // Returns nullptr if pt is null or does not have production COMPILATION_UNIT.
+    // PARSE_ERROR nodes left by a recovering parse are skipped, and a command whose
+    // body is still deferred (see LazyParse.h) gets a null CmdDef::body.
     std::shared_ptr<CompilationUnit> buildAst(const spParseTree& pt);
 
+    // The same, building the top-level definitions in parallel on `pool`. Each
+    // definition goes into its own slot of CompilationUnit::definitions, and the
+    // nodes are then numbered and interned in source order, so the AST and its
+    // NodeIds are those buildAst makes. If definitions fail to build, the
+    // exception of the first of them in source order is rethrown.
+    std::shared_ptr<CompilationUnit> buildAst(const spParseTree& pt, WorkStealingPool& pool);
+
+    // Parse tokens as a COMPILATION_UNIT and build the AST as the parse goes: each
+    // group production has a build action that makes its part of the AST from what
+    // its children built, so no ParseTree is made at all (see ActionParser.h). What
+    // a backtracking parse backs out of is dropped, its types included. Produces the
+    // same AST, NodeIds included, as buildAst on the full parse tree. If the tokens
+    // do not form a complete compilation unit, reports the furthest failure to diags
+    // and returns nullptr.
+    std::shared_ptr<CompilationUnit> parseAst(const std::list<spToken>& tokens, Diagnostics& diags);
+
 } // namespace basis
 
 #endif // ASTBUILDER_H
@@ -0,0 +1,28 @@
+#include "AstContext.h"
+
+using namespace basis;
+
+TypeNode* AstContext::makeType(TypeNode::Variant&& type) {
+    uint64_t hash = TypeInterner::hash(type);
+    if (TypeNode* existing = types.find(type, hash)) return existing;
+    TypeNode* node = arena.make<TypeNode>(std::move(type));
+    node->hash = hash;
+    node->id = static_cast<NodeId>(typeNodes.size());
+    typeNodes.push_back(node);
+    types.insert(node);
+    return node;
+}
+
+ExprNode* AstContext::makeExpr(ExprNode::Variant&& expr) {
+    ExprNode* node = arena.make<ExprNode>(std::move(expr));
+    node->id = static_cast<NodeId>(exprNodes.size());
+    exprNodes.push_back(node);
+    return node;
+}
+
+void AstContext::dropTypes(size_t count) {
+    while (typeNodes.size() > count) {
+        types.erase(typeNodes.back());
+        typeNodes.pop_back();
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef ASTCONTEXT_H
+#define ASTCONTEXT_H
+
+#include <memory>
+#include <vector>
+
+#include "Ast.h"
+#include "AstArena.h"
+#include "TypeInterner.h"
+
+namespace basis {
+
+// Owns the memory of one AST: buildAst makes the CompilationUnit, its nodes and
+// their child lists in the arena, so building allocates in large blocks and
+// tearing down frees them at once. It also numbers the TypeNodes and ExprNodes
+// in the order it makes them, which is the same for the same input, and interns
+// the types, so each distinct type has one TypeNode and one NodeId.
+struct AstContext {
+    // Contexts that definitions were built in by a parallel buildAst; their arenas
+    // hold those definitions' nodes and lists. Declared first so that they outlive
+    // the arena, whose teardown destroys the CompilationUnit.
+    std::vector<std::unique_ptr<AstContext>> parts;
+    AstArena               arena;
+    TypeInterner           types;
+    std::vector<TypeNode*> typeNodes;   // by NodeId
+    std::vector<ExprNode*> exprNodes;   // by NodeId
+
+    // The canonical node of a type whose children are canonical already, made
+    // and numbered the first time the type is seen.
+    TypeNode* makeType(TypeNode::Variant&& type);
+    // A new expression node with the next NodeId.
+    ExprNode* makeExpr(ExprNode::Variant&& expr);
+    // Forget the types made since there were `count`: they are no longer numbered
+    // or interned, though their memory stays in the arena. For a build that backs
+    // out of what it made, as parseAst does when the parse backtracks.
+    void dropTypes(size_t count);
+
+    template<typename Node> const std::vector<Node*>& nodes() const;
+};
+
+template<> inline const std::vector<TypeNode*>& AstContext::nodes<TypeNode>() const { return typeNodes; }
+template<> inline const std::vector<ExprNode*>& AstContext::nodes<ExprNode>() const { return exprNodes; }
+
+} // namespace basis
+
+#endif // ASTCONTEXT_H
@@ -0,0 +1,175 @@
+#ifndef ASTFIELDS_H
+#define ASTFIELDS_H
+
+#include "Ast.h"
+
+namespace basis {
+
+// The fields of each AST structure, in declaration order, for code that walks an
+// AST generically: visitFields(a, node) calls a(field) for every field, and the
+// visitor decides how to treat scalars, strings, lists, variants and pointers.
+// TypeNode and ExprNode pointers are fields like any other; a visitor that wants
+// to follow them calls visitFields on node->v itself. CompilationUnit::context
+// and the structural hashes are not fields. Positions go through visitLocation,
+// which argument-dependent lookup also finds beside the visitor, so a visitor
+// that ignores them overloads it for its own type.
+
+template<typename A> void visitLocation(A& a, Located& n) { a(n.line); a(n.col); }
+
+template<typename A> void visitFields(A& a, EnumItem& n) {
+    visitLocation(a, n); a(n.name); a(n.value);
+}
+template<typename A> void visitFields(A& a, FieldDecl& n) {
+    visitLocation(a, n); a(n.type); a(n.name);
+}
+template<typename A> void visitFields(A& a, UnionCandidate& n) {
+    visitLocation(a, n); a(n.domain); a(n.name);
+}
+template<typename A> void visitFields(A& a, VariantCandidate& n) {
+    visitLocation(a, n); a(n.type); a(n.name);
+}
+template<typename A> void visitFields(A& a, InstanceType& n) {
+    visitLocation(a, n); a(n.typeName); a(n.delegate);
+}
+template<typename A> void visitFields(A& a, CmdParam& n) {
+    visitLocation(a, n); a(n.type); a(n.name); a(n.isTypeVar); a(n.typeVarName);
+}
+template<typename A> void visitFields(A& a, CmdReceiver& n) {
+    visitLocation(a, n); a(n.type); a(n.name);
+}
+template<typename A> void visitFields(A& a, CallParam& n) {
+    visitLocation(a, n); a(n.isEmpty); a(n.expr);
+}
+template<typename A> void visitFields(A& a, SuffixOp& n) {
+    a(n.kind); a(n.indexLoc); a(n.indexExt);
+}
+
+// types
+template<typename A> void visitFields(A& a, NamedType& n) {
+    a(n.name); a(n.typeArgs); a(n.writeable);
+}
+template<typename A> void visitFields(A& a, PtrType& n) { a(n.depth); a(n.inner); }
+template<typename A> void visitFields(A& a, RangeType& n) { a(n.size); a(n.element); }
+template<typename A> void visitFields(A& a, CmdTypeArg& n) { a(n.type); a(n.writeable); }
+template<typename A> void visitFields(A& a, CmdType& n) { a(n.kind); a(n.args); }
+template<typename A> void visitFields(A& a, InlineRecordType& n) { a(n.scopeName); a(n.fields); }
+template<typename A> void visitFields(A& a, InlineObjectType& n) { a(n.scopeName); a(n.fields); }
+template<typename A> void visitFields(A& a, InlineUnionType& n) { a(n.scopeName); a(n.candidates); }
+template<typename A> void visitFields(A& a, InlineVariantType& n) {
+    a(n.scopeName); a(n.candidates);
+}
+
+// expressions
+template<typename A> void visitFields(A& a, LiteralExpr& n)    { visitLocation(a, n); a(n.text); }
+template<typename A> void visitFields(A& a, Identifier& n)     { a(n.qualifiers); a(n.name); }
+template<typename A> void visitFields(A& a, IdentifierExpr& n) {
+    visitLocation(a, n); a(n.ident); a(n.isAlloc);
+}
+template<typename A> void visitFields(A& a, EnumDerefExpr& n) {
+    visitLocation(a, n); a(n.typeName); a(n.memberName);
+}
+template<typename A> void visitFields(A& a, CallCommandExpr& n) {
+    visitLocation(a, n); a(n.target); a(n.params);
+}
+template<typename A> void visitFields(A& a, CallConstructorExpr& n) {
+    visitLocation(a, n); a(n.typeName); a(n.params);
+}
+template<typename A> void visitFields(A& a, CallVCommandExpr& n) {
+    visitLocation(a, n); a(n.receivers); a(n.name); a(n.params);
+}
+template<typename A> void visitFields(A& a, CallFailExpr& n) {
+    visitLocation(a, n); a(n.expr);
+}
+template<typename A> void visitFields(A& a, SuffixExpr& n) {
+    visitLocation(a, n); a(n.base); a(n.suffixes);
+}
+template<typename A> void visitFields(A& a, BinaryExpr::OpTerm& n)  { a(n.op); a(n.term); }
+template<typename A> void visitFields(A& a, BinaryExpr& n) {
+    visitLocation(a, n); a(n.first); a(n.rest);
+}
+template<typename A> void visitFields(A& a, QuoteExpr& n) {
+    visitLocation(a, n); a(n.kind); a(n.invoke); a(n.group);
+}
+template<typename A> void visitFields(A& a, CmdLiteralExpr& n) {
+    visitLocation(a, n); a(n.kind); a(n.params); a(n.body);
+}
+
+// statements and structure
+template<typename A> void visitFields(A& a, AssignStat& n) {
+    visitLocation(a, n); a(n.target); a(n.value);
+}
+template<typename A> void visitFields(A& a, ExprStat& n)   { visitLocation(a, n); a(n.expr); }
+template<typename A> void visitFields(A& a, Block& n) {
+    visitLocation(a, n); a(n.kind); a(n.recoverType); a(n.recoverIdent); a(n.recoverExpr); a(n.body);
+}
+template<typename A> void visitFields(A& a, StatNode& n)  { a(n.v); }
+template<typename A> void visitFields(A& a, CallGroup& n) { visitLocation(a, n); a(n.statements); }
+template<typename A> void visitFields(A& a, CmdBody& n) {
+    visitLocation(a, n); a(n.subs); a(n.isEmpty); a(n.group);
+}
+
+// signatures
+template<typename A> void visitFields(A& a, RegularSig& n) {
+    a(n.name); a(n.failMode); a(n.params); a(n.implicitParams); a(n.returnVal);
+}
+template<typename A> void visitFields(A& a, VCommandSig& n) {
+    a(n.receivers); a(n.name); a(n.failMode); a(n.params); a(n.implicitParams); a(n.returnVal);
+}
+template<typename A> void visitFields(A& a, ConstructorSig& n) { a(n.receiver); a(n.params); }
+template<typename A> void visitFields(A& a, DestructorSig& n)  { a(n.receiver); }
+template<typename A> void visitFields(A& a, FailHandlerSig& n) { a(n.receiver); }
+
+// declarations
+template<typename A> void visitFields(A& a, ModuleDecl& n) { visitLocation(a, n); a(n.name); }
+template<typename A> void visitFields(A& a, ImportDecl& n) {
+    visitLocation(a, n); a(n.kind); a(n.path); a(n.alias); a(n.name);
+}
+template<typename A> void visitFields(A& a, AliasDecl& n) {
+    visitLocation(a, n); a(n.name); a(n.type);
+}
+template<typename A> void visitFields(A& a, DomainDecl& n) {
+    visitLocation(a, n); a(n.name); a(n.parent);
+}
+template<typename A> void visitFields(A& a, EnumDecl& n) {
+    visitLocation(a, n); a(n.enumTypeName); a(n.enumName); a(n.items);
+}
+template<typename A> void visitFields(A& a, RecordDecl& n) {
+    visitLocation(a, n); a(n.name); a(n.fields);
+}
+template<typename A> void visitFields(A& a, ObjectDecl& n) {
+    visitLocation(a, n); a(n.name); a(n.fields);
+}
+template<typename A> void visitFields(A& a, UnionDecl& n) {
+    visitLocation(a, n); a(n.name); a(n.candidates);
+}
+template<typename A> void visitFields(A& a, VariantDecl& n) {
+    visitLocation(a, n); a(n.name); a(n.candidates);
+}
+template<typename A> void visitFields(A& a, InstanceDecl& n) {
+    visitLocation(a, n); a(n.name); a(n.types);
+}
+template<typename A> void visitFields(A& a, CmdDecl& n) {
+    visitLocation(a, n); a(n.signature);
+}
+template<typename A> void visitFields(A& a, IntrinsicDecl& n) {
+    visitLocation(a, n); a(n.signature);
+}
+template<typename A> void visitFields(A& a, CmdDef& n) {
+    visitLocation(a, n); a(n.signature); a(n.body);
+}
+template<typename A> void visitFields(A& a, ClassDecl& n) {
+    visitLocation(a, n); a(n.name); a(n.members);
+}
+template<typename A> void visitFields(A& a, ProgramDecl& n) {
+    visitLocation(a, n); a(n.entryPoint);
+}
+template<typename A> void visitFields(A& a, TestDecl& n) {
+    visitLocation(a, n); a(n.label); a(n.body);
+}
+template<typename A> void visitFields(A& a, CompilationUnit& n) {
+    visitLocation(a, n); a(n.module); a(n.imports); a(n.definitions);
+}
+
+} // namespace basis
+
+#endif // ASTFIELDS_H
@@ -0,0 +1,134 @@
+#include "AstHash.h"
+#include "AstFields.h"
+#include "StableHash.h"
+
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+
+using namespace basis;
+
+namespace {
+
+    template<typename T>
+    concept Scalar = std::is_integral_v<T> || std::is_enum_v<T>;
+
+    // Hashes the fields it visits, following expressions and hashing command
+    // bodies on the way.
+    struct StructuralHash {
+        StableHasher h;
+
+        template<Scalar T> void operator()(T& v) { h.add(static_cast<uint64_t>(v)); }
+        void operator()(std::string& s) { h.add(s); }
+        void operator()(std::optional<std::string>& s) {
+            h.add(s.has_value());
+            if (s) h.add(*s);
+        }
+        void operator()(TypeNode*& p) { h.add(p ? p->hash : 0); }
+        void operator()(ExprNode*& p) {
+            h.add(p != nullptr);
+            if (p) (*this)(p->v);
+        }
+        void operator()(CmdBody*& p);
+        template<typename T> void operator()(T*& p) {
+            h.add(p != nullptr);
+            if (p) visitFields(*this, *p);
+        }
+        template<typename T> void operator()(AstList<T>& list) {
+            h.add(list.size());
+            for (auto& element : list) (*this)(element);
+        }
+        template<typename... Ts> void operator()(std::variant<Ts...>& v) {
+            h.add(v.index());
+            std::visit([this](auto& alt) { visitFields(*this, alt); }, v);
+        }
+        template<typename T> requires std::is_class_v<T> void operator()(T& n) { visitFields(*this, n); }
+    };
+
+    // positions are not part of the structure
+    void visitLocation(StructuralHash&, Located&) {}
+
+    void StructuralHash::operator()(CmdBody*& p) {
+        h.add(p != nullptr);
+        if (!p) return;
+        StructuralHash body;
+        visitFields(body, *p);
+        p->hash = body.h.value;
+        h.add(p->hash);
+    }
+
+    template<typename T>
+    uint64_t structuralHash(T& node) {
+        StructuralHash s;
+        s(node);
+        return s.h.value;
+    }
+
+    // What a definition is matched by across units: its kind and its name, or the
+    // signature of a command. The signature is hashed without the body.
+    uint64_t identity(TopLevelDef& definition) {
+        StableHasher h;
+        h.add(definition.index());
+        std::visit([&](auto& d) {
+            using T = std::decay_t<decltype(d)>;
+            if constexpr (std::is_same_v<T, EnumDecl>) h.add(d.enumName);
+            else if constexpr (std::is_same_v<T, TestDecl>) h.add(d.label);
+            else if constexpr (requires { d.signature; }) h.add(structuralHash(d.signature));
+            else if constexpr (requires { d.name; }) h.add(d.name);
+        }, definition);
+        return h.value;
+    }
+
+    // Keys of the definitions of a unit, the n-th definition with the same
+    // identity keyed apart from the first.
+    std::vector<uint64_t> keys(CompilationUnit& cu) {
+        std::unordered_map<uint64_t, uint64_t> seen;
+        std::vector<uint64_t> result;
+        result.reserve(cu.definitions.size());
+        for (auto& definition : cu.definitions) {
+            uint64_t id = identity(definition);
+            StableHasher h;
+            h.add(id);
+            h.add(seen[id]++);
+            result.push_back(h.value);
+        }
+        return result;
+    }
+
+}
+
+void basis::hashDefinitions(CompilationUnit& cu) {
+    cu.definitionHashes.clear();
+    cu.definitionHashes.reserve(cu.definitions.size());
+    for (auto& definition : cu.definitions) cu.definitionHashes.push_back(structuralHash(definition));
+}
+
+DefinitionDiff basis::diffDefinitions(CompilationUnit& before, CompilationUnit& after) {
+    for (CompilationUnit* cu : {&before, &after}) {
+        if (cu->definitionHashes.size() != cu->definitions.size()) hashDefinitions(*cu);
+    }
+    auto beforeKeys = keys(before);
+    auto afterKeys = keys(after);
+
+    std::unordered_map<uint64_t, size_t> index;
+    index.reserve(beforeKeys.size());
+    for (size_t i = 0; i < beforeKeys.size(); ++i) index.emplace(beforeKeys[i], i);
+
+    DefinitionDiff diff;
+    std::vector<bool> matched(beforeKeys.size());
+    for (size_t j = 0; j < afterKeys.size(); ++j) {
+        auto found = index.find(afterKeys[j]);
+        if (found == index.end()) {
+            diff.added.push_back(j);
+            continue;
+        }
+        size_t i = found->second;
+        matched[i] = true;
+        if (before.definitionHashes[i] == after.definitionHashes[j]) ++diff.unchanged;
+        else diff.changed.emplace_back(i, j);
+    }
+    for (size_t i = 0; i < matched.size(); ++i) {
+        if (!matched[i]) diff.removed.push_back(i);
+    }
+    return diff;
+}
@@ -0,0 +1,38 @@
+#ifndef ASTHASH_H
+#define ASTHASH_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "Ast.h"
+
+namespace basis {
+
+// Structural hashes of definitions, for telling which definitions changed between
+// two builds of a unit. A hash covers every field of the definition and of what
+// it encloses, but not positions or NodeIds, so moving a definition or editing
+// the lines above it leaves its hash alone. Hashes are stable from run to run.
+// Types use TypeNode::hash, which the TypeInterner computes the same way.
+
+// Hash every CmdBody, bottom-up, into CmdBody::hash, and every definition into
+// cu.definitionHashes. Run again after changing the AST.
+void hashDefinitions(CompilationUnit& cu);
+
+// Definitions are matched between units by kind and name; commands by kind and
+// signature, so an overload is a definition of its own and a changed signature
+// is one definition removed and another added. Indices are into the units'
+// definitions, in increasing order (of the after index, for changed).
+struct DefinitionDiff {
+    std::vector<size_t>                    added;     // in after
+    std::vector<size_t>                    removed;   // in before
+    std::vector<std::pair<size_t, size_t>> changed;   // (before, after)
+    size_t                                 unchanged = 0;
+};
+
+// Hashes units that are not hashed yet; linear in the number of definitions.
+DefinitionDiff diffDefinitions(CompilationUnit& before, CompilationUnit& after);
+
+} // namespace basis
+
+#endif // ASTHASH_H
@@ -0,0 +1,262 @@
+#include "BuildCache.h"
+#include "AstBinary.h"
+#include "MappedFile.h"
+#include "StableHash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <thread>
+
+using namespace basis;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    // An entry: "BCCH", buildCacheVersion, the whole key, the diagnostics, then the AST
+    // image if there is a unit. Numbers are little-endian, strings a 32-bit
+    // length and the bytes.
+    constexpr char magic[4] = {'B', 'C', 'C', 'H'};
+    constexpr const char* extension = ".bcache";
+    // temporary files older than this were left by a compiler that died
+    constexpr auto abandoned = std::chrono::minutes(10);
+
+    struct Writer {
+        std::vector<unsigned char> out;
+
+        void u32(uint32_t v) {
+            for (int i = 0; i < 4; ++i) out.push_back(static_cast<unsigned char>(v >> (8 * i)));
+        }
+        void u64(uint64_t v) {
+            u32(static_cast<uint32_t>(v));
+            u32(static_cast<uint32_t>(v >> 32));
+        }
+        void key(const BuildCache::Key& k) {
+            out.insert(out.end(), k.begin(), k.end());
+        }
+        void string(const std::string& s) {
+            u32(static_cast<uint32_t>(s.size()));
+            out.insert(out.end(), s.begin(), s.end());
+        }
+        void loc(const SourceLoc& l) {
+            u64(l.line);
+            u64(l.col);
+        }
+    };
+
+    struct Reader {
+        const unsigned char* p;
+        const unsigned char* end;
+        bool ok = true;
+
+        bool has(size_t n) {
+            ok = ok && static_cast<size_t>(end - p) >= n;
+            return ok;
+        }
+        uint32_t u32() {
+            if (!has(4)) return 0;
+            uint32_t v = 0;
+            for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+            p += 4;
+            return v;
+        }
+        uint64_t u64() {
+            uint64_t low = u32();
+            return low | static_cast<uint64_t>(u32()) << 32;
+        }
+        bool key(const BuildCache::Key& k) {
+            if (!has(k.size()) || !std::equal(k.begin(), k.end(), p)) return false;
+            p += k.size();
+            return true;
+        }
+        std::string string() {
+            uint32_t size = u32();
+            if (!has(size)) return {};
+            std::string s(reinterpret_cast<const char*>(p), size);
+            p += size;
+            return s;
+        }
+        SourceLoc loc() {
+            SourceLoc l;
+            l.line = u64();
+            l.col = u64();
+            return l;
+        }
+    };
+
+    // unique among the processes and threads writing to the directory
+    std::string temporaryName(const std::string& final) {
+        static std::atomic<uint64_t> counter = 0;
+        StableHasher h;
+        h.add(static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id())));
+        h.add(static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+        h.add(static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count()));
+        h.add(counter++);
+        h.add(static_cast<uint64_t>(std::random_device{}()));
+        char suffix[24];
+        std::snprintf(suffix, sizeof suffix, ".%016llx", static_cast<unsigned long long>(h.value));
+        return final + suffix + ".tmp";
+    }
+
+}
+
+BuildCache::BuildCache(std::string directory, uint64_t maxBytes)
+    : dir(std::move(directory)), maxBytes(maxBytes) {}
+
+// CMake passes the commit in (see CMakeLists.txt); a build without it goes by
+// when this file was compiled.
+#ifndef BASIS_BUILD_ID
+#define BASIS_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+std::string_view BuildCache::buildId() {
+    return BASIS_BUILD_ID;
+}
+
+BuildCache::Key BuildCache::key(std::string_view source, const std::vector<uint64_t>& dependencies) {
+    // no compile option changes what a file builds to yet; one that does goes in here
+    Sha256 h;
+    h.add(buildCacheVersion);
+    h.add(astBinaryVersion);
+    h.add(buildId());
+    h.add(source);
+    h.add(dependencies.size());
+    for (uint64_t d : dependencies) h.add(d);
+    return h.digest();
+}
+
+std::string BuildCache::pathOf(const Key& key) const {
+    std::string name;
+    for (unsigned char byte : key) {
+        name += "0123456789abcdef"[byte >> 4];
+        name += "0123456789abcdef"[byte & 15];
+    }
+    return (fs::path(dir) / (name + extension)).string();
+}
+
+std::optional<BuildCache::Entry> BuildCache::load(const Key& key) const {
+    std::string path = pathOf(key);
+    MappedFile file(path);
+    if (!file.isOpen()) return std::nullopt;
+
+    Reader in{file.data(), file.data() + file.size()};
+    if (!in.has(sizeof magic) || !std::equal(magic, magic + sizeof magic, in.p)) return std::nullopt;
+    in.p += sizeof magic;
+    // the name of the file is the key; a file moved or copied under it is not
+    if (in.u32() != buildCacheVersion || !in.key(key)) return std::nullopt;
+
+    Entry entry;
+    uint32_t count = in.u32();
+    for (uint32_t i = 0; i < count && in.ok; ++i) {
+        Diagnostic d;
+        uint32_t severity = in.u32(), phase = in.u32();
+        if (severity > static_cast<uint32_t>(Severity::Fatal) || phase > static_cast<uint32_t>(Phase::Sema))
+            return std::nullopt;
+        d.severity = static_cast<Severity>(severity);
+        d.phase = static_cast<Phase>(phase);
+        d.loc = in.loc();
+        d.message = in.string();
+        d.relatedLoc = in.loc();
+        d.related = in.string();
+        entry.diagnostics.report(std::move(d));
+    }
+    if (in.u32()) {
+        uint64_t size = in.u64();
+        if (!in.has(size)) return std::nullopt;
+        entry.unit = readAstBinary(in.p, size);
+        if (!entry.unit) return std::nullopt;
+    }
+    if (!in.ok) return std::nullopt;
+
+    // used now, for evict()
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return entry;
+}
+
+bool BuildCache::store(const Key& key, const Diagnostics& diagnostics, const CompilationUnit* unit) const {
+    Writer out;
+    out.out.insert(out.out.end(), magic, magic + sizeof magic);
+    out.u32(buildCacheVersion);
+    out.key(key);
+    out.u32(static_cast<uint32_t>(diagnostics.all().size()));
+    for (auto& d : diagnostics.all()) {
+        out.u32(static_cast<uint32_t>(d.severity));
+        out.u32(static_cast<uint32_t>(d.phase));
+        out.loc(d.loc);
+        out.string(d.message);
+        out.loc(d.relatedLoc);
+        out.string(d.related);
+    }
+    out.u32(unit != nullptr);
+    if (unit) {
+        auto image = writeAstBinary(*unit);
+        out.u64(image.size());
+        out.out.insert(out.out.end(), image.begin(), image.end());
+    }
+
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    std::string path = pathOf(key);
+    std::string temporary = temporaryName(path);
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(out.out.data()),
+                   static_cast<std::streamsize>(out.out.size()));
+        if (!file.good()) {
+            file.close();
+            fs::remove(temporary, ec);
+            return false;
+        }
+    }
+    // replaces an entry another compiler stored meanwhile, which is the same
+    fs::rename(temporary, path, ec);
+    if (ec) {
+        fs::remove(temporary, ec);
+        return false;
+    }
+    return true;
+}
+
+void BuildCache::evict() const {
+    struct Item {
+        fs::path path;
+        fs::file_time_type used;
+        uintmax_t size;
+    };
+    std::vector<Item> entries;
+    uintmax_t total = 0;
+    auto now = fs::file_time_type::clock::now();
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        // other compilers may remove what is listed here; skip what is gone
+        std::error_code entryError;
+        auto name = it->path().filename().string();
+        auto used = fs::last_write_time(it->path(), entryError);
+        if (entryError) continue;
+        if (name.ends_with(".tmp")) {
+            if (now - used > abandoned) fs::remove(it->path(), entryError);
+            continue;
+        }
+        if (it->path().extension() != extension) continue;
+        auto size = fs::file_size(it->path(), entryError);
+        if (entryError) continue;
+        entries.push_back({it->path(), used, size});
+        total += size;
+    }
+    if (total <= maxBytes) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Item& a, const Item& b) { return a.used < b.used; });
+    for (auto& entry : entries) {
+        if (total <= maxBytes) break;
+        std::error_code removeError;
+        fs::remove(entry.path, removeError);
+        total -= entry.size;
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef BUILDCACHE_H
+#define BUILDCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Ast.h"
+#include "Diagnostic.h"
+#include "Sha256.h"
+
+namespace basis {
+
+// Bump when the front end builds anything differently, so that entries made by
+// an older compiler are never hit.
+constexpr uint32_t buildCacheVersion = 2;
+
+// An on-disk cache of what building a file produced: its diagnostics and its
+// AST, as an AstBinary image. Entries are addressed by a SHA-256 of everything
+// the build depends on, so an entry never goes stale, it just stops being hit,
+// and one build cannot be made to hit another's entry.
+//
+// Each entry is one file, <key>.bcache, written under a temporary name and
+// renamed into place, so compilers running at the same time over the same
+// directory see whole entries or none; a reader keeps the entry it mapped even
+// if another process evicts it meanwhile. A hit marks the entry used, and
+// evict() removes the least recently used entries until the directory is back
+// under its size.
+class BuildCache {
+public:
+    BuildCache(std::string directory, uint64_t maxBytes);
+
+    using Key = Sha256::Digest;
+    // Key of a build of `source`, under this compiler. Callers whose results
+    // depend on more than the source, such as the interfaces of imported
+    // modules, add those hashes.
+    static Key key(std::string_view source, const std::vector<uint64_t>& dependencies = {});
+    // Which build of the compiler this is. Keys include it too, so a change that
+    // nobody bumped buildCacheVersion for does not hit old entries either.
+    static std::string_view buildId();
+
+    struct Entry {
+        Diagnostics                      diagnostics;
+        std::shared_ptr<CompilationUnit> unit;   // null when the build made none
+    };
+    std::optional<Entry> load(const Key& key) const;
+    // False if the entry could not be written; the build goes on without it.
+    bool store(const Key& key, const Diagnostics& diagnostics, const CompilationUnit* unit) const;
+
+    void evict() const;
+    const std::string& directory() const { return dir; }
+    // The file the entry for `key` is kept in.
+    std::string pathOf(const Key& key) const;
+
+private:
+    std::string dir;
+    uint64_t maxBytes;
+};
+
+} // namespace basis
+
+#endif // BUILDCACHE_H
@@ -1,26 +1,122 @@
 #include "CompileOptions.h"
 
+#include <algorithm>
+#include <filesystem>
 #include <functional>
 #include <map>
+#include <set>
+#include <stdexcept>
 #include <vector>
 
+namespace fs = std::filesystem;
+
 namespace basis {
     using CompileOptionsSetter = std::function<void(CompileOptions&, std::string&)>;
-    const std::map<std::string, CompileOptionsSetter> options_map {
-             {"-file", [](CompileOptions& o, std::string& arg) { o.filename = arg; }}
+    // options that take a value are followed by it; the others are flags
+    struct CompileOption {
+        bool takesValue;
+        CompileOptionsSetter set;
+        bool namesPath = false;     // the value is a file or directory
+    };
+    const std::map<std::string, CompileOption> options_map {
+             {"-file", {true, [](CompileOptions& o, std::string& arg) { o.files.push_back(arg); }, true}},
+             {"-I", {true, [](CompileOptions& o, std::string& arg) { o.importPaths.push_back(arg); }, true}},
+             {"-j", {true, [](CompileOptions& o, std::string& arg) {
+                 int jobs = std::stoi(arg);
+                 if ( jobs < 1 ) throw std::invalid_argument("-j");
+                 o.jobs = static_cast<unsigned>(jobs);
+             }}},
+             {"-cache", {true, [](CompileOptions& o, std::string& arg) { o.cacheDir = arg; }, true}},
+             {"-cache-size", {true, [](CompileOptions& o, std::string& arg) {
+                 long long megabytes = std::stoll(arg);
+                 if ( megabytes < 1 ) throw std::invalid_argument("-cache-size");
+                 o.cacheBytes = static_cast<uint64_t>(megabytes) << 20;
+             }}},
+             {"-mem-report", {false, [](CompileOptions& o, std::string&) { o.memReport = true; }}},
+             {"-time-phases", {false, [](CompileOptions& o, std::string&) {
+                 o.timePhases = PhaseTiming::Table;
+             }}},
+             {"-time-phases-json", {false, [](CompileOptions& o, std::string&) {
+                 o.timePhases = PhaseTiming::Json;
+             }}}
     };
     bool CompileOptions::readCompileOptions(std::vector<std::string>& arguments) {
         if ( arguments.empty() ) return false;
         auto size = arguments.size();
-        if ( size % 2 != 0 ) return false;
         try {
-            for ( int i = 0; i < size; i += 2 ) {
-                options_map.at(arguments[i])(*this, arguments[i + 1]);
+            for ( size_t i = 0; i < size; ++i ) {
+                auto& option = options_map.at(arguments[i]);
+                if ( option.takesValue && ++i == size ) return false;
+                option.set(*this, arguments[i]);
             }
         } catch ( std::exception& e ) {
             return false;
         }
-        if (filename.empty()) return false;
+        if (files.empty()) return false;
         return true;
     }
-} // basis
\ No newline at end of file
+
+    void resolvePaths(std::vector<std::string>& arguments, const std::string& directory) {
+        for ( size_t i = 0; i < arguments.size(); ++i ) {
+            auto option = options_map.find(arguments[i]);
+            // what readCompileOptions rejects is left for it to reject
+            if ( option == options_map.end() || !option->second.takesValue ) continue;
+            if ( ++i == arguments.size() ) break;
+            fs::path value(arguments[i]);
+            if ( option->second.namesPath && value.is_relative() )
+                arguments[i] = (fs::path(directory) / value).string();
+        }
+    }
+
+    namespace {
+        // * matches any run of characters, ? any one
+        bool matches(const char* pattern, const char* name) {
+            if ( *pattern == '\0' ) return *name == '\0';
+            if ( *pattern == '*' )
+                return matches(pattern + 1, name) || (*name != '\0' && matches(pattern, name + 1));
+            if ( *name == '\0' ) return false;
+            return (*pattern == '?' || *pattern == *name) && matches(pattern + 1, name + 1);
+        }
+    }
+
+    std::vector<std::string> CompileOptions::inputFiles(Diagnostics& diagnostics) const {
+        std::vector<std::string> result;
+        std::set<std::string> seen;
+        auto missing = [&](const char* message, const std::string& arg) {
+            diagnostics.report({Severity::Error, Phase::Lex, {}, message, {}, {}, arg});
+        };
+        auto addSorted = [&](std::vector<std::string> found) {
+            std::sort(found.begin(), found.end());
+            for ( auto& file : found ) {
+                if ( seen.insert(file).second ) result.push_back(std::move(file));
+            }
+        };
+        for ( auto& arg : files ) {
+            fs::path path(arg);
+            std::string name = path.filename().string();
+            std::error_code ec, entryError;
+            std::vector<std::string> found;
+            if ( name.find_first_of("*?") != std::string::npos ) {
+                fs::path dir = path.has_parent_path() ? path.parent_path() : fs::path(".");
+                for ( fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec) ) {
+                    fs::path entry = path.has_parent_path() ? it->path() : it->path().filename();
+                    bool match = matches(name.c_str(), entry.filename().string().c_str());
+                    if ( match && it->is_regular_file(entryError) ) found.push_back(entry.string());
+                }
+                if ( found.empty() ) missing("no input files match", arg);
+            } else if ( fs::is_directory(path, ec) ) {
+                fs::recursive_directory_iterator it(path, ec), end;
+                for ( ; !ec && it != end; it.increment(ec) ) {
+                    if ( it->is_regular_file(entryError) && it->path().extension() == ".b" )
+                        found.push_back(it->path().string());
+                }
+            } else if ( fs::exists(path, ec) ) {
+                found.push_back(arg);
+            } else {
+                missing("no such input file", arg);
+            }
+            addSorted(std::move(found));
+        }
+        return result;
+    }
+} // basis
@@ -5,12 +5,33 @@
 #include <string>
 #include <vector>
 
+#include "Diagnostic.h"
+
 namespace basis {
+    enum class PhaseTiming { None, Table, Json };
+
     struct CompileOptions {
-        std::string filename;
+        std::vector<std::string> files;         // -file, once per file, directory or pattern
+        std::vector<std::string> importPaths;   // -I, searched in order for imports
         std::string outputFile;
+        unsigned jobs = 0;                      // -j: files compiled at once; 0 for one per hardware thread
+        std::string cacheDir;                   // -cache: where to keep what building each file made
+        uint64_t cacheBytes = 512ull << 20;     // -cache-size, given in megabytes
+        bool memReport = false;                 // -mem-report: print where the memory of the modules goes
+        PhaseTiming timePhases = PhaseTiming::None;   // -time-phases, -time-phases-json: report on stderr
         bool readCompileOptions(std::vector<std::string>& arguments);
+
+        // The source files the -file arguments name, in argument order: a directory
+        // stands for the .b files below it and a pattern with * or ? in its last
+        // component for the files it matches, each sorted by path. A name that
+        // neither exists nor matches is an error.
+        std::vector<std::string> inputFiles(Diagnostics& diagnostics) const;
     };
+
+    // Make the relative files and directories that options in `arguments` name
+    // relative to `directory` instead, for arguments given in another working
+    // directory than this process's.
+    void resolvePaths(std::vector<std::string>& arguments, const std::string& directory);
 }
 
 #endif
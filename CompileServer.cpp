@@ -0,0 +1,366 @@
+#include "CompileServer.h"
+#include "CompileOptions.h"
+#include "StableHash.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace basis;
+
+namespace fs = std::filesystem;
+
+void ResidentModules::compile(const std::string& file, const CompileOptions& options, FileResult& result,
+                              const BuildCache* cache) {
+    std::error_code ec, sizeError;
+    auto modified = fs::last_write_time(file, ec);
+    auto size = fs::file_size(file, sizeError);
+    // what is not kept, or cannot be, is built as without a server
+    if ( options.memReport || ec || sizeError ) {
+        compileFile(file, options, result, cache);
+        return;
+    }
+    std::string key = fs::weakly_canonical(file, ec).string();
+    if ( ec ) key = file;
+
+    auto reuse = [&](const Kept& k) {
+        result.diagnostics = k.diagnostics;
+        result.unit = k.unit;
+        ++hitCount;
+    };
+    {
+        std::lock_guard lock(mutex);
+        auto it = kept.find(key);
+        if ( it != kept.end() && it->second.modified == modified && it->second.size == size ) {
+            reuse(it->second);
+            return;
+        }
+    }
+
+    std::string source;
+    bool opened;
+    {
+        ScopedPhase phase(options.timePhases != PhaseTiming::None ? &result.times : nullptr, "read");
+        std::ifstream input(file, std::ios::binary);
+        opened = input.is_open();
+        if ( opened ) source.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+    if ( !opened ) {
+        compileFile(file, options, result, cache);
+        return;
+    }
+    StableHasher h;
+    h.add(source);
+    {
+        // touched but not changed
+        std::lock_guard lock(mutex);
+        auto it = kept.find(key);
+        if ( it != kept.end() && it->second.hash == h.value ) {
+            it->second.modified = modified;
+            it->second.size = size;
+            reuse(it->second);
+            return;
+        }
+    }
+
+    compileSource(source, options, result, cache);
+    std::lock_guard lock(mutex);
+    kept[key] = Kept{modified, size, h.value, result.diagnostics, result.unit};
+}
+
+size_t ResidentModules::size() {
+    std::lock_guard lock(mutex);
+    return kept.size();
+}
+
+#ifndef _WIN32
+
+namespace {
+
+    bool sendAll(int fd, const char* data, size_t size) {
+        while ( size > 0 ) {
+#ifdef MSG_NOSIGNAL
+            ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+#else
+            ssize_t sent = ::send(fd, data, size, 0);
+#endif
+            if ( sent < 0 && errno == EINTR ) continue;
+            if ( sent <= 0 ) return false;
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    bool receiveAll(int fd, char* data, size_t size) {
+        while ( size > 0 ) {
+            ssize_t got = ::recv(fd, data, size, 0);
+            if ( got < 0 && errno == EINTR ) continue;
+            if ( got <= 0 ) return false;
+            data += got;
+            size -= static_cast<size_t>(got);
+        }
+        return true;
+    }
+
+    bool sendFrame(int fd, char kind, const char* data, size_t size) {
+        char header[5] = {kind};
+        for ( int i = 0; i < 4; ++i ) header[1 + i] = static_cast<char>(size >> (8 * i));
+        return sendAll(fd, header, sizeof header) && sendAll(fd, data, size);
+    }
+
+    bool receiveFrame(int fd, char& kind, std::string& data) {
+        unsigned char header[5];
+        if ( !receiveAll(fd, reinterpret_cast<char*>(header), sizeof header) ) return false;
+        kind = static_cast<char>(header[0]);
+        uint32_t size = 0;
+        for ( int i = 0; i < 4; ++i ) size |= static_cast<uint32_t>(header[1 + i]) << (8 * i);
+        data.resize(size);
+        return receiveAll(fd, data.data(), size);
+    }
+
+    // Sends what is written to it as frames of one kind.
+    class FrameBuffer : public std::streambuf {
+    public:
+        FrameBuffer(int fd, char kind) : fd(fd), kind(kind) { setp(buffer, buffer + sizeof buffer); }
+
+    protected:
+        int_type overflow(int_type c) override {
+            if ( !flush() ) return traits_type::eof();
+            if ( !traits_type::eq_int_type(c, traits_type::eof()) ) sputc(traits_type::to_char_type(c));
+            return traits_type::not_eof(c);
+        }
+        int sync() override { return flush() ? 0 : -1; }
+
+    private:
+        bool flush() {
+            size_t size = static_cast<size_t>(pptr() - pbase());
+            setp(buffer, buffer + sizeof buffer);
+            return size == 0 || sendFrame(fd, kind, buffer, size);
+        }
+
+        int fd;
+        char kind;
+        char buffer[4096];
+    };
+
+    bool socketAddress(const std::string& path, sockaddr_un& address) {
+        std::memset(&address, 0, sizeof address);
+        address.sun_family = AF_UNIX;
+        if ( path.size() >= sizeof address.sun_path ) return false;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    int connectTo(const std::string& path) {
+        sockaddr_un address;
+        if ( !socketAddress(path, address) ) return -1;
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if ( fd < 0 ) return -1;
+        if ( ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0 ) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    CompileServer* signalled = nullptr;
+
+    extern "C" void stopOnSignal(int) {
+        if ( signalled ) signalled->stop();
+    }
+
+}
+
+CompileServer::CompileServer(std::string socketPath) : path(std::move(socketPath)) {}
+
+CompileServer::~CompileServer() {
+    stop();
+}
+
+bool CompileServer::listen(std::string& error) {
+    sockaddr_un address;
+    if ( !socketAddress(path, address) ) {
+        error = "socket path too long: " + path;
+        return false;
+    }
+    int live = connectTo(path);
+    if ( live >= 0 ) {
+        ::close(live);
+        error = "a server is already listening on " + path;
+        return false;
+    }
+    ::unlink(path.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if ( fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0 ||
+         ::listen(fd, 64) != 0 ) {
+        error = "cannot listen on " + path + ": " + std::strerror(errno);
+        if ( fd >= 0 ) ::close(fd);
+        return false;
+    }
+    listener = fd;
+    return true;
+}
+
+void CompileServer::serve() {
+    while ( !stopping ) {
+        int fd = listener;
+        if ( fd < 0 ) break;
+        // wake now and then, for a stop() that poll() does not see
+        pollfd ready{fd, POLLIN, 0};
+        if ( ::poll(&ready, 1, 200) <= 0 || !(ready.revents & POLLIN) ) continue;
+        int connection = ::accept(fd, nullptr, nullptr);
+        if ( connection < 0 ) continue;
+        {
+            std::lock_guard lock(activeMutex);
+            ++active;
+            connections.insert(connection);
+        }
+        std::thread([this, connection] {
+            handle(connection);
+            std::lock_guard lock(activeMutex);
+            // closed under the lock, so serve() never shuts down a reused descriptor
+            connections.erase(connection);
+            ::close(connection);
+            if ( --active == 0 ) idle.notify_all();
+        }).detach();
+    }
+    std::unique_lock lock(activeMutex);
+    // a client that never finishes its request would keep handle() in recv;
+    // compiles that have it already only send, so they run to the end
+    for ( int connection : connections ) ::shutdown(connection, SHUT_RD);
+    idle.wait(lock, [this] { return active == 0; });
+    ::unlink(path.c_str());
+}
+
+void CompileServer::stop() {
+    // only async-signal-safe calls here
+    stopping = true;
+    int fd = listener.exchange(-1);
+    if ( fd >= 0 ) {
+        ::shutdown(fd, SHUT_RDWR);
+        ::close(fd);
+    }
+}
+
+void CompileServer::handle(int connection) {
+    std::vector<std::string> arguments;
+    std::string directory;
+    char kind;
+    std::string data;
+    bool complete = false;
+    while ( receiveFrame(connection, kind, data) ) {
+        if ( kind == 'r' ) {
+            complete = true;
+            break;
+        }
+        if ( kind == 'd' ) directory = std::move(data);
+        else if ( kind == 'a' ) arguments.push_back(std::move(data));
+        else break;
+    }
+    if ( complete ) {
+        // paths are the client's, not relative to where the server started
+        if ( !directory.empty() ) resolvePaths(arguments, directory);
+        FrameBuffer outBuffer(connection, 'o'), errBuffer(connection, 'e');
+        std::ostream out(&outBuffer), err(&errBuffer);
+        int status;
+        try {
+            status = ::compile(arguments, out, err, &resident);
+        } catch ( std::exception& e ) {
+            err << "internal error: " << e.what() << std::endl;
+            status = 1;
+        } catch ( ... ) {
+            err << "internal error" << std::endl;
+            status = 1;
+        }
+        out.flush();
+        err.flush();
+        std::string text = std::to_string(status);
+        sendFrame(connection, 'x', text.data(), text.size());
+    }
+}
+
+int basis::runCompileServer(const std::string& socketPath) {
+    CompileServer server(socketPath);
+    std::string error;
+    if ( !server.listen(error) ) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    signalled = &server;
+    std::signal(SIGINT, stopOnSignal);
+    std::signal(SIGTERM, stopOnSignal);
+    server.serve();
+    signalled = nullptr;
+    return 0;
+}
+
+int basis::forwardCompile(const std::string& socketPath, const std::vector<std::string>& arguments,
+                          std::ostream& out, std::ostream& err) {
+    int fd = connectTo(socketPath);
+    if ( fd < 0 ) {
+        err << "no compile server on " << socketPath << std::endl;
+        return 1;
+    }
+    std::error_code ec;
+    std::string directory = fs::current_path(ec).string();
+    bool sent = ec || sendFrame(fd, 'd', directory.data(), directory.size());
+    for ( auto& argument : arguments ) sent = sent && sendFrame(fd, 'a', argument.data(), argument.size());
+    sent = sent && sendFrame(fd, 'r', nullptr, 0);
+
+    char kind;
+    std::string data;
+    while ( sent && receiveFrame(fd, kind, data) ) {
+        if ( kind == 'o' ) out << data;
+        else if ( kind == 'e' ) err << data;
+        else if ( kind == 'x' ) {
+            ::close(fd);
+            out.flush();
+            return std::atoi(data.c_str());
+        }
+    }
+    ::close(fd);
+    err << "lost the connection to the compile server" << std::endl;
+    return 1;
+}
+
+#else
+
+CompileServer::CompileServer(std::string socketPath) : path(std::move(socketPath)) {}
+CompileServer::~CompileServer() = default;
+
+bool CompileServer::listen(std::string& error) {
+    error = "the compile server needs Unix sockets";
+    return false;
+}
+void CompileServer::serve() {}
+void CompileServer::stop() { stopping = true; }
+void CompileServer::handle(int) {}
+
+int basis::runCompileServer(const std::string& socketPath) {
+    std::string error;
+    CompileServer(socketPath).listen(error);
+    std::cerr << error << std::endl;
+    return 1;
+}
+
+int basis::forwardCompile(const std::string&, const std::vector<std::string>&, std::ostream&,
+                          std::ostream& err) {
+    err << "the compile server needs Unix sockets" << std::endl;
+    return 1;
+}
+
+#endif
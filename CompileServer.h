@@ -0,0 +1,100 @@
+#ifndef COMPILESERVER_H
+#define COMPILESERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "compiler.h"
+
+namespace basis {
+
+// What files built to, kept between compiles. A file is taken as unchanged while
+// its modification time and size are; when they are not, it is read again and
+// taken as unchanged if its content hashes the same. Safe to use from many
+// compiles at once.
+class ResidentModules {
+public:
+    // Fill `result` as compileFile would, from what is kept if the file is
+    // unchanged and by compileFile otherwise. Memory reports are not kept, so a
+    // compile that wants one always builds.
+    void compile(const std::string& file, const CompileOptions& options, FileResult& result,
+                 const BuildCache* cache = nullptr);
+
+    size_t size();
+    size_t hits() const { return hitCount; }
+
+private:
+    struct Kept {
+        std::filesystem::file_time_type  modified;
+        uintmax_t                        size = 0;
+        uint64_t                         hash = 0;
+        Diagnostics                      diagnostics;
+        std::shared_ptr<CompilationUnit> unit;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Kept> kept;   // by canonical path
+    std::atomic<size_t> hitCount = 0;
+};
+
+// `basis --server <socket>`: compiles what clients send over a local socket, with
+// the grammar built once and unchanged files taken from ResidentModules. Each
+// connection is one compile, run on its own thread, so compiles from several
+// clients run at once.
+//
+// A connection carries frames: a kind byte, a 32-bit little-endian length and
+// that many bytes. The client sends its working directory in a 'd' frame, which
+// relative paths in the arguments are taken against, an 'a' frame per argument
+// and then 'r'; the server streams what the compile writes in 'o' (stdout) and
+// 'e' (stderr) frames and ends with an 'x' frame holding the exit status as text.
+class CompileServer {
+public:
+    explicit CompileServer(std::string socketPath);
+    ~CompileServer();
+    CompileServer(const CompileServer&) = delete;
+    CompileServer& operator=(const CompileServer&) = delete;
+
+    // Bind the socket, replacing a stale socket file but not a live server.
+    // False, with the reason in `error`, if that fails.
+    bool listen(std::string& error);
+    // Accept connections until stop(); returns once every compile has ended.
+    // Clients still sending their arguments by then are cut off.
+    void serve();
+    // From any thread, or a signal handler.
+    void stop();
+
+    ResidentModules& modules() { return resident; }
+
+private:
+    void handle(int connection);
+
+    std::string path;
+    std::atomic<int> listener = -1;
+    std::atomic<bool> stopping = false;
+    ResidentModules resident;
+    // compiles still running, each on a detached thread, and their connections
+    std::mutex activeMutex;
+    std::condition_variable idle;
+    size_t active = 0;
+    std::unordered_set<int> connections;
+};
+
+// Serve on `socketPath` until SIGINT or SIGTERM; the exit status of the server.
+int runCompileServer(const std::string& socketPath);
+// `basis --connect <socket> <options>`: have the server compile with these
+// arguments, writing what it sends back to `out` and `err`. Returns the exit
+// status of the compile, or 1 if there is no server.
+int forwardCompile(const std::string& socketPath, const std::vector<std::string>& arguments,
+                   std::ostream& out, std::ostream& err);
+
+} // namespace basis
+
+#endif // COMPILESERVER_H
@@ -1,9 +0,0 @@
-#include "CompilerContext.h"
-
-namespace basis {
-    CompilerContext::~CompilerContext() {
-        if( inputFile.is_open() ) {
-          inputFile.close();
-        }
-    }
-} // basis
\ No newline at end of file
@@ -1,16 +1,11 @@
 #ifndef COMPILERCONTEXT_H
 #define COMPILERCONTEXT_H
 
-#include <fstream>
-#include <iostream>
-
 #include "CompileOptions.h"
 #include "Diagnostic.h"
 
 namespace basis {
     struct CompilerContext {
-        ~CompilerContext();
-        std::ifstream inputFile;
         CompileOptions options;
         Diagnostics    diagnostics;
     };
@@ -0,0 +1,145 @@
+#include "DefinitionIndex.h"
+#include "StableHash.h"
+
+#include <type_traits>
+
+using namespace basis;
+
+namespace {
+
+    // The kind, name and receiver types of a command signature.
+    void describe(CmdSignature& signature, DefinitionEntry& entry) {
+        auto receiver = [&](const CmdReceiver& r) { entry.receivers.push_back(r.type ? r.type->hash : 0); };
+        std::visit([&](auto& sig) {
+            using T = std::decay_t<decltype(sig)>;
+            if constexpr (std::is_same_v<T, RegularSig>) {
+                entry.kind = DefinitionKind::Command;
+                entry.name = sig.name;
+            } else if constexpr (std::is_same_v<T, VCommandSig>) {
+                entry.kind = DefinitionKind::Command;
+                entry.name = sig.name;
+                for (auto& r : sig.receivers) receiver(r);
+            } else {
+                if constexpr (std::is_same_v<T, ConstructorSig>) entry.kind = DefinitionKind::Constructor;
+                else if constexpr (std::is_same_v<T, DestructorSig>) entry.kind = DefinitionKind::Destructor;
+                else entry.kind = DefinitionKind::FailHandler;
+                receiver(sig.receiver);
+            }
+        }, signature);
+    }
+
+    template<typename T>
+    DefinitionKind simpleKind() {
+        if constexpr (std::is_same_v<T, AliasDecl>) return DefinitionKind::Alias;
+        else if constexpr (std::is_same_v<T, DomainDecl>) return DefinitionKind::Domain;
+        else if constexpr (std::is_same_v<T, UnionDecl>) return DefinitionKind::Union;
+        else if constexpr (std::is_same_v<T, VariantDecl>) return DefinitionKind::Variant;
+        else {
+            static_assert(std::is_same_v<T, InstanceDecl>);
+            return DefinitionKind::Instance;
+        }
+    }
+
+}
+
+size_t DefinitionIndex::KeyHash::operator()(const Key& key) const {
+    StableHasher h;
+    h.add(key.module);
+    h.add(key.owner);
+    h.add(key.name);
+    h.add(static_cast<uint64_t>(key.kind));
+    return static_cast<size_t>(h.value);
+}
+
+void DefinitionIndex::insert(DefinitionEntry&& entry) {
+    Key key{entry.module, entry.owner, entry.name, entry.kind};
+    keys[key].push_back(static_cast<uint32_t>(entries.size()));
+    entries.push_back(std::move(entry));
+}
+
+void DefinitionIndex::add(CompilationUnit& cu) {
+    std::string_view module = cu.module ? std::string_view(cu.module->name) : std::string_view();
+    for (auto& definition : cu.definitions) {
+        DefinitionEntry entry;
+        entry.module = module;
+        entry.unit = &cu;
+        entry.definition = &definition;
+        entry.node = &definition;
+        // members follow the definition they are in
+        auto member = [&](DefinitionKind kind, std::string_view owner, std::string_view name, auto* node) {
+            DefinitionEntry m;
+            m.kind = kind;
+            m.module = module;
+            m.owner = owner;
+            m.name = name;
+            m.unit = &cu;
+            m.definition = &definition;
+            m.node = node;
+            return m;
+        };
+        std::vector<DefinitionEntry> members;
+
+        std::visit([&](auto& d) {
+            using T = std::decay_t<decltype(d)>;
+            if constexpr (std::is_same_v<T, EnumDecl>) {
+                entry.kind = DefinitionKind::Enum;
+                entry.name = d.enumName;
+                for (auto& item : d.items)
+                    members.push_back(member(DefinitionKind::EnumItem, d.enumName, item.name, &item));
+            } else if constexpr (std::is_same_v<T, RecordDecl> || std::is_same_v<T, ObjectDecl>) {
+                entry.kind = std::is_same_v<T, RecordDecl> ? DefinitionKind::Record : DefinitionKind::Object;
+                entry.name = d.name;
+                for (auto& field : d.fields)
+                    members.push_back(member(DefinitionKind::Field, d.name, field.name, &field));
+            } else if constexpr (std::is_same_v<T, ClassDecl>) {
+                entry.kind = DefinitionKind::Class;
+                entry.name = d.name;
+                for (auto& m : d.members) {
+                    DefinitionEntry command = member(DefinitionKind::Command, d.name, {}, &m);
+                    std::visit([&](auto& decl) { describe(decl.signature, command); }, m);
+                    members.push_back(std::move(command));
+                }
+            } else if constexpr (std::is_same_v<T, CmdDecl> || std::is_same_v<T, IntrinsicDecl> ||
+                                 std::is_same_v<T, CmdDef>) {
+                describe(d.signature, entry);
+            } else if constexpr (std::is_same_v<T, TestDecl>) {
+                entry.kind = DefinitionKind::Test;
+                entry.name = d.label;
+            } else if constexpr (std::is_same_v<T, ProgramDecl>) {
+                entry.kind = DefinitionKind::Program;
+            } else {
+                entry.kind = simpleKind<T>();
+                entry.name = d.name;
+            }
+        }, definition);
+
+        insert(std::move(entry));
+        for (auto& m : members) insert(std::move(m));
+    }
+}
+
+void DefinitionIndex::merge(const DefinitionIndex& other) {
+    entries.reserve(entries.size() + other.entries.size());
+    for (const auto& entry : other.entries) insert(DefinitionEntry(entry));
+}
+
+std::vector<const DefinitionEntry*> DefinitionIndex::find(std::string_view module, std::string_view name,
+                                                          DefinitionKind kind, std::string_view owner) const {
+    std::vector<const DefinitionEntry*> found;
+    auto it = keys.find(Key{module, owner, name, kind});
+    if (it == keys.end()) return found;
+    for (uint32_t i : it->second) found.push_back(&entries[i]);
+    return found;
+}
+
+const DefinitionEntry* DefinitionIndex::findOverload(std::string_view module, std::string_view name,
+                                                     DefinitionKind kind,
+                                                     const std::vector<uint64_t>& receivers,
+                                                     std::string_view owner) const {
+    auto it = keys.find(Key{module, owner, name, kind});
+    if (it == keys.end()) return nullptr;
+    for (uint32_t i : it->second) {
+        if (entries[i].receivers == receivers) return &entries[i];
+    }
+    return nullptr;
+}
@@ -0,0 +1,76 @@
+#ifndef DEFINITIONINDEX_H
+#define DEFINITIONINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "Ast.h"
+
+namespace basis {
+
+enum class DefinitionKind {
+    Alias, Domain, Enum, EnumItem, Record, Object, Field, Union, Variant, Instance,
+    Command, Constructor, Destructor, FailHandler, Class, Program, Test
+};
+
+// One named thing a unit defines. Members (enum items, fields, the commands of a
+// class) have the name of what they are in as their owner; constructors,
+// destructors and fail handlers have no name and are told apart by receiver. The
+// strings point into the unit, so an entry is valid as long as the unit is.
+struct DefinitionEntry {
+    DefinitionKind         kind = DefinitionKind::Alias;
+    std::string_view       module;       // empty when the unit has no .module
+    std::string_view       owner;
+    std::string_view       name;
+    std::vector<uint64_t>  receivers;    // TypeNode::hash of each receiver, for commands
+    CompilationUnit*       unit = nullptr;
+    TopLevelDef*           definition = nullptr;   // the definition that is or holds the entry
+    std::variant<TopLevelDef*, EnumItem*, FieldDecl*, ClassMember*> node;
+};
+
+// Hash index of what units define, by (module, name, kind) and the owner for
+// members, so that finding a definition does not scan CompilationUnit::definitions.
+// Commands with the same name are overloads and share a key; the receiver types
+// of each tell them apart. Indexes of many units merge into one.
+class DefinitionIndex {
+public:
+    DefinitionIndex() = default;
+    explicit DefinitionIndex(CompilationUnit& cu) { add(cu); }
+
+    void add(CompilationUnit& cu);
+    void merge(const DefinitionIndex& other);
+
+    // Every entry under the key, in the order added.
+    std::vector<const DefinitionEntry*> find(std::string_view module, std::string_view name,
+                                             DefinitionKind kind, std::string_view owner = {}) const;
+    // The one command under the key whose receiver types have these hashes.
+    const DefinitionEntry* findOverload(std::string_view module, std::string_view name, DefinitionKind kind,
+                                        const std::vector<uint64_t>& receivers,
+                                        std::string_view owner = {}) const;
+
+    size_t size() const { return entries.size(); }
+    const std::vector<DefinitionEntry>& all() const { return entries; }
+
+private:
+    struct Key {
+        std::string_view module, owner, name;
+        DefinitionKind kind;
+        bool operator==(const Key&) const = default;
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    void insert(DefinitionEntry&& entry);
+
+    std::vector<DefinitionEntry> entries;
+    std::unordered_map<Key, std::vector<uint32_t>, KeyHash> keys;
+};
+
+} // namespace basis
+
+#endif // DEFINITIONINDEX_H
@@ -12,16 +12,16 @@ namespace basis {
     }
 
     void Diagnostics::note(Phase p, SourceLoc loc, std::string msg) {
-        report({Severity::Note, p, loc, std::move(msg), {}, {}});
+        report({Severity::Note, p, loc, std::move(msg), {}, {}, {}});
     }
     void Diagnostics::warning(Phase p, SourceLoc loc, std::string msg) {
-        report({Severity::Warning, p, loc, std::move(msg), {}, {}});
+        report({Severity::Warning, p, loc, std::move(msg), {}, {}, {}});
     }
     void Diagnostics::error(Phase p, SourceLoc loc, std::string msg) {
-        report({Severity::Error, p, loc, std::move(msg), {}, {}});
+        report({Severity::Error, p, loc, std::move(msg), {}, {}, {}});
     }
     void Diagnostics::fatal(Phase p, SourceLoc loc, std::string msg) {
-        report({Severity::Fatal, p, loc, std::move(msg), {}, {}});
+        report({Severity::Fatal, p, loc, std::move(msg), {}, {}, {}});
     }
 
     void Diagnostics::clear() {
@@ -38,6 +38,12 @@ namespace basis {
         other.clear();
     }
 
+    void Diagnostics::setFile(const std::string& file) {
+        for (auto& d : diags) {
+            if (d.file.empty()) d.file = file;
+        }
+    }
+
     static const char* severityLabel(Severity s) {
         switch (s) {
             case Severity::Note:    return "note";
@@ -53,12 +59,14 @@ namespace basis {
             case Phase::Lex:   return "lex";
             case Phase::Parse: return "parse";
             case Phase::Build: return "build";
+            case Phase::Import: return "import";
             case Phase::Sema:  return "sema";
         }
         return "?";
     }
 
     void printDiagnostic(std::ostream& os, const Diagnostic& d) {
+        if (!d.file.empty()) os << d.file << ": ";
         os << '[' << phaseLabel(d.phase) << "] " << severityLabel(d.severity) << ": ";
         if (d.loc.present()) os << '(' << d.loc.line << ':' << d.loc.col << ") ";
         os << d.message;
@@ -9,7 +9,7 @@
 namespace basis {
 
     enum class Severity { Note, Warning, Error, Fatal };
-    enum class Phase    { Lex, Parse, Build, Sema };
+    enum class Phase    { Lex, Parse, Build, Import, Sema };
 
     struct SourceLoc {
         size_t line = 0;
@@ -24,6 +24,7 @@ namespace basis {
         std::string message;
         SourceLoc   relatedLoc;
         std::string related;
+        std::string file;       // the input file, when compiling more than one
     };
 
     class Diagnostics {
@@ -43,6 +44,8 @@ namespace basis {
         void clear();
 
         void append(Diagnostics&& other);
+        // Name the file of every diagnostic that does not name one yet.
+        void setFile(const std::string& file);
 
     private:
         std::vector<Diagnostic> diags;
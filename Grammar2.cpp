@@ -1,4 +1,5 @@
 #include "Grammar2.h"
+#include "Operators.h"
 using namespace basis;
 
 
@@ -362,12 +363,21 @@ void Grammar2::initCommandDefinitions() {
 
    DEF_CMD = exclusiveGroup(Production::DEF_CMD,
        all(COMMAND, DEF_CMD_SIGNATURE, forward(DEF_CMD_BODY)) );
+
+   // Signatures only: the body, with any subs, is kept as its token span and
+   // parsed on demand (see LazyParse.h). The strict group ends it at the bound.
+   DEF_CMD_BODY_DEFERRED = defer(Production::DEF_CMD_BODY_DEFERRED, TokenType::EQUALS);
+   DEF_CMD_DEFERRED = exclusiveGroup(Production::DEF_CMD,
+       all(COMMAND, DEF_CMD_SIGNATURE, DEF_CMD_BODY_DEFERRED) );
 }
 
 void Grammar2::initClassTypes() {
     DEF_CLASS = exclusiveGroup(Production::DEF_CLASS,
         all(CLASS, group(Production::DEF_CLASS_NAME, TYPENAME), COLON,
             group(Production::DEF_CLASS_CMDS, oneOrMore( any(DEF_CMD_DECL,DEF_CMD))) ));
+    DEF_CLASS_DEFERRED = exclusiveGroup(Production::DEF_CLASS,
+        all(CLASS, group(Production::DEF_CLASS_NAME, TYPENAME), COLON,
+            group(Production::DEF_CLASS_CMDS, oneOrMore( any(DEF_CMD_DECL,DEF_CMD_DEFERRED))) ));
 }
 
 void Grammar2::initCommandBody() {
@@ -378,21 +388,10 @@ void Grammar2::initCommandBody() {
     CALL_PARM_EMPTY = as(Production::CALL_PARM_EMPTY, UNDERSCORE);
     CALL_PARAMETER = group(Production::CALL_PARAMETER, any( CALL_PARM_EMPTY, CALL_PARM_EXPR) );
 
-    CALL_OPERATOR = group(Production::CALL_OPERATOR,
-    any(
-            as(Production::CALL_OPER_SCOPE, DCOLON),
-            as(Production::CALL_OPER_CHOICE, PIPE),
-            as(Production::CALL_OPER_ADD, PLUS),
-            as(Production::CALL_OPER_SUBTRACT, MINUS),
-            as(Production::CALL_OPER_MULTIPLY, ASTERISK),
-            as(Production::CALL_OPER_DIVIDE, SLASH),
-            as(Production::CALL_OPER_LESSTHAN, LANGLE),
-            as(Production::CALL_OPER_GREATERTHAN, RANGLE),
-            as(Production::CALL_OPER_LESSTHAN_EQ, LEQUALS),
-            as(Production::CALL_OPER_GREATERTHAN_EQ, GREQUALS),
-            as(Production::CALL_OPER_EQUALS, EQUALS),
-            as(Production::CALL_OPER_INSERT, DLANGLE),
-            as(Production::CALL_OPER_EXTRACT, DRANGLE) ));
+    // one lookup on the token type; precedence is applied when the AST is built
+    std::vector<std::pair<TokenType, Production>> operatorTokens;
+    for (const OperatorInfo& op : operatorTable()) operatorTokens.emplace_back(op.token, op.production);
+    CALL_OPERATOR = group(Production::CALL_OPERATOR, dispatch(operatorTokens));
 
     CALL_BLOCKQUOTE = any(
         boundedGroup(Production::CALL_BLOCK_NOFAIL,
@@ -436,7 +435,7 @@ void Grammar2::initCommandBody() {
     CALL_COMMAND = boundedGroup(Production::CALL_COMMAND,
         all(CALL_CMD_TARGET, maybe(all(COLON, separated(CALL_PARAMETER, COMMA)))) );
     // special handling to enable multiple dispatch
-    CALL_VCOMMAND = boundedGroup(Production::CALL_VCOMMANDo,
+    CALL_VCOMMAND = boundedGroup(Production::CALL_VCOMMAND,
         all(LPAREN, separated(IDENTIFIER, COMMA), RPAREN, DCOLON, IDENTIFIER,
             maybe(all(COLON, separated(CALL_PARAMETER, COMMA))) ));
     CALL_FAIL = boundedGroup(Production::CALL_FAIL, all(FAIL, forward(CALL_EXPRESSION)));
@@ -472,24 +471,57 @@ void Grammar2::initCommandBody() {
 }
 
 void Grammar2::initCompilationUnit() {
+    DEF_TOP_LEVEL = any(
+        DEF_ALIAS,
+        DEF_CLASS,
+        DEF_CMD,
+        DEF_CMD_DECL,
+        DEF_CMD_INTRINSIC,
+        DEF_DOMAIN,
+        DEF_ENUM,
+        DEF_INSTANCE,
+        DEF_OBJECT,
+        DEF_PROGRAM,
+        DEF_RECORD,
+        DEF_TEST,
+        DEF_UNION,
+        DEF_VARIANT );
+
     COMPILATION_UNIT = group(Production::COMPILATION_UNIT, all(
         maybe(DEF_MODULE),
         maybe(oneOrMore(DEF_IMPORT)),
-        maybe(oneOrMore(any(
-            DEF_ALIAS,
-            DEF_CLASS,
-            DEF_CMD,
-            DEF_CMD_DECL,
-            DEF_CMD_INTRINSIC,
-            DEF_DOMAIN,
-            DEF_ENUM,
-            DEF_INSTANCE,
-            DEF_OBJECT,
-            DEF_PROGRAM,
-            DEF_RECORD,
-            DEF_TEST,
-            DEF_UNION,
-            DEF_VARIANT )))));
+        maybe(oneOrMore(DEF_TOP_LEVEL))));
+
+    // Same shape, but a definition that fails to parse becomes a PARSE_ERROR node
+    // spanning its bounded tokens, and parsing resumes with the next definition.
+    // A broken import is picked up by the same recovery, as it is bounded alike.
+    DEF_TOP_LEVEL_RECOVER = recover(DEF_TOP_LEVEL);
+    COMPILATION_UNIT_RECOVER = group(Production::COMPILATION_UNIT, all(
+        maybe(DEF_MODULE),
+        maybe(oneOrMore(DEF_IMPORT)),
+        maybe(oneOrMore(DEF_TOP_LEVEL_RECOVER))));
+
+    // Signatures only: command bodies are left unparsed, for passes that need
+    // just the interface of a unit.
+    DEF_TOP_LEVEL_SIGNATURES = any(
+        DEF_ALIAS,
+        DEF_CLASS_DEFERRED,
+        DEF_CMD_DEFERRED,
+        DEF_CMD_DECL,
+        DEF_CMD_INTRINSIC,
+        DEF_DOMAIN,
+        DEF_ENUM,
+        DEF_INSTANCE,
+        DEF_OBJECT,
+        DEF_PROGRAM,
+        DEF_RECORD,
+        DEF_TEST,
+        DEF_UNION,
+        DEF_VARIANT );
+    COMPILATION_UNIT_SIGNATURES = group(Production::COMPILATION_UNIT, all(
+        maybe(DEF_MODULE),
+        maybe(oneOrMore(DEF_IMPORT)),
+        maybe(oneOrMore(DEF_TOP_LEVEL_SIGNATURES))));
 }
 
 Grammar2& basis::getGrammar() {
@@ -187,6 +187,7 @@ namespace basis {
 
         // Class definition
         SPPF DEF_CLASS;
+        SPPF DEF_CLASS_DEFERRED;
 
         // Command definitions
         SPPF DEF_CMD;
@@ -212,6 +213,8 @@ namespace basis {
         SPPF DEF_CMD_PARM_NAME;
         SPPF DEF_CMD_IMPARMS;
         SPPF DEF_CMD_RETVAL;
+        SPPF DEF_CMD_BODY_DEFERRED;
+        SPPF DEF_CMD_DEFERRED;
 
         // Command Body
         SPPF DEF_CMD_BODY;
@@ -245,8 +248,13 @@ namespace basis {
 
         // Expressions
 
-        // top-level parse function
+        // top-level parse functions
+        SPPF DEF_TOP_LEVEL;
+        SPPF DEF_TOP_LEVEL_RECOVER;
         SPPF COMPILATION_UNIT;
+        SPPF COMPILATION_UNIT_RECOVER;
+        SPPF DEF_TOP_LEVEL_SIGNATURES;
+        SPPF COMPILATION_UNIT_SIGNATURES;
     };
     Grammar2& getGrammar();
 
@@ -0,0 +1,542 @@
+#include "GrammarLint.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace basis;
+
+namespace {
+
+    constexpr uint64_t costCap = std::numeric_limits<uint64_t>::max();
+
+    uint64_t addCost(uint64_t a, uint64_t b) {
+        return a > costCap - b ? costCap : a + b;
+    }
+
+    bool isLeaf(ParseFn::Kind kind) {
+        switch (kind) {
+            case ParseFn::Kind::Custom:
+            case ParseFn::Kind::Discard:
+            case ParseFn::Kind::Match:
+            case ParseFn::Kind::Dispatch:
+            case ParseFn::Kind::Defer:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+}
+
+size_t GrammarLintReport::count(LintFinding::Severity severity) const {
+    return std::count_if(findings.begin(), findings.end(),
+                         [severity](const LintFinding& f) { return f.severity == severity; });
+}
+
+void GrammarLint::addRule(const std::string& name, const SPPF& fn) {
+    if (!fn) return;
+    rules.emplace_back(name, fn);
+    names.emplace(fn.get(), name);
+}
+
+GrammarLintReport GrammarLint::lint(const Grammar2& g) {
+    GrammarLint lint;
+    const std::pair<const char*, const SPPF&> grammarRules[] = {
+            {"DECIMAL", g.DECIMAL},
+            {"HEXNUMBER", g.HEXNUMBER},
+            {"BINARY", g.BINARY},
+            {"NUMBER", g.NUMBER},
+            {"STRING", g.STRING},
+            {"LITERAL", g.LITERAL},
+            {"IDENTIFIER", g.IDENTIFIER},
+            {"TYPENAME", g.TYPENAME},
+            {"TYPENAME_UNQUALIFIED", g.TYPENAME_UNQUALIFIED},
+            {"QUALIFIED_TYPENAME", g.QUALIFIED_TYPENAME},
+            {"ALIAS", g.ALIAS},
+            {"CLASS", g.CLASS},
+            {"COMMAND", g.COMMAND},
+            {"DECLARE", g.DECLARE},
+            {"DOMAIN", g.DOMAIN},
+            {"ENUMERATION", g.ENUMERATION},
+            {"IMPORT", g.IMPORT},
+            {"INSTANCE", g.INSTANCE},
+            {"INTRINSIC", g.INTRINSIC},
+            {"MODULE", g.MODULE},
+            {"OBJECT", g.OBJECT},
+            {"PROGRAM", g.PROGRAM},
+            {"RECORD", g.RECORD},
+            {"SUBCOMMAND", g.SUBCOMMAND},
+            {"TEST", g.TEST},
+            {"FAIL", g.FAIL},
+            {"UNION", g.UNION},
+            {"VARIANT", g.VARIANT},
+            {"AMBANG", g.AMBANG},
+            {"AMPERSAND", g.AMPERSAND},
+            {"AMPHORA", g.AMPHORA},
+            {"APOSTROPHE", g.APOSTROPHE},
+            {"ASTERISK", g.ASTERISK},
+            {"BANGBRACE", g.BANGBRACE},
+            {"BANGLANGLE", g.BANGLANGLE},
+            {"CARAT", g.CARAT},
+            {"COMMA", g.COMMA},
+            {"COLON", g.COLON},
+            {"COLANGLE", g.COLANGLE},
+            {"COLBRACE", g.COLBRACE},
+            {"DCOLON", g.DCOLON},
+            {"DLANGLE", g.DLANGLE},
+            {"DRANGLE", g.DRANGLE},
+            {"EQUALS", g.EQUALS},
+            {"GREQUALS", g.GREQUALS},
+            {"LANGLE", g.LANGLE},
+            {"LEQUALS", g.LEQUALS},
+            {"LARROW", g.LARROW},
+            {"LBRACE", g.LBRACE},
+            {"LBRACKET", g.LBRACKET},
+            {"LPAREN", g.LPAREN},
+            {"MINUS", g.MINUS},
+            {"PERCENT", g.PERCENT},
+            {"PIPE", g.PIPE},
+            {"PLUS", g.PLUS},
+            {"POUND", g.POUND},
+            {"QBRACE", g.QBRACE},
+            {"QCOLON", g.QCOLON},
+            {"QLANGLE", g.QLANGLE},
+            {"QMARK", g.QMARK},
+            {"QMINUS", g.QMINUS},
+            {"DQMARK", g.DQMARK},
+            {"RANGLE", g.RANGLE},
+            {"RARROW", g.RARROW},
+            {"RBRACE", g.RBRACE},
+            {"RBRACKET", g.RBRACKET},
+            {"RPAREN", g.RPAREN},
+            {"SLASH", g.SLASH},
+            {"UNDERSCORE", g.UNDERSCORE},
+            {"DEF_ENUM_ITEM_LIST", g.DEF_ENUM_ITEM_LIST},
+            {"DEF_ENUM_NAME2", g.DEF_ENUM_NAME2},
+            {"DEF_ENUM_NAME1", g.DEF_ENUM_NAME1},
+            {"DEF_ENUM", g.DEF_ENUM},
+            {"DEF_INSTANCE", g.DEF_INSTANCE},
+            {"DEF_INSTANCE_NAME", g.DEF_INSTANCE_NAME},
+            {"DEF_INSTANCE_DELEGATE", g.DEF_INSTANCE_DELEGATE},
+            {"DEF_INSTANCE_TYPES", g.DEF_INSTANCE_TYPES},
+            {"TYPE_EXPR", g.TYPE_EXPR},
+            {"TYPE_EXPR_PTR", g.TYPE_EXPR_PTR},
+            {"TYPE_EXPR_VECTOR", g.TYPE_EXPR_VECTOR},
+            {"TYPE_EXPR_VECTOR_FIXED", g.TYPE_EXPR_VECTOR_FIXED},
+            {"TYPE_EXPR_CMD", g.TYPE_EXPR_CMD},
+            {"TYPE_CMDEXPR_ARG", g.TYPE_CMDEXPR_ARG},
+            {"TYPEDEF_NAME_Q", g.TYPEDEF_NAME_Q},
+            {"TYPEDEF_PARMS", g.TYPEDEF_PARMS},
+            {"TYPEDEF_PARM_TYPE", g.TYPEDEF_PARM_TYPE},
+            {"TYPEDEF_PARM_VALUE", g.TYPEDEF_PARM_VALUE},
+            {"TYPE_NAME_Q", g.TYPE_NAME_Q},
+            {"TYPE_NAME_ARGS", g.TYPE_NAME_ARGS},
+            {"TYPE_ARG_TYPE", g.TYPE_ARG_TYPE},
+            {"TYPE_ARG_VALUE", g.TYPE_ARG_VALUE},
+            {"TYPE_EXPR_DOMAIN", g.TYPE_EXPR_DOMAIN},
+            {"DEF_ALIAS", g.DEF_ALIAS},
+            {"DEF_MODULE", g.DEF_MODULE},
+            {"DEF_MODULE_NAME", g.DEF_MODULE_NAME},
+            {"DEF_PROGRAM", g.DEF_PROGRAM},
+            {"DEF_TEST", g.DEF_TEST},
+            {"DEF_IMPORT", g.DEF_IMPORT},
+            {"DEF_IMPORT_FILE", g.DEF_IMPORT_FILE},
+            {"DEF_IMPORT_STANDARD", g.DEF_IMPORT_STANDARD},
+            {"DEF_DOMAIN", g.DEF_DOMAIN},
+            {"DEF_RECORD", g.DEF_RECORD},
+            {"DEF_RECORD_FIELDS", g.DEF_RECORD_FIELDS},
+            {"DEF_RECORD_FIELD", g.DEF_RECORD_FIELD},
+            {"DEF_OBJECT", g.DEF_OBJECT},
+            {"DEF_OBJECT_FIELDS", g.DEF_OBJECT_FIELDS},
+            {"DEF_OBJECT_FIELD", g.DEF_OBJECT_FIELD},
+            {"DEF_UNION", g.DEF_UNION},
+            {"DEF_UNION_CANDIDATES", g.DEF_UNION_CANDIDATES},
+            {"DEF_UNION_CANDIDATE", g.DEF_UNION_CANDIDATE},
+            {"DEF_VARIANT", g.DEF_VARIANT},
+            {"DEF_VARIANT_CANDIDATES", g.DEF_VARIANT_CANDIDATES},
+            {"DEF_VARIANT_CANDIDATE", g.DEF_VARIANT_CANDIDATE},
+            {"DEF_INLINE_RECORD", g.DEF_INLINE_RECORD},
+            {"DEF_INLINE_UNION", g.DEF_INLINE_UNION},
+            {"DEF_INLINE_OBJECT", g.DEF_INLINE_OBJECT},
+            {"DEF_INLINE_VARIANT", g.DEF_INLINE_VARIANT},
+            {"DEF_CLASS", g.DEF_CLASS},
+            {"DEF_CLASS_DEFERRED", g.DEF_CLASS_DEFERRED},
+            {"DEF_CMD", g.DEF_CMD},
+            {"DEF_SUB", g.DEF_SUB},
+            {"DEF_SUBS", g.DEF_SUBS},
+            {"DEF_CMD_DECL", g.DEF_CMD_DECL},
+            {"DEF_CMD_INTRINSIC", g.DEF_CMD_INTRINSIC},
+            {"DEF_CMD_SIGNATURE", g.DEF_CMD_SIGNATURE},
+            {"DEF_CMD_REGULAR_FORM", g.DEF_CMD_REGULAR_FORM},
+            {"DEF_CMD_RECEIVERS", g.DEF_CMD_RECEIVERS},
+            {"DEF_CMD_RECEIVER", g.DEF_CMD_RECEIVER},
+            {"DEF_CMD_NAME_SPEC", g.DEF_CMD_NAME_SPEC},
+            {"DEF_CMD_NAME", g.DEF_CMD_NAME},
+            {"DEF_CMD_FAILS", g.DEF_CMD_FAILS},
+            {"DEF_CMD_MAYFAIL", g.DEF_CMD_MAYFAIL},
+            {"DEF_CMD_PARMS", g.DEF_CMD_PARMS},
+            {"DEF_CMD_VPARMS", g.DEF_CMD_VPARMS},
+            {"DEF_CMD_PARM_LIST", g.DEF_CMD_PARM_LIST},
+            {"DEF_CMD_PARM", g.DEF_CMD_PARM},
+            {"DEF_CMD_PARMTYPE_NAME", g.DEF_CMD_PARMTYPE_NAME},
+            {"DEF_CMD_PARMTYPE_VAR", g.DEF_CMD_PARMTYPE_VAR},
+            {"DEF_CMD_PARM_TYPE", g.DEF_CMD_PARM_TYPE},
+            {"DEF_CMD_PARM_NAME", g.DEF_CMD_PARM_NAME},
+            {"DEF_CMD_IMPARMS", g.DEF_CMD_IMPARMS},
+            {"DEF_CMD_RETVAL", g.DEF_CMD_RETVAL},
+            {"DEF_CMD_BODY_DEFERRED", g.DEF_CMD_BODY_DEFERRED},
+            {"DEF_CMD_DEFERRED", g.DEF_CMD_DEFERRED},
+            {"DEF_CMD_BODY", g.DEF_CMD_BODY},
+            {"DEF_CMD_EMPTY", g.DEF_CMD_EMPTY},
+            {"CALL_GROUP", g.CALL_GROUP},
+            {"CALL_INVOKE", g.CALL_INVOKE},
+            {"CALL_EXPRESSION", g.CALL_EXPRESSION},
+            {"CALL_CONSTRUCTOR", g.CALL_CONSTRUCTOR},
+            {"CALL_COMMAND", g.CALL_COMMAND},
+            {"CALL_VCOMMAND", g.CALL_VCOMMAND},
+            {"CALL_FAIL", g.CALL_FAIL},
+            {"CALL_ASSIGNMENT", g.CALL_ASSIGNMENT},
+            {"SUBCALL_EXPRESSION", g.SUBCALL_EXPRESSION},
+            {"CALL_EXPR_TERM", g.CALL_EXPR_TERM},
+            {"CALL_EXPR_SUFFIX", g.CALL_EXPR_SUFFIX},
+            {"CALL_EXPR_INDEX", g.CALL_EXPR_INDEX},
+            {"CALL_EXPR_ADDR", g.CALL_EXPR_ADDR},
+            {"CALL_EXPR_DEREF", g.CALL_EXPR_DEREF},
+            {"CALL_OPERATOR", g.CALL_OPERATOR},
+            {"CALL_QUOTE", g.CALL_QUOTE},
+            {"CALL_SUBQUOTE", g.CALL_SUBQUOTE},
+            {"CALL_BLOCKQUOTE", g.CALL_BLOCKQUOTE},
+            {"CALL_CMD_LITERAL", g.CALL_CMD_LITERAL},
+            {"CALL_CMD_TARGET", g.CALL_CMD_TARGET},
+            {"CALL_IDENTIFIER", g.CALL_IDENTIFIER},
+            {"CALL_PARAMETER", g.CALL_PARAMETER},
+            {"CALL_PARM_EXPR", g.CALL_PARM_EXPR},
+            {"CALL_PARM_EMPTY", g.CALL_PARM_EMPTY},
+            {"RECOVER_SPEC", g.RECOVER_SPEC},
+            {"BLOCK", g.BLOCK},
+            {"DEF_TOP_LEVEL", g.DEF_TOP_LEVEL},
+            {"DEF_TOP_LEVEL_RECOVER", g.DEF_TOP_LEVEL_RECOVER},
+            {"COMPILATION_UNIT", g.COMPILATION_UNIT},
+            {"COMPILATION_UNIT_RECOVER", g.COMPILATION_UNIT_RECOVER},
+            {"DEF_TOP_LEVEL_SIGNATURES", g.DEF_TOP_LEVEL_SIGNATURES},
+            {"COMPILATION_UNIT_SIGNATURES", g.COMPILATION_UNIT_SIGNATURES},
+    };
+    for (auto& [name, fn] : grammarRules) lint.addRule(name, fn);
+    return lint.run();
+}
+
+std::vector<const ParseFn*> GrammarLint::children(const ParseFn* fn) const {
+    std::vector<const ParseFn*> result;
+    for (auto& child : fn->parts().children) result.push_back(child.get());
+    // a forward() read before its target was assigned
+    std::erase(result, nullptr);
+    return result;
+}
+
+void GrammarLint::collect(const ParseFn* fn, const std::string& owner) {
+    if (nodes.contains(fn)) return;
+    auto named = names.find(fn);
+    Node& node = nodes[fn];
+    node.owner = named != names.end() ? named->second : owner;
+    node.children = children(fn);
+    order.push_back(fn);
+    for (const ParseFn* child : node.children) collect(child, node.owner);
+}
+
+bool GrammarLint::nullableSequence(std::span<const SPPF> sequence) {
+    return std::all_of(sequence.begin(), sequence.end(),
+                       [this](const SPPF& sp) { return nodes[sp.get()].nullable; });
+}
+
+GrammarLint::TokenSet GrammarLint::firstOfSequence(std::span<const SPPF> sequence) {
+    TokenSet first;
+    for (auto& fn : sequence) {
+        const Node& node = nodes[fn.get()];
+        first |= node.first;
+        if (!node.nullable) break;
+    }
+    return first;
+}
+
+// Nullable (can succeed without consuming), infallible (succeeds whenever a token
+// remains) and FIRST all only grow, so iterate to a fixpoint to settle cycles.
+void GrammarLint::solveNullableAndFirst() {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const ParseFn* fn : order) {
+            bool nullable = false;
+            bool infallible = false;
+            TokenSet first;
+            auto child = [this](const SPPF& sp) -> const Node& { return nodes[sp.get()]; };
+            const ParseFn::Parts parts = fn->parts();
+            switch (parts.kind) {
+                case ParseFn::Kind::Custom:
+                    first.set();
+                    break;
+                case ParseFn::Kind::Discard:
+                    first.set(static_cast<size_t>(parts.type));
+                    break;
+                case ParseFn::Kind::Match:
+                    first.set(static_cast<size_t>(parts.type));
+                    break;
+                case ParseFn::Kind::Dispatch: {
+                    auto matches = parts.matches;
+                    for (size_t i = 0; i < matches.size(); ++i) first.set(i, matches[i]);
+                    break;
+                }
+                case ParseFn::Kind::Defer:
+                    first.set(static_cast<size_t>(parts.type));
+                    break;
+                case ParseFn::Kind::Maybe: {
+                    nullable = infallible = true;
+                    first = child(parts.children[0]).first;
+                    break;
+                }
+                case ParseFn::Kind::Prefix: {
+                    auto sequence = parts.children;
+                    nullable = true;
+                    infallible = true;
+                    for (size_t i = 1; i < sequence.size(); ++i) infallible = infallible && child(sequence[i]).infallible;
+                    first = firstOfSequence(sequence);
+                    break;
+                }
+                case ParseFn::Kind::Any:
+                    for (auto& alternative : parts.children) {
+                        nullable = nullable || child(alternative).nullable;
+                        infallible = infallible || child(alternative).infallible;
+                        first |= child(alternative).first;
+                    }
+                    break;
+                case ParseFn::Kind::All: {
+                    auto sequence = parts.children;
+                    nullable = nullableSequence(sequence);
+                    infallible = std::all_of(sequence.begin(), sequence.end(),
+                                             [&](const SPPF& sp) { return child(sp).infallible; });
+                    first = firstOfSequence(sequence);
+                    break;
+                }
+                case ParseFn::Kind::BoundedGroup: {
+                    // the group must also end at the bound, so it is never infallible
+                    auto sequence = parts.children;
+                    nullable = nullableSequence(sequence);
+                    first = firstOfSequence(sequence);
+                    break;
+                }
+                case ParseFn::Kind::OneOrMore: {
+                    const Node& node = child(parts.children[0]);
+                    nullable = node.nullable;
+                    infallible = node.infallible;
+                    first = node.first;
+                    break;
+                }
+                case ParseFn::Kind::Separated: {
+                    const Node& element = child(parts.children[0]);
+                    const Node& separator = child(parts.children[1]);
+                    nullable = element.nullable && (parts.optionalSeparator || separator.nullable);
+                    infallible = element.infallible && (parts.optionalSeparator || separator.infallible);
+                    first = element.first;
+                    if (element.nullable) first |= separator.first;
+                    break;
+                }
+                case ParseFn::Kind::Recover: {
+                    // a failure is turned into a PARSE_ERROR node for the leading token
+                    const Node& node = child(parts.children[0]);
+                    nullable = node.nullable;
+                    infallible = true;
+                    first.set();
+                    break;
+                }
+                case ParseFn::Kind::Bound:
+                case ParseFn::Kind::Group:
+                case ParseFn::Kind::Forward:
+                case ParseFn::Kind::As: {
+                    const Node& node = nodes[fn];
+                    if (node.children.empty()) break;
+                    const Node& inner = nodes[node.children.front()];
+                    nullable = inner.nullable;
+                    infallible = inner.infallible;
+                    first = inner.first;
+                    break;
+                }
+            }
+            Node& node = nodes[fn];
+            if (nullable != node.nullable || infallible != node.infallible || first != node.first) {
+                node.nullable = nullable;
+                node.infallible = infallible;
+                node.first = first;
+                changed = true;
+            }
+        }
+    }
+}
+
+// The children a combinator can try on the token it starts on.
+std::vector<const ParseFn*> GrammarLint::startChildren(const ParseFn* fn) {
+    auto sequenceStart = [this](std::span<const SPPF> sequence) {
+        std::vector<const ParseFn*> result;
+        for (auto& sp : sequence) {
+            result.push_back(sp.get());
+            if (!nodes[sp.get()].nullable) break;
+        }
+        return result;
+    };
+    const ParseFn::Parts parts = fn->parts();
+    switch (parts.kind) {
+        case ParseFn::Kind::Prefix:       return sequenceStart(parts.children);
+        case ParseFn::Kind::All:          return sequenceStart(parts.children);
+        case ParseFn::Kind::BoundedGroup: return sequenceStart(parts.children);
+        case ParseFn::Kind::Separated: {
+            std::vector<const ParseFn*> result{parts.children[0].get()};
+            if (nodes[parts.children[0].get()].nullable) result.push_back(parts.children[1].get());
+            return result;
+        }
+        default:
+            return nodes[fn].children;
+    }
+}
+
+// Leaves test the token once; everything else is the sum of the children that can
+// be tried on it. A rule reached again on the same token is left recursion.
+uint64_t GrammarLint::startCost(const ParseFn* fn, std::vector<const ParseFn*>& stack) {
+    Node& node = nodes[fn];
+    if (node.costState == 2) return node.cost;
+    if (node.costState == 1) {
+        auto at = std::find(stack.begin(), stack.end(), fn);
+        std::string cycle;
+        for (auto it = at; it != stack.end(); ++it) {
+            if (names.contains(*it)) cycle += names[*it] + " -> ";
+        }
+        cycle += describe(fn);
+        report(LintFinding::Severity::Error, fn,
+               "left recursion: " + cycle + " is reached again without consuming a token");
+        return 0;
+    }
+    if (isLeaf(fn->kind())) {
+        node.costState = 2;
+        node.cost = 1;
+        return 1;
+    }
+    node.costState = 1;
+    stack.push_back(fn);
+    uint64_t cost = 0;
+    for (const ParseFn* child : startChildren(fn)) cost = addCost(cost, startCost(child, stack));
+    stack.pop_back();
+    node.cost = cost;
+    node.costState = 2;
+    return cost;
+}
+
+void GrammarLint::checkLoops(const ParseFn* fn) {
+    const ParseFn::Parts parts = fn->parts();
+    if (parts.kind == ParseFn::Kind::OneOrMore) {
+        const ParseFn* spfn = parts.children[0].get();
+        if (nodes[spfn].nullable) {
+            report(LintFinding::Severity::Error, fn,
+                   "oneOrMore of " + describe(spfn) + ", which can succeed without consuming a token, never ends");
+        }
+    }
+    else if (parts.kind == ParseFn::Kind::Separated) {
+        if (nodes[parts.children[0].get()].nullable && nodes[parts.children[1].get()].nullable) {
+            report(LintFinding::Severity::Error, fn,
+                   "separated list of " + describe(parts.children[0].get()) + " by " + describe(parts.children[1].get())
+                   + " never ends: both can succeed without consuming a token");
+        }
+    }
+}
+
+void GrammarLint::checkAlternatives(const ParseFn* fn) {
+    const ParseFn::Parts parts = fn->parts();
+    if (parts.kind != ParseFn::Kind::Any) return;
+    auto alternatives = parts.children;
+    auto label = [&](size_t i) {
+        return "alternative " + std::to_string(i + 1) + " (" + describe(alternatives[i].get()) + ")";
+    };
+    std::vector<bool> shadowed(alternatives.size(), false);
+    for (size_t i = 0; i < alternatives.size(); ++i) {
+        if (shadowed[i]) continue;
+        const ParseFn* earlier = alternatives[i].get();
+        const Node& a = nodes[earlier];
+        if (a.infallible && i + 1 < alternatives.size()) {
+            report(LintFinding::Severity::Warning, fn,
+                   label(i) + " always succeeds, so the " + std::to_string(alternatives.size() - i - 1)
+                   + " after it are never tried");
+            return;
+        }
+        bool singleToken = !a.nullable && (earlier->kind() == ParseFn::Kind::Discard
+                                        || earlier->kind() == ParseFn::Kind::Match
+                                        || earlier->kind() == ParseFn::Kind::Dispatch);
+        for (size_t j = i + 1; j < alternatives.size(); ++j) {
+            if (shadowed[j]) continue;
+            const ParseFn* later = alternatives[j].get();
+            const Node& b = nodes[later];
+            if (later == earlier) {
+                shadowed[j] = true;
+                report(LintFinding::Severity::Warning, fn, label(j) + " repeats " + label(i) + " and is never tried");
+            }
+            else if (singleToken && !b.nullable && b.first.any() && (b.first & ~a.first).none()) {
+                shadowed[j] = true;
+                report(LintFinding::Severity::Warning, fn,
+                       label(j) + " is shadowed by " + label(i) + ", which matches every token it can start with");
+            }
+            else if ((a.first & b.first).any()) {
+                TokenSet overlap = a.first & b.first;
+                std::string tokens;
+                size_t shown = 0;
+                for (size_t t = 0; t < overlap.size() && shown < 4; ++t) {
+                    if (!overlap.test(t)) continue;
+                    tokens += (shown++ ? ", " : "") + std::string(tokenTypeName(static_cast<TokenType>(t)));
+                }
+                if (overlap.count() > shown) tokens += ", ...";
+                report(LintFinding::Severity::Note, fn,
+                       label(i) + " and " + label(j) + " can both start with " + tokens);
+            }
+        }
+    }
+}
+
+std::string GrammarLint::describe(const ParseFn* fn) const {
+    auto named = names.find(fn);
+    if (named != names.end()) return named->second;
+    const ParseFn::Parts parts = fn->parts();
+    switch (parts.kind) {
+        case ParseFn::Kind::Custom:       return "custom";
+        case ParseFn::Kind::Discard:      return std::string("discard(") + tokenTypeName(parts.type) + ")";
+        case ParseFn::Kind::Match:        return std::string("match(") + tokenTypeName(parts.type) + ")";
+        case ParseFn::Kind::Dispatch:     return "dispatch";
+        case ParseFn::Kind::Defer:        return std::string("defer(") + tokenTypeName(parts.type) + ")";
+        case ParseFn::Kind::Maybe:        return "maybe";
+        case ParseFn::Kind::Prefix:       return "prefix";
+        case ParseFn::Kind::Any:          return "any";
+        case ParseFn::Kind::All:          return "all";
+        case ParseFn::Kind::OneOrMore:    return "oneOrMore";
+        case ParseFn::Kind::Separated:    return "separated";
+        case ParseFn::Kind::Bound:        return "bound";
+        case ParseFn::Kind::Group:        return "group";
+        case ParseFn::Kind::BoundedGroup: return "boundedGroup";
+        case ParseFn::Kind::As:           return "as";
+        case ParseFn::Kind::Recover:      return "recover";
+        case ParseFn::Kind::Forward: {
+            auto target = names.find(parts.children[0].get());
+            return target != names.end() ? "forward(" + target->second + ")" : "forward";
+        }
+    }
+    return "?";
+}
+
+void GrammarLint::report(LintFinding::Severity severity, const ParseFn* fn, std::string message) {
+    result.findings.push_back({severity, nodes[fn].owner, std::move(message)});
+}
+
+GrammarLintReport GrammarLint::run() {
+    nodes.clear();
+    order.clear();
+    result = {};
+    for (auto& [name, fn] : rules) collect(fn.get(), name);
+    solveNullableAndFirst();
+    for (const ParseFn* fn : order) checkLoops(fn);
+    for (const ParseFn* fn : order) checkAlternatives(fn);
+    std::vector<const ParseFn*> stack;
+    for (auto& [name, fn] : rules) result.costs.push_back({name, startCost(fn.get(), stack)});
+    return result;
+}
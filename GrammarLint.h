@@ -0,0 +1,93 @@
+#ifndef GRAMMARLINT_H
+#define GRAMMARLINT_H
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Grammar2.h"
+#include "Parsing2.h"
+#include "Token.h"
+
+namespace basis {
+
+    struct LintFinding {
+        enum class Severity { Error, Warning, Note };
+        Severity    severity;
+        std::string rule;       // the nearest named rule containing the combinator
+        std::string message;
+    };
+
+    // Worst-case number of leaf tests one call of a rule makes against the token
+    // it starts on, when every alternative that can start there is tried and fails.
+    // Nesting multiplies it, so it is the factor by which the parser can re-scan
+    // a token before committing.
+    struct RuleCost {
+        std::string rule;
+        uint64_t    factor;
+    };
+
+    struct GrammarLintReport {
+        std::vector<LintFinding> findings;
+        std::vector<RuleCost>    costs;     // in the order the rules were added
+        size_t count(LintFinding::Severity severity) const;
+    };
+
+    // Static checks over a combinator graph, without parsing anything:
+    //  - errors: a nullable child under oneOrMore() or a separated() list whose
+    //    element and separator are both nullable (the loop never ends), and rules
+    //    that can reach themselves without consuming a token (left recursion)
+    //  - warnings: any() alternatives that can never be tried, because an earlier
+    //    one always succeeds, is the same combinator, or matches every token the
+    //    later one can start with
+    //  - notes: any() alternatives whose FIRST sets overlap, so that the later one
+    //    is tried only after the earlier one fails on the same token
+    // Custom combinators are opaque: they are taken to consume a token and to start
+    // with any token.
+    class GrammarLint {
+    public:
+        // Name a root of the graph; findings are attributed to the nearest named rule.
+        void addRule(const std::string& name, const SPPF& fn);
+        GrammarLintReport run();
+
+        // Every rule of a grammar, in declaration order.
+        static GrammarLintReport lint(const Grammar2& grammar);
+
+    private:
+        using TokenSet = std::bitset<tokenTypeCount>;
+        struct Node {
+            std::vector<const ParseFn*> children;
+            std::string owner;
+            bool nullable = false;
+            bool infallible = false;
+            TokenSet first;
+            uint64_t cost = 0;
+            int costState = 0;      // 0 unvisited, 1 on the stack, 2 done
+        };
+
+        void collect(const ParseFn* fn, const std::string& owner);
+        std::vector<const ParseFn*> children(const ParseFn* fn) const;
+        std::vector<const ParseFn*> startChildren(const ParseFn* fn);
+        void solveNullableAndFirst();
+        bool nullableSequence(std::span<const SPPF> sequence);
+        TokenSet firstOfSequence(std::span<const SPPF> sequence);
+        uint64_t startCost(const ParseFn* fn, std::vector<const ParseFn*>& stack);
+        void checkLoops(const ParseFn* fn);
+        void checkAlternatives(const ParseFn* fn);
+        std::string describe(const ParseFn* fn) const;
+        void report(LintFinding::Severity severity, const ParseFn* fn, std::string message);
+
+        std::vector<std::pair<std::string, SPPF>> rules;
+        std::unordered_map<const ParseFn*, std::string> names;
+        std::unordered_map<const ParseFn*, Node> nodes;
+        std::vector<const ParseFn*> order;     // first-visit order, for stable reports
+        GrammarLintReport result;
+    };
+
+}
+
+#endif // GRAMMARLINT_H
@@ -0,0 +1,319 @@
+#include "IncrementalParse.h"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "Grammar2.h"
+#include "Parsing2.h"
+
+namespace basis {
+
+    TokenEdit diffTokens(const std::list<spToken>& oldTokens, const std::list<spToken>& newTokens) {
+        // the lexer bounds each token by the next one at its column or left of it
+        auto same = [](const Token& a, const Token& b) {
+            return a.type == b.type && a.text == b.text && a.columnNumber == b.columnNumber;
+        };
+        // before the edit tokens keep their lines; after it they all move by as many
+        size_t prefix = 0;
+        auto o = oldTokens.cbegin();
+        auto n = newTokens.cbegin();
+        while (o != oldTokens.cend() && n != newTokens.cend() && same(**o, **n) &&
+               (*o)->lineNumber == (*n)->lineNumber) {
+            ++o; ++n; ++prefix;
+        }
+        size_t suffix = 0;
+        auto ro = oldTokens.crbegin();
+        auto rn = newTokens.crbegin();
+        size_t oldRest = oldTokens.size() - prefix;
+        size_t newRest = newTokens.size() - prefix;
+        const Token* oldNext = nullptr;
+        const Token* newNext = nullptr;
+        auto sameLines = [&] {
+            return !oldNext ||
+                   oldNext->lineNumber - (*ro)->lineNumber == newNext->lineNumber - (*rn)->lineNumber;
+        };
+        while (suffix < oldRest && suffix < newRest && same(**ro, **rn) && sameLines()) {
+            oldNext = ro->get();
+            newNext = rn->get();
+            ++ro; ++rn; ++suffix;
+        }
+        return TokenEdit{prefix, oldRest - suffix, newRest - suffix, n, true};
+    }
+
+    namespace {
+
+        using TokenIt = std::list<spToken>::iterator;
+
+        // from whichever end is nearer
+        TokenIt at(std::list<spToken>& tokens, size_t pos) {
+            if (pos > tokens.size() / 2)
+                return std::prev(tokens.end(), static_cast<std::ptrdiff_t>(tokens.size() - pos));
+            return std::next(tokens.begin(), static_cast<std::ptrdiff_t>(pos));
+        }
+
+        const Token* firstToken(const spParseTree& pt) {
+            for (auto node = pt; node; node = node->spDown) {
+                if (node->pToken) return node->pToken;
+            }
+            return nullptr;
+        }
+
+        bool isHeader(const spParseTree& pt) {
+            return pt->production == Production::DEF_MODULE || pt->production == Production::DEF_IMPORT;
+        }
+
+        // Give a token the position of its counterpart in newTokens.
+        void place(Token& t, const Token& fresh, size_t index) {
+            t.lineNumber = fresh.lineNumber;
+            t.columnNumber = fresh.columnNumber;
+            t.index = static_cast<uint32_t>(index);
+        }
+
+        // Splice the inserted tokens of newTokens into `tokens`, and give every token
+        // of the result the line, column, index and bound of its counterpart in
+        // newTokens. The tokens kept are the ones the untouched subtrees refer to.
+        // Used when there is no region to confine the update to.
+        void adoptAll(std::list<spToken>& tokens, std::list<spToken>& newTokens, const TokenEdit& edit) {
+            std::vector<spToken> fresh(newTokens.begin(), newTokens.end());
+            auto kept = tokens.erase(at(tokens, edit.begin), at(tokens, edit.begin + edit.removed));
+            auto inserted = at(newTokens, edit.begin);
+            tokens.splice(kept, newTokens, inserted, at(newTokens, edit.begin + edit.inserted));
+
+            std::vector<spToken> merged(tokens.begin(), tokens.end());
+            for (size_t i = 0; i < merged.size(); ++i) {
+                const Token& f = *fresh[i];
+                bool kept = f.bound && f.bound->index < merged.size();
+                merged[i]->bound = kept ? merged[f.bound->index] : nullptr;
+                place(*merged[i], f, i);
+            }
+        }
+
+        // adoptAll() for an edit inside the tokens [regionBegin, regionEnd) of the old
+        // list, of which `o` is the first. diffTokens leaves the tokens before the edit
+        // where they were and moves the ones after it by whole lines, and no bound
+        // leaves the region but for the token after it, so only the region has bounds
+        // to update; the tokens after it move by the same lines and indices. Fills
+        // `region` with the tokens of the region and points `regionStart` at the first
+        // of them, or returns false if they break that rule, leaving the lists as they
+        // were.
+        bool adopt(std::list<spToken>& tokens, TokenIt o, std::list<spToken>& newTokens,
+                   const TokenEdit& edit, size_t regionBegin, size_t regionEnd, std::vector<spToken>& region,
+                   TokenIt& regionStart) {
+            size_t shift = edit.inserted - edit.removed;   // wraps when tokens go, as indices do
+            size_t newRegionEnd = regionEnd + shift;
+            // the first definition of the region has no token before it to point at it
+            if (regionBegin == edit.begin && edit.removed > 0 && regionBegin > 0) return false;
+
+            std::list<spToken>::const_iterator n;
+            if (edit.located)
+                n = std::prev(edit.newBegin, static_cast<std::ptrdiff_t>(edit.begin - regionBegin));
+            else
+                n = at(newTokens, regionBegin);
+            auto inserted = std::next(n, static_cast<std::ptrdiff_t>(edit.begin - regionBegin));
+            auto insertedEnd = std::next(inserted, static_cast<std::ptrdiff_t>(edit.inserted));
+            std::vector<spToken> fresh;
+            for (size_t i = regionBegin; i < newRegionEnd; ++i, ++n) fresh.push_back(*n);
+            const Token* freshAfter = n == newTokens.end() ? nullptr : n->get();
+
+            regionStart = o;
+            for (size_t i = regionBegin; i < edit.begin; ++i, ++o) region.push_back(*o);
+            auto removed = o;
+            region.insert(region.end(), inserted, insertedEnd);
+            std::advance(o, static_cast<std::ptrdiff_t>(edit.removed));
+            auto kept = o;
+            for (size_t i = edit.begin + edit.removed; i < regionEnd; ++i, ++o) region.push_back(*o);
+            const spToken after = o == tokens.end() ? nullptr : *o;
+            if ((after == nullptr) != (freshAfter == nullptr)) {
+                region.clear();
+                return false;
+            }
+
+            std::vector<spToken> bounds(region.size());
+            for (size_t i = 0; i < region.size(); ++i) {
+                const Token* b = fresh[i]->bound.get();
+                if (!b) continue;
+                if (b->index >= regionBegin && b->index < newRegionEnd) {
+                    bounds[i] = region[b->index - regionBegin];
+                } else if (b->index == newRegionEnd && after) {
+                    bounds[i] = after;
+                } else {
+                    region.clear();
+                    return false;
+                }
+            }
+
+            tokens.erase(removed, kept);
+            tokens.splice(kept, newTokens, inserted, insertedEnd);
+            // an empty erase turns the spliced const_iterator into an iterator
+            if (regionBegin == edit.begin)
+                regionStart = edit.inserted > 0 ? tokens.erase(inserted, inserted) : kept;
+            for (size_t i = 0; i < region.size(); ++i) {
+                region[i]->bound = std::move(bounds[i]);
+                place(*region[i], *fresh[i], regionBegin + i);
+            }
+            if (after && (shift != 0 || after->lineNumber != freshAfter->lineNumber)) {
+                size_t lines = freshAfter->lineNumber - after->lineNumber;   // wraps as well
+                for (; o != tokens.end(); ++o) {
+                    (*o)->lineNumber += lines;
+                    (*o)->index = static_cast<uint32_t>((*o)->index + shift);
+                }
+            }
+            return true;
+        }
+
+    }
+
+    IncrementalUnit::IncrementalUnit(std::list<spToken> tokens, bool recovering)
+        : toks(std::move(tokens)), recovering(recovering) {
+        fullParse(nullptr);
+    }
+
+    bool IncrementalUnit::fullParse(ReparseStats* stats) {
+        Grammar2& grammar = getGrammar();
+        Parser parser(toks, recovering ? grammar.COMPILATION_UNIT_RECOVER : grammar.COMPILATION_UNIT);
+        bool ok = parser.parse() && parser.allTokensConsumed();
+        unit = ok ? parser.parseTree : nullptr;
+        indexDefinitions();
+        if (stats) {
+            stats->fullParse = true;
+            stats->reused = 0;
+            stats->reparsed = definitions.size();
+        }
+        return ok;
+    }
+
+    size_t IncrementalUnit::startOf(size_t i) const {
+        return i < definitions.size() ? (*definitions[i].start)->index : toks.size();
+    }
+
+    namespace {
+
+        // Find where each of the definitions from `children` up to `stop` starts, in
+        // the tokens [from, end) of which `first` is at `from`. Definitions open at the
+        // tokens chained by bound from the first token. Leading keywords are usually
+        // discarded from the tree, so each definition starts at the last such lead at
+        // or before its first recorded token. Reads Token::index.
+        template <typename Definition>
+        bool locate(TokenIt first, size_t from, size_t end, spParseTree children, const spParseTree& stop,
+                    std::vector<Definition>& found) {
+            std::vector<size_t> leads;
+            for (const Token* t = first->get(); t && t->index < end; t = t->bound.get()) {
+                if (t->index < from || (!leads.empty() && t->index <= leads.back())) return false;
+                leads.push_back(t->index);
+            }
+            auto it = first;
+            size_t pos = from;
+            for (auto c = children; c != stop; c = c->spNext) {
+                const Token* t = firstToken(c);
+                if (!t || t->index < from || t->index >= end) return false;
+                auto lead = std::upper_bound(leads.begin(), leads.end(), t->index);
+                if (lead == leads.begin() || *(lead - 1) < pos) return false;
+                std::advance(it, static_cast<std::ptrdiff_t>(*(lead - 1) - pos));
+                pos = *(lead - 1);
+                found.push_back(Definition{it, c});
+            }
+            return true;
+        }
+
+    }
+
+    void IncrementalUnit::indexDefinitions() {
+        definitions.clear();
+        if (!unit || unit->production != Production::COMPILATION_UNIT || toks.empty()) return;
+        if (!locate(toks.begin(), 0, toks.size(), unit->spDown, nullptr, definitions)) definitions.clear();
+    }
+
+    bool IncrementalUnit::reparse(std::list<spToken>& newTokens, const TokenEdit& edit, ReparseStats* stats) {
+        if (stats) *stats = ReparseStats{};
+        if (toks.empty() || edit.begin + edit.removed > toks.size() ||
+            toks.size() - edit.removed + edit.inserted != newTokens.size()) {
+            toks = std::move(newTokens);
+            newTokens.clear();
+            return fullParse(stats);
+        }
+        if (definitions.empty()) {
+            adoptAll(toks, newTokens, edit);
+            return fullParse(stats);
+        }
+
+        // the definitions are ordered by where they start: the ones whose tokens
+        // overlap or abut the edit are a run of them, found by their old positions
+        size_t editEnd = edit.begin + edit.removed;
+        auto byStart = [](const Definition& d, size_t pos) { return (*d.start)->index < pos; };
+        size_t first = static_cast<size_t>(
+            std::lower_bound(definitions.begin() + 1, definitions.end(), edit.begin, byStart) -
+            definitions.begin()) - 1;
+        size_t last = static_cast<size_t>(
+            std::upper_bound(definitions.begin(), definitions.end(), editEnd,
+                             [](size_t pos, const Definition& d) { return pos < (*d.start)->index; }) -
+            definitions.begin());
+        if (last == 0) {
+            adoptAll(toks, newTokens, edit);
+            return fullParse(stats);
+        }
+        --last;
+
+        std::vector<spToken> regionTokens;
+        TokenIt regionStart;
+        if (edit.removed == 0 && edit.inserted == 0) {
+            // only lines moved; an empty region at the edit
+            auto o = std::next(definitions[last].start,
+                               static_cast<std::ptrdiff_t>(edit.begin - startOf(last)));
+            if (!adopt(toks, o, newTokens, edit, edit.begin, edit.begin, regionTokens, regionStart))
+                adoptAll(toks, newTokens, edit);
+            if (stats) stats->reused = definitions.size();
+            return true;
+        }
+
+        bool header = first > 0 && isHeader(definitions[first - 1].node);
+        for (size_t i = first; i <= last && !header; ++i) header = isHeader(definitions[i].node);
+        size_t regionBegin = startOf(first), regionEnd = startOf(last + 1);
+        if (header || !adopt(toks, definitions[first].start, newTokens, edit, regionBegin, regionEnd,
+                             regionTokens, regionStart)) {
+            adoptAll(toks, newTokens, edit);
+            return fullParse(stats);
+        }
+
+        spParseTree parsed;
+        std::vector<Definition> fresh;
+        if (!regionTokens.empty()) {
+            // a token list of the region alone, so that indexing it does not cost the file
+            std::list<spToken> region(regionTokens.begin(), regionTokens.end());
+            Grammar2& grammar = getGrammar();
+            SPPF items = oneOrMore(recovering ? grammar.DEF_TOP_LEVEL_RECOVER : grammar.DEF_TOP_LEVEL);
+            TokenIndex index(region);
+            TokenPos pos = 0;
+            TokenPos furthest = pos;
+            const ParseFn* furthestParser = nullptr;
+            spParseTree* pParsed = &parsed;
+            if (!items->parse(index, &pParsed, &pos, index.end(), &furthest, &furthestParser) ||
+                !ParseFn::atLimit(index, pos, index.end()) ||
+                !locate(regionStart, regionBegin, regionBegin + regionTokens.size(), parsed, nullptr,
+                        fresh)) {
+                return fullParse(stats);
+            }
+        }
+
+        // stitch the region between the untouched definitions, which stay where they are
+        spParseTree rest = last + 1 < definitions.size() ? definitions[last + 1].node : nullptr;
+        if (parsed) {
+            auto end = parsed;
+            while (end->spNext) end = end->spNext;
+            end->spNext = rest;
+        } else {
+            parsed = rest;
+        }
+        if (first == 0) unit->spDown = parsed;
+        else definitions[first - 1].node->spNext = parsed;
+        if (stats) {
+            stats->reused = definitions.size() - (last - first + 1);
+            stats->reparsed = fresh.size();
+        }
+        auto replaced = definitions.erase(definitions.begin() + static_cast<std::ptrdiff_t>(first),
+                                          definitions.begin() + static_cast<std::ptrdiff_t>(last + 1));
+        definitions.insert(replaced, fresh.begin(), fresh.end());
+        return true;
+    }
+
+}
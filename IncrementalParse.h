@@ -0,0 +1,85 @@
+#ifndef INCREMENTALPARSE_H
+#define INCREMENTALPARSE_H
+
+#include <cstddef>
+#include <list>
+#include <vector>
+
+#include "ParseObject.h"
+#include "Token.h"
+
+namespace basis {
+
+    // A token-level edit: tokens [begin, begin + removed) of the previous token list
+    // were replaced by tokens [begin, begin + inserted) of the new one.
+    struct TokenEdit {
+        size_t begin    = 0;
+        size_t removed  = 0;
+        size_t inserted = 0;
+        // token `begin` of the new list, when diffTokens found it on its way, so
+        // that reparse need not walk the list to it again
+        std::list<spToken>::const_iterator newBegin{};
+        bool located = false;
+    };
+
+    struct ReparseStats {
+        size_t reused   = 0;   // top-level subtrees carried over from the old tree
+        size_t reparsed = 0;   // top-level subtrees produced by parsing
+        bool   fullParse = false;
+    };
+
+    // Compute the smallest edit turning oldTokens into newTokens, comparing tokens by
+    // type, text and column. Columns decide the bounds, so an edit that only changes
+    // indentation is an edit. Tokens before the edit are on the same lines, and the
+    // ones after it all move by the same number of lines.
+    TokenEdit diffTokens(const std::list<spToken>& oldTokens, const std::list<spToken>& newTokens);
+
+    // A unit parsed as a COMPILATION_UNIT and kept parsed through edits. Besides its
+    // tokens and tree it keeps where each top-level definition starts, so an edit
+    // finds the definitions it touches without walking the unit.
+    class IncrementalUnit {
+    public:
+        // Parse `tokens` in full. With `recovering`, COMPILATION_UNIT_RECOVER
+        // semantics are used throughout.
+        explicit IncrementalUnit(std::list<spToken> tokens, bool recovering = false);
+
+        // Bring the unit up to date with newTokens, a fresh lex of the edited text
+        // that differs from tokens() by `edit`. Only the top-level definitions whose
+        // token spans touch the edit are reparsed. The other subtrees stay in the tree
+        // as they are, and so do the tokens they refer to: tokens() takes the
+        // inserted tokens from newTokens and keeps its own elsewhere, with their
+        // positions and bounds updated.
+        //
+        // Work is proportional to the edit. The tokens after it are visited only to
+        // move them when the edit changes the number of tokens or lines, and newTokens
+        // is walked up to the edit unless the edit is located in it. newTokens keeps
+        // the tokens that were not taken, for the caller to free.
+        //
+        // Edits touching the module or import declarations, and regions that fail to
+        // parse on their own, fall back to a full parse. Returns whether the updated
+        // tokens parse; tree() is null if they do not.
+        bool reparse(std::list<spToken>& newTokens, const TokenEdit& edit, ReparseStats* stats = nullptr);
+
+        const std::list<spToken>& tokens() const { return toks; }
+        const spParseTree& tree() const { return unit; }
+
+    private:
+        using TokenIt = std::list<spToken>::iterator;
+        struct Definition {
+            TokenIt     start;   // the keyword opening it, usually discarded from the tree
+            spParseTree node;
+        };
+
+        bool fullParse(ReparseStats* stats);
+        void indexDefinitions();
+        size_t startOf(size_t i) const;
+
+        std::list<spToken> toks;
+        spParseTree unit;
+        std::vector<Definition> definitions;   // the children of unit, in order
+        bool recovering;
+    };
+
+}
+
+#endif // INCREMENTALPARSE_H
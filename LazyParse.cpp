@@ -0,0 +1,64 @@
+#include "LazyParse.h"
+
+#include <vector>
+
+#include "Grammar2.h"
+#include "ParseMachine.h"
+
+namespace basis {
+
+    bool parseSignatures(const std::list<spToken>& tokens, spParseTree& result) {
+        Parser parser(tokens, getGrammar().COMPILATION_UNIT_SIGNATURES);
+        bool ok = parser.parseWithStack() && parser.allTokensConsumed();
+        result = ok ? parser.parseTree : nullptr;
+        return ok;
+    }
+
+    bool parseDeferredBody(const TokenIndex& tokens, const spParseTree& node) {
+        if (!node || node->production != Production::DEF_CMD_BODY_DEFERRED ||
+            !node->pToken || !node->spDown || !node->spDown->pToken) {
+            return false;
+        }
+        // Token::index is the lexer position; check it refers to these tokens
+        TokenPos begin = node->pToken->index;
+        TokenPos last = node->spDown->pToken->index;
+        if (begin > last || last >= tokens.end() ||
+            tokens[begin] != node->pToken || tokens[last] != node->spDown->pToken) {
+            return false;
+        }
+        spParseTree body;
+        spParseTree* pBody = &body;
+        TokenPos pos = begin;
+        TokenPos furthest = begin;
+        const ParseFn* furthestParser = nullptr;
+        ParseMachine machine(tokens, Parser::defaultMaxDepth);
+        if (!machine.run(getGrammar().DEF_CMD_BODY.get(), &pBody, &pos, last + 1, &furthest, &furthestParser) ||
+            pos != last + 1) {
+            return false;
+        }
+        node->production = body->production;
+        node->pToken = body->pToken;
+        node->spDown = body->spDown;
+        return true;
+    }
+
+    size_t parseDeferredBodies(const std::list<spToken>& tokens, const spParseTree& pt) {
+        TokenIndex index(tokens);
+        size_t failed = 0;
+        std::vector<spParseTree> pending{pt};
+        while (!pending.empty()) {
+            spParseTree node = pending.back();
+            pending.pop_back();
+            for (; node; node = node->spNext) {
+                if (node->production == Production::DEF_CMD_BODY_DEFERRED) {
+                    // a parsed body may hold subs, whose bodies are parsed with it
+                    if (!parseDeferredBody(index, node)) ++failed;
+                    continue;
+                }
+                if (node->spDown) pending.push_back(node->spDown);
+            }
+        }
+        return failed;
+    }
+
+}
@@ -0,0 +1,31 @@
+#ifndef LAZYPARSE_H
+#define LAZYPARSE_H
+
+#include <cstddef>
+#include <list>
+
+#include "ParseObject.h"
+#include "Parsing2.h"
+#include "Token.h"
+
+namespace basis {
+
+    // Parse tokens as a COMPILATION_UNIT for its signatures only. Everything but
+    // command bodies is parsed in full; each `.cmd` body, subs included, is left as a
+    // DEF_CMD_BODY_DEFERRED node for its `=` token, with a DEFERRED_END child for
+    // the body's last token. Returns false if the tokens do not form a complete unit.
+    bool parseSignatures(const std::list<spToken>& tokens, spParseTree& result);
+
+    // Parse the body behind one DEF_CMD_BODY_DEFERRED node and turn the node, in
+    // place, into the DEF_CMD_BODY a full parse produces. tokens must index the lexer
+    // output the tree was parsed from. Returns false, leaving the node deferred, if
+    // the span is not from these tokens or does not parse as a body.
+    bool parseDeferredBody(const TokenIndex& tokens, const spParseTree& node);
+
+    // Parse every deferred body under pt. Returns the number left deferred because
+    // they failed to parse.
+    size_t parseDeferredBodies(const std::list<spToken>& tokens, const spParseTree& pt);
+
+}
+
+#endif // LAZYPARSE_H
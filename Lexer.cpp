@@ -60,6 +60,7 @@ bool Lexer::read() {
 spToken Lexer::nextToken() {
     // record and initialize the token
     spToken pToken = std::make_shared<Token>();
+    pToken->index = static_cast<uint32_t>(output.size());
     output.push_back(pToken);
     pToken->lineNumber = lineNumber;
     pToken->columnNumber = columnNumber;
@@ -144,78 +145,78 @@ bool Lexer::readWhitespace() {
 
 bool Lexer::readHex() {
     // read hexadecimals before numerics
-    if( read()) {
-        spToken pToken = nextToken();
-        pToken->columnNumber -= 1; // correct for the extra 'x' character
-        pToken->type = TokenType::HEXNUMBER;
-        size_t hexDigitCount = 0;
-        while( input.good() && (isxdigit(input.peek()) || input.peek() == '_') ) {
-            if( input.peek() == '_' ) {
-                // underscore must be preceded and followed by a hex digit
-                if( !isxdigit(readChar) ) {
-                    output.pop_back();
-                    writeError("invalid hex value: underscore must follow a hex digit", pToken.get());
-                    return false;
-                }
-                read(); // consume the underscore
-                if( !input.good() || !isxdigit(input.peek()) ) {
-                    output.pop_back();
-                    writeError("invalid hex value: underscore must be followed by a hex digit", pToken.get());
-                    return false;
-                }
-                pToken->text += readChar; // add the underscore
+    // look for the 'x' before recording anything, so that a failure leaves no token
+    if( !input.good() || input.peek() != 'x' ) return false;
+    // record the token at the leading '0', so that it bounds by its own column
+    spToken pToken = nextToken();
+    read();
+    pToken->type = TokenType::HEXNUMBER;
+    size_t hexDigitCount = 0;
+    while( input.good() && (isxdigit(input.peek()) || input.peek() == '_') ) {
+        if( input.peek() == '_' ) {
+            // underscore must be preceded and followed by a hex digit
+            if( !isxdigit(readChar) ) {
+                output.pop_back();
+                writeError("invalid hex value: underscore must follow a hex digit", pToken.get());
+                return false;
             }
-            read();
-            pToken->text += readChar;
-            hexDigitCount++;
-        }
-        // ensure we read an even number of digits so we have whole bytes
-        if( hexDigitCount % 2 != 0 ) {
-            output.pop_back(); // Remove the invalid token from output
-            writeError("invalid hex value", pToken.get());
-            return false;
+            read(); // consume the underscore
+            if( !input.good() || !isxdigit(input.peek()) ) {
+                output.pop_back();
+                writeError("invalid hex value: underscore must be followed by a hex digit", pToken.get());
+                return false;
+            }
+            pToken->text += readChar; // add the underscore
         }
-        return true;
+        read();
+        pToken->text += readChar;
+        hexDigitCount++;
     }
-    return false;
+    // ensure we read an even number of digits so we have whole bytes
+    if( hexDigitCount % 2 != 0 ) {
+        output.pop_back(); // Remove the invalid token from output
+        writeError("invalid hex value", pToken.get());
+        return false;
+    }
+    return true;
 }
 
 bool Lexer::readBinary() {
     // read binary literals (0b followed by multiples of 8 binary digits)
-    if( read()) {
-        spToken pToken = nextToken();
-        pToken->columnNumber -= 1; // correct for the extra 'b' character
-        pToken->type = TokenType::BINARY;
-        size_t binaryDigitCount = 0;
-        while( input.good() && (input.peek() == '0' || input.peek() == '1' || input.peek() == '_') ) {
-            if( input.peek() == '_' ) {
-                // underscore must be preceded and followed by a binary digit
-                if( readChar != '0' && readChar != '1' ) {
-                    output.pop_back();
-                    writeError("invalid binary value: underscore must follow a binary digit", pToken.get());
-                    return false;
-                }
-                read(); // consume the underscore
-                if( !input.good() || (input.peek() != '0' && input.peek() != '1') ) {
-                    output.pop_back();
-                    writeError("invalid binary value: underscore must be followed by a binary digit", pToken.get());
-                    return false;
-                }
-                pToken->text += readChar; // add the underscore
+    // look for the 'b' before recording anything, so that a failure leaves no token
+    if( !input.good() || input.peek() != 'b' ) return false;
+    // record the token at the leading '0', so that it bounds by its own column
+    spToken pToken = nextToken();
+    read();
+    pToken->type = TokenType::BINARY;
+    size_t binaryDigitCount = 0;
+    while( input.good() && (input.peek() == '0' || input.peek() == '1' || input.peek() == '_') ) {
+        if( input.peek() == '_' ) {
+            // underscore must be preceded and followed by a binary digit
+            if( readChar != '0' && readChar != '1' ) {
+                output.pop_back();
+                writeError("invalid binary value: underscore must follow a binary digit", pToken.get());
+                return false;
             }
-            read();
-            pToken->text += readChar;
-            binaryDigitCount++;
-        }
-        // ensure we read a multiple of 8 digits so we have whole bytes
-        if( binaryDigitCount % 8 != 0 ) {
-            output.pop_back(); // Remove the invalid token from output
-            writeError("invalid binary value", pToken.get());
-            return false;
+            read(); // consume the underscore
+            if( !input.good() || (input.peek() != '0' && input.peek() != '1') ) {
+                output.pop_back();
+                writeError("invalid binary value: underscore must be followed by a binary digit", pToken.get());
+                return false;
+            }
+            pToken->text += readChar; // add the underscore
         }
-        return true;
+        read();
+        pToken->text += readChar;
+        binaryDigitCount++;
     }
-    return false;
+    // ensure we read a multiple of 8 digits so we have whole bytes
+    if( binaryDigitCount % 8 != 0 ) {
+        output.pop_back(); // Remove the invalid token from output
+        writeError("invalid binary value", pToken.get());
+        return false;
+    }
+    return true;
 }
 
 bool Lexer::readNumeric() {
@@ -420,6 +421,10 @@ bool Lexer::readPunct() {
             read();
             pToken->text += readChar;
             pToken->type = TokenType::LEQUALS;
+        } else if ( input.good() && input.peek() == '>') {
+            read();
+            pToken->text += readChar;
+            pToken->type = TokenType::LRANGLE;
         } else {
             pToken->type = TokenType::LANGLE;
         }
@@ -440,6 +445,10 @@ bool Lexer::readPunct() {
             pToken->text += readChar;
             pToken->type = TokenType::BANGBRACE;
             braceStack.push(pToken);
+        } else if ( input.good() && input.peek() == '=' ) {
+            read();
+            pToken->text += readChar;
+            pToken->type = TokenType::BANGEQUALS;
         } else {
             pToken->type = TokenType::BANG;
         }
@@ -472,7 +481,13 @@ bool Lexer::readPunct() {
         pToken->type = TokenType::DOLLAR;
         break;
     case '=':
-        pToken->type = TokenType::EQUALS;
+        if ( input.good() && input.peek() == '=' ) {
+            read();
+            pToken->text += readChar;
+            pToken->type = TokenType::DEQUALS;
+        } else {
+            pToken->type = TokenType::EQUALS;
+        }
         break;
     case '{':
         pToken->type = TokenType::LBRACE;
@@ -0,0 +1,33 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace basis {
+
+// A file mapped read-only into memory for as long as the object lives. Where
+// mapping is not available the file is read into a buffer instead.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return open; }
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    bool open = false;
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::vector<unsigned char> buffer;
+};
+
+} // namespace basis
+
+#endif // MAPPEDFILE_H
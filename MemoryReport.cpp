@@ -0,0 +1,279 @@
+#include "MemoryReport.h"
+#include "AstContext.h"
+#include "AstFields.h"
+#include "Productions.h"
+#include "Token.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace basis;
+
+namespace {
+
+    template<typename T> constexpr const char* nodeName = nullptr;
+    template<> constexpr const char* nodeName<EnumItem> = "EnumItem";
+    template<> constexpr const char* nodeName<FieldDecl> = "FieldDecl";
+    template<> constexpr const char* nodeName<UnionCandidate> = "UnionCandidate";
+    template<> constexpr const char* nodeName<VariantCandidate> = "VariantCandidate";
+    template<> constexpr const char* nodeName<InstanceType> = "InstanceType";
+    template<> constexpr const char* nodeName<CmdParam> = "CmdParam";
+    template<> constexpr const char* nodeName<CmdReceiver> = "CmdReceiver";
+    template<> constexpr const char* nodeName<CallParam> = "CallParam";
+    template<> constexpr const char* nodeName<SuffixOp> = "SuffixOp";
+    template<> constexpr const char* nodeName<NamedType> = "NamedType";
+    template<> constexpr const char* nodeName<PtrType> = "PtrType";
+    template<> constexpr const char* nodeName<RangeType> = "RangeType";
+    template<> constexpr const char* nodeName<CmdTypeArg> = "CmdTypeArg";
+    template<> constexpr const char* nodeName<CmdType> = "CmdType";
+    template<> constexpr const char* nodeName<InlineRecordType> = "InlineRecordType";
+    template<> constexpr const char* nodeName<InlineObjectType> = "InlineObjectType";
+    template<> constexpr const char* nodeName<InlineUnionType> = "InlineUnionType";
+    template<> constexpr const char* nodeName<InlineVariantType> = "InlineVariantType";
+    template<> constexpr const char* nodeName<LiteralExpr> = "LiteralExpr";
+    template<> constexpr const char* nodeName<Identifier> = "Identifier";
+    template<> constexpr const char* nodeName<IdentifierExpr> = "IdentifierExpr";
+    template<> constexpr const char* nodeName<EnumDerefExpr> = "EnumDerefExpr";
+    template<> constexpr const char* nodeName<CallCommandExpr> = "CallCommandExpr";
+    template<> constexpr const char* nodeName<CallConstructorExpr> = "CallConstructorExpr";
+    template<> constexpr const char* nodeName<CallVCommandExpr> = "CallVCommandExpr";
+    template<> constexpr const char* nodeName<CallFailExpr> = "CallFailExpr";
+    template<> constexpr const char* nodeName<SuffixExpr> = "SuffixExpr";
+    template<> constexpr const char* nodeName<BinaryExpr::OpTerm> = "BinaryExpr::OpTerm";
+    template<> constexpr const char* nodeName<BinaryExpr> = "BinaryExpr";
+    template<> constexpr const char* nodeName<QuoteExpr> = "QuoteExpr";
+    template<> constexpr const char* nodeName<CmdLiteralExpr> = "CmdLiteralExpr";
+    template<> constexpr const char* nodeName<AssignStat> = "AssignStat";
+    template<> constexpr const char* nodeName<ExprStat> = "ExprStat";
+    template<> constexpr const char* nodeName<Block> = "Block";
+    template<> constexpr const char* nodeName<CallGroup> = "CallGroup";
+    template<> constexpr const char* nodeName<CmdBody> = "CmdBody";
+    template<> constexpr const char* nodeName<RegularSig> = "RegularSig";
+    template<> constexpr const char* nodeName<VCommandSig> = "VCommandSig";
+    template<> constexpr const char* nodeName<ConstructorSig> = "ConstructorSig";
+    template<> constexpr const char* nodeName<DestructorSig> = "DestructorSig";
+    template<> constexpr const char* nodeName<FailHandlerSig> = "FailHandlerSig";
+    template<> constexpr const char* nodeName<ModuleDecl> = "ModuleDecl";
+    template<> constexpr const char* nodeName<ImportDecl> = "ImportDecl";
+    template<> constexpr const char* nodeName<AliasDecl> = "AliasDecl";
+    template<> constexpr const char* nodeName<DomainDecl> = "DomainDecl";
+    template<> constexpr const char* nodeName<EnumDecl> = "EnumDecl";
+    template<> constexpr const char* nodeName<RecordDecl> = "RecordDecl";
+    template<> constexpr const char* nodeName<ObjectDecl> = "ObjectDecl";
+    template<> constexpr const char* nodeName<UnionDecl> = "UnionDecl";
+    template<> constexpr const char* nodeName<VariantDecl> = "VariantDecl";
+    template<> constexpr const char* nodeName<InstanceDecl> = "InstanceDecl";
+    template<> constexpr const char* nodeName<CmdDecl> = "CmdDecl";
+    template<> constexpr const char* nodeName<IntrinsicDecl> = "IntrinsicDecl";
+    template<> constexpr const char* nodeName<CmdDef> = "CmdDef";
+    template<> constexpr const char* nodeName<ClassDecl> = "ClassDecl";
+    template<> constexpr const char* nodeName<ProgramDecl> = "ProgramDecl";
+    template<> constexpr const char* nodeName<TestDecl> = "TestDecl";
+    template<> constexpr const char* nodeName<CompilationUnit> = "CompilationUnit";
+
+    template<typename T>
+    concept Scalar = std::is_integral_v<T> || std::is_enum_v<T>;
+
+    template<typename T> struct IsVariant : std::false_type {};
+    template<typename... Ts> struct IsVariant<std::variant<Ts...>> : std::true_type {};
+
+    // The heap a string holds; nothing when its text fits inside the string.
+    size_t heapBytes(const std::string& s) {
+        auto* self = reinterpret_cast<const char*>(&s);
+        bool inline_ = s.data() >= self && s.data() < self + sizeof(s);
+        return inline_ ? 0 : s.capacity() + 1;
+    }
+
+    // Charges what it visits to the node being visited; see AstNodeMemory.
+    struct Accounting {
+        std::map<std::string_view, AstNodeMemory>& rows;
+        std::unordered_set<const TypeNode*> types;
+        AstNodeMemory* owner = nullptr;
+
+        template<typename T> void node(T& n, size_t storage) {
+            static_assert(nodeName<T> != nullptr, "every AST structure has a name");
+            AstNodeMemory& row = rows[nodeName<T>];
+            ++row.count;
+            row.bytes += storage;
+            AstNodeMemory* outer = std::exchange(owner, &row);
+            visitFields(*this, n);
+            owner = outer;
+        }
+        // A node allocated on its own, in a list or behind a pointer, whose
+        // storage goes to the alternative it holds if it holds one.
+        template<typename T> void stored(T& n) {
+            if constexpr (IsVariant<T>::value)
+                std::visit([&](auto& alt) { node(alt, sizeof(T)); }, n);
+            else if constexpr (requires { n.v; })
+                std::visit([&](auto& alt) { node(alt, sizeof(T)); }, n.v);
+            else
+                node(n, sizeof(T));
+        }
+
+        template<Scalar T> void operator()(T&) {}
+        void operator()(std::string& s) { owner->bytes += heapBytes(s); }
+        void operator()(std::optional<std::string>& s) {
+            if (s) owner->bytes += heapBytes(*s);
+        }
+        void operator()(TypeNode*& p) {
+            if (p && types.insert(p).second) stored(*p);
+        }
+        template<typename T> void operator()(T*& p) {
+            if (p) stored(*p);
+        }
+        template<typename T> void operator()(AstList<T>& list) {
+            if constexpr (std::is_class_v<T> && !std::is_same_v<T, std::string>) {
+                owner->bytes += (list.capacity() - list.size()) * sizeof(T);
+                for (auto& element : list) stored(element);
+            } else {
+                owner->bytes += list.capacity() * sizeof(T);
+                for (auto& element : list) (*this)(element);
+            }
+        }
+        // held inline: counted, but the storage is the enclosing node's
+        template<typename... Ts> void operator()(std::variant<Ts...>& v) {
+            std::visit([&](auto& alt) { node(alt, 0); }, v);
+        }
+        template<typename T> requires std::is_class_v<T> void operator()(T& n) {
+            if constexpr (requires { n.v; }) (*this)(n.v);
+            else node(n, 0);
+        }
+    };
+
+    void arenaBytes(const AstContext& context, size_t& allocated, size_t& reserved) {
+        allocated += context.arena.bytesAllocated();
+        reserved += context.arena.bytesReserved();
+        for (auto& part : context.parts) arenaBytes(*part, allocated, reserved);
+    }
+
+    using Row = std::pair<std::string, std::pair<size_t, size_t>>;
+
+    // Rows largest first, by name among equals; no bytes column without a label.
+    void printTable(std::ostream& os, const char* title, const char* countLabel, const char* bytesLabel,
+                    std::vector<Row> rows) {
+        if (rows.empty()) return;
+        std::stable_sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+            if (a.second.second != b.second.second) return a.second.second > b.second.second;
+            if (a.second.first != b.second.first) return a.second.first > b.second.first;
+            return a.first < b.first;
+        });
+        size_t width = std::string(title).size();
+        size_t count = 0, bytes = 0;
+        for (auto& row : rows) {
+            width = std::max(width, row.first.size());
+            count += row.second.first;
+            bytes += row.second.second;
+        }
+        auto line = [&](const std::string& name, const std::string& c, const std::string& b) {
+            os << std::left << std::setw(static_cast<int>(width)) << name << std::right << std::setw(12) << c;
+            if (bytesLabel) os << std::setw(14) << b;
+            os << '\n';
+        };
+        line(title, countLabel, bytesLabel ? bytesLabel : "");
+        for (auto& row : rows)
+            line(row.first, std::to_string(row.second.first), std::to_string(row.second.second));
+        line("total", std::to_string(count), std::to_string(bytes));
+        os << '\n';
+    }
+
+}
+
+void MemoryReport::addTokens(const std::list<spToken>& tokens) {
+    for (auto& token : tokens) {
+        TokenMemory& row = this->tokens[static_cast<size_t>(token->type)];
+        ++row.count;
+        row.textBytes += token->text.size();
+    }
+}
+
+void MemoryReport::addParseTree(const spParseTree& tree) {
+    // iteratively: statement lists make long spNext chains
+    std::vector<const ParseTree*> pending;
+    if (tree) pending.push_back(tree.get());
+    while (!pending.empty()) {
+        const ParseTree* node = pending.back();
+        pending.pop_back();
+        ++productions[static_cast<size_t>(node->production)];
+        if (node->spNext) pending.push_back(node->spNext.get());
+        if (node->spDown) pending.push_back(node->spDown.get());
+    }
+}
+
+void MemoryReport::addAst(CompilationUnit& cu) {
+    Accounting accounting{astNodes, {}, nullptr};
+    accounting.node(cu, sizeof(CompilationUnit));
+    // a list that visitFields leaves out
+    astNodes[nodeName<CompilationUnit>].bytes += cu.definitionHashes.capacity() * sizeof(uint64_t);
+    if (cu.context) arenaBytes(*cu.context, arenaAllocated, arenaReserved);
+}
+
+void MemoryReport::merge(const MemoryReport& other) {
+    for (auto& [name, row] : other.astNodes) {
+        astNodes[name].count += row.count;
+        astNodes[name].bytes += row.bytes;
+    }
+    for (size_t p = 0; p < productionCount; ++p) productions[p] += other.productions[p];
+    for (size_t t = 0; t < tokenTypeCount; ++t) {
+        tokens[t].count += other.tokens[t].count;
+        tokens[t].textBytes += other.tokens[t].textBytes;
+    }
+    arenaAllocated += other.arenaAllocated;
+    arenaReserved += other.arenaReserved;
+}
+
+size_t MemoryReport::astBytes() const {
+    size_t bytes = 0;
+    for (auto& [name, row] : astNodes) bytes += row.bytes;
+    return bytes;
+}
+
+size_t MemoryReport::parseTreeNodes() const {
+    size_t count = 0;
+    for (size_t n : productions) count += n;
+    return count;
+}
+
+size_t MemoryReport::tokenCount() const {
+    size_t count = 0;
+    for (auto& row : tokens) count += row.count;
+    return count;
+}
+
+size_t MemoryReport::tokenTextBytes() const {
+    size_t bytes = 0;
+    for (auto& row : tokens) bytes += row.textBytes;
+    return bytes;
+}
+
+void basis::printMemoryReport(std::ostream& os, const MemoryReport& report) {
+    std::vector<Row> rows;
+    for (size_t t = 0; t < tokenTypeCount; ++t) {
+        auto& row = report.tokens[t];
+        if (row.count) rows.push_back({tokenTypeName(static_cast<TokenType>(t)), {row.count, row.textBytes}});
+    }
+    printTable(os, "token", "count", "text bytes", std::move(rows));
+
+    rows.clear();
+    for (size_t p = 0; p < productionCount; ++p) {
+        if (report.productions[p])
+            rows.push_back({productionName(static_cast<Production>(p)), {report.productions[p], 0}});
+    }
+    printTable(os, "production", "nodes", nullptr, std::move(rows));
+    if (report.parseTreeNodes())
+        os << "parse tree: " << report.parseTreeBytes() << " bytes at " << sizeof(ParseTree)
+           << " a node\n\n";
+
+    rows.clear();
+    for (auto& [name, row] : report.astNodes) rows.push_back({std::string(name), {row.count, row.bytes}});
+    printTable(os, "ast node", "count", "bytes", std::move(rows));
+    if (report.arenaReserved)
+        os << "ast arenas: " << report.arenaAllocated << " bytes allocated, " << report.arenaReserved
+           << " reserved\n";
+}
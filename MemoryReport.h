@@ -0,0 +1,64 @@
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include <array>
+#include <cstddef>
+#include <iosfwd>
+#include <list>
+#include <map>
+#include <string_view>
+
+#include "Ast.h"
+#include "ParseObject.h"
+#include "Productions.h"
+#include "Token.h"
+
+namespace basis {
+
+// What the nodes of one AST type cost. A node's bytes are its own storage where
+// it is allocated on its own (a list element or the target of a pointer; an
+// alternative of a variant is charged the size of the variant or node holding
+// it), plus the heap its strings hold and the unused capacity of its lists. A
+// list of strings, pointers or scalars is charged whole to the node owning it.
+// Structures held inline in another node count but add no storage of their own,
+// so the bytes of all types add up to the memory of the AST.
+struct AstNodeMemory {
+    size_t count = 0;
+    size_t bytes = 0;
+};
+
+struct TokenMemory {
+    size_t count = 0;
+    size_t textBytes = 0;   // length of the token texts
+};
+
+// Where the memory of a parsed module goes: AST nodes by type, parse tree nodes
+// by production and tokens by type. Add the tokens of a Lexer, the tree of a
+// Parser and the units of buildAst, in any combination; adding more of the same
+// accumulates, and reports merge, so one report can cover many modules.
+struct MemoryReport {
+    std::map<std::string_view, AstNodeMemory>   astNodes;   // by type name
+    std::array<size_t, productionCount>         productions{};
+    std::array<TokenMemory, tokenTypeCount>     tokens{};
+    size_t                                      arenaAllocated = 0;   // by the units' AstContexts
+    size_t                                      arenaReserved = 0;
+
+    void addTokens(const std::list<spToken>& tokens);
+    void addParseTree(const spParseTree& tree);
+    // Each distinct TypeNode counts once, however many nodes refer to it.
+    void addAst(CompilationUnit& cu);
+    void merge(const MemoryReport& other);
+
+    size_t astBytes() const;
+    size_t parseTreeNodes() const;
+    size_t parseTreeBytes() const { return parseTreeNodes() * sizeof(ParseTree); }
+    size_t tokenCount() const;
+    size_t tokenTextBytes() const;
+};
+
+// One table per section, largest first, leaving out what has no entries.
+void printMemoryReport(std::ostream& os, const MemoryReport& report);
+
+} // namespace basis
+
+#endif // MEMORYREPORT_H
@@ -0,0 +1,200 @@
+#include "ModuleLoader.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <queue>
+#include <utility>
+
+using namespace basis;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    bool isFile(const fs::path& path) {
+        std::error_code ec;
+        return fs::is_regular_file(path, ec);
+    }
+
+    // The same file by whatever path it was reached.
+    std::string identity(const std::string& path) {
+        std::error_code ec;
+        fs::path canonical = fs::weakly_canonical(path, ec);
+        return ec ? fs::path(path).lexically_normal().string() : canonical.string();
+    }
+
+    SourceLoc locationOf(const ImportDecl* decl) {
+        return {static_cast<size_t>(decl->line), static_cast<size_t>(decl->col)};
+    }
+
+    std::string importName(const ImportDecl& import) {
+        return import.kind == ImportDecl::Kind::File ? "\"" + import.path + "\"" : import.name;
+    }
+
+}
+
+ModuleLoader::ModuleLoader(std::vector<std::string> searchPaths, Frontend frontend)
+    : searchPaths(std::move(searchPaths)), frontend(std::move(frontend)) {}
+
+std::string ModuleLoader::resolve(const ImportDecl& import, const std::string& importer) const {
+    fs::path relative;
+    if (import.kind == ImportDecl::Kind::File) {
+        relative = import.path;
+        fs::path beside = fs::path(importer).parent_path() / relative;
+        if (isFile(beside)) return beside.lexically_normal().string();
+    } else {
+        // Std::Core is Std/Core.b
+        std::string name = import.name;
+        for (size_t at; (at = name.find("::")) != std::string::npos;) name.replace(at, 2, "/");
+        relative = name + ".b";
+    }
+    for (auto& dir : searchPaths) {
+        fs::path candidate = fs::path(dir) / relative;
+        if (isFile(candidate)) return candidate.lexically_normal().string();
+    }
+    return {};
+}
+
+size_t ModuleLoader::add(const std::string& path, std::vector<size_t>& wave) {
+    auto [it, added] = byFile.emplace(identity(path), loaded.size());
+    if (added) {
+        loaded.emplace_back().path = path;
+        wave.push_back(it->second);
+    }
+    return it->second;
+}
+
+void ModuleLoader::resolveImports(size_t index, std::vector<size_t>& wave) {
+    if (!loaded[index].unit) return;
+    for (const ImportDecl* decl : loaded[index].unit->imports) {
+        std::string file = resolve(*decl, loaded[index].path);
+        if (file.empty()) {
+            loaded[index].diagnostics.error(Phase::Import, locationOf(decl),
+                                            "cannot find import " + importName(*decl));
+            continue;
+        }
+        size_t imported = add(file, wave);
+        // `loaded` may have grown
+        loaded[index].imports.push_back({imported, decl});
+    }
+}
+
+void ModuleLoader::load(const std::vector<std::string>& roots, WorkStealingPool& pool) {
+    std::vector<size_t> wave;
+    for (auto& root : roots) add(root, wave);
+    while (!wave.empty()) {
+        pool.run(wave.size(), [&](size_t i, unsigned) { frontend(wave[i], loaded[wave[i]]); });
+        std::vector<size_t> next;
+        for (size_t index : wave) resolveImports(index, next);
+        wave = std::move(next);
+    }
+    sortModules();
+}
+
+void ModuleLoader::sortModules() {
+    // Kahn's algorithm, taking the lowest ready index first
+    size_t count = loaded.size();
+    std::vector<size_t> waiting(count);
+    std::vector<std::vector<size_t>> importers(count);
+    for (size_t i = 0; i < count; ++i) {
+        for (auto& import : loaded[i].imports) {
+            ++waiting[i];
+            importers[import.module].push_back(i);
+        }
+    }
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<>> ready;
+    for (size_t i = 0; i < count; ++i) {
+        if (waiting[i] == 0) ready.push(i);
+    }
+    order.clear();
+    std::vector<bool> ordered(count);
+    while (!ready.empty()) {
+        size_t i = ready.top();
+        ready.pop();
+        order.push_back(i);
+        ordered[i] = true;
+        for (size_t importer : importers[i]) {
+            if (--waiting[importer] == 0) ready.push(importer);
+        }
+    }
+    if (order.size() < count) reportCycles(ordered);
+}
+
+void ModuleLoader::reportCycles(const std::vector<bool>& ordered) {
+    // depth-first from each module left out of the order; every import back to a
+    // module on the path closes a cycle
+    enum class Mark { New, OnPath, Done };
+    std::vector<Mark> marks(loaded.size(), Mark::New);
+    std::vector<size_t> path;
+    std::function<void(size_t)> visit = [&](size_t i) {
+        marks[i] = Mark::OnPath;
+        path.push_back(i);
+        for (auto& import : loaded[i].imports) {
+            if (ordered[import.module]) continue;
+            if (marks[import.module] == Mark::New) {
+                visit(import.module);
+            } else if (marks[import.module] == Mark::OnPath) {
+                auto start = std::find(path.begin(), path.end(), import.module);
+                std::string chain;
+                for (auto it = start; it != path.end(); ++it) chain += loaded[*it].path + " imports ";
+                chain += loaded[import.module].path;
+                loaded[i].diagnostics.report({Severity::Error, Phase::Import, locationOf(import.decl),
+                                              "import cycle through " + importName(*import.decl),
+                                              {}, chain, {}});
+            }
+        }
+        path.pop_back();
+        marks[i] = Mark::Done;
+    };
+    for (size_t i = 0; i < loaded.size(); ++i) {
+        if (!ordered[i] && marks[i] == Mark::New) visit(i);
+    }
+}
+
+void ModuleLoader::runInImportOrder(WorkStealingPool& pool,
+                                    const std::function<void(size_t, Module&)>& phase) {
+    std::vector<size_t> waiting(loaded.size());
+    std::vector<std::vector<size_t>> importers(loaded.size());
+    std::deque<size_t> ready;
+    // modules left out of the order are not importers here, so never get ready
+    for (size_t i : order) {
+        for (auto& import : loaded[i].imports) {
+            ++waiting[i];
+            importers[import.module].push_back(i);
+        }
+        if (waiting[i] == 0) ready.push_back(i);
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t remaining = order.size();
+    bool failed = false;
+    // one loop per worker, each taking whichever module is ready next
+    pool.run(pool.workers(), [&](size_t, unsigned) {
+        std::unique_lock lock(mutex);
+        for (;;) {
+            changed.wait(lock, [&] { return !ready.empty() || remaining == 0 || failed; });
+            if (remaining == 0 || failed) return;
+            size_t i = ready.front();
+            ready.pop_front();
+            lock.unlock();
+            try {
+                phase(i, loaded[i]);
+            } catch (...) {
+                lock.lock();
+                failed = true;
+                changed.notify_all();
+                throw;
+            }
+            lock.lock();
+            --remaining;
+            for (size_t importer : importers[i]) {
+                if (--waiting[importer] == 0) ready.push_back(importer);
+            }
+            changed.notify_all();
+        }
+    });
+}
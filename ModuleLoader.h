@@ -0,0 +1,78 @@
+#ifndef MODULELOADER_H
+#define MODULELOADER_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Ast.h"
+#include "Diagnostic.h"
+#include "WorkStealingPool.h"
+
+namespace basis {
+
+struct ModuleImport {
+    size_t            module;   // index of the imported module
+    const ImportDecl* decl;
+};
+
+// One source file of a program and what it imports.
+struct Module {
+    std::string                      path;
+    std::shared_ptr<CompilationUnit> unit;          // null when the file did not build
+    Diagnostics                      diagnostics;   // of the file, and of its imports
+    std::vector<ModuleImport>        imports;       // resolved imports, in source order
+};
+
+// Finds the modules a program is made of, starting from its root files. A file
+// import (.import "base.b") is looked up beside the importing file, then in each
+// search path; a standard import (.import Std::Core) is Std/Core.b in a search
+// path. Modules are loaded in waves: the files of a wave are lexed, parsed and
+// built in parallel, then their imports are resolved, in source order, to make
+// the next wave, so module indices are the same from run to run. An import that
+// does not resolve, and each import cycle, is an error in the importing module,
+// at the import.
+class ModuleLoader {
+public:
+    // Lexes, parses and builds module.path into module.unit and
+    // module.diagnostics. Called for different modules at once.
+    using Frontend = std::function<void(size_t index, Module& module)>;
+
+    ModuleLoader(std::vector<std::string> searchPaths, Frontend frontend);
+
+    void load(const std::vector<std::string>& roots, WorkStealingPool& pool);
+
+    // The file an import names, or empty if there is none.
+    std::string resolve(const ImportDecl& import, const std::string& importer) const;
+
+    std::vector<Module>& modules() { return loaded; }
+    const std::vector<Module>& modules() const { return loaded; }
+    // Every module after the modules it imports; modules in an import cycle, or
+    // that import one, are left out.
+    const std::vector<size_t>& importOrder() const { return order; }
+
+    // Call phase(index, module) for each module in importOrder(), on the pool,
+    // starting a module as soon as the phase has returned for all its imports,
+    // so modules that do not depend on each other run at the same time. If the
+    // phase throws, no more modules start and the exception is rethrown.
+    void runInImportOrder(WorkStealingPool& pool, const std::function<void(size_t, Module&)>& phase);
+
+private:
+    size_t add(const std::string& path, std::vector<size_t>& wave);
+    void resolveImports(size_t index, std::vector<size_t>& wave);
+    void sortModules();
+    void reportCycles(const std::vector<bool>& ordered);
+
+    std::vector<std::string> searchPaths;
+    Frontend frontend;
+    std::vector<Module> loaded;
+    std::unordered_map<std::string, size_t> byFile;   // by canonical path
+    std::vector<size_t> order;
+};
+
+} // namespace basis
+
+#endif // MODULELOADER_H
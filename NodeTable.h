@@ -0,0 +1,54 @@
+#ifndef NODETABLE_H
+#define NODETABLE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "AstContext.h"
+
+namespace basis {
+
+// One attribute of every TypeNode or ExprNode of a unit, kept in a column by
+// NodeId rather than on the nodes, so that a pass can add its results without
+// growing the AST, run over them in order, and drop them when it is done.
+// Nodes made after the table was sized are not covered; see resize().
+template<typename Node, typename T>
+class NodeTable {
+public:
+    using reference       = typename std::vector<T>::reference;
+    using const_reference = typename std::vector<T>::const_reference;
+
+    explicit NodeTable(const AstContext& context, const T& initial = T{})
+        : context(&context), values(context.nodes<Node>().size(), initial) {}
+
+    reference       operator[](const Node& node)       { return values[node.id]; }
+    const_reference operator[](const Node& node) const { return values[node.id]; }
+    reference       operator[](NodeId id)              { return values[id]; }
+    const_reference operator[](NodeId id) const        { return values[id]; }
+
+    size_t size() const { return values.size(); }
+    void resize(const T& initial = T{}) { values.resize(context->nodes<Node>().size(), initial); }
+
+    auto begin()       { return values.begin(); }
+    auto end()         { return values.end(); }
+    auto begin() const { return values.begin(); }
+    auto end()   const { return values.end(); }
+
+    // Call f(node, value) for every node, in NodeId order.
+    template<typename F>
+    void forEach(F&& f) {
+        auto& nodes = context->nodes<Node>();
+        for (size_t i = 0; i < values.size(); ++i) f(*nodes[i], values[i]);
+    }
+
+private:
+    const AstContext* context;
+    std::vector<T> values;
+};
+
+template<typename T> using TypeTable = NodeTable<TypeNode, T>;
+template<typename T> using ExprTable = NodeTable<ExprNode, T>;
+
+} // namespace basis
+
+#endif // NODETABLE_H
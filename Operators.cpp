@@ -0,0 +1,43 @@
+#include "Operators.h"
+
+#include <array>
+
+namespace basis {
+
+    namespace {
+
+        constexpr OperatorInfo operators[] = {
+            { TokenType::PIPE,       Production::CALL_OPER_CHOICE,         "|",  1, Associativity::Left,  false },
+            { TokenType::LANGLE,     Production::CALL_OPER_LESSTHAN,       "<",  3, Associativity::Chain, true  },
+            { TokenType::RANGLE,     Production::CALL_OPER_GREATERTHAN,    ">",  3, Associativity::Chain, true  },
+            { TokenType::LEQUALS,    Production::CALL_OPER_LESSTHAN_EQ,    "<=", 3, Associativity::Chain, true  },
+            { TokenType::GREQUALS,   Production::CALL_OPER_GREATERTHAN_EQ, ">=", 3, Associativity::Chain, true  },
+            { TokenType::EQUALS,     Production::CALL_OPER_EQUALS,         "=",  3, Associativity::Chain, false },
+            { TokenType::BANGEQUALS, Production::CALL_OPER_NOT_EQUALS,     "!=", 3, Associativity::Chain, false },
+            { TokenType::DEQUALS,    Production::CALL_OPER_EQUIVALENT,     "==", 3, Associativity::Chain, true  },
+            { TokenType::LRANGLE,    Production::CALL_OPER_NOT_EQUIVALENT, "<>", 3, Associativity::Chain, true  },
+            { TokenType::DLANGLE,    Production::CALL_OPER_INSERT,         "<<", 4, Associativity::Left,  true  },
+            { TokenType::DRANGLE,    Production::CALL_OPER_EXTRACT,        ">>", 4, Associativity::Left,  true  },
+            { TokenType::PLUS,       Production::CALL_OPER_ADD,            "+",  5, Associativity::Left,  true  },
+            { TokenType::MINUS,      Production::CALL_OPER_SUBTRACT,       "-",  5, Associativity::Left,  true  },
+            { TokenType::ASTERISK,   Production::CALL_OPER_MULTIPLY,       "*",  6, Associativity::Left,  true  },
+            { TokenType::SLASH,      Production::CALL_OPER_DIVIDE,         "/",  6, Associativity::Left,  true  },
+            { TokenType::PERCENT,    Production::CALL_OPER_MODULO,         "%",  6, Associativity::Left,  true  },
+            { TokenType::DCOLON,     Production::CALL_OPER_SCOPE,          "::", 7, Associativity::Left,  false },
+        };
+
+        constexpr std::array<const OperatorInfo*, tokenTypeCount> byToken = [] {
+            std::array<const OperatorInfo*, tokenTypeCount> table{};
+            for (const OperatorInfo& op : operators) table[static_cast<size_t>(op.token)] = &op;
+            return table;
+        }();
+
+    }
+
+    std::span<const OperatorInfo> operatorTable() { return operators; }
+
+    const OperatorInfo* findOperator(TokenType type) {
+        return byToken[static_cast<size_t>(type)];
+    }
+
+}
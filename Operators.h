@@ -0,0 +1,37 @@
+#ifndef OPERATORS_H
+#define OPERATORS_H
+
+#include <span>
+
+#include "Productions.h"
+#include "Token.h"
+
+namespace basis {
+
+    enum class Associativity {
+        Left,    // a - b - c is (a - b) - c
+        Right,   // a op b op c is a op (b op c)
+        Chain    // comparatives: each test yields its right operand to the next
+    };
+
+    // One infix operator of CALL_EXPRESSION. Precedence and associativity are fixed
+    // by the language; `licensed` operators are answered by a concept method
+    // (README §9.8), the others are built in.
+    struct OperatorInfo {
+        TokenType     token;
+        Production    production;
+        const char*   text;
+        int           precedence;   // higher binds tighter
+        Associativity associativity;
+        bool          licensed;
+    };
+
+    // Every infix operator, loosest first.
+    std::span<const OperatorInfo> operatorTable();
+
+    // The operator spelled by a token type, or nullptr.
+    const OperatorInfo* findOperator(TokenType type);
+
+}
+
+#endif // OPERATORS_H
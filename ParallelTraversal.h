@@ -0,0 +1,54 @@
+#ifndef PARALLELTRAVERSAL_H
+#define PARALLELTRAVERSAL_H
+
+#include <vector>
+
+#include "Ast.h"
+#include "WorkStealingPool.h"
+
+namespace basis {
+
+// Runs a pass over the definitions of a unit in parallel, for passes that look
+// at one definition at a time. The items are the top-level definitions, except
+// that a class counts as its members, each an item of its own, so one large class
+// does not hold up a worker. Each worker gets its own copy of `prototype` and
+// walks the items it takes with traverse(), so Pass is a copyable Traverser or
+// StaticTraverser. Afterwards reduce(result, part) is called with a copy of the
+// prototype and each worker's pass in worker order, and the result is returned.
+//
+// Which worker walks which item varies from run to run, so reduce should not
+// depend on it: sum counts, merge sets, or sort what it collects by position.
+// The hooks of the CompilationUnit, its module and imports and of ClassDecl are
+// not called, as no single pass sees all that they enclose. If the pass throws,
+// the exception of the first failing item in source order is rethrown.
+template<typename Pass, typename Reduce>
+Pass traverseDefinitions(CompilationUnit& cu, WorkStealingPool& pool, const Pass& prototype,
+                         Reduce reduce) {
+    // the items in source order; exactly one of the two is set
+    struct Item {
+        TopLevelDef* definition = nullptr;
+        ClassMember* member = nullptr;
+    };
+    std::vector<Item> items;
+    for (auto& definition : cu.definitions) {
+        if (auto* cls = std::get_if<ClassDecl>(&definition)) {
+            for (auto& member : cls->members) items.push_back({nullptr, &member});
+        } else {
+            items.push_back({&definition, nullptr});
+        }
+    }
+
+    std::vector<Pass> passes(pool.workers(), prototype);
+    pool.run(items.size(), [&](size_t i, unsigned worker) {
+        if (items[i].member) passes[worker].traverse(*items[i].member);
+        else passes[worker].traverse(*items[i].definition);
+    });
+
+    Pass result = prototype;
+    for (auto& part : passes) reduce(result, part);
+    return result;
+}
+
+} // namespace basis
+
+#endif // PARALLELTRAVERSAL_H
@@ -0,0 +1,322 @@
+#include "ParseMachine.h"
+
+namespace basis {
+
+    ParseMachine::ParseMachine(const TokenIndex& tokens, size_t maxDepth)
+        : tokens(tokens), maxDepth(maxDepth) {}
+
+    bool ParseMachine::run(const ParseFn* fn, spParseTree** dpspResult,
+                           TokenPos* pPos, TokenPos limit,
+                           TokenPos* pFurthest, const ParseFn** ppFurthestParser) {
+        this->pPos = pPos;
+        this->pFurthest = pFurthest;
+        this->ppFurthestParser = ppFurthestParser;
+        TokenPos begin = *pPos;
+        frames.clear();
+        result = false;
+        exceeded = false;
+        exceededAt = nullptr;
+        peak = 0;
+
+        push(fn, dpspResult, limit);
+        while (!frames.empty() && !exceeded) {
+            step(frames.back());
+        }
+        if (exceeded) {
+            frames.clear();
+            *pPos = begin;
+            return false;
+        }
+        return result;
+    }
+
+    bool ParseMachine::push(const ParseFn* fn, spParseTree** dpspResult, TokenPos limit) {
+        if (frames.size() >= maxDepth) {
+            exceeded = true;
+            exceededAt = *pPos == tokens.end() ? nullptr : tokens[*pPos];
+            return false;
+        }
+        frames.push_back(Frame{fn, dpspResult, limit});
+        if (frames.size() > peak) peak = frames.size();
+        return true;
+    }
+
+    void ParseMachine::finish(bool ok) {
+        Frame& f = frames.back();
+        if (f.guarded) *pPos = f.saved;
+        frames.pop_back();
+        result = ok;
+    }
+
+    // Each case mirrors the parse() of its combinator in Parsing2.cpp: a call to
+    // a child parser becomes a push plus a new state, resumed with the child's
+    // outcome in `result`. Returning means finish(), which applies the frame's
+    // RollbackGuard unless it was committed (guarded = false).
+    void ParseMachine::step(Frame& f) {
+        const ParseFn::Parts parts = f.fn->parts();
+        switch (parts.kind) {
+        case ParseFn::Kind::Discard: {
+            if (!ParseFn::atLimit(tokens, *pPos, f.limit) && tokens[*pPos]->type == parts.type) {
+                ++(*pPos);
+                return finish(true);
+            }
+            ParseFn::updateFurthest(*pPos, pFurthest, ppFurthestParser, f.fn);
+            return finish(false);
+        }
+        case ParseFn::Kind::Match: {
+            if (!ParseFn::atLimit(tokens, *pPos, f.limit) && tokens[*pPos]->type == parts.type) {
+                **f.dpspResult = std::make_shared<ParseTree>(parts.prod, tokens[*pPos]);
+                ++(*pPos);
+                *f.dpspResult = &((**f.dpspResult)->spNext);
+                return finish(true);
+            }
+            ParseFn::updateFurthest(*pPos, pFurthest, ppFurthestParser, f.fn);
+            return finish(false);
+        }
+        case ParseFn::Kind::Maybe: {
+            if (f.state == 0) {
+                guard(f);
+                f.next = *f.dpspResult;
+                f.state = 1;
+                push(parts.children[0].get(), &f.next, f.limit);
+                return;
+            }
+            if (result) {
+                *f.dpspResult = f.next;
+                f.guarded = false;
+            }
+            return finish(true);
+        }
+        case ParseFn::Kind::Prefix: {
+            switch (f.state) {
+            case 0:
+                if (parts.children.empty()) return finish(true);
+                guard(f);
+                f.next = *f.dpspResult;
+                f.state = 1;
+                push(parts.children[0].get(), &f.next, f.limit);
+                return;
+            case 1:
+                if (!result) {
+                    *f.dpspResult = f.next;
+                    f.guarded = false;
+                    return finish(true);
+                }
+                if (*f.next) f.next = &((*f.next)->spNext);
+                f.index = 1;
+                break;
+            default:
+                if (!result) return finish(false);
+                if (*f.next) f.next = &((*f.next)->spNext);
+                ++f.index;
+                break;
+            }
+            if (f.index < parts.children.size()) {
+                f.state = 2;
+                push(parts.children[f.index].get(), &f.next, f.limit);
+                return;
+            }
+            *f.dpspResult = f.next;
+            f.guarded = false;
+            return finish(true);
+        }
+        case ParseFn::Kind::Any: {
+            if (f.state == 0) {
+                guard(f);
+                f.state = 1;
+            } else if (result) {
+                f.guarded = false;
+                return finish(true);
+            } else {
+                ++f.index;
+            }
+            if (f.index < parts.children.size()) {
+                push(parts.children[f.index].get(), f.dpspResult, f.limit);
+                return;
+            }
+            return finish(false);
+        }
+        case ParseFn::Kind::All: {
+            if (f.state == 0) {
+                guard(f);
+                f.next = *f.dpspResult;
+                f.state = 1;
+            } else {
+                if (!result) return finish(false);
+                if (*f.next) f.next = &((*f.next)->spNext);
+                ++f.index;
+            }
+            if (f.index < parts.children.size()) {
+                push(parts.children[f.index].get(), &f.next, f.limit);
+                return;
+            }
+            *f.dpspResult = f.next;
+            f.guarded = false;
+            return finish(true);
+        }
+        case ParseFn::Kind::OneOrMore: {
+            switch (f.state) {
+            case 0:
+                f.state = 1;
+                push(parts.children[0].get(), f.dpspResult, f.limit);
+                return;
+            case 1:
+                if (!result) return finish(false);
+                f.next = *f.dpspResult;
+                break;
+            default:
+                if (!result) {
+                    *f.dpspResult = f.next;
+                    return finish(true);
+                }
+                break;
+            }
+            if (*f.next) f.next = &((*f.next)->spNext);
+            f.state = 2;
+            push(parts.children[0].get(), &f.next, f.limit);
+            return;
+        }
+        case ParseFn::Kind::Separated: {
+            switch (f.state) {
+            case 0:
+                f.state = 1;
+                push(parts.children[0].get(), f.dpspResult, f.limit);
+                return;
+            case 1:
+                if (!result) return finish(false);
+                f.next = *f.dpspResult;
+                if (*f.next) f.next = &((*f.next)->spNext);
+                break;
+            case 2:
+                if (!result) {
+                    // the loop's guard restores the position on either path
+                    if (parts.optionalSeparator || f.foundSeparator) {
+                        *f.dpspResult = f.next;
+                        return finish(true);
+                    }
+                    return finish(false);
+                }
+                f.foundSeparator = true;
+                f.state = 3;
+                push(parts.children[0].get(), &f.next, f.limit);
+                return;
+            default:
+                if (!result) return finish(false);
+                f.guarded = false;
+                if (*f.next) f.next = &((*f.next)->spNext);
+                break;
+            }
+            guard(f);
+            f.state = 2;
+            push(parts.children[1].get(), &f.next, f.limit);
+            return;
+        }
+        case ParseFn::Kind::Bound: {
+            if (ParseFn::atLimit(tokens, *pPos, f.limit)) {
+                ParseFn::updateFurthest(*pPos, pFurthest, ppFurthestParser, f.fn);
+                return finish(false);
+            }
+            // tail call: the bounded parser's outcome is ours
+            f = Frame{parts.children[0].get(), f.dpspResult, tokens.bound(*pPos)};
+            return;
+        }
+        case ParseFn::Kind::Group: {
+            if (f.state == 0) {
+                guard(f);
+                f.target = *f.dpspResult;
+                (*f.target) = std::make_shared<ParseTree>(parts.prod);
+                f.next = &(*f.target)->spDown;
+                f.state = 1;
+                push(parts.children[0].get(), &f.next, f.limit);
+                return;
+            }
+            if (result) {
+                f.guarded = false;
+                return finish(true);
+            }
+            f.target->reset();
+            return finish(false);
+        }
+        case ParseFn::Kind::BoundedGroup: {
+            // the inner All shares this frame: its guard saves the same position
+            if (f.state == 0) {
+                if (ParseFn::atLimit(tokens, *pPos, f.limit)) {
+                    ParseFn::updateFurthest(*pPos, pFurthest, ppFurthestParser, f.fn);
+                    return finish(false);
+                }
+                f.boundLimit = ParseFn::getBoundLimit(tokens, *pPos, f.limit);
+                guard(f);
+                f.next = ParseFn::createGroupNode(parts.prod, f.dpspResult);
+                f.state = 1;
+            } else {
+                if (!result) {
+                    (*f.dpspResult)->reset();
+                    return finish(false);
+                }
+                if (*f.next) f.next = &((*f.next)->spNext);
+                ++f.index;
+            }
+            if (f.index < parts.children.size()) {
+                push(parts.children[f.index].get(), &f.next, f.boundLimit);
+                return;
+            }
+            if ((!parts.strict && f.boundLimit == tokens.end()) || ParseFn::atLimit(tokens, *pPos, f.boundLimit)) {
+                f.guarded = false;
+                return finish(true);
+            }
+            (*f.dpspResult)->reset();
+            return finish(false);
+        }
+        case ParseFn::Kind::Forward: {
+            f = Frame{parts.children[0].get(), f.dpspResult, f.limit};
+            return;
+        }
+        case ParseFn::Kind::As: {
+            if (f.state == 0) {
+                f.start = *pPos;
+                f.target = *f.dpspResult;
+                f.state = 1;
+                push(parts.children[0].get(), f.dpspResult, f.limit);
+                return;
+            }
+            if (!result) return finish(false);
+            if (*f.target) {
+                (*f.target)->production = parts.prod;
+            } else if (f.start != *pPos) {
+                *f.target = std::make_shared<ParseTree>(parts.prod, tokens[f.start]);
+                *f.dpspResult = &((*f.target)->spNext);
+            }
+            return finish(true);
+        }
+        case ParseFn::Kind::Recover: {
+            if (f.state == 0) {
+                if (ParseFn::atLimit(tokens, *pPos, f.limit)) {
+                    ParseFn::updateFurthest(*pPos, pFurthest, ppFurthestParser, f.fn);
+                    return finish(false);
+                }
+                f.state = 1;
+                push(parts.children[0].get(), f.dpspResult, f.limit);
+                return;
+            }
+            if (result) return finish(true);
+            const Token* lead = tokens[*pPos];
+            const Token* at = *pFurthest == tokens.end() ? nullptr : tokens[*pFurthest];
+            spParseTree* target = *f.dpspResult;
+            (*target) = std::make_shared<ParseTree>(Production::PARSE_ERROR, lead);
+            (*target)->spDown = std::make_shared<ParseTree>(Production::PARSE_ERROR_AT, at);
+            TokenPos resume = tokens.bound(*pPos);
+            do {
+                ++(*pPos);
+            } while (!ParseFn::atLimit(tokens, *pPos, f.limit) && *pPos != resume);
+            *f.dpspResult = &(*target)->spNext;
+            return finish(true);
+        }
+        case ParseFn::Kind::Defer:
+        case ParseFn::Kind::Dispatch:
+            // leaves: they never call another parser, so they run in place
+        case ParseFn::Kind::Custom:
+            return finish(f.fn->parse(tokens, f.dpspResult, pPos, f.limit, pFurthest, ppFurthestParser));
+        }
+    }
+
+}
@@ -0,0 +1,68 @@
+#ifndef PARSEMACHINE_H
+#define PARSEMACHINE_H
+
+#include <deque>
+
+#include "Parsing2.h"
+
+namespace basis {
+
+    // Runs a combinator graph without recursing on the C++ stack. Each active
+    // combinator is a frame holding its resume point, slot cursor and rollback
+    // position; frames live in a heap-allocated deque so that the slots a parent
+    // hands to a child stay put as the stack grows. Every built-in combinator is
+    // stepped exactly as its parse() would run, so trees, positions and furthest
+    // failures are identical. ParseFn subclasses of Kind::Custom are called
+    // through parse().
+    class ParseMachine {
+    public:
+        ParseMachine(const TokenIndex& tokens, size_t maxDepth);
+
+        // Same contract as ParseFn::parse. Fails, leaving *pPos at its starting
+        // position, if more than maxDepth frames would be active at once.
+        bool run(const ParseFn* fn, spParseTree** dpspResult,
+                 TokenPos* pPos, TokenPos limit,
+                 TokenPos* pFurthest, const ParseFn** ppFurthestParser);
+
+        bool depthExceeded() const { return exceeded; }
+        // token at which the limit was hit, or nullptr at end of input
+        const Token* depthExceededAt() const { return exceededAt; }
+        // deepest frame count reached by the last run
+        size_t peakDepth() const { return peak; }
+
+    private:
+        struct Frame {
+            const ParseFn* fn;
+            spParseTree** dpspResult;
+            TokenPos limit;
+            int state = 0;
+            size_t index = 0;
+            spParseTree* next = nullptr;    // slot cursor for sequenced children
+            spParseTree* target = nullptr;  // node created (Group) or first result slot (As)
+            TokenPos saved = 0;             // RollbackGuard position
+            bool guarded = false;
+            TokenPos start = 0;
+            TokenPos boundLimit = 0;
+            bool foundSeparator = false;
+        };
+
+        bool push(const ParseFn* fn, spParseTree** dpspResult, TokenPos limit);
+        void step(Frame& f);
+        void finish(bool ok);
+        void guard(Frame& f) { f.saved = *pPos; f.guarded = true; }
+
+        const TokenIndex& tokens;
+        size_t maxDepth;
+        std::deque<Frame> frames;
+        TokenPos* pPos = nullptr;
+        TokenPos* pFurthest = nullptr;
+        const ParseFn** ppFurthestParser = nullptr;
+        bool result = false;
+        bool exceeded = false;
+        const Token* exceededAt = nullptr;
+        size_t peak = 0;
+    };
+
+}
+
+#endif // PARSEMACHINE_H
@@ -1,11 +1,40 @@
 #include "ParseObject.h"
 
+#include <utility>
+#include <vector>
+
 using namespace basis;
 
+// Release uniquely owned descendants from a heap worklist, so that freeing a deeply
+// nested tree or a long sibling chain does not recurse once per node.
+ParseTree::~ParseTree() {
+    if (!spDown && !spNext) return;
+    std::vector<spParseTree> pending;
+    auto take = [&pending](spParseTree& sp) {
+        if (sp && sp.use_count() == 1) pending.push_back(std::move(sp));
+    };
+    take(spDown);
+    take(spNext);
+    while (!pending.empty()) {
+        spParseTree node = std::move(pending.back());
+        pending.pop_back();
+        take(node->spDown);
+        take(node->spNext);
+    }
+}
 
 bool basis::operator==(const ParseTree& lhs, const ParseTree& rhs) {
-    return lhs.production == rhs.production
-        && ((lhs.pToken == nullptr && rhs.pToken == nullptr) || *lhs.pToken == *rhs.pToken)
-        && ((lhs.spNext == nullptr && rhs.spNext == nullptr) || *lhs.spNext == *rhs.spNext)
-        && ((lhs.spDown == nullptr && rhs.spDown == nullptr) || *lhs.spDown == *rhs.spDown);
+    std::vector<std::pair<const ParseTree*, const ParseTree*>> pending{{&lhs, &rhs}};
+    while (!pending.empty()) {
+        auto [l, r] = pending.back();
+        pending.pop_back();
+        if (l->production != r->production) return false;
+        if ((l->pToken == nullptr) != (r->pToken == nullptr)) return false;
+        if (l->pToken && !(*l->pToken == *r->pToken)) return false;
+        if ((l->spNext == nullptr) != (r->spNext == nullptr)) return false;
+        if ((l->spDown == nullptr) != (r->spDown == nullptr)) return false;
+        if (l->spNext) pending.emplace_back(l->spNext.get(), r->spNext.get());
+        if (l->spDown) pending.emplace_back(l->spDown.get(), r->spDown.get());
+    }
+    return true;
 }
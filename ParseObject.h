@@ -20,6 +20,7 @@ namespace basis {
         ParseTree(Production p, const Token* pT, spParseTree spN): production(p), pToken(pT), spNext(spN)  {}
         ParseTree(Production p, const Token* pT, spParseTree spN, spParseTree spD)
             : production(p), pToken(pT), spNext(spN), spDown(spD) {}
+        ~ParseTree();
         Production production;
         spParseTree spNext;
         spParseTree spDown;
@@ -1,91 +1,110 @@
 #include "Parsing2.h"
+#include "ParseMachine.h"
 
-namespace basis {
+#include <array>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
 
-    // ParseFn static helpers
-    bool ParseFn::atLimit(const std::list<spToken>& tokens, itToken* pIter, const Token* pLimit) {
-        return (*pIter) == tokens.cend() || (pLimit != nullptr && (*pIter)->get() == pLimit);
-    }
+namespace basis {
 
-    const Token* ParseFn::getBoundLimit(const std::list<spToken>& tokens, itToken* pIter, const Token* pLimit) {
-        if (atLimit(tokens, pIter, pLimit)) return nullptr;
-        return (*pIter)->get()->bound ? (*pIter)->get()->bound.get() : nullptr;
+    // TokenIndex implementation
+    TokenIndex::TokenIndex(const std::list<spToken>& tokens) {
+        if (tokens.size() >= UINT32_MAX) throw std::length_error("TokenIndex: too many tokens");
+        toks.reserve(tokens.size());
+        bool lexerIndexed = true;
+        for (const spToken& t : tokens) {
+            lexerIndexed = lexerIndexed && t->index == toks.size();
+            toks.push_back(t.get());
+        }
+        bounds.reserve(toks.size());
+        if (lexerIndexed) {
+            // straight from the lexer: Token::index is the position
+            for (const Token* t : toks) {
+                const Token* b = t->bound.get();
+                bounds.push_back(b && b->index < end() && toks[b->index] == b ? b->index : end());
+            }
+            return;
+        }
+        std::unordered_map<const Token*, TokenPos> positions;
+        positions.reserve(toks.size());
+        for (TokenPos i = 0; i < end(); ++i) positions.emplace(toks[i], i);
+        for (const Token* t : toks) {
+            auto it = t->bound ? positions.find(t->bound.get()) : positions.end();
+            bounds.push_back(it == positions.end() ? end() : it->second);
+        }
     }
 
+    // ParseFn static helpers
     spParseTree* ParseFn::createGroupNode(Production prod, spParseTree** dpspResult) {
         spParseTree* target = *dpspResult;
         (*target) = std::make_shared<ParseTree>(prod);
         return &(*target)->spDown;
     }
 
-    void ParseFn::updateFurthest(const std::list<spToken>& tokens, itToken* pIter,
-                                 itToken* pFurthest, const ParseFn** ppFurthestParser, const ParseFn* pThis) {
-        if (*pIter == tokens.cend()) {
-            if (*pFurthest != tokens.cend()) {
-                *pFurthest = *pIter;
-                *ppFurthestParser = pThis;
-            }
-            return;
-        }
-        if (*pFurthest == tokens.cend()) return;
-
-        // Compare positions - furthest is the one with higher line number, or same line but higher column
-        const Token* current = (*pIter)->get();
-        const Token* furthest = (*pFurthest)->get();
-
-        if (current->lineNumber > furthest->lineNumber ||
-            (current->lineNumber == furthest->lineNumber && current->columnNumber > furthest->columnNumber)) {
-            *pFurthest = *pIter;
-            *ppFurthestParser = pThis;
-        }
-    }
-
     // Parsing2 implementation
     Parser::Parser(const std::list<spToken>& tokens, SPPF spParseFn)
-        : tokens(tokens), spfn(spParseFn), finalPosition(tokens.cend()),
-          furthestPosition(tokens.cend()), furthestParser(nullptr) {}
+        : tokens(tokens), spfn(spParseFn), finalPosition(this->tokens.end()),
+          furthestPosition(this->tokens.end()), furthestParser(nullptr), succeeded(false),
+          depthLimit(0), depthExceededAt(nullptr), depthExceeded(false) {}
 
     bool Parser::parse() {
-        finalPosition = tokens.cbegin();
-        furthestPosition = tokens.cbegin();
+        finalPosition = 0;
+        furthestPosition = 0;
+        furthestParser = nullptr;
+        depthExceeded = false;
+        spParseTree* pTree = &parseTree;
+        succeeded = spfn->parse(tokens, &pTree, &finalPosition, tokens.end(), &furthestPosition, &furthestParser);
+        return succeeded;
+    }
+
+    bool Parser::parseWithStack(size_t maxDepth) {
+        finalPosition = 0;
+        furthestPosition = 0;
         furthestParser = nullptr;
         spParseTree* pTree = &parseTree;
-        return spfn->parse(tokens, &pTree, &finalPosition, nullptr, &furthestPosition, &furthestParser);
+        ParseMachine machine(tokens, maxDepth);
+        succeeded = machine.run(spfn.get(), &pTree, &finalPosition, tokens.end(), &furthestPosition, &furthestParser);
+        depthLimit = maxDepth;
+        depthExceeded = machine.depthExceeded();
+        depthExceededAt = machine.depthExceededAt();
+        if (depthExceeded) parseTree.reset();
+        return succeeded;
     }
 
     bool Parser::allTokensConsumed() const {
-        return finalPosition == tokens.cend();
+        return finalPosition == tokens.end();
     }
 
     std::string Parser::getError() const {
-        if (furthestPosition == tokens.cend()) {
+        if (furthestPosition == tokens.end()) {
             return "Unexpected end of input";
         }
 
+        const Token* furthest = tokens[furthestPosition];
         std::stringstream ss;
         ss << "Syntax error at ("
-           << furthestPosition->get()->lineNumber << ":"
-           << furthestPosition->get()->columnNumber << ") "
-           << "unexpected token: " << furthestPosition->get()->text;
-
-        if (furthestPosition->get()->bound) {
-            ss << " -> (" << furthestPosition->get()->bound->lineNumber << ":"
-               << furthestPosition->get()->bound->columnNumber << ") "
-               << furthestPosition->get()->bound->text;
+           << furthest->lineNumber << ":"
+           << furthest->columnNumber << ") "
+           << "unexpected token: " << furthest->text;
+
+        if (furthest->bound) {
+            ss << " -> (" << furthest->bound->lineNumber << ":"
+               << furthest->bound->columnNumber << ") "
+               << furthest->bound->text;
         }
         ss << std::endl;
         return ss.str();
     }
 
-    Diagnostic Parser::getErrorDiagnostic() const {
+    Diagnostic unexpectedToken(const Token* t) {
         Diagnostic d;
         d.severity = Severity::Error;
         d.phase    = Phase::Parse;
-        if (furthestPosition == tokens.cend()) {
+        if (t == nullptr) {
             d.message = "unexpected end of input";
             return d;
         }
-        const Token* t = furthestPosition->get();
         d.loc = SourceLoc{t->lineNumber, t->columnNumber};
         d.message = "unexpected token: " + t->text;
         if (t->bound) {
@@ -95,57 +114,145 @@ namespace basis {
         return d;
     }
 
-    // Discard implementation
-    Discard::Discard(TokenType type) : type(type) {}
+    Diagnostic nestingTooDeep(const Token* t, size_t limit) {
+        Diagnostic d;
+        d.severity = Severity::Error;
+        d.phase    = Phase::Parse;
+        if (t) d.loc = SourceLoc{t->lineNumber, t->columnNumber};
+        d.message = "nesting exceeds the parser depth limit of " + std::to_string(limit);
+        return d;
+    }
 
-    bool Discard::parse(const std::list<spToken>& tokens, spParseTree** _unused,
-                       itToken* pIter, const Token* pLimit,
-                       itToken* pFurthest, const ParseFn** ppFurthestParser) const {
-        if (atLimit(tokens, pIter, pLimit)) {
-            updateFurthest(tokens, pIter, pFurthest, ppFurthestParser, this);
+    Diagnostic Parser::getErrorDiagnostic() const {
+        if (depthExceeded) return nestingTooDeep(depthExceededAt, depthLimit);
+        return unexpectedToken(furthestPosition == tokens.end() ? nullptr : tokens[furthestPosition]);
+    }
+
+    static size_t reportRecovered(const spParseTree& pt, Diagnostics& diags) {
+        size_t count = 0;
+        for (auto node = pt; node; node = node->spNext) {
+            if (node->production == Production::PARSE_ERROR) {
+                const Token* at = node->spDown ? node->spDown->pToken : nullptr;
+                Diagnostic d = unexpectedToken(at);
+                if (node->pToken) {
+                    d.relatedLoc = SourceLoc{node->pToken->lineNumber, node->pToken->columnNumber};
+                    d.related    = "in definition starting with: " + node->pToken->text;
+                }
+                diags.report(std::move(d));
+                ++count;
+                continue;
+            }
+            count += reportRecovered(node->spDown, diags);
+        }
+        return count;
+    }
+
+    size_t Parser::reportErrors(Diagnostics& diags) const {
+        if (!succeeded) {
+            diags.report(getErrorDiagnostic());
+            return 1;
+        }
+        size_t count = reportRecovered(parseTree, diags);
+        if (!allTokensConsumed()) {
+            diags.report(unexpectedToken(tokens[finalPosition]));
+            ++count;
+        }
+        return count;
+    }
+
+    // Discard implementation
+    bool Discard::parse(const TokenIndex& tokens, spParseTree** _unused,
+                       TokenPos* pPos, TokenPos limit,
+                       TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        if (atLimit(tokens, *pPos, limit)) {
+            updateFurthest(*pPos, pFurthest, ppFurthestParser, this);
             return false;
         }
-        if ((*pIter)->get()->type == type) {
-            ++(*pIter);
+        if (tokens[*pPos]->type == type) {
+            ++(*pPos);
             return true;
         }
-        updateFurthest(tokens, pIter, pFurthest, ppFurthestParser, this);
+        updateFurthest(*pPos, pFurthest, ppFurthestParser, this);
         return false;
     }
 
-    SPPF discard(TokenType type) { return std::make_shared<Discard>(type); }
+    namespace {
+        template<size_t... I>
+        constexpr std::array<Discard, sizeof...(I)> discardTable(std::index_sequence<I...>) {
+            return {Discard(static_cast<TokenType>(I))...};
+        }
+
+        // built at compile time, so no grammar construction allocates a discard
+        constinit std::array<Discard, tokenTypeCount> discards =
+            discardTable(std::make_index_sequence<tokenTypeCount>{});
+    }
+
+    SPPF discard(TokenType type) {
+        // an empty owner makes a non-owning pointer with no control block
+        return SPPF(SPPF(), &discards[static_cast<size_t>(type)]);
+    }
 
     // Match implementation
     Match::Match(Production prod, TokenType type) : prod(prod), type(type) {}
 
-    bool Match::parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                     itToken* pIter, const Token* pLimit,
-                     itToken* pFurthest, const ParseFn** ppFurthestParser) const {
-        if (atLimit(tokens, pIter, pLimit)) {
-            updateFurthest(tokens, pIter, pFurthest, ppFurthestParser, this);
+    bool Match::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                     TokenPos* pPos, TokenPos limit,
+                     TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        if (atLimit(tokens, *pPos, limit)) {
+            updateFurthest(*pPos, pFurthest, ppFurthestParser, this);
             return false;
         }
-        if ((*pIter)->get()->type == type) {
-            **dpspResult = std::make_shared<ParseTree>(prod, (*pIter)->get());
-            ++(*pIter);
+        if (tokens[*pPos]->type == type) {
+            **dpspResult = std::make_shared<ParseTree>(prod, tokens[*pPos]);
+            ++(*pPos);
             *dpspResult = &((**dpspResult)->spNext);
             return true;
         }
-        updateFurthest(tokens, pIter, pFurthest, ppFurthestParser, this);
+        updateFurthest(*pPos, pFurthest, ppFurthestParser, this);
         return false;
     }
 
     SPPF match(Production prod, TokenType type) { return std::make_shared<Match>(prod, type); }
 
+    // Dispatch implementation
+    Dispatch::Dispatch(const std::vector<std::pair<TokenType, Production>>& table) : productions{}, matches{} {
+        for (auto& [type, prod] : table) {
+            productions[static_cast<size_t>(type)] = prod;
+            matches[static_cast<size_t>(type)] = true;
+        }
+    }
+
+    bool Dispatch::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                         TokenPos* pPos, TokenPos limit,
+                         TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        if (atLimit(tokens, *pPos, limit)) {
+            updateFurthest(*pPos, pFurthest, ppFurthestParser, this);
+            return false;
+        }
+        size_t type = static_cast<size_t>(tokens[*pPos]->type);
+        if (matches[type]) {
+            **dpspResult = std::make_shared<ParseTree>(productions[type], tokens[*pPos]);
+            ++(*pPos);
+            *dpspResult = &((**dpspResult)->spNext);
+            return true;
+        }
+        updateFurthest(*pPos, pFurthest, ppFurthestParser, this);
+        return false;
+    }
+
+    SPPF dispatch(const std::vector<std::pair<TokenType, Production>>& table) {
+        return std::make_shared<Dispatch>(table);
+    }
+
     // Maybe implementation
     Maybe::Maybe(SPPF spParseFn): spfn(spParseFn) {}
 
-    bool Maybe::parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                      itToken* pIter, const Token* pLimit,
-                      itToken* pFurthest, const ParseFn** ppFurthestParser) const {
-        RollbackGuard<itToken> guard(pIter);
+    bool Maybe::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                      TokenPos* pPos, TokenPos limit,
+                      TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        RollbackGuard<TokenPos> guard(pPos);
         spParseTree* next = *dpspResult;
-        if (spfn->parse(tokens, &next, pIter, pLimit, pFurthest, ppFurthestParser)) {
+        if (spfn->parse(tokens, &next, pPos, limit, pFurthest, ppFurthestParser)) {
             *dpspResult = next;
             guard.commit();
         }
@@ -155,18 +262,18 @@ namespace basis {
     SPPF maybe(SPPF parseFn) { return std::make_shared<Maybe>(parseFn); }
 
     // Prefix implementation
-    Prefix::Prefix(std::vector<SPPF> sequence) : sequence(sequence) {}
+    Prefix::Prefix(std::vector<SPPF> sequence) : sequence(std::move(sequence)) {}
 
-    bool Prefix::parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                       itToken* pIter, const Token* pLimit,
-                       itToken* pFurthest, const ParseFn** ppFurthestParser) const {
+    bool Prefix::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                       TokenPos* pPos, TokenPos limit,
+                       TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
         if (sequence.empty()) return true;
 
-        RollbackGuard<itToken> guard(pIter);
+        RollbackGuard<TokenPos> guard(pPos);
         spParseTree* next = *dpspResult;
 
         // Try to match the first element (the prefix)
-        if (!sequence[0]->parse(tokens, &next, pIter, pLimit, pFurthest, ppFurthestParser)) {
+        if (!sequence[0]->parse(tokens, &next, pPos, limit, pFurthest, ppFurthestParser)) {
             // Prefix not found - succeed without consuming anything
             *dpspResult = next;
             guard.commit();
@@ -176,7 +283,7 @@ namespace basis {
         // Prefix matched - now all remaining elements must match
         if (*next) next = &((*next)->spNext);
         for (size_t i = 1; i < sequence.size(); ++i) {
-            if (!sequence[i]->parse(tokens, &next, pIter, pLimit, pFurthest, ppFurthestParser)) {
+            if (!sequence[i]->parse(tokens, &next, pPos, limit, pFurthest, ppFurthestParser)) {
                 // Failed after prefix matched - restore position and fail
                 return false;
             }
@@ -190,14 +297,14 @@ namespace basis {
     SPPF prefix(SPPF parseFn) { return std::make_shared<Prefix>(std::vector<SPPF>{parseFn}); }
 
     // Any implementation
-    Any::Any(std::vector<SPPF> alternatives) : alternatives(alternatives) {}
+    Any::Any(std::vector<SPPF> alternatives) : alternatives(std::move(alternatives)) {}
 
-    bool Any::parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                   itToken* pIter, const Token* pLimit,
-                   itToken* pFurthest, const ParseFn** ppFurthestParser) const {
-        RollbackGuard<itToken> guard(pIter);
+    bool Any::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                   TokenPos* pPos, TokenPos limit,
+                   TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        RollbackGuard<TokenPos> guard(pPos);
         for (const SPPF& alt : alternatives) {
-            if (alt->parse(tokens, dpspResult, pIter, pLimit, pFurthest, ppFurthestParser)) {
+            if (alt->parse(tokens, dpspResult, pPos, limit, pFurthest, ppFurthestParser)) {
                 guard.commit();
                 return true;
             }
@@ -207,15 +314,15 @@ namespace basis {
     }
 
     // All implementation
-    All::All(std::vector<SPPF> sequence) : sequence(sequence) {}
+    All::All(std::vector<SPPF> sequence) : sequence(std::move(sequence)) {}
 
-    bool All::parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                   itToken* pIter, const Token* pLimit,
-                   itToken* pFurthest, const ParseFn** ppFurthestParser) const {
-        RollbackGuard<itToken> guard(pIter);
+    bool All::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                   TokenPos* pPos, TokenPos limit,
+                   TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        RollbackGuard<TokenPos> guard(pPos);
         spParseTree* next = *dpspResult;
         for (const SPPF& fn : sequence) {
-            if (!fn->parse(tokens, &next, pIter, pLimit, pFurthest, ppFurthestParser)) {
+            if (!fn->parse(tokens, &next, pPos, limit, pFurthest, ppFurthestParser)) {
                 return false;
             }
             if (*next) next = &((*next)->spNext);
@@ -228,15 +335,15 @@ namespace basis {
     // OneOrMore implementation
     OneOrMore::OneOrMore(SPPF spParseFn) : spfn(spParseFn) {}
 
-    bool OneOrMore::parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                         itToken* pIter, const Token* pLimit,
-                         itToken* pFurthest, const ParseFn** ppFurthestParser) const {
-        if (!spfn->parse(tokens, dpspResult, pIter, pLimit, pFurthest, ppFurthestParser)) {
+    bool OneOrMore::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                         TokenPos* pPos, TokenPos limit,
+                         TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        if (!spfn->parse(tokens, dpspResult, pPos, limit, pFurthest, ppFurthestParser)) {
             return false;
         }
         spParseTree* next = *dpspResult;
         if (*next) next = &((*next)->spNext);
-        while (spfn->parse(tokens, &next, pIter, pLimit, pFurthest, ppFurthestParser)) {
+        while (spfn->parse(tokens, &next, pPos, limit, pFurthest, ppFurthestParser)) {
             if (*next) next = &((*next)->spNext);
         }
         *dpspResult = next;
@@ -247,27 +354,29 @@ namespace basis {
 
     // Separated implementation
     Separated::Separated(SPPF spElement, SPPF spSeparator, bool optionalSeparator)
-        : spElement(spElement), spSeparator(spSeparator), optionalSeparator(optionalSeparator) {}
+        : children{spElement, spSeparator}, optionalSeparator(optionalSeparator) {}
 
-    bool Separated::parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                         itToken* pIter, const Token* pLimit,
-                         itToken* pFurthest, const ParseFn** ppFurthestParser) const {
+    bool Separated::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                         TokenPos* pPos, TokenPos limit,
+                         TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        const SPPF& spElement = children[0];
+        const SPPF& spSeparator = children[1];
         bool foundSeparator = false;
-        if (!spElement->parse(tokens, dpspResult, pIter, pLimit, pFurthest, ppFurthestParser)) {
+        if (!spElement->parse(tokens, dpspResult, pPos, limit, pFurthest, ppFurthestParser)) {
             return false;
         }
         spParseTree* next = *dpspResult;
         if (*next) next = &((*next)->spNext);
         while (true) {
-            RollbackGuard<itToken> guard(pIter);
-            if (!spSeparator->parse(tokens, &next, pIter, pLimit, pFurthest, ppFurthestParser)) {
+            RollbackGuard<TokenPos> guard(pPos);
+            if (!spSeparator->parse(tokens, &next, pPos, limit, pFurthest, ppFurthestParser)) {
                 // if the separator is optional or we've already found a separator, then we're done
                 if (optionalSeparator || foundSeparator) break;
                 // no separator found and not optional - fail
                 return false;
             }
             foundSeparator = true;
-            if (!spElement->parse(tokens, &next, pIter, pLimit, pFurthest, ppFurthestParser)) {
+            if (!spElement->parse(tokens, &next, pPos, limit, pFurthest, ppFurthestParser)) {
                 // Found separator but no following element - restore position and fail
                 return false;
             }
@@ -285,15 +394,14 @@ namespace basis {
     // Bound implementation
     Bound::Bound(SPPF spParseFn) : spfn(spParseFn) {}
 
-    bool Bound::parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                     itToken* pIter, const Token* pLimit,
-                     itToken* pFurthest, const ParseFn** ppFurthestParser) const {
-        if (atLimit(tokens, pIter, pLimit)) {
-            updateFurthest(tokens, pIter, pFurthest, ppFurthestParser, this);
+    bool Bound::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                     TokenPos* pPos, TokenPos limit,
+                     TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        if (atLimit(tokens, *pPos, limit)) {
+            updateFurthest(*pPos, pFurthest, ppFurthestParser, this);
             return false;
         }
-        const Token* boundLimit = (*pIter)->get()->bound ? (*pIter)->get()->bound.get() : nullptr;
-        return spfn->parse(tokens, dpspResult, pIter, boundLimit, pFurthest, ppFurthestParser);
+        return spfn->parse(tokens, dpspResult, pPos, tokens.bound(*pPos), pFurthest, ppFurthestParser);
     }
 
     SPPF bound(SPPF parseFn) { return std::make_shared<Bound>(parseFn); }
@@ -301,14 +409,14 @@ namespace basis {
     // Group implementation
     Group::Group(Production prod, SPPF spParseFn) : prod(prod), spfn(spParseFn) {}
 
-    bool Group::parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                     itToken* pIter, const Token* pLimit,
-                     itToken* pFurthest, const ParseFn** ppFurthestParser) const {
-        RollbackGuard<itToken> guard(pIter);
+    bool Group::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                     TokenPos* pPos, TokenPos limit,
+                     TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        RollbackGuard<TokenPos> guard(pPos);
         spParseTree* target = *dpspResult;
         (*target) = std::make_shared<ParseTree>(prod);
         spParseTree* down = &(*target)->spDown;
-        if (spfn->parse(tokens, &down, pIter, pLimit, pFurthest, ppFurthestParser)) {
+        if (spfn->parse(tokens, &down, pPos, limit, pFurthest, ppFurthestParser)) {
             guard.commit();
             return true;
         }
@@ -319,23 +427,22 @@ namespace basis {
 
     // BoundedGroup implementation
     BoundedGroup::BoundedGroup(bool isStrict, Production prod, std::vector<SPPF> sequence)
-        : isStrict(isStrict), prod(prod), sequence(sequence) {}
+        : isStrict(isStrict), prod(prod), all(std::move(sequence)) {}
 
-    bool BoundedGroup::parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                            itToken* pIter, const Token* pLimit,
-                            itToken* pFurthest, const ParseFn** ppFurthestParser) const {
-        if (atLimit(tokens, pIter, pLimit)) {
-            updateFurthest(tokens, pIter, pFurthest, ppFurthestParser, this);
+    bool BoundedGroup::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                            TokenPos* pPos, TokenPos limit,
+                            TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        if (atLimit(tokens, *pPos, limit)) {
+            updateFurthest(*pPos, pFurthest, ppFurthestParser, this);
             return false;
         }
-        const Token* boundLimit = getBoundLimit(tokens, pIter, pLimit);
+        TokenPos boundLimit = getBoundLimit(tokens, *pPos, limit);
 
-        RollbackGuard<itToken> guard(pIter);
+        RollbackGuard<TokenPos> guard(pPos);
         spParseTree* down = createGroupNode(prod, dpspResult);
 
-        All allParser(sequence);
-        if ( allParser.parse(tokens, &down, pIter, boundLimit, pFurthest, ppFurthestParser) &&
-             (!isStrict && boundLimit == nullptr || atLimit(tokens, pIter, boundLimit))) {
+        if ( all.parse(tokens, &down, pPos, boundLimit, pFurthest, ppFurthestParser) &&
+             (!isStrict && boundLimit == tokens.end() || atLimit(tokens, *pPos, boundLimit))) {
             guard.commit();
             return true;
         }
@@ -347,10 +454,10 @@ namespace basis {
     // Forward implementation
     Forward::Forward(const SPPF& ref) : spfnRef(ref) {}
 
-    bool Forward::parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                     itToken* pIter, const Token* pLimit,
-                     itToken* pFurthest, const ParseFn** ppFurthestParser) const {
-        return spfnRef->parse(tokens, dpspResult, pIter, pLimit, pFurthest, ppFurthestParser);
+    bool Forward::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                     TokenPos* pPos, TokenPos limit,
+                     TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        return spfnRef->parse(tokens, dpspResult, pPos, limit, pFurthest, ppFurthestParser);
     }
 
     SPPF forward(const SPPF& spfnRef) {
@@ -360,16 +467,16 @@ namespace basis {
     // As implementation
     As::As(Production prod, SPPF spParseFn) : prod(prod), spfn(spParseFn) {}
 
-    bool As::parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                   itToken* pIter, const Token* pLimit,
-                   itToken* pFurthest, const ParseFn** ppFurthestParser) const {
-        itToken start = *pIter;
+    bool As::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                   TokenPos* pPos, TokenPos limit,
+                   TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        TokenPos start = *pPos;
         spParseTree* firstResult = *dpspResult;
-        if (spfn->parse(tokens, dpspResult, pIter, pLimit, pFurthest, ppFurthestParser)) {
+        if (spfn->parse(tokens, dpspResult, pPos, limit, pFurthest, ppFurthestParser)) {
             if (*firstResult) {
                 (*firstResult)->production = prod;
-            } else if (start != *pIter) {
-                *firstResult = std::make_shared<ParseTree>(prod, (*start).get());
+            } else if (start != *pPos) {
+                *firstResult = std::make_shared<ParseTree>(prod, tokens[start]);
                 *dpspResult = &((*firstResult)->spNext);
             }
             return true;
@@ -379,5 +486,56 @@ namespace basis {
 
     SPPF as(Production prod, SPPF parseFn) { return std::make_shared<As>(prod, parseFn); }
 
-}
+    // Recover implementation
+    Recover::Recover(SPPF spParseFn) : spfn(spParseFn) {}
+
+    bool Recover::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                        TokenPos* pPos, TokenPos limit,
+                        TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        if (atLimit(tokens, *pPos, limit)) {
+            updateFurthest(*pPos, pFurthest, ppFurthestParser, this);
+            return false;
+        }
+        if (spfn->parse(tokens, dpspResult, pPos, limit, pFurthest, ppFurthestParser)) {
+            return true;
+        }
+        // Definitions never scan past their bound, so the furthest failure lies
+        // within the span of the definition that just failed.
+        const Token* lead = tokens[*pPos];
+        const Token* at = *pFurthest == tokens.end() ? nullptr : tokens[*pFurthest];
+        spParseTree* target = *dpspResult;
+        (*target) = std::make_shared<ParseTree>(Production::PARSE_ERROR, lead);
+        (*target)->spDown = std::make_shared<ParseTree>(Production::PARSE_ERROR_AT, at);
+        // resynchronize: always consume the leading token, then skip to its bound
+        TokenPos resume = tokens.bound(*pPos);
+        do {
+            ++(*pPos);
+        } while (!atLimit(tokens, *pPos, limit) && *pPos != resume);
+        *dpspResult = &(*target)->spNext;
+        return true;
+    }
+
+    SPPF recover(SPPF parseFn) { return std::make_shared<Recover>(parseFn); }
 
+    // Defer implementation
+    Defer::Defer(Production prod, TokenType lead) : prod(prod), lead(lead) {}
+
+    bool Defer::parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                      TokenPos* pPos, TokenPos limit,
+                      TokenPos* pFurthest, const ParseFn** ppFurthestParser) const {
+        if (atLimit(tokens, *pPos, limit) || tokens[*pPos]->type != lead) {
+            updateFurthest(*pPos, pFurthest, ppFurthestParser, this);
+            return false;
+        }
+        TokenPos end = limit < tokens.end() ? limit : tokens.end();
+        spParseTree* target = *dpspResult;
+        (*target) = std::make_shared<ParseTree>(prod, tokens[*pPos]);
+        (*target)->spDown = std::make_shared<ParseTree>(Production::DEFERRED_END, tokens[end - 1]);
+        *pPos = end;
+        *dpspResult = &(*target)->spNext;
+        return true;
+    }
+
+    SPPF defer(Production prod, TokenType lead) { return std::make_shared<Defer>(prod, lead); }
+
+}
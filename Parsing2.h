@@ -1,11 +1,15 @@
 #ifndef PARSER2_H
 #define PARSER2_H
 
+#include <array>
+#include <cstdint>
 #include <list>
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <memory>
+#include <span>
+#include <utility>
 #include <vector>
 
 #include "Diagnostic.h"
@@ -15,76 +19,168 @@
 
 namespace basis {
 
-    using itToken = std::list<spToken>::const_iterator;
+    // Parser positions are 32-bit indices into the token sequence; the end of
+    // input is the position one past the last token.
+    using TokenPos = uint32_t;
+
+    // Random-access view of a token list for the parser: the tokens by position,
+    // and each token's bound as a position (end() when it has none), so that
+    // limits, rollbacks and furthest-failure tracking are plain integer compares.
+    class TokenIndex {
+    public:
+        explicit TokenIndex(const std::list<spToken>& tokens);
+        TokenPos end() const { return static_cast<TokenPos>(toks.size()); }
+        const Token* operator[](TokenPos pos) const { return toks[pos]; }
+        TokenPos bound(TokenPos pos) const { return bounds[pos]; }
+    private:
+        std::vector<const Token*> toks;
+        std::vector<TokenPos> bounds;
+    };
+
+    class ParseFn;
+    using SPPF = std::shared_ptr<ParseFn>;
 
     // Base class for all parse function combinators
     class ParseFn {
     public:
+        // Identifies the built-in combinators to engines that walk the combinator
+        // graph instead of calling parse(). Other subclasses report Custom.
+        enum class Kind {
+            Custom, Discard, Match, Maybe, Prefix, Any, All, OneOrMore, Separated,
+            Bound, Group, BoundedGroup, Forward, As, Recover, Defer, Dispatch
+        };
+
+        // What those engines read of a built-in combinator. Fields that do not
+        // apply to its kind keep their defaults.
+        struct Parts {
+            Kind kind = Kind::Custom;
+            std::span<const SPPF> children{};   // in order; Separated: element, separator
+            Production prod{};                  // Match, Group, BoundedGroup, As, Defer
+            TokenType type{};                   // Discard, Match; the lead token of Defer
+            bool strict = false;                // BoundedGroup
+            bool optionalSeparator = false;     // Separated
+            std::span<const bool> matches{};    // Dispatch: the token types in its table
+            std::span<const Production> productions{};  // Dispatch: what each of them matches as
+        };
+
         virtual ~ParseFn() = default;
-        virtual bool parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                          itToken* pIter, const Token* pLimit,
-                          itToken* pFurthest, const ParseFn** ppFurthestParser) const = 0;
-        static bool atLimit(const std::list<spToken>& tokens, itToken* pIter, const Token* pLimit);
-        static const Token* getBoundLimit(const std::list<spToken>& tokens, itToken* pIter, const Token* pLimit);
+        virtual Parts parts() const { return {}; }
+        Kind kind() const { return parts().kind; }
+        virtual bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                          TokenPos* pPos, TokenPos limit,
+                          TokenPos* pFurthest, const ParseFn** ppFurthestParser) const = 0;
+        static bool atLimit(const TokenIndex& tokens, TokenPos pos, TokenPos limit) {
+            return pos == limit || pos == tokens.end();
+        }
+        static TokenPos getBoundLimit(const TokenIndex& tokens, TokenPos pos, TokenPos limit) {
+            return atLimit(tokens, pos, limit) ? tokens.end() : tokens.bound(pos);
+        }
         static spParseTree* createGroupNode(Production prod, spParseTree** dpspResult);
-        static void updateFurthest(const std::list<spToken>& tokens, itToken* pIter,
-                                   itToken* pFurthest, const ParseFn** ppFurthestParser, const ParseFn* pThis);
+        // tokens are in source order, so the furthest failure is the highest position
+        static void updateFurthest(TokenPos pos, TokenPos* pFurthest,
+                                   const ParseFn** ppFurthestParser, const ParseFn* pThis) {
+            if (pos > *pFurthest) {
+                *pFurthest = pos;
+                *ppFurthestParser = pThis;
+            }
+        }
     };
 
-    using SPPF = std::shared_ptr<ParseFn>;
-
     // Parser class that uses function objects
     class Parser {
     public:
+        // About 1400 nested parentheses or 400 nested calls: within what buildAst
+        // and the passes after it take on a default-sized stack (maxBuildNesting).
+        static constexpr size_t defaultMaxDepth = 10000;
+
         explicit Parser(const std::list<spToken>& tokens, SPPF spParseFn);
         bool parse();
+        // Same result as parse(), but run on a ParseMachine whose frames live on the
+        // heap. Input nested deeper than maxDepth frames fails with a diagnostic
+        // instead of exhausting the C++ stack.
+        bool parseWithStack(size_t maxDepth = defaultMaxDepth);
         // test support; will not be used at runtime
         bool allTokensConsumed() const;
         std::string getError() const;
         Diagnostic  getErrorDiagnostic() const;
+        // Report every syntax error of the last parse: the PARSE_ERROR nodes left by
+        // recover() in source order, then any input the parse stopped short of. A
+        // failed parse reports its furthest failure. Returns the number reported.
+        size_t reportErrors(Diagnostics& diags) const;
 
         spParseTree parseTree;
 
     private:
-        const std::list<spToken>& tokens;
+        TokenIndex tokens;
         SPPF spfn;
-        itToken finalPosition;
-        itToken furthestPosition;
+        TokenPos finalPosition;
+        TokenPos furthestPosition;
         const ParseFn* furthestParser;
+        bool succeeded;
+        size_t depthLimit;
+        const Token* depthExceededAt;
+        bool depthExceeded;
     };
 
+    // The parse diagnostic for an unexpected token; nullptr means end of input.
+    Diagnostic unexpectedToken(const Token* t);
+    // The parse diagnostic for input nested deeper than `limit` combinators, hit at t.
+    Diagnostic nestingTooDeep(const Token* t, size_t limit);
+
     // Discard combinator - matches a token type but doesn't create parse tree node
     class Discard : public ParseFn {
     public:
-        explicit Discard(TokenType type);
-        bool parse(const std::list<spToken>& tokens, spParseTree** _unused,
-                  itToken* pIter, const Token* pLimit,
-                  itToken* pFurthest, const ParseFn** ppFurthestParser) const override;
+        constexpr explicit Discard(TokenType type) : type(type) {}
+        bool parse(const TokenIndex& tokens, spParseTree** _unused,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override { return {.kind = Kind::Discard, .type = type}; }
     private:
         TokenType type;
     };
+    // Discards share one constant-initialized leaf per token type.
     SPPF discard(TokenType type);
 
     // Match combinator - matches a token type and creates parse tree node
     class Match : public ParseFn {
     public:
         Match(Production prod, TokenType type);
-        bool parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                  itToken* pIter, const Token* pLimit,
-                  itToken* pFurthest, const ParseFn** ppFurthestParser) const override;
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override { return {.kind = Kind::Match, .prod = prod, .type = type}; }
     private:
         Production prod;
         TokenType type;
     };
     SPPF match(Production prod, TokenType type);
 
+    // Dispatch combinator - matches any token type in its table with a single lookup,
+    // creating a parse tree node of the production the table maps it to. Equivalent to
+    // an any() of as(prod, discard(type)) alternatives, without trying each in turn.
+    class Dispatch : public ParseFn {
+    public:
+        explicit Dispatch(const std::vector<std::pair<TokenType, Production>>& table);
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override {
+            return {.kind = Kind::Dispatch, .matches = matches, .productions = productions};
+        }
+    private:
+        std::array<Production, tokenTypeCount> productions;
+        std::array<bool, tokenTypeCount> matches;
+    };
+    SPPF dispatch(const std::vector<std::pair<TokenType, Production>>& table);
+
     // Maybe combinator - optional parsing (always succeeds)
     class Maybe : public ParseFn {
     public:
         explicit Maybe(SPPF spParseFn);
-        bool parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                  itToken* pIter, const Token* pLimit,
-                  itToken* pFurthest, const ParseFn** ppFurthestParser) const override;
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override { return {.kind = Kind::Maybe, .children = {&spfn, 1}}; }
     private:
         SPPF spfn;
     };
@@ -94,9 +190,10 @@ namespace basis {
     class Prefix : public ParseFn {
     public:
         explicit Prefix(std::vector<SPPF> sequence);
-        bool parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                  itToken* pIter, const Token* pLimit,
-                  itToken* pFurthest, const ParseFn** ppFurthestParser) const override;
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override { return {.kind = Kind::Prefix, .children = sequence}; }
     private:
         std::vector<SPPF> sequence;
     };
@@ -110,9 +207,10 @@ namespace basis {
     class Any : public ParseFn {
     public:
         explicit Any(std::vector<SPPF> alternatives);
-        bool parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                  itToken* pIter, const Token* pLimit,
-                  itToken* pFurthest, const ParseFn** ppFurthestParser) const override;
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override { return {.kind = Kind::Any, .children = alternatives}; }
     private:
         std::vector<SPPF> alternatives;
     };
@@ -126,9 +224,10 @@ namespace basis {
     class All : public ParseFn {
     public:
         explicit All(std::vector<SPPF> sequence);
-        bool parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                  itToken* pIter, const Token* pLimit,
-                  itToken* pFurthest, const ParseFn** ppFurthestParser) const override;
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override { return {.kind = Kind::All, .children = sequence}; }
     private:
         std::vector<SPPF> sequence;
     };
@@ -142,9 +241,10 @@ namespace basis {
     class OneOrMore : public ParseFn {
     public:
         explicit OneOrMore(SPPF spParseFn);
-        bool parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                  itToken* pIter, const Token* pLimit,
-                  itToken* pFurthest, const ParseFn** ppFurthestParser) const override;
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override { return {.kind = Kind::OneOrMore, .children = {&spfn, 1}}; }
     private:
         SPPF spfn;
     };
@@ -154,12 +254,14 @@ namespace basis {
     class Separated : public ParseFn {
     public:
         Separated(SPPF spElement, SPPF spSeparator, bool optionalSeparator = true);
-        bool parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                  itToken* pIter, const Token* pLimit,
-                  itToken* pFurthest, const ParseFn** ppFurthestParser) const override;
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override {
+            return {.kind = Kind::Separated, .children = children, .optionalSeparator = optionalSeparator};
+        }
     private:
-        SPPF spElement;
-        SPPF spSeparator;
+        std::array<SPPF, 2> children; // element, separator
         bool optionalSeparator;
     };
     SPPF separated(SPPF element, SPPF separator, bool optionalSeparator = true);
@@ -168,9 +270,10 @@ namespace basis {
     class Bound : public ParseFn {
     public:
         explicit Bound(SPPF spParseFn);
-        bool parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                  itToken* pIter, const Token* pLimit,
-                  itToken* pFurthest, const ParseFn** ppFurthestParser) const override;
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override { return {.kind = Kind::Bound, .children = {&spfn, 1}}; }
     private:
         SPPF spfn;
     };
@@ -180,9 +283,10 @@ namespace basis {
     class Group : public ParseFn {
     public:
         Group(Production prod, SPPF spParseFn);
-        bool parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                  itToken* pIter, const Token* pLimit,
-                  itToken* pFurthest, const ParseFn** ppFurthestParser) const override;
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override { return {.kind = Kind::Group, .children = {&spfn, 1}, .prod = prod}; }
     private:
         Production prod;
         SPPF spfn;
@@ -193,13 +297,16 @@ namespace basis {
     class BoundedGroup : public ParseFn {
     public:
         BoundedGroup(bool isStrict, Production prod, std::vector<SPPF> sequence);
-        bool parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                  itToken* pIter, const Token* pLimit,
-                  itToken* pFurthest, const ParseFn** ppFurthestParser) const override;
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override {
+            return {.kind = Kind::BoundedGroup, .children = all.parts().children, .prod = prod, .strict = isStrict};
+        }
     private:
         bool isStrict;
         Production prod;
-        std::vector<SPPF> sequence;
+        All all;
     };
 
     template<typename... Args>
@@ -216,9 +323,10 @@ namespace basis {
     class Forward : public ParseFn {
     public:
         explicit Forward(const SPPF& spfnRef);
-        bool parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                  itToken* pIter, const Token* pLimit,
-                  itToken* pFurthest, const ParseFn** ppFurthestParser) const override;
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override { return {.kind = Kind::Forward, .children = {&spfnRef, 1}}; }
     private:
         const SPPF& spfnRef;
     };
@@ -229,15 +337,48 @@ namespace basis {
     class As : public ParseFn {
     public:
         As(Production prod, SPPF spParseFn);
-        bool parse(const std::list<spToken>& tokens, spParseTree** dpspResult,
-                  itToken* pIter, const Token* pLimit,
-                  itToken* pFurthest, const ParseFn** ppFurthestParser) const override;
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                  TokenPos* pPos, TokenPos limit,
+                  TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override { return {.kind = Kind::As, .children = {&spfn, 1}, .prod = prod}; }
     private:
         Production prod;
         SPPF spfn;
     };
     SPPF as(Production prod, SPPF parseFn);
 
+    // Recover combinator - on failure, emits a PARSE_ERROR node for the leading token
+    // (with a PARSE_ERROR_AT child at the furthest failure) and resynchronizes at the
+    // leading token's bound, so the enclosing repetition can carry on.
+    class Recover : public ParseFn {
+    public:
+        explicit Recover(SPPF spParseFn);
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                   TokenPos* pPos, TokenPos limit,
+                   TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override { return {.kind = Kind::Recover, .children = {&spfn, 1}}; }
+    private:
+        SPPF spfn;
+    };
+    SPPF recover(SPPF parseFn);
+
+    // Defer combinator - when the next token is `lead`, consumes every token up to the
+    // limit without parsing them. Emits a prod node for the first token with a
+    // DEFERRED_END child for the last, so the span can be parsed later. Use it last
+    // in a bounded group, where the limit is the end of the definition.
+    class Defer : public ParseFn {
+    public:
+        Defer(Production prod, TokenType lead);
+        bool parse(const TokenIndex& tokens, spParseTree** dpspResult,
+                   TokenPos* pPos, TokenPos limit,
+                   TokenPos* pFurthest, const ParseFn** ppFurthestParser) const override;
+        Parts parts() const override { return {.kind = Kind::Defer, .prod = prod, .type = lead}; }
+    private:
+        Production prod;
+        TokenType lead;
+    };
+    SPPF defer(Production prod, TokenType lead);
+
 }
 
 #endif // PARSER2_H
@@ -0,0 +1,171 @@
+#include "PhaseTimer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <ostream>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace basis;
+
+namespace {
+
+    uint64_t wallNow() {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+    }
+
+#ifndef _WIN32
+    uint64_t cpuNow(clockid_t clock) {
+        timespec ts{};
+        clock_gettime(clock, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000u + static_cast<uint64_t>(ts.tv_nsec);
+    }
+    uint64_t threadCpuNow() { return cpuNow(CLOCK_THREAD_CPUTIME_ID); }
+    uint64_t processCpuNow() { return cpuNow(CLOCK_PROCESS_CPUTIME_ID); }
+
+    uint64_t peakRssNow() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return static_cast<uint64_t>(usage.ru_maxrss);          // bytes
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;   // kilobytes
+#endif
+    }
+#else
+    // no thread clock or peak RSS without the Windows API; the process clock stands in
+    uint64_t processCpuNow() {
+        return static_cast<uint64_t>(std::clock()) * (1000000000u / CLOCKS_PER_SEC);
+    }
+    uint64_t threadCpuNow() { return processCpuNow(); }
+    uint64_t peakRssNow() { return 0; }
+#endif
+
+    void mergeInto(std::vector<TimeReport::Phase>& into, const std::vector<TimeReport::Phase>& from) {
+        for (auto& phase : from) {
+            auto it = std::find_if(into.begin(), into.end(), [&](auto& p) { return p.name == phase.name; });
+            if (it == into.end()) {
+                into.push_back(phase);
+                continue;
+            }
+            it->time.add(phase.time);
+            mergeInto(it->children, phase.children);
+        }
+    }
+
+    std::string milliseconds(uint64_t ns) {
+        char text[32];
+        std::snprintf(text, sizeof text, "%.3f", static_cast<double>(ns) / 1e6);
+        return text;
+    }
+
+    std::string kibibytes(uint64_t bytes) { return std::to_string(bytes / 1024); }
+
+    void printRows(std::ostream& os, const std::vector<TimeReport::Phase>& phases, size_t depth,
+                   size_t nameWidth) {
+        for (auto& phase : phases) {
+            std::string name = std::string(2 * depth, ' ') + phase.name;
+            char row[160];
+            std::snprintf(row, sizeof row, "%-*s %8zu %12s %12s %12s\n", static_cast<int>(nameWidth),
+                          name.c_str(), phase.time.calls, milliseconds(phase.time.wallNs).c_str(),
+                          milliseconds(phase.time.cpuNs).c_str(),
+                          kibibytes(phase.time.peakRssGrowth).c_str());
+            os << row;
+            printRows(os, phase.children, depth + 1, nameWidth);
+        }
+    }
+
+    size_t widestName(const std::vector<TimeReport::Phase>& phases, size_t depth) {
+        size_t width = 0;
+        for (auto& phase : phases)
+            width = std::max({width, 2 * depth + phase.name.size(), widestName(phase.children, depth + 1)});
+        return width;
+    }
+
+    void printJsonTime(std::ostream& os, const PhaseTime& time) {
+        os << "\"calls\": " << time.calls << ", \"wall_ms\": " << milliseconds(time.wallNs)
+           << ", \"cpu_ms\": " << milliseconds(time.cpuNs) << ", \"peak_rss_kib\": "
+           << kibibytes(time.peakRssGrowth);
+    }
+
+    void printJsonPhases(std::ostream& os, const std::vector<TimeReport::Phase>& phases) {
+        os << '[';
+        for (size_t i = 0; i < phases.size(); ++i) {
+            if (i) os << ", ";
+            // phase names are identifiers the compiler chose; nothing in them needs escaping
+            os << "{\"name\": \"" << phases[i].name << "\", ";
+            printJsonTime(os, phases[i].time);
+            os << ", \"children\": ";
+            printJsonPhases(os, phases[i].children);
+            os << '}';
+        }
+        os << ']';
+    }
+
+}
+
+void PhaseTime::add(const PhaseTime& other) {
+    calls += other.calls;
+    wallNs += other.wallNs;
+    cpuNs += other.cpuNs;
+    peakRssGrowth += other.peakRssGrowth;
+}
+
+void TimeReport::begin(std::string_view name) {
+    Phase& parent = open.empty() ? root : *open.back().phase;
+    auto it = std::find_if(parent.children.begin(), parent.children.end(),
+                           [&](auto& p) { return p.name == name; });
+    if (it == parent.children.end()) {
+        parent.children.push_back({std::string(name), {}, {}});
+        it = parent.children.end() - 1;
+    }
+    open.push_back({&*it, wallNow(), threadCpuNow(), peakRssNow()});
+}
+
+void TimeReport::end() {
+    if (open.empty()) return;
+    Open started = open.back();
+    open.pop_back();
+    PhaseTime& time = started.phase->time;
+    time.calls++;
+    time.wallNs += wallNow() - started.wallNs;
+    time.cpuNs += threadCpuNow() - started.cpuNs;
+    time.peakRssGrowth += peakRssNow() - started.peakRss;
+}
+
+void TimeReport::merge(const TimeReport& other) {
+    mergeInto(open.empty() ? root.children : open.back().phase->children, other.root.children);
+    process.add(other.process);
+}
+
+ProcessTimer::ProcessTimer() : wallNs(wallNow()), cpuNs(processCpuNow()), peakRss(peakRssNow()) {}
+
+PhaseTime ProcessTimer::elapsed() const {
+    return {1, wallNow() - wallNs, processCpuNow() - cpuNs, peakRssNow() - peakRss};
+}
+
+void basis::printTimeReport(std::ostream& os, const TimeReport& report) {
+    size_t width = std::max<size_t>(widestName(report.phases(), 0), 7);
+    char header[160];
+    std::snprintf(header, sizeof header, "%-*s %8s %12s %12s %12s\n", static_cast<int>(width), "phase",
+                  "calls", "wall ms", "cpu ms", "peak rss KiB");
+    os << header;
+    printRows(os, report.phases(), 0, width);
+    if (report.process.calls) {
+        TimeReport::Phase process{"process", report.process, {}};
+        printRows(os, {process}, 0, width);
+    }
+}
+
+void basis::printTimeReportJson(std::ostream& os, const TimeReport& report) {
+    os << "{\"phases\": ";
+    printJsonPhases(os, report.phases());
+    os << ", \"process\": {";
+    printJsonTime(os, report.process);
+    os << "}}\n";
+}
@@ -0,0 +1,97 @@
+#ifndef PHASETIMER_H
+#define PHASETIMER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace basis {
+
+// What the runs of one phase took, summed over them. CPU time is that of the
+// thread running the phase, so it stays right when phases run on many threads at
+// once; wall time is too, but phases that overlap add up to more than the time
+// that passed. Peak RSS growth is how far the peak resident size of the whole
+// process rose while the phase ran: a phase that raised it on one thread may be
+// charged to another running at the same time, but the growths of phases that
+// did not overlap add up to the growth of the run.
+struct PhaseTime {
+    size_t   calls = 0;
+    uint64_t wallNs = 0;
+    uint64_t cpuNs = 0;
+    uint64_t peakRssGrowth = 0;   // bytes
+
+    void add(const PhaseTime& other);
+};
+
+// Times of phases nested as they ran: a phase begun while another is open is
+// one of its children. Phases of the same name under the same parent are one
+// entry, so a report can cover many files, and reports of different threads
+// merge by name.
+//
+// One thread at a time records into a report; give each worker its own and
+// merge them.
+class TimeReport {
+public:
+    struct Phase {
+        std::string        name;
+        PhaseTime          time;
+        std::vector<Phase> children;   // in the order they first ran
+    };
+
+    void begin(std::string_view name);
+    void end();
+    void merge(const TimeReport& other);
+
+    const std::vector<Phase>& phases() const { return root.children; }
+    bool empty() const { return root.children.empty(); }
+
+    // The whole run, every thread: set by whoever times the run.
+    PhaseTime process;
+
+private:
+    struct Open {
+        Phase*   phase;   // stays put: only the children of the innermost open phase grow
+        uint64_t wallNs, cpuNs, peakRss;
+    };
+    Phase root;
+    std::vector<Open> open;
+};
+
+// Times a phase from construction to destruction; does nothing without a report.
+class ScopedPhase {
+public:
+    ScopedPhase(TimeReport* report, std::string_view name) : report(report) {
+        if (report) report->begin(name);
+    }
+    ~ScopedPhase() {
+        if (report) report->end();
+    }
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    TimeReport* report;
+};
+
+// The time and CPU of the whole process, and its peak RSS growth, since construction.
+class ProcessTimer {
+public:
+    ProcessTimer();
+    PhaseTime elapsed() const;
+
+private:
+    uint64_t wallNs, cpuNs, peakRss;
+};
+
+// A table with a row per phase, children indented below their parent, and a
+// last row for the whole process when the report has it.
+void printTimeReport(std::ostream& os, const TimeReport& report);
+// {"phases": [{"name", "calls", "wall_ms", "cpu_ms", "peak_rss_kib", "children"}], "process": {...}}
+void printTimeReportJson(std::ostream& os, const TimeReport& report);
+
+} // namespace basis
+
+#endif // PHASETIMER_H
@@ -0,0 +1,69 @@
+#include "Productions.h"
+
+#include <algorithm>
+#include <array>
+
+using namespace basis;
+
+namespace {
+
+    constexpr std::array productionNames = {
+        "DECIMAL", "HEXNUMBER", "BINARY", "NUMBER", "STRING", "IDENTIFIER", "IDENTIFIER_NAME",
+        "TYPENAME", "QUALIFIED_TYPENAME", "IDENTIFIER_QUALIFIER", "ALIAS", "CLASS", "COMMAND",
+        "DECLARE", "DOMAIN", "ENUMERATION", "IMPORT", "INSTANCE", "INTRINSIC", "MODULE", "OBJECT",
+        "PROGRAM", "RECORD", "SUBCOMMAND", "TEST", "AMBANG", "AMPERSAND", "AMPHORA", "APOSTROPHE",
+        "ASTERISK", "BANG", "BANGBRACE", "BANGLANGLE", "CARAT", "COMMA", "COLON", "COLANGLE",
+        "COLBRACE", "DCOLON", "DOLLAR", "EQUALS", "EXTRACT", "GREQUALS", "INSERT", "LANGLE",
+        "LEQUALS", "LARROW", "LBRACE", "LBRACKET", "LPAREN", "MINUS", "PERCENT", "PIPE", "PLUS",
+        "POUND", "QBRACE", "QLANGLE", "QMARK", "QMINUS", "DQMARK", "RANGLE", "RARROW", "RBRACE",
+        "RBRACKET", "RPAREN", "SLASH", "UNDERSCORE", "LITERAL", "DEF_ENUM", "DEF_ENUM_NAME",
+        "DEF_ENUM_TYPENAME", "DEF_ENUM_ITEM_NAME", "DEF_ENUM_ITEM_LIST", "TYPEDEF_NAME_Q",
+        "TYPEDEF_PARMS", "TYPEDEF_PARM_TYPE", "TYPEDEF_PARM_VALUE", "TYPE_NAME_Q", "TYPE_NAME_ARGS",
+        "TYPE_ARG_TYPE", "TYPE_ARG_VALUE", "TYPE_EXPR_PTR", "TYPE_EXPR_RANGE",
+        "TYPE_EXPR_RANGE_FIXED", "TYPE_EXPR", "TYPE_EXPR_CMD", "TYPE_CMDEXPR_ARG",
+        "TYPE_EXPR_DOMAIN", "TYPE_ARG_WRITEABLE", "TYPE_CMD_NOFAIL", "TYPE_CMD_MAYFAIL",
+        "TYPE_CMD_FAILS", "DEF_ALIAS", "DEF_MODULE", "DEF_MODULE_NAME", "DEF_PROGRAM", "DEF_TEST",
+        "DEF_IMPORT", "DEF_IMPORT_FILE", "DEF_IMPORT_STANDARD", "DEF_IMPORT_ALIAS",
+        "DEF_IMPORT_FILENAME", "DEF_DOMAIN", "DEF_DOMAIN_NAME", "DEF_DOMAIN_PARENT",
+        "DEF_DOMAIN_PARENT_TYPE", "DEF_DOMAIN_PARENT_RANGE", "DEF_DOMAIN_PARENT_RANGE_SIZE",
+        "DEF_DOMAIN_PARENT_RANGE_TYPE", "DEF_RECORD", "DEF_RECORD_NAME", "DEF_RECORD_FIELDS",
+        "DEF_RECORD_FIELD", "DEF_RECORD_FIELD_NAME", "DEF_RECORD_FIELD_DOMAIN", "DEF_OBJECT",
+        "DEF_OBJECT_NAME", "DEF_OBJECT_FIELDS", "DEF_OBJECT_FIELD", "DEF_OBJECT_FIELD_NAME",
+        "DEF_OBJECT_FIELD_TYPE", "DEF_UNION", "DEF_UNION_NAME", "DEF_UNION_CANDIDATES",
+        "DEF_UNION_CANDIDATE", "DEF_UNION_CANDIDATE_DOMAIN", "DEF_UNION_CANDIDATE_NAME",
+        "DEF_VARIANT", "DEF_VARIANT_NAME", "DEF_VARIANT_CANDIDATES", "DEF_VARIANT_CANDIDATE",
+        "DEF_VARIANT_CANDIDATE_TYPE", "DEF_VARIANT_CANDIDATE_NAME", "DEF_INLINE_SCOPE_NAME",
+        "DEF_INLINE_RECORD", "DEF_INLINE_UNION", "DEF_INLINE_OBJECT", "DEF_INLINE_VARIANT",
+        "DEF_CLASS", "DEF_CLASS_NAME", "DEF_CLASS_CMDS", "DEF_INSTANCE", "DEF_INSTANCE_NAME",
+        "DEF_INSTANCE_DELEGATE", "DEF_INSTANCE_TYPES", "DEF_CMD", "DEF_SUB", "DEF_SUBS",
+        "DEF_CMD_DECL", "DEF_CMD_INTRINSIC", "DEF_CMD_RECEIVERS", "DEF_CMD_RECEIVER_ATSTACK",
+        "DEF_CMD_RECEIVER_ATSTACK_FAIL", "DEF_CMD_RECEIVER", "DEF_CMD_CTOR", "DEF_CMD_VCOMMAND",
+        "DEF_CMD_REGULAR", "DEF_CMD_NAME_SPEC", "DEF_CMD_NAME", "DEF_CMD_FAILS", "DEF_CMD_MAYFAIL",
+        "DEF_CMD_PARMS", "DEF_CMD_PARM", "DEF_CMD_PARMTYPE_NAME", "DEF_CMD_PARMTYPE_VAR",
+        "DEF_CMD_PARM_TYPE", "DEF_CMD_PARM_NAME", "DEF_CMD_IMPARMS", "DEF_CMD_RETVAL",
+        "DEF_CMD_BODY", "DEF_CMD_EMPTY", "CALL_GROUP", "CALL_CONSTRUCTOR", "CALL_COMMAND",
+        "CALL_VCOMMAND", "CALL_FAIL", "CALL_ASSIGNMENT", "CALL_EXPRESSION", "SUBCALL_EXPRESSION",
+        "CALL_EXPR_ADDR", "CALL_EXPR_DEREF", "CALL_EXPR_INDEX", "CALL_EXPRINDEX_LOC",
+        "CALL_EXPRINDEX_EXT", "CALL_OPERATOR", "CALL_OPER_SCOPE", "CALL_OPER_CHOICE",
+        "CALL_OPER_ADD", "CALL_OPER_SUBTRACT", "CALL_OPER_MULTIPLY", "CALL_OPER_DIVIDE",
+        "CALL_OPER_LESSTHAN", "CALL_OPER_GREATERTHAN", "CALL_OPER_LESSTHAN_EQ",
+        "CALL_OPER_GREATERTHAN_EQ", "CALL_OPER_EQUALS", "CALL_OPER_INSERT", "CALL_OPER_EXTRACT",
+        "CALL_OPER_MODULO", "CALL_OPER_NOT_EQUALS", "CALL_OPER_EQUIVALENT",
+        "CALL_OPER_NOT_EQUIVALENT", "CALL_QUOTE", "CALL_CMD_TARGET", "CALL_PARAMETER",
+        "CALL_PARM_EMPTY", "CALL_PARM_EXPR", "CALL_IDENTIFIER", "CALL_QUOTED", "CALL_BLOCK_NOFAIL",
+        "CALL_BLOCK_FAIL", "CALL_CMD_LITERAL", "CALL_CMDLIT_NOFAIL", "CALL_CMDLIT_MAYFAIL",
+        "CALL_CMDLIT_MUSTFAIL", "CALL_BLOCK_MAYFAIL", "ALLOC_IDENTIFIER", "ON_EXIT", "ON_EXIT_FAIL",
+        "DO_WHEN", "DO_WHEN_MULTI", "DO_WHEN_FAIL", "DO_WHEN_SELECT", "DO_ELSE", "DO_UNLESS",
+        "DO_BLOCK", "DO_REWIND", "DO_RECOVER", "DO_RECOVER_SPEC", "DO_ON_EXIT", "DO_ON_EXIT_FAIL",
+        "RECOVER_SPEC", "ENUM_DEREF", "PARSE_ERROR", "PARSE_ERROR_AT", "DEF_CMD_BODY_DEFERRED",
+        "DEFERRED_END", "COMPILATION_UNIT"
+    };
+    // sized by its names, so a name missing or left over does not compile
+    static_assert(productionNames.size() == productionCount, "one name per production");
+    static_assert(std::ranges::none_of(productionNames, [](const char* name) { return name == nullptr; }));
+
+}
+
+const char* basis::productionName(Production production) {
+    return productionNames[static_cast<size_t>(production)];
+}
@@ -1,6 +1,8 @@
 #ifndef PRODUCTIONS_H
 #define PRODUCTIONS_H
 
+#include <cstddef>
+
 namespace basis {
     // production rule identifiers
     enum class Production {
@@ -227,6 +229,10 @@ namespace basis {
         CALL_OPER_EQUALS,
         CALL_OPER_INSERT,
         CALL_OPER_EXTRACT,
+        CALL_OPER_MODULO,
+        CALL_OPER_NOT_EQUALS,
+        CALL_OPER_EQUIVALENT,
+        CALL_OPER_NOT_EQUIVALENT,
         CALL_QUOTE,
         CALL_CMD_TARGET,
         CALL_PARAMETER,
@@ -262,10 +268,23 @@ namespace basis {
         ENUM_DEREF,
 
 
+        // -- syntax error recovery
+        PARSE_ERROR,
+        PARSE_ERROR_AT,
+
+        // -- deferred parsing
+        DEF_CMD_BODY_DEFERRED,
+        DEFERRED_END,
+
         // -- compilation unit
         COMPILATION_UNIT
 
     };
+    // COMPILATION_UNIT is the last production
+    constexpr size_t productionCount = static_cast<size_t>(Production::COMPILATION_UNIT) + 1;
+
+    // The enumerator name of a production, for reports
+    const char* productionName(Production production);
 }
 
 #endif // PRODUCTIONS_H
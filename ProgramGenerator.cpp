@@ -0,0 +1,452 @@
+#include "ProgramGenerator.h"
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include "Lexer.h"
+
+using namespace basis;
+
+namespace {
+
+    // Fixed spellings; literals and names are made up as they are written.
+    const char* spelling(TokenType type) {
+        switch (type) {
+            case TokenType::ALIAS:       return ".alias";
+            case TokenType::CLASS:       return ".class";
+            case TokenType::COMMAND:     return ".cmd";
+            case TokenType::DECLARE:     return ".decl";
+            case TokenType::DOMAIN:      return ".domain";
+            case TokenType::ENUMERATION: return ".enum";
+            case TokenType::IMPORT:      return ".import";
+            case TokenType::INSTANCE:    return ".instance";
+            case TokenType::INTRINSIC:   return ".intrinsic";
+            case TokenType::MODULE:      return ".module";
+            case TokenType::OBJECT:      return ".object";
+            case TokenType::PROGRAM:     return ".program";
+            case TokenType::RECORD:      return ".record";
+            case TokenType::SUBCOMMAND:  return ".sub";
+            case TokenType::TEST:        return ".test";
+            case TokenType::FAIL:        return ".fail";
+            case TokenType::UNION:       return ".union";
+            case TokenType::VARIANT:     return ".variant";
+            case TokenType::AMBANG:      return "@!";
+            case TokenType::AMPERSAND:   return "&";
+            case TokenType::AMPHORA:     return "@";
+            case TokenType::APOSTROPHE:  return "'";
+            case TokenType::ASTERISK:    return "*";
+            case TokenType::BANG:        return "!";
+            case TokenType::BANGBRACE:   return "!{";
+            case TokenType::BANGEQUALS:  return "!=";
+            case TokenType::BANGLANGLE:  return "!<";
+            case TokenType::CARAT:       return "^";
+            case TokenType::COMMA:       return ",";
+            case TokenType::COLON:       return ":";
+            case TokenType::COLANGLE:    return ":<";
+            case TokenType::COLBRACE:    return ":{";
+            case TokenType::DCOLON:      return "::";
+            case TokenType::DEQUALS:     return "==";
+            case TokenType::DLANGLE:     return "<<";
+            case TokenType::DOLLAR:      return "$";
+            case TokenType::DRANGLE:     return ">>";
+            case TokenType::EQUALS:      return "=";
+            case TokenType::GREQUALS:    return ">=";
+            case TokenType::LANGLE:      return "<";
+            case TokenType::LEQUALS:     return "<=";
+            case TokenType::LRANGLE:     return "<>";
+            case TokenType::LARROW:      return "<-";
+            case TokenType::LBRACE:      return "{";
+            case TokenType::LBRACKET:    return "[";
+            case TokenType::LPAREN:      return "(";
+            case TokenType::MINUS:       return "-";
+            case TokenType::PERCENT:     return "%";
+            case TokenType::PIPE:        return "|";
+            case TokenType::PLUS:        return "+";
+            case TokenType::POUND:       return "#";
+            case TokenType::QBRACE:      return "?{";
+            case TokenType::QCOLON:      return "?:";
+            case TokenType::QLANGLE:     return "?<";
+            case TokenType::QMARK:       return "?";
+            case TokenType::QMINUS:      return "?-";
+            case TokenType::DQMARK:      return "??";
+            case TokenType::RANGLE:      return ">";
+            case TokenType::RARROW:      return "->";
+            case TokenType::RBRACE:      return "}";
+            case TokenType::RBRACKET:    return "]";
+            case TokenType::RPAREN:      return ")";
+            case TokenType::SLASH:       return "/";
+            case TokenType::UNDERSCORE:  return "_";
+            default:                     return nullptr;
+        }
+    }
+
+    int delimiterDepth(TokenType type) {
+        switch (type) {
+            case TokenType::LPAREN:
+            case TokenType::LBRACKET:
+            case TokenType::LBRACE:
+            case TokenType::COLBRACE:
+            case TokenType::BANGBRACE:
+            case TokenType::QBRACE:
+                return 1;
+            case TokenType::RPAREN:
+            case TokenType::RBRACKET:
+            case TokenType::RBRACE:
+                return -1;
+            default:
+                return 0;
+        }
+    }
+
+    // Follows each definition while it is checked, so that its own bounds end where
+    // they would in a unit instead of at the end of input.
+    const std::string sentinel = ".alias Sentinel: Int\n";
+
+}
+
+ProgramGenerator::ProgramGenerator(const Grammar2& grammar, GeneratorOptions options)
+    : grammar(grammar), options(options), rng(options.seed) {
+    // commands dominate real code
+    setWeight(grammar.DEF_CMD, 8);
+    setWeight(grammar.DEF_CLASS, 2);
+    setWeight(grammar.DEF_RECORD, 2);
+}
+
+void ProgramGenerator::setWeight(const SPPF& rule, unsigned weight) {
+    weights[rule.get()] = weight;
+}
+
+unsigned ProgramGenerator::weightOf(const ParseFn* fn) const {
+    auto found = weights.find(fn);
+    if (found == weights.end() && fn->kind() == ParseFn::Kind::Forward) {
+        found = weights.find(fn->parts().children[0].get());
+    }
+    return found != weights.end() ? found->second : 1;
+}
+
+// Height and bounded starts over everything reachable from root, to a fixpoint so
+// that forward() cycles settle.
+void ProgramGenerator::solve(const ParseFn* root) {
+    if (nodes.contains(root)) return;
+    auto children = [](const ParseFn* fn) {
+        std::vector<const ParseFn*> result;
+        for (auto& child : fn->parts().children) result.push_back(child.get());
+        return result;
+    };
+
+    std::vector<const ParseFn*> order;
+    std::vector<const ParseFn*> pending{root};
+    while (!pending.empty()) {
+        const ParseFn* fn = pending.back();
+        pending.pop_back();
+        if (!fn || nodes.contains(fn)) continue;
+        nodes[fn];
+        order.push_back(fn);
+        for (const ParseFn* child : children(fn)) pending.push_back(child);
+    }
+
+    constexpr unsigned never = ~0u;
+    auto plusOne = [](unsigned h) { return h == never ? never : h + 1; };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const ParseFn* fn : order) {
+            std::vector<const ParseFn*> kids = children(fn);
+            unsigned height = never;
+            bool boundedStart = false;
+            const ParseFn::Parts parts = fn->parts();
+            switch (parts.kind) {
+                case ParseFn::Kind::Custom:
+                    break;
+                case ParseFn::Kind::Discard:
+                case ParseFn::Kind::Match:
+                case ParseFn::Kind::Dispatch:
+                case ParseFn::Kind::Defer:
+                    height = 0;
+                    break;
+                case ParseFn::Kind::Maybe:
+                case ParseFn::Kind::Prefix:
+                    // both can be left out
+                    height = 0;
+                    boundedStart = !kids.empty() && nodes[kids.front()].boundedStart;
+                    break;
+                case ParseFn::Kind::Any: {
+                    unsigned lowest = never;
+                    boundedStart = !kids.empty();
+                    for (const ParseFn* kid : kids) {
+                        lowest = std::min(lowest, nodes[kid].height);
+                        boundedStart = boundedStart && nodes[kid].boundedStart;
+                    }
+                    height = plusOne(lowest);
+                    break;
+                }
+                case ParseFn::Kind::All:
+                case ParseFn::Kind::BoundedGroup: {
+                    unsigned highest = 0;
+                    for (const ParseFn* kid : kids) highest = std::max(highest, nodes[kid].height);
+                    height = plusOne(highest);
+                    boundedStart = parts.kind == ParseFn::Kind::BoundedGroup
+                                || (!kids.empty() && nodes[kids.front()].boundedStart);
+                    break;
+                }
+                case ParseFn::Kind::Separated: {
+                    unsigned element = nodes[parts.children[0].get()].height;
+                    unsigned separator = parts.optionalSeparator ? 0 : nodes[parts.children[1].get()].height;
+                    height = plusOne(std::max(element, separator));
+                    boundedStart = nodes[parts.children[0].get()].boundedStart;
+                    break;
+                }
+                default:
+                    if (kids.empty() || !kids.front()) break;
+                    height = plusOne(nodes[kids.front()].height);
+                    boundedStart = parts.kind == ParseFn::Kind::Bound || nodes[kids.front()].boundedStart;
+                    break;
+            }
+            Node& node = nodes[fn];
+            if (height != node.height || boundedStart != node.boundedStart) {
+                node.height = height;
+                node.boundedStart = boundedStart;
+                changed = true;
+            }
+        }
+    }
+}
+
+// A weighted pick among the alternatives; past maxDepth, the shallowest one, so
+// that every walk ends.
+const ParseFn* ProgramGenerator::choose(const ParseFn* fn, unsigned depth) {
+    auto alternatives = fn->parts().children;
+    if (depth >= options.maxDepth) {
+        const ParseFn* best = alternatives.front().get();
+        for (auto& alternative : alternatives) {
+            if (nodes[alternative.get()].height < nodes[best].height) best = alternative.get();
+        }
+        return best;
+    }
+    unsigned total = 0;
+    for (auto& alternative : alternatives) total += weightOf(alternative.get());
+    if (total == 0) return alternatives.front().get();
+    unsigned pick = below(total);
+    for (auto& alternative : alternatives) {
+        unsigned weight = weightOf(alternative.get());
+        if (pick < weight) return alternative.get();
+        pick -= weight;
+    }
+    return alternatives.back().get();
+}
+
+void ProgramGenerator::walk(const ParseFn* fn, unsigned depth) {
+    bool exhausted = depth >= options.maxDepth;
+    const ParseFn::Parts parts = fn->parts();
+    switch (parts.kind) {
+        case ParseFn::Kind::Custom:
+            break;
+        case ParseFn::Kind::Discard:
+            token(parts.type);
+            break;
+        case ParseFn::Kind::Match:
+            token(parts.type);
+            break;
+        case ParseFn::Kind::Dispatch: {
+            auto matches = parts.matches;
+            std::vector<TokenType> types;
+            for (size_t i = 0; i < matches.size(); ++i) {
+                if (matches[i]) types.push_back(static_cast<TokenType>(i));
+            }
+            if (!types.empty()) token(types[below(static_cast<unsigned>(types.size()))]);
+            break;
+        }
+        case ParseFn::Kind::Defer:
+            token(parts.type);
+            token(TokenType::IDENTIFIER);
+            break;
+        case ParseFn::Kind::Maybe:
+            if (!exhausted && chance()) walk(parts.children[0].get(), depth);
+            break;
+        case ParseFn::Kind::Prefix:
+            if (!exhausted && chance()) {
+                for (auto& element : parts.children) walk(element.get(), depth);
+            }
+            break;
+        case ParseFn::Kind::Any:
+            walk(choose(fn, depth), depth);
+            break;
+        case ParseFn::Kind::All:
+            for (auto& element : parts.children) walk(element.get(), depth);
+            break;
+        case ParseFn::Kind::BoundedGroup:
+            bounded(parts.children, depth, true);
+            break;
+        case ParseFn::Kind::OneOrMore:
+            repeat(parts.children[0].get(), depth);
+            break;
+        case ParseFn::Kind::Separated: {
+            unsigned more = exhausted ? 0 : below(options.maxRepeat);
+            if (!parts.optionalSeparator) more = std::max(more, 1u);
+            walk(parts.children[0].get(), depth);
+            for (unsigned i = 0; i < more; ++i) {
+                walk(parts.children[1].get(), depth);
+                walk(parts.children[0].get(), depth);
+            }
+            break;
+        }
+        case ParseFn::Kind::Bound:
+            bounded(parts.children, depth, false);
+            break;
+        case ParseFn::Kind::Group:
+            walk(parts.children[0].get(), depth);
+            break;
+        case ParseFn::Kind::As:
+            walk(parts.children[0].get(), depth);
+            break;
+        case ParseFn::Kind::Recover:
+            walk(parts.children[0].get(), depth);
+            break;
+        case ParseFn::Kind::Forward:
+            walk(parts.children[0].get(), depth + 1);
+            break;
+    }
+}
+
+// Items that begin bounded groups each get a line, indented past the line the
+// repetition starts on; whatever follows the last item starts a line at the same
+// indent, which ends the last item's bound. Inside delimiters the closing token
+// bounds the items, so they stay on the line, and only one is written.
+void ProgramGenerator::repeat(const ParseFn* item, unsigned depth) {
+    unsigned count = depth >= options.maxDepth ? 1 : 1 + below(options.maxRepeat);
+    if (!nodes[item].boundedStart) {
+        for (unsigned i = 0; i < count; ++i) walk(item, depth);
+        return;
+    }
+    if (!delimiters.empty()) {
+        walk(item, depth);
+        return;
+    }
+    size_t indent = std::max(lineIndent + 4, innermostColumn());
+    for (unsigned i = 0; i < count; ++i) {
+        newline(indent);
+        walk(item, depth);
+    }
+    pendingIndent = static_cast<int>(indent);
+}
+
+// A group that must end at its bound, if written mid-line, has whatever follows it
+// start a line: one column past the innermost group still open, which is at most
+// the group's own column, so that its bound falls there and the open groups' do not.
+void ProgramGenerator::bounded(std::span<const SPPF> sequence, unsigned depth, bool mustReachBound) {
+    open.push_back(0);
+    for (auto& element : sequence) walk(element.get(), depth);
+    size_t column = open.back();
+    open.pop_back();
+    if (mustReachBound && column > 0) pendingIndent = static_cast<int>(innermostColumn());
+}
+
+// A line must start past the groups still open, and past the innermost open
+// delimiter: a closing token in an earlier column than its opener would bound the
+// groups outside it.
+size_t ProgramGenerator::innermostColumn() const {
+    size_t column = delimiters.empty() ? 0 : delimiters.back();
+    for (size_t c : open) column = std::max(column, c);
+    return column;
+}
+
+void ProgramGenerator::newline(size_t indent) {
+    text += '\n';
+    lineOffset = text.size();
+    text.append(indent, ' ');
+    lineIndent = indent;
+    lineStart = true;
+    pendingIndent = -1;
+}
+
+void ProgramGenerator::token(TokenType type) {
+    if (pendingIndent >= 0) newline(static_cast<size_t>(pendingIndent));
+    if (!lineStart) text += ' ';
+    lineStart = false;
+    size_t column = text.size() - lineOffset + 1;
+    for (auto it = open.rbegin(); it != open.rend() && *it == 0; ++it) *it = column;
+    if (delimiterDepth(type) > 0) delimiters.push_back(column);
+    if (delimiterDepth(type) < 0 && !delimiters.empty()) delimiters.pop_back();
+    if (const char* fixed = spelling(type)) {
+        text += fixed;
+        return;
+    }
+    static const char hex[] = "0123456789abcdef";
+    switch (type) {
+        case TokenType::DECIMAL:
+            text += std::to_string(below(1000)) + "." + std::to_string(below(100));
+            break;
+        case TokenType::HEXNUMBER:
+            text += "0x";
+            text += hex[below(16)];
+            text += hex[below(16)];
+            break;
+        case TokenType::BINARY:
+            text += "0b";
+            for (int i = 0; i < 8; ++i) text += chance() ? '1' : '0';
+            break;
+        case TokenType::NUMBER:
+            text += std::to_string(below(1000));
+            break;
+        case TokenType::STRING:
+            text += "\"s" + std::to_string(below(100)) + "\"";
+            break;
+        case TokenType::IDENTIFIER:
+            text += static_cast<char>('a' + below(26));
+            text += std::to_string(below(100));
+            break;
+        case TokenType::TYPENAME:
+            text += static_cast<char>('A' + below(26));
+            text += std::to_string(below(100));
+            break;
+        default:
+            break;
+    }
+}
+
+bool ProgramGenerator::parses(const std::string& definition) const {
+    std::istringstream input(definition + sentinel);
+    Lexer lexer(input, discardDiagnostics());
+    if (!lexer.scan()) return false;
+    Parser parser(lexer.output, grammar.COMPILATION_UNIT);
+    return parser.parse() && parser.allTokensConsumed();
+}
+
+std::string ProgramGenerator::definition(const SPPF& rule) {
+    solve(rule.get());
+    for (unsigned attempt = 0; attempt < options.maxAttempts; ++attempt) {
+        text.clear();
+        lineIndent = 0;
+        lineOffset = 0;
+        lineStart = true;
+        open.clear();
+        delimiters.clear();
+        pendingIndent = -1;
+        walk(rule.get(), 0);
+        text += '\n';
+        if (parses(text)) {
+            ++generated;
+            return std::move(text);
+        }
+        ++rejected;
+    }
+    return {};
+}
+
+size_t ProgramGenerator::generate(std::ostream& out, size_t bytes) {
+    size_t written = 0;
+    auto write = [&](const std::string& s) {
+        out << s;
+        written += s.size();
+    };
+    write(definition(grammar.DEF_MODULE));
+    write(definition(grammar.DEF_IMPORT));
+    while (written < bytes) {
+        std::string next = definition();
+        // a rule that never parses would loop forever
+        if (next.empty()) break;
+        write(next);
+    }
+    return written;
+}
@@ -0,0 +1,95 @@
+#ifndef PROGRAMGENERATOR_H
+#define PROGRAMGENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Grammar2.h"
+#include "Parsing2.h"
+#include "Token.h"
+
+namespace basis {
+
+    struct GeneratorOptions {
+        uint64_t seed        = 1;
+        unsigned maxDepth    = 6;     // forward() references followed before taking the shortest way out
+        unsigned maxRepeat   = 3;     // most items one repetition emits
+        unsigned maxAttempts = 100;   // tries per definition before giving up on it
+    };
+
+    // Generates Basis source by walking the combinator graph of a Grammar2 with
+    // weighted random choices. Lines are laid out so that the lexer's indentation
+    // bounds close groups where the walk did: repetitions whose items begin
+    // bounded groups (statements, subs, class members) put each item on its own
+    // indented line, and whatever follows a bounded group written mid-line starts
+    // a new one. Any() commits to its first match and maybe() is greedy, so a
+    // random walk does not always spell input that parses back the way it was
+    // chosen; every definition is parsed before it is returned, and regenerated
+    // if it fails.
+    class ProgramGenerator {
+    public:
+        explicit ProgramGenerator(const Grammar2& grammar, GeneratorOptions options = {});
+
+        // Relative weight of `rule` where it is an any() alternative, directly or
+        // through forward(); rules default to 1, and 0 is never chosen.
+        void setWeight(const SPPF& rule, unsigned weight);
+
+        // One definition of `rule`, starting in column 1 and ending with a newline,
+        // that parses in a compilation unit. Empty if none did within maxAttempts.
+        std::string definition(const SPPF& rule);
+        std::string definition() { return definition(grammar.DEF_TOP_LEVEL); }
+
+        // Write a compilation unit of at least `bytes` bytes: a module, an import,
+        // then top-level definitions. Returns the number of bytes written.
+        size_t generate(std::ostream& out, size_t bytes);
+
+        size_t definitionsGenerated() const { return generated; }
+        size_t definitionsRejected() const { return rejected; }
+
+    private:
+        struct Node {
+            unsigned height = ~0u;      // depth of the shallowest derivation
+            bool boundedStart = false;  // begins a bounded group at its first token
+        };
+
+        void walk(const ParseFn* fn, unsigned depth);
+        void repeat(const ParseFn* item, unsigned depth);
+        void bounded(std::span<const SPPF> sequence, unsigned depth, bool mustReachBound);
+        size_t innermostColumn() const;
+        const ParseFn* choose(const ParseFn* fn, unsigned depth);
+        unsigned weightOf(const ParseFn* fn) const;
+        void solve(const ParseFn* root);
+        void token(TokenType type);
+        void newline(size_t indent);
+        bool parses(const std::string& text) const;
+        bool chance() { return rng() & 1; }
+        unsigned below(unsigned n) { return static_cast<unsigned>(rng() % n); }
+
+        const Grammar2& grammar;
+        GeneratorOptions options;
+        std::mt19937_64 rng;
+        std::unordered_map<const ParseFn*, Node> nodes;
+        std::unordered_map<const ParseFn*, unsigned> weights;
+
+        // the definition being written
+        std::string text;
+        size_t lineIndent = 0;
+        size_t lineOffset = 0;      // where the current line starts in text
+        bool lineStart = true;
+        std::vector<size_t> open;   // first columns of the bounded groups being written
+        std::vector<size_t> delimiters;     // columns of the open delimiters
+        int pendingIndent = -1;     // the next token starts a line at this indent
+
+        size_t generated = 0;
+        size_t rejected = 0;
+    };
+
+}
+
+#endif // PROGRAMGENERATOR_H
@@ -0,0 +1,36 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace basis {
+
+// SHA-256, for hashes that stand in for what they hash: two inputs are taken to
+// be the same when their digests are, as BuildCache takes two builds to be. Adds
+// values the way StableHasher does.
+class Sha256 {
+public:
+    using Digest = std::array<unsigned char, 32>;
+
+    void bytes(const void* data, size_t size);
+    void add(uint64_t n) { bytes(&n, sizeof n); }
+    void add(std::string_view s) { add(s.size()); bytes(s.data(), s.size()); }
+    // Pads what was added and returns its digest; add nothing after.
+    Digest digest();
+
+private:
+    void block(const unsigned char* data);
+
+    std::array<uint32_t, 8> state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                     0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    unsigned char buffer[64] = {};
+    size_t buffered = 0;
+    uint64_t length = 0;    // in bytes
+};
+
+} // namespace basis
+
+#endif // SHA256_H
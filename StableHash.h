@@ -0,0 +1,25 @@
+#ifndef STABLEHASH_H
+#define STABLEHASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace basis {
+
+// FNV-1a, for hashes that are the same from run to run, as the structural hashes
+// of types and definitions must be to compare two builds.
+struct StableHasher {
+    uint64_t value = 14695981039346656037ull;
+
+    void bytes(const void* data, size_t size) {
+        auto* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) value = (value ^ p[i]) * 1099511628211ull;
+    }
+    void add(uint64_t n) { bytes(&n, sizeof n); }
+    void add(std::string_view s) { add(s.size()); bytes(s.data(), s.size()); }
+};
+
+} // namespace basis
+
+#endif // STABLEHASH_H
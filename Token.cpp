@@ -1,13 +1,44 @@
 #include "Token.h"
 
+#include <algorithm>
+#include <array>
+
 using namespace basis;
 
+namespace {
+
+    constexpr std::array tokenNames = {
+        "_NOTHING", "DECIMAL", "HEXNUMBER", "BINARY", "NUMBER", "STRING",
+        "IDENTIFIER", "TYPENAME", "ALIAS", "CLASS", "COMMAND", "DECLARE",
+        "DOMAIN", "ENUMERATION", "IMPORT", "INSTANCE", "INTRINSIC", "MODULE",
+        "OBJECT", "PROGRAM", "RECORD", "SUBCOMMAND", "TEST", "FAIL",
+        "UNION", "VARIANT", "AMBANG", "AMPERSAND", "AMPHORA", "APOSTROPHE",
+        "ASTERISK", "BANG", "BANGBRACE", "BANGEQUALS", "BANGLANGLE", "CARAT",
+        "COMMA", "COLON", "COLANGLE", "COLBRACE", "DCOLON", "DEQUALS",
+        "DLANGLE", "DOLLAR", "DRANGLE", "EQUALS", "GREQUALS", "LANGLE",
+        "LEQUALS", "LRANGLE", "LARROW", "LBRACE", "LBRACKET", "LPAREN",
+        "MINUS", "PERCENT", "PIPE", "PLUS", "POUND", "QBRACE",
+        "QCOLON", "QLANGLE", "QMARK", "QMINUS", "DQMARK", "RANGLE",
+        "RARROW", "RBRACE", "RBRACKET", "RPAREN", "SLASH", "UNDERSCORE"
+    };
+    // sized by its names, so a name missing or left over does not compile
+    static_assert(tokenNames.size() == tokenTypeCount, "one name per token type");
+    static_assert(std::ranges::none_of(tokenNames, [](const char* name) { return name == nullptr; }));
+
+}
+
+const char* basis::tokenTypeName(TokenType type) {
+    return tokenNames[static_cast<size_t>(type)];
+}
+
 bool basis::operator==(const Token& lhs, const Token& rhs) {
     return lhs.type == rhs.type
         && lhs.text == rhs.text
         && lhs.lineNumber == rhs.lineNumber
         && lhs.columnNumber == rhs.columnNumber
-        && ((lhs.bound == nullptr && rhs.bound == nullptr) ||
+        // the same bound token ends the comparison; following bounds of a long unit
+        // from token to token would otherwise make it quadratic
+        && (lhs.bound == rhs.bound ||
             (lhs.bound != nullptr &&  rhs.bound != nullptr && *lhs.bound == *rhs.bound));
     ;
 }
@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <string>
+#include <cstdint>
 #include <memory>
 
 namespace basis {
@@ -47,6 +48,7 @@ namespace basis {
         ASTERISK,
         BANG,
         BANGBRACE,
+        BANGEQUALS,
         BANGLANGLE,
         CARAT,
         COMMA,
@@ -54,6 +56,7 @@ namespace basis {
         COLANGLE,
         COLBRACE,
         DCOLON,
+        DEQUALS,
         DLANGLE,
         DOLLAR,
         DRANGLE,
@@ -61,6 +64,7 @@ namespace basis {
         GREQUALS,
         LANGLE,
         LEQUALS,
+        LRANGLE,
         LARROW,
         LBRACE,
         LBRACKET,
@@ -84,6 +88,11 @@ namespace basis {
         SLASH,
         UNDERSCORE,
     };
+    // UNDERSCORE is the last token type
+    constexpr size_t tokenTypeCount = static_cast<size_t>(TokenType::UNDERSCORE) + 1;
+
+    // The enumerator name of a token type, for reports
+    const char* tokenTypeName(TokenType type);
 
     class Token {
     public:
@@ -92,7 +101,9 @@ namespace basis {
         size_t lineNumber;
         size_t columnNumber;
         spToken bound;
-        Token() : type(TokenType::_NOTHING), lineNumber(0), columnNumber(0), bound(nullptr) {}
+        // position in the lexer's output; lets the parser index bounds without a lookup
+        uint32_t index;
+        Token() : type(TokenType::_NOTHING), lineNumber(0), columnNumber(0), bound(nullptr), index(0) {}
     };
 
     bool operator==(const Token& lhs, const Token& rhs);
@@ -0,0 +1,126 @@
+#include "TypeInterner.h"
+#include "StableHash.h"
+
+#include <string>
+#include <type_traits>
+
+using namespace basis;
+
+namespace {
+
+    // Over the fields of a type, and the hashes of its children.
+    struct Hasher : StableHasher {
+        using StableHasher::add;
+        void add(const TypeNode* child) { add(child ? child->hash : 0); }
+    };
+
+    template<typename T>
+    void fields(const T& type, Hasher& h) {
+        if constexpr (std::is_same_v<T, NamedType>) {
+            h.add(type.name);
+            h.add(type.writeable);
+            h.add(type.typeArgs.size());
+            for (auto* arg : type.typeArgs) h.add(arg);
+        } else if constexpr (std::is_same_v<T, PtrType>) {
+            h.add(static_cast<uint64_t>(type.depth));
+            h.add(type.inner);
+        } else if constexpr (std::is_same_v<T, RangeType>) {
+            h.add(type.size);
+            h.add(type.element);
+        } else if constexpr (std::is_same_v<T, CmdType>) {
+            h.add(static_cast<uint64_t>(type.kind));
+            h.add(type.args.size());
+            for (auto& arg : type.args) { h.add(arg.type); h.add(arg.writeable); }
+        } else if constexpr (std::is_same_v<T, InlineRecordType> || std::is_same_v<T, InlineObjectType>) {
+            h.add(type.scopeName);
+            h.add(type.fields.size());
+            for (auto& field : type.fields) { h.add(field.type); h.add(field.name); }
+        } else if constexpr (std::is_same_v<T, InlineUnionType>) {
+            h.add(type.scopeName);
+            h.add(type.candidates.size());
+            for (auto& c : type.candidates) { h.add(c.domain); h.add(c.name); }
+        } else {
+            static_assert(std::is_same_v<T, InlineVariantType>);
+            h.add(type.scopeName);
+            h.add(type.candidates.size());
+            for (auto& c : type.candidates) { h.add(c.type); h.add(c.name); }
+        }
+    }
+
+    // Children compare by identity: they are canonical already.
+    template<typename List, typename Same>
+    bool sameLists(const List& lhs, const List& rhs, Same same) {
+        if (lhs.size() != rhs.size()) return false;
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            if (!same(lhs[i], rhs[i])) return false;
+        }
+        return true;
+    }
+
+    template<typename T>
+    bool sameFields(const T& lhs, const T& rhs) {
+        if constexpr (std::is_same_v<T, NamedType>) {
+            return lhs.name == rhs.name && lhs.writeable == rhs.writeable && lhs.typeArgs == rhs.typeArgs;
+        } else if constexpr (std::is_same_v<T, PtrType>) {
+            return lhs.depth == rhs.depth && lhs.inner == rhs.inner;
+        } else if constexpr (std::is_same_v<T, RangeType>) {
+            return lhs.size == rhs.size && lhs.element == rhs.element;
+        } else if constexpr (std::is_same_v<T, CmdType>) {
+            return lhs.kind == rhs.kind && sameLists(lhs.args, rhs.args, [](auto& a, auto& b) {
+                return a.type == b.type && a.writeable == b.writeable;
+            });
+        } else if constexpr (std::is_same_v<T, InlineRecordType> || std::is_same_v<T, InlineObjectType>) {
+            return lhs.scopeName == rhs.scopeName && sameLists(lhs.fields, rhs.fields, [](auto& a, auto& b) {
+                return a.type == b.type && a.name == b.name;
+            });
+        } else if constexpr (std::is_same_v<T, InlineUnionType>) {
+            return lhs.scopeName == rhs.scopeName && sameLists(lhs.candidates, rhs.candidates, [](auto& a, auto& b) {
+                return a.domain == b.domain && a.name == b.name;
+            });
+        } else {
+            return lhs.scopeName == rhs.scopeName && sameLists(lhs.candidates, rhs.candidates, [](auto& a, auto& b) {
+                return a.type == b.type && a.name == b.name;
+            });
+        }
+    }
+
+}
+
+uint64_t TypeInterner::hash(const TypeNode::Variant& type) {
+    Hasher h;
+    h.add(type.index());
+    std::visit([&](auto& alt) { fields(alt, h); }, type);
+    return h.value;
+}
+
+bool TypeInterner::equal(const TypeNode::Variant& lhs, const TypeNode::Variant& rhs) {
+    if (lhs.index() != rhs.index()) return false;
+    return std::visit([&](auto& alt) {
+        return sameFields(alt, std::get<std::decay_t<decltype(alt)>>(rhs));
+    }, lhs);
+}
+
+TypeNode* TypeInterner::find(const TypeNode::Variant& type, uint64_t hash) const {
+    auto [begin, end] = table.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+        if (equal(it->second->v, type)) {
+            ++found;
+            return it->second;
+        }
+    }
+    return nullptr;
+}
+
+void TypeInterner::insert(TypeNode* node) {
+    table.emplace(node->hash, node);
+}
+
+void TypeInterner::erase(const TypeNode* node) {
+    auto [begin, end] = table.equal_range(node->hash);
+    for (auto it = begin; it != end; ++it) {
+        if (it->second == node) {
+            table.erase(it);
+            return;
+        }
+    }
+}
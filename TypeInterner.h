@@ -0,0 +1,46 @@
+#ifndef TYPEINTERNER_H
+#define TYPEINTERNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "Ast.h"
+
+namespace basis {
+
+// Hash-consing table for type expressions. Types are interned bottom-up, so the
+// children of a type are already canonical: two types are structurally equal
+// exactly when their alternatives match field by field and their children are
+// the same nodes. A canonical TypeNode is therefore shared by every use of its
+// type, equality of interned types is pointer equality, and TypeNode::hash is
+// computed once, from the fields and the children's hashes.
+//
+// Positions are not part of a type node, its members included: whatever uses a
+// type (a field, a parameter, a receiver, a definition) carries its own, so the
+// same type written in two places is still one node.
+class TypeInterner {
+public:
+    // The canonical node equal to `type`, or null if there is none yet.
+    TypeNode* find(const TypeNode::Variant& type, uint64_t hash) const;
+    // Add `node`, whose hash is set, as the canonical node of its type.
+    void insert(TypeNode* node);
+    // Take `node` out again, so its type is new the next time it is seen.
+    void erase(const TypeNode* node);
+    // Forget every type; the nodes themselves are untouched.
+    void clear() { table.clear(); }
+
+    size_t size() const { return table.size(); }          // distinct types
+    size_t uses() const { return found + table.size(); }  // type expressions interned
+
+    static uint64_t hash(const TypeNode::Variant& type);
+    static bool equal(const TypeNode::Variant& lhs, const TypeNode::Variant& rhs);
+
+private:
+    std::unordered_multimap<uint64_t, TypeNode*> table;
+    mutable size_t found = 0;
+};
+
+} // namespace basis
+
+#endif // TYPEINTERNER_H
@@ -0,0 +1,107 @@
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+
+using namespace basis;
+
+WorkStealingPool::WorkStealingPool(unsigned workers) {
+    if (workers == 0) workers = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned w = 0; w < workers; ++w) queues.push_back(std::make_unique<Queue>());
+    for (unsigned w = 1; w < workers; ++w) threads.emplace_back([this, w] { serve(w); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) thread.join();
+}
+
+void WorkStealingPool::run(size_t count, const std::function<void(size_t, unsigned)>& fn) {
+    if (count == 0) return;
+    failures.assign(count, nullptr);
+    firstFailure = count;
+    unsigned n = workers();
+    for (unsigned w = 0; w < n; ++w) {
+        std::lock_guard<std::mutex> lock(queues[w]->mutex);
+        for (size_t i = count * w / n; i < count * (w + 1) / n; ++i) queues[w]->tasks.push_back(i);
+    }
+    task = &fn;
+
+    if (threads.empty()) {
+        work(0);
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy = static_cast<unsigned>(threads.size());
+            ++generation;
+        }
+        wake.notify_all();
+        work(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return busy == 0; });
+    }
+
+    task = nullptr;
+    size_t first = firstFailure;
+    if (first < count) {
+        std::exception_ptr failure = failures[first];
+        failures.clear();
+        std::rethrow_exception(failure);
+    }
+}
+
+void WorkStealingPool::serve(unsigned worker) {
+    size_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        work(worker);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0) idle.notify_all();
+    }
+}
+
+void WorkStealingPool::work(unsigned worker) {
+    size_t index;
+    while (take(worker, index)) {
+        if (index > firstFailure) continue;
+        try {
+            (*task)(index, worker);
+        } catch (...) {
+            failures[index] = std::current_exception();
+            size_t first = firstFailure;
+            while (index < first && !firstFailure.compare_exchange_weak(first, index)) {}
+        }
+    }
+}
+
+// Tasks never make tasks, so once every queue is empty this worker is done.
+bool WorkStealingPool::take(unsigned worker, size_t& index) {
+    {
+        Queue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            index = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    unsigned n = workers();
+    for (unsigned k = 1; k < n; ++k) {
+        Queue& victim = *queues[(worker + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            index = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,65 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace basis {
+
+// A fixed set of worker threads for running many independent tasks over indices.
+// run() deals the indices out to the workers in contiguous blocks; a worker takes
+// from the back of its own queue and, when that is empty, steals from the front
+// of another's, so uneven tasks even out. The calling thread works as worker 0.
+class WorkStealingPool {
+public:
+    // `workers` counts the calling thread; 0 means one per hardware thread.
+    explicit WorkStealingPool(unsigned workers = 0);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned workers() const { return static_cast<unsigned>(queues.size()); }
+
+    // Call task(index, worker) for each index in [0, count) and return when all
+    // calls have. If tasks throw, the exception of the lowest index is rethrown,
+    // whatever order they ran in; tasks above a failed index may be skipped.
+    // Not reentrant: a task must not call run() on the same pool.
+    void run(size_t count, const std::function<void(size_t index, unsigned worker)>& task);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    void serve(unsigned worker);
+    void work(unsigned worker);
+    bool take(unsigned worker, size_t& index);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    size_t generation = 0;
+    unsigned busy = 0;
+    bool stopping = false;
+
+    // the current run
+    const std::function<void(size_t, unsigned)>* task = nullptr;
+    std::vector<std::exception_ptr> failures;
+    std::atomic<size_t> firstFailure = 0;
+};
+
+} // namespace basis
+
+#endif // WORKSTEALINGPOOL_H
@@ -0,0 +1,287 @@
+// Parser micro-benchmarks. Usage: basis_bench [copies] [iterations]
+//
+// Parses a synthetic compilation unit built from `copies` repetitions of a mixed
+// set of definitions, and a unit of the same size from ProgramGenerator, and
+// builds the AST of the first, alone and on a WorkStealingPool, then walks it
+// with three counting passes as one virtual Traverser, as three StaticTraversers
+// and as one FusedTraverser. It also edits one definition of units of growing
+// size and compares a full parse with an incremental reparse. The grammar
+// tries alternatives in order, so most of the work is failed matches: every
+// failure runs the limit check and furthest-failure update, which is what
+// these numbers mostly reflect.
+
+#include "../AstBuilder.h"
+#include "../Grammar2.h"
+#include "../IncrementalParse.h"
+#include "../Lexer.h"
+#include "../Parsing2.h"
+#include "../ProgramGenerator.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace basis;
+
+namespace {
+
+    std::string syntheticUnit(int copies) {
+        std::ostringstream out;
+        out << ".module Bench\n.import Std::Core\n";
+        for (int i = 0; i < copies; ++i) {
+            out << ".alias A" << i << ": [4]^Int\n"
+                << ".enum E" << i << ": red = 1, green, blue\n"
+                << ".record R" << i << ": Int x, Int y, [8]String names\n"
+                << ".union U" << i << ": Int i, String s\n"
+                << ".cmd run" << i << ": Int n -> result =\n"
+                << "    result <- (n + 1 * 2 - n / 3)\n"
+                << "    print: result, n\n"
+                << "    #t <- (data^ + ptr^)\n"
+                << ".test \"run" << i << "\" = a <- ({doIt}: data)\n";
+        }
+        return out.str();
+    }
+
+    // n identifiers, laid out ten to a line
+    std::list<spToken> identifierTokens(int n) {
+        std::list<spToken> tokens;
+        for (int i = 0; i < n; ++i) {
+            auto token = std::make_shared<Token>();
+            token->type = TokenType::IDENTIFIER;
+            token->text = "x";
+            token->lineNumber = i / 10 + 1;
+            token->columnNumber = (i % 10) * 2 + 1;
+            token->index = static_cast<uint32_t>(i);
+            tokens.push_back(token);
+        }
+        return tokens;
+    }
+
+    // Every token is tried against `misses` alternatives that fail before the one
+    // that matches, so the parse is dominated by failed matches.
+    SPPF failureHeavy(int misses) {
+        std::vector<SPPF> alternatives;
+        for (int i = 0; i < misses; ++i) alternatives.push_back(discard(TokenType::NUMBER));
+        alternatives.push_back(discard(TokenType::IDENTIFIER));
+        return oneOrMore(std::make_shared<Any>(alternatives));
+    }
+
+    // Three small passes, as a virtual Traverser and as static ones.
+    struct VirtualPasses : Traverser {
+        size_t calls = 0, binaries = 0, literals = 0;
+        void visit(CallCommandExpr&) override { ++calls; }
+        void visit(BinaryExpr&) override      { ++binaries; }
+        void visit(LiteralExpr&) override     { ++literals; }
+    };
+    struct CountCalls : StaticTraverser<CountCalls> {
+        size_t n = 0;
+        void visit(CallCommandExpr&) { ++n; }
+    };
+    struct CountBinaries : StaticTraverser<CountBinaries> {
+        size_t n = 0;
+        void visit(BinaryExpr&) { ++n; }
+    };
+    struct CountLiterals : StaticTraverser<CountLiterals> {
+        size_t n = 0;
+        void visit(LiteralExpr&) { ++n; }
+    };
+
+    template <typename Fn>
+    double timeIt(int iterations, Fn&& fn) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) fn();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / iterations;
+    }
+
+    std::list<spToken> lex(const std::string& text) {
+        std::istringstream input(text);
+        Lexer lexer(input, discardDiagnostics());
+        lexer.scan();
+        return std::move(lexer.output);
+    }
+
+    // A full parse and a reparse of a unit of `copies` copies with one number in the
+    // middle copy changed; the reparse should not grow with the unit.
+    bool reparseScaling(int copies, int iterations) {
+        std::string before = syntheticUnit(copies);
+        std::string after = before;
+        size_t at = after.find("n + 1", after.find("run" + std::to_string(copies / 2) + ":"));
+        after[at + 4] = '7';
+        Grammar2& grammar = getGrammar();
+
+        auto edited = lex(after);
+        Parser full(edited, grammar.COMPILATION_UNIT);
+        bool ok = true;
+        double parse = timeIt(iterations, [&] { ok = full.parse() && ok; });
+
+        // the edit and its undo, one after the other, on one unit kept parsed
+        IncrementalUnit unit(lex(before));
+        ok = ok && unit.tree();
+        std::chrono::duration<double> spent{};
+        ReparseStats stats;
+        for (int i = 0; i < iterations && ok; ++i) {
+            auto newTokens = lex(i % 2 == 0 ? after : before);
+            TokenEdit edit = diffTokens(unit.tokens(), newTokens);
+            auto start = std::chrono::steady_clock::now();
+            ok = unit.reparse(newTokens, edit, &stats) && !stats.fullParse;
+            spent += std::chrono::steady_clock::now() - start;
+        }
+        if (!ok) return false;
+        std::cout << "reparse       : " << edited.size() << " tokens, full " << parse * 1e3 << " ms, reparse "
+                  << spent.count() / iterations * 1e3 << " ms (" << stats.reparsed << " of "
+                  << stats.reparsed + stats.reused << " definitions)" << std::endl;
+        return true;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    int copies = argc > 1 ? std::atoi(argv[1]) : 200;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    // cold start: first grammar use and first parse of a small unit, measured
+    // before anything else has warmed the allocator or caches
+    double firstGrammar = timeIt(1, [] { getGrammar(); });
+    double firstParse = timeIt(1, [] {
+        std::istringstream small(syntheticUnit(1));
+        Lexer smallLexer(small, discardDiagnostics());
+        smallLexer.scan();
+        Parser smallParser(smallLexer.output, getGrammar().COMPILATION_UNIT);
+        smallParser.parse();
+    });
+    double grammarBuild = timeIt(iterations, [] { Grammar2 fresh; });
+
+    std::istringstream input(syntheticUnit(copies));
+    Lexer lexer(input, discardDiagnostics());
+    if (!lexer.scan()) {
+        std::cerr << "lex failed" << std::endl;
+        return 1;
+    }
+    const auto& tokens = lexer.output;
+    Grammar2& grammar = getGrammar();
+
+    {
+        Parser parser(tokens, grammar.COMPILATION_UNIT);
+        if (!parser.parse() || !parser.allTokensConsumed()) {
+            std::cerr << "synthetic unit failed to parse: " << parser.getError();
+            return 1;
+        }
+    }
+
+    bool ok = true;
+    double setup = timeIt(iterations, [&] {
+        Parser parser(tokens, grammar.COMPILATION_UNIT);
+    });
+    Parser parser(tokens, grammar.COMPILATION_UNIT);
+    double recursive = timeIt(iterations, [&] {
+        ok = parser.parse() && parser.allTokensConsumed() && ok;
+    });
+    double stacked = timeIt(iterations, [&] {
+        ok = parser.parseWithStack() && parser.allTokensConsumed() && ok;
+    });
+    Parser signatureParser(tokens, grammar.COMPILATION_UNIT_SIGNATURES);
+    double signatures = timeIt(iterations, [&] {
+        ok = signatureParser.parse() && signatureParser.allTokensConsumed() && ok;
+    });
+    double ast = timeIt(iterations, [&] {
+        ok = buildAst(parser.parseTree) != nullptr && ok;
+    });
+    WorkStealingPool pool;
+    double parallelAst = timeIt(iterations, [&] {
+        ok = buildAst(parser.parseTree, pool) != nullptr && ok;
+    });
+    if (!ok) {
+        std::cerr << "synthetic unit failed to parse" << std::endl;
+        return 1;
+    }
+
+    auto report = [&](const char* name, double seconds) {
+        std::cout << name << ": " << seconds * 1e3 << " ms/parse, "
+                  << tokens.size() / seconds / 1e6 << " Mtokens/s" << std::endl;
+    };
+    std::cout << "first grammar : " << firstGrammar * 1e6 << " us" << std::endl;
+    std::cout << "first parse   : " << firstParse * 1e6 << " us" << std::endl;
+    std::cout << "grammar build : " << grammarBuild * 1e6 << " us" << std::endl;
+    std::cout << tokens.size() << " tokens, " << iterations << " iterations" << std::endl;
+    std::cout << "parser setup  : " << setup * 1e3 << " ms" << std::endl;
+    report("parse         ", recursive);
+    report("parseWithStack", stacked);
+    report("signatures    ", signatures);
+    std::cout << "ast build     : " << ast * 1e3 << " ms (including teardown)" << std::endl;
+    std::cout << "ast build -j" << pool.workers() << "  : " << parallelAst * 1e3 << " ms" << std::endl;
+
+    auto cu = buildAst(parser.parseTree);
+    size_t found = 0;
+    double virtualWalk = timeIt(iterations, [&] {
+        VirtualPasses passes;
+        passes.traverse(*cu);
+        found += passes.calls + passes.binaries + passes.literals;
+    });
+    double staticWalks = timeIt(iterations, [&] {
+        CountCalls calls;
+        CountBinaries binaries;
+        CountLiterals literals;
+        calls.traverse(*cu);
+        binaries.traverse(*cu);
+        literals.traverse(*cu);
+        found += calls.n + binaries.n + literals.n;
+    });
+    double fusedWalk = timeIt(iterations, [&] {
+        CountCalls calls;
+        CountBinaries binaries;
+        CountLiterals literals;
+        FusedTraverser(calls, binaries, literals).traverse(*cu);
+        found += calls.n + binaries.n + literals.n;
+    });
+    std::cout << "3 passes      : " << virtualWalk * 1e3 << " ms virtual, " << staticWalks * 1e3
+              << " ms static in 3 walks, " << fusedWalk * 1e3 << " ms fused (" << found / 3 / iterations
+              << " hooks)" << std::endl;
+
+    std::istringstream generatedInput([&] {
+        std::ostringstream out;
+        ProgramGenerator generator(grammar);
+        generator.generate(out, syntheticUnit(copies).size());
+        return out.str();
+    }());
+    Lexer generatedLexer(generatedInput, discardDiagnostics());
+    if (!generatedLexer.scan()) {
+        std::cerr << "generated unit failed to lex" << std::endl;
+        return 1;
+    }
+    Parser generatedParser(generatedLexer.output, grammar.COMPILATION_UNIT);
+    double generated = timeIt(iterations, [&] {
+        ok = generatedParser.parse() && generatedParser.allTokensConsumed() && ok;
+    });
+    if (!ok) {
+        std::cerr << "generated unit failed to parse" << std::endl;
+        return 1;
+    }
+    std::cout << "generated     : " << generated * 1e3 << " ms/parse, "
+              << generatedLexer.output.size() / generated / 1e6 << " Mtokens/s ("
+              << generatedLexer.output.size() << " tokens)" << std::endl;
+
+    for (int scale : {1, 4, 16}) {
+        if (!reparseScaling(copies * scale, iterations)) {
+            std::cerr << "reparse benchmark failed" << std::endl;
+            return 1;
+        }
+    }
+
+    const int misses = 15;
+    auto idents = identifierTokens(static_cast<int>(tokens.size()));
+    SPPF heavy = failureHeavy(misses);
+    Parser failingParser(idents, heavy);
+    double failing = timeIt(iterations, [&] {
+        ok = failingParser.parse() && failingParser.allTokensConsumed() && ok;
+    });
+    if (!ok) {
+        std::cerr << "failure benchmark did not parse" << std::endl;
+        return 1;
+    }
+    std::cout << "failed match  : " << failing / (idents.size() * misses) * 1e9 << " ns/failure" << std::endl;
+    return 0;
+}
@@ -0,0 +1,45 @@
+// Random program generator. Usage: basis_generate [size] [seed] [depth]
+//
+// Writes a compilation unit of at least `size` bytes (a number with an optional
+// K, M or G suffix; default 1K) to standard output, generated from Grammar2 by
+// ProgramGenerator. The same seed gives the same program. `depth` is how many
+// forward() references deep definitions may nest (default 6).
+
+#include "../Grammar2.h"
+#include "../ProgramGenerator.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace basis;
+
+namespace {
+
+    size_t parseSize(const std::string& text) {
+        char* end = nullptr;
+        size_t size = std::strtoull(text.c_str(), &end, 10);
+        switch (*end) {
+            case 'k': case 'K': return size << 10;
+            case 'm': case 'M': return size << 20;
+            case 'g': case 'G': return size << 30;
+            default:            return size;
+        }
+    }
+
+}
+
+int main(int argc, char** argv) {
+    size_t size = argc > 1 ? parseSize(argv[1]) : 1 << 10;
+    GeneratorOptions options;
+    if (argc > 2) options.seed = std::strtoull(argv[2], nullptr, 10);
+    if (argc > 3) options.maxDepth = static_cast<unsigned>(std::atoi(argv[3]));
+
+    std::ios::sync_with_stdio(false);
+    ProgramGenerator generator(getGrammar(), options);
+    size_t written = generator.generate(std::cout, size);
+    std::cout.flush();
+    std::cerr << written << " bytes, " << generator.definitionsGenerated() << " definitions, "
+              << generator.definitionsRejected() << " rejected" << std::endl;
+    return written >= size ? 0 : 1;
+}
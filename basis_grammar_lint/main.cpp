@@ -0,0 +1,74 @@
+// Grammar lint. Usage: basis_grammar_lint [--notes] [--max-factor N]
+//
+// Checks Grammar2 for combinators that loop without consuming, left recursion and
+// any() alternatives that can never be tried, and lists the rules with the highest
+// re-scan factors. Exits non-zero on an error, or when a rule's factor exceeds N,
+// so grammar changes can be gated on parse complexity.
+
+#include "../Grammar2.h"
+#include "../GrammarLint.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace basis;
+
+namespace {
+
+    const char* severityName(LintFinding::Severity severity) {
+        switch (severity) {
+            case LintFinding::Severity::Error:   return "error";
+            case LintFinding::Severity::Warning: return "warning";
+            case LintFinding::Severity::Note:    return "note";
+        }
+        return "?";
+    }
+
+}
+
+int main(int argc, char** argv) {
+    bool notes = false;
+    uint64_t maxFactor = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--notes")) {
+            notes = true;
+        }
+        else if (!std::strcmp(argv[i], "--max-factor") && i + 1 < argc) {
+            maxFactor = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else {
+            std::cerr << "usage: basis_grammar_lint [--notes] [--max-factor N]" << std::endl;
+            return 2;
+        }
+    }
+
+    GrammarLintReport report = GrammarLint::lint(getGrammar());
+    for (auto& finding : report.findings) {
+        if (finding.severity == LintFinding::Severity::Note && !notes) continue;
+        std::cout << finding.rule << ": " << severityName(finding.severity) << ": " << finding.message << std::endl;
+    }
+
+    auto costs = report.costs;
+    std::stable_sort(costs.begin(), costs.end(),
+                     [](const RuleCost& a, const RuleCost& b) { return a.factor > b.factor; });
+    std::cout << "highest re-scan factors:" << std::endl;
+    for (size_t i = 0; i < costs.size() && i < 10; ++i) {
+        std::cout << "  " << costs[i].rule << ": " << costs[i].factor << std::endl;
+    }
+
+    size_t errors = report.count(LintFinding::Severity::Error);
+    size_t over = 0;
+    if (maxFactor) {
+        for (auto& cost : costs) {
+            if (cost.factor <= maxFactor) continue;
+            std::cout << cost.rule << ": error: re-scan factor " << cost.factor
+                      << " exceeds " << maxFactor << std::endl;
+            ++over;
+        }
+    }
+    std::cout << errors << " errors, " << report.count(LintFinding::Severity::Warning) << " warnings, "
+              << report.count(LintFinding::Severity::Note) << " notes" << std::endl;
+    return errors || over ? 1 : 0;
+}
@@ -1,12 +1,21 @@
 #include "../compiler.h"
+#include "../CompileServer.h"
 
 #include <string>
 #include <vector>
 
 int main(int argc, char** argv) {
     std::vector<std::string> arguments;
-    for ( int i = 0; i < argc; i++ ) {
+    for ( int i = 1; i < argc; i++ ) {
         arguments.emplace_back(argv[i]);
     }
+    if ( arguments.size() == 2 && arguments[0] == "--server" ) {
+        return runCompileServer(arguments[1]);
+    }
+    if ( arguments.size() >= 2 && arguments[0] == "--connect" ) {
+        std::string socket = arguments[1];
+        arguments.erase(arguments.begin(), arguments.begin() + 2);
+        return forwardCompile(socket, arguments, std::cout, std::cerr);
+    }
     return compile(arguments);
 }
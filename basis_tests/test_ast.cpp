@@ -672,6 +672,69 @@ TEST_CASE("Ast::Expr - BinaryExpr") {
         ")"));
 }
 
+TEST_CASE("Ast::Expr - BinaryExpr precedence") {
+    // tighter operators nest below looser ones, on either side
+    CHECK(testAst(".test \"x\" = a + b * c",
+        "CompilationUnit(TestDecl('x',CallGroup(ExprStat("
+            "BinaryExpr("
+                "CallCommandExpr(IdentifierExpr('a')),"
+                "'+',"
+                "BinaryExpr(CallCommandExpr(IdentifierExpr('b')),'*',CallCommandExpr(IdentifierExpr('c')))"
+            ")"
+        "))))"));
+    CHECK(testAst(".test \"x\" = a * b + c % d",
+        "CompilationUnit(TestDecl('x',CallGroup(ExprStat("
+            "BinaryExpr("
+                "BinaryExpr(CallCommandExpr(IdentifierExpr('a')),'*',CallCommandExpr(IdentifierExpr('b'))),"
+                "'+',"
+                "BinaryExpr(CallCommandExpr(IdentifierExpr('c')),'%',CallCommandExpr(IdentifierExpr('d')))"
+            ")"
+        "))))"));
+    // choice is loosest, shifts sit between comparison and arithmetic
+    CHECK(testAst(".test \"x\" = a << b + c | d",
+        "CompilationUnit(TestDecl('x',CallGroup(ExprStat("
+            "BinaryExpr("
+                "BinaryExpr("
+                    "CallCommandExpr(IdentifierExpr('a')),"
+                    "'<<',"
+                    "BinaryExpr(CallCommandExpr(IdentifierExpr('b')),'+',CallCommandExpr(IdentifierExpr('c')))"
+                "),"
+                "'|',"
+                "CallCommandExpr(IdentifierExpr('d'))"
+            ")"
+        "))))"));
+    // comparatives chain at one level
+    CHECK(testAst(".test \"x\" = lo <= x + 1 < hi",
+        "CompilationUnit(TestDecl('x',CallGroup(ExprStat("
+            "BinaryExpr("
+                "CallCommandExpr(IdentifierExpr('lo')),"
+                "'<=',"
+                "BinaryExpr(CallCommandExpr(IdentifierExpr('x')),'+',LiteralExpr('1')),"
+                "'<',"
+                "CallCommandExpr(IdentifierExpr('hi'))"
+            ")"
+        "))))"));
+}
+
+TEST_CASE("Ast::Expr - BinaryExpr equality operators") {
+    CHECK(testAst(".test \"x\" = a == b",
+        "CompilationUnit(TestDecl('x',CallGroup(ExprStat("
+            "BinaryExpr(CallCommandExpr(IdentifierExpr('a')),'==',CallCommandExpr(IdentifierExpr('b')))"
+        "))))"));
+    CHECK(testAst(".test \"x\" = a != b",
+        "CompilationUnit(TestDecl('x',CallGroup(ExprStat("
+            "BinaryExpr(CallCommandExpr(IdentifierExpr('a')),'!=',CallCommandExpr(IdentifierExpr('b')))"
+        "))))"));
+    CHECK(testAst(".test \"x\" = a <> b = c",
+        "CompilationUnit(TestDecl('x',CallGroup(ExprStat("
+            "BinaryExpr("
+                "CallCommandExpr(IdentifierExpr('a')),'<>',"
+                "CallCommandExpr(IdentifierExpr('b')),'=',"
+                "CallCommandExpr(IdentifierExpr('c'))"
+            ")"
+        "))))"));
+}
+
 TEST_CASE("Ast::Expr - SuffixExpr") {
     CHECK(testAst(".test \"x\" = ptr^",
         "CompilationUnit("
@@ -9176,11 +9239,13 @@ TEST_CASE("Ast::CALL_EXPRESSION in CALL_GROUP - chained operations") {
                             "'+',"
                             "CallCommandExpr(IdentifierExpr('b')),"
                             "'-',"
-                            "CallCommandExpr(IdentifierExpr('c')),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('d')),"
-                            "'/',"
-                            "CallCommandExpr(IdentifierExpr('e'))"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('c')),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('d')),"
+                                "'/',"
+                                "CallCommandExpr(IdentifierExpr('e'))"
+                            ")"
                         ")"
                     ")"
                 ")"
@@ -9214,9 +9279,11 @@ TEST_CASE("Ast::CALL_EXPRESSION in CALL_GROUP - chained operations") {
                         "BinaryExpr("
                             "CallCommandExpr(IdentifierExpr('value')),"
                             "'<<',"
-                            "LiteralExpr('1'),"
-                            "'+',"
-                            "CallCommandExpr(IdentifierExpr('offset'))"
+                            "BinaryExpr("
+                                "LiteralExpr('1'),"
+                                "'+',"
+                                "CallCommandExpr(IdentifierExpr('offset'))"
+                            ")"
                         ")"
                     ")"
                 ")"
@@ -9232,9 +9299,11 @@ TEST_CASE("Ast::CALL_EXPRESSION in CALL_GROUP - chained operations") {
                         "BinaryExpr("
                             "CallCommandExpr(IdentifierExpr('mask')),"
                             "'>>',"
-                            "LiteralExpr('4'),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('scale'))"
+                            "BinaryExpr("
+                                "LiteralExpr('4'),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('scale'))"
+                            ")"
                         ")"
                     ")"
                 ")"
@@ -9401,9 +9470,11 @@ TEST_CASE("Ast::CALL_EXPRESSION in CALL_GROUP - with parentheses") {
                         "BinaryExpr("
                             "CallCommandExpr(IdentifierExpr('x')),"
                             "'+',"
-                            "CallCommandExpr(IdentifierExpr('y')),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('z'))"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('y')),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('z'))"
+                            ")"
                         ")"
                     ")"
                 ")"
@@ -9648,9 +9719,11 @@ TEST_CASE("Ast::CALL_EXPRESSION in CALL_GROUP - comparison operators") {
                 "CallGroup("
                     "ExprStat("
                         "BinaryExpr("
-                            "CallCommandExpr(IdentifierExpr('x')),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('y')),"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('x')),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('y'))"
+                            "),"
                             "'>=',"
                             "CallCommandExpr(IdentifierExpr('z'))"
                         ")"
@@ -9832,14 +9905,16 @@ TEST_CASE("Ast::CALL_EXPRESSION in CALL_GROUP - with invocations") {
                                 "CallParam(CallCommandExpr(IdentifierExpr('y')))"
                             "),"
                             "'+',"
-                            "CallCommandExpr("
-                                "IdentifierExpr('process'),"
-                                "CallParam(CallCommandExpr(IdentifierExpr('a')))"
-                            "),"
-                            "'*',"
-                            "CallCommandExpr("
-                                "IdentifierExpr('calculate'),"
-                                "CallParam(CallCommandExpr(IdentifierExpr('b')))"
+                            "BinaryExpr("
+                                "CallCommandExpr("
+                                    "IdentifierExpr('process'),"
+                                    "CallParam(CallCommandExpr(IdentifierExpr('a')))"
+                                "),"
+                                "'*',"
+                                "CallCommandExpr("
+                                    "IdentifierExpr('calculate'),"
+                                    "CallParam(CallCommandExpr(IdentifierExpr('b')))"
+                                ")"
                             ")"
                         ")"
                     ")"
@@ -13931,9 +14006,11 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                         "BinaryExpr("
                             "CallCommandExpr(IdentifierExpr('a')),"
                             "'+',"
-                            "CallCommandExpr(IdentifierExpr('b')),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('c'))"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('b')),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('c'))"
+                            ")"
                         ")"
                     ")"
                 ")"
@@ -13950,9 +14027,11 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                         "BinaryExpr("
                             "CallCommandExpr(IdentifierExpr('x')),"
                             "'-',"
-                            "CallCommandExpr(IdentifierExpr('y')),"
-                            "'/',"
-                            "CallCommandExpr(IdentifierExpr('z'))"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('y')),"
+                                "'/',"
+                                "CallCommandExpr(IdentifierExpr('z'))"
+                            ")"
                         ")"
                     ")"
                 ")"
@@ -13967,13 +14046,17 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                     "AssignStat("
                         "IdentifierExpr('a'),"
                         "BinaryExpr("
-                            "CallCommandExpr(IdentifierExpr('a')),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('b')),"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('a')),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('b'))"
+                            "),"
                             "'+',"
-                            "CallCommandExpr(IdentifierExpr('c')),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('d'))"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('c')),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('d'))"
+                            ")"
                         ")"
                     ")"
                 ")"
@@ -13988,13 +14071,17 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                     "AssignStat("
                         "IdentifierExpr('a'),"
                         "BinaryExpr("
-                            "CallCommandExpr(IdentifierExpr('p')),"
-                            "'/',"
-                            "CallCommandExpr(IdentifierExpr('q')),"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('p')),"
+                                "'/',"
+                                "CallCommandExpr(IdentifierExpr('q'))"
+                            "),"
                             "'-',"
-                            "CallCommandExpr(IdentifierExpr('r')),"
-                            "'/',"
-                            "CallCommandExpr(IdentifierExpr('s'))"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('r')),"
+                                "'/',"
+                                "CallCommandExpr(IdentifierExpr('s'))"
+                            ")"
                         ")"
                     ")"
                 ")"
@@ -14013,11 +14100,13 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                             "'+',"
                             "CallCommandExpr(IdentifierExpr('b')),"
                             "'-',"
-                            "CallCommandExpr(IdentifierExpr('c')),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('d')),"
-                            "'/',"
-                            "CallCommandExpr(IdentifierExpr('e'))"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('c')),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('d')),"
+                                "'/',"
+                                "CallCommandExpr(IdentifierExpr('e'))"
+                            ")"
                         ")"
                     ")"
                 ")"
@@ -14106,9 +14195,11 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                         "BinaryExpr("
                             "CallCommandExpr(IdentifierExpr('x')),"
                             "'+',"
-                            "CallCommandExpr(IdentifierExpr('y')),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('z'))"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('y')),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('z'))"
+                            ")"
                         ")"
                     ")"
                 ")"
@@ -14244,9 +14335,7 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                         "BinaryExpr("
                             "CallCommandExpr(IdentifierExpr('a')),"
                             "'<<',"
-                            "LiteralExpr('1'),"
-                            "'+',"
-                            "CallCommandExpr(IdentifierExpr('b'))"
+                            "BinaryExpr(LiteralExpr('1'),'+',CallCommandExpr(IdentifierExpr('b')))"
                         ")"
                     ")"
                 ")"
@@ -14263,9 +14352,7 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                         "BinaryExpr("
                             "CallCommandExpr(IdentifierExpr('x')),"
                             "'>>',"
-                            "LiteralExpr('2'),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('y'))"
+                            "BinaryExpr(LiteralExpr('2'),'*',CallCommandExpr(IdentifierExpr('y')))"
                         ")"
                     ")"
                 ")"
@@ -14672,11 +14759,13 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                     "AssignStat("
                         "IdentifierExpr('result'),"
                         "BinaryExpr("
-                            "CallCommandExpr(IdentifierExpr('a')),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('b')),"
-                            "'/',"
-                            "CallCommandExpr(IdentifierExpr('c')),"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('a')),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('b')),"
+                                "'/',"
+                                "CallCommandExpr(IdentifierExpr('c'))"
+                            "),"
                             "'+',"
                             "CallCommandExpr(IdentifierExpr('d'))"
                         ")"
@@ -14695,13 +14784,17 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                         "BinaryExpr("
                             "CallCommandExpr(IdentifierExpr('p')),"
                             "'+',"
-                            "CallCommandExpr(IdentifierExpr('q')),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('r')),"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('q')),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('r'))"
+                            "),"
                             "'-',"
-                            "CallCommandExpr(IdentifierExpr('s')),"
-                            "'/',"
-                            "CallCommandExpr(IdentifierExpr('t'))"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('s')),"
+                                "'/',"
+                                "CallCommandExpr(IdentifierExpr('t'))"
+                            ")"
                         ")"
                     ")"
                 ")"
@@ -14884,11 +14977,13 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                     "AssignStat("
                         "IdentifierExpr('value'),"
                         "BinaryExpr("
-                            "CallCommandExpr(IdentifierExpr('x')),"
-                            "'*',"
-                            "CallCommandExpr("
-                                "IdentifierExpr('process'),"
-                                "CallParam(CallCommandExpr(IdentifierExpr('item')))"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('x')),"
+                                "'*',"
+                                "CallCommandExpr("
+                                    "IdentifierExpr('process'),"
+                                    "CallParam(CallCommandExpr(IdentifierExpr('item')))"
+                                ")"
                             "),"
                             "'+',"
                             "CallCommandExpr(IdentifierExpr('y'))"
@@ -14908,12 +15003,14 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                         "BinaryExpr("
                             "CallCommandExpr(IdentifierExpr('doIt')),"
                             "'+',"
-                            "CallCommandExpr("
-                                "IdentifierExpr('calculate'),"
-                                "CallParam(CallCommandExpr(IdentifierExpr('x')))"
-                            "),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('z'))"
+                            "BinaryExpr("
+                                "CallCommandExpr("
+                                    "IdentifierExpr('calculate'),"
+                                    "CallParam(CallCommandExpr(IdentifierExpr('x')))"
+                                "),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('z'))"
+                            ")"
                         ")"
                     ")"
                 ")"
@@ -15021,9 +15118,11 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                     "AssignStat("
                         "IdentifierExpr('result',alloc),"
                         "BinaryExpr("
-                            "CallCommandExpr(IdentifierExpr('x')),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('y')),"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('x')),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('y'))"
+                            "),"
                             "'+',"
                             "CallCommandExpr(IdentifierExpr('z'))"
                         ")"
@@ -15092,14 +15191,16 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                                 "CallParam(CallCommandExpr(IdentifierExpr('y')))"
                             "),"
                             "'+',"
-                            "CallCommandExpr("
-                                "IdentifierExpr('process'),"
-                                "CallParam(CallCommandExpr(IdentifierExpr('a')))"
-                            "),"
-                            "'*',"
-                            "CallCommandExpr("
-                                "IdentifierExpr('calculate'),"
-                                "CallParam(CallCommandExpr(IdentifierExpr('b')))"
+                            "BinaryExpr("
+                                "CallCommandExpr("
+                                    "IdentifierExpr('process'),"
+                                    "CallParam(CallCommandExpr(IdentifierExpr('a')))"
+                                "),"
+                                "'*',"
+                                "CallCommandExpr("
+                                    "IdentifierExpr('calculate'),"
+                                    "CallParam(CallCommandExpr(IdentifierExpr('b')))"
+                                ")"
                             ")"
                         ")"
                     ")"
@@ -15397,9 +15498,11 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                     "AssignStat("
                         "IdentifierExpr('check'),"
                         "BinaryExpr("
-                            "CallCommandExpr(IdentifierExpr('x')),"
-                            "'*',"
-                            "CallCommandExpr(IdentifierExpr('y')),"
+                            "BinaryExpr("
+                                "CallCommandExpr(IdentifierExpr('x')),"
+                                "'*',"
+                                "CallCommandExpr(IdentifierExpr('y'))"
+                            "),"
                             "'>=',"
                             "CallCommandExpr(IdentifierExpr('z'))"
                         ")"
@@ -15470,9 +15573,11 @@ TEST_CASE("Ast::CALL_OPERATOR") {
                         "AssignStat("
                             "IdentifierExpr('value'),"
                             "BinaryExpr("
-                                "CallCommandExpr(IdentifierExpr('x')),"
-                                "'*',"
-                                "CallCommandExpr(IdentifierExpr('y')),"
+                                "BinaryExpr("
+                                    "CallCommandExpr(IdentifierExpr('x')),"
+                                    "'*',"
+                                    "CallCommandExpr(IdentifierExpr('y'))"
+                                "),"
                                 "'+',"
                                 "CallCommandExpr(IdentifierExpr('z'))"
                             ")"
@@ -0,0 +1,79 @@
+#include "doctest.h"
+
+#include "../AstArena.h"
+#include "test_ast_helpers.h"
+
+#include <cstdint>
+#include <string>
+
+using namespace basis;
+
+namespace {
+
+    struct Counted {
+        explicit Counted(int& count) : count(count) { ++count; }
+        ~Counted() { --count; }
+        int& count;
+    };
+
+}
+
+TEST_CASE("AstArena::allocations are aligned and grow past a block") {
+    AstArena arena;
+    for (size_t alignment : {1, 2, 8, 16, 64}) {
+        arena.allocate(1, 1);
+        auto address = reinterpret_cast<uintptr_t>(arena.allocate(3, alignment));
+        CHECK_EQ(address % alignment, 0);
+    }
+    auto* big = static_cast<char*>(arena.allocate(100000, 8));
+    big[99999] = 1;
+    CHECK(arena.bytesReserved() >= arena.bytesAllocated());
+    CHECK(arena.bytesAllocated() >= 100000);
+}
+
+TEST_CASE("AstArena::destructors run when the arena goes") {
+    int live = 0;
+    {
+        AstArena arena;
+        for (int i = 0; i < 1000; ++i) arena.make<Counted>(live);
+        auto* text = arena.make<std::string>(200, 'x');
+        CHECK_EQ(text->size(), 200);
+        CHECK_EQ(live, 1000);
+    }
+    CHECK_EQ(live, 0);
+}
+
+TEST_CASE("AstArena::lists draw from the arena in scope, and the heap outside it") {
+    AstArena arena;
+    AstList<int> heap;
+    heap.assign(64, 1);
+    CHECK_EQ(arena.bytesAllocated(), 0);
+    {
+        AstArena::Scope scope(arena);
+        CHECK_EQ(AstArena::current(), &arena);
+        AstList<int> list;
+        list.assign(64, 1);
+        CHECK(arena.bytesAllocated() >= 64 * sizeof(int));
+    }
+    CHECK_EQ(AstArena::current(), nullptr);
+}
+
+TEST_CASE("AstArena::buildAst keeps the unit in its context") {
+    // the parse tree is gone by the time buildUnit returns
+    auto cu = buildUnit(
+        ".module App\n"
+        ".import Std::Core\n"
+        ".record Point: Int x, Int y\n"
+        ".cmd run: Int n -> result =\n"
+        "    result <- (n + 1)\n");
+    REQUIRE(cu);
+    REQUIRE(cu->context);
+    CHECK(cu->context->arena.bytesAllocated() > 0);
+    CHECK_EQ(cu->module->name, "App");
+    REQUIRE_EQ(cu->definitions.size(), 2);
+    auto& record = std::get<RecordDecl>(cu->definitions[0]);
+    CHECK_EQ(std::get<NamedType>(record.fields[1].type->v).name, "Int");
+    auto& run = std::get<CmdDef>(cu->definitions[1]);
+    REQUIRE(run.body);
+    CHECK_EQ(run.body->group->statements.size(), 1);
+}
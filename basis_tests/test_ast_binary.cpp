@@ -0,0 +1,122 @@
+#include "doctest.h"
+
+#include "../AstBinary.h"
+#include "../ProgramGenerator.h"
+#include "AstSerialize.h"
+#include "test_ast_helpers.h"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+using namespace basis;
+
+namespace {
+
+    std::shared_ptr<CompilationUnit> roundTrip(const CompilationUnit& cu) {
+        auto image = writeAstBinary(cu);
+        return readAstBinary(image.data(), image.size());
+    }
+
+    const char* sample =
+        ".module Shapes\n"
+        ".import Std::Core\n"
+        ".enum Color: red, green = 4, blue\n"
+        ".alias Grid: [4]^Int\n"
+        ".object Point: Int x, Int y, Grid cells\n"
+        ".cmd move: Int dx, ^Int dy -> result =\n"
+        " .sub inner: Int z = work: z\n"
+        " result <- (dx + 1)\n"
+        ".test \"moves\" = move: 1, 2\n";
+
+}
+
+TEST_CASE("AstBinary::a unit reads back the same") {
+    auto cu = buildUnit(sample);
+    REQUIRE(cu);
+    auto loaded = roundTrip(*cu);
+    REQUIRE(loaded);
+    CHECK_EQ(serializeAst(*loaded), serializeAst(*cu));
+
+    auto& point = std::get<ObjectDecl>(loaded->definitions[2]);
+    auto& original = std::get<ObjectDecl>(cu->definitions[2]);
+    CHECK_EQ(point.line, original.line);
+    CHECK_EQ(point.fields[1].col, original.fields[1].col);
+}
+
+TEST_CASE("AstBinary::NodeIds and shared types survive loading") {
+    auto cu = buildUnit(sample);
+    REQUIRE(cu);
+    auto loaded = roundTrip(*cu);
+    REQUIRE(loaded);
+    REQUIRE_NE(loaded->context, cu->context);
+    CHECK_EQ(loaded->context->typeNodes.size(), cu->context->typeNodes.size());
+    CHECK_EQ(loaded->context->exprNodes.size(), cu->context->exprNodes.size());
+    for (size_t i = 0; i < loaded->context->typeNodes.size(); ++i) {
+        CHECK_EQ(loaded->context->typeNodes[i]->id, i);
+        CHECK_EQ(loaded->context->typeNodes[i]->hash, cu->context->typeNodes[i]->hash);
+    }
+
+    auto& fields = std::get<ObjectDecl>(loaded->definitions[2]).fields;
+    auto& params = std::get<RegularSig>(std::get<CmdDef>(loaded->definitions[3]).signature).params;
+    CHECK_EQ(fields[0].type, params[0].type);
+    CHECK_EQ(fields[0].type->id, std::get<ObjectDecl>(cu->definitions[2]).fields[0].type->id);
+
+    // the image of the loaded unit is the image it was loaded from
+    CHECK(writeAstBinary(*loaded) == writeAstBinary(*cu));
+}
+
+TEST_CASE("AstBinary::generated units read back the same") {
+    for (uint64_t seed = 1; seed <= 6; ++seed) {
+        INFO("seed " << seed);
+        GeneratorOptions options;
+        options.seed = seed;
+        ProgramGenerator generator(getGrammar(), options);
+        std::ostringstream out;
+        generator.generate(out, 6000);
+        auto cu = buildUnit(out.str());
+        REQUIRE(cu);
+        auto loaded = roundTrip(*cu);
+        REQUIRE(loaded);
+        CHECK_EQ(serializeAst(*loaded), serializeAst(*cu));
+    }
+}
+
+TEST_CASE("AstBinary::damaged images are refused") {
+    auto cu = buildUnit(sample);
+    REQUIRE(cu);
+    auto image = writeAstBinary(*cu);
+
+    CHECK_FALSE(readAstBinary(image.data(), 8));
+    for (size_t cut : {image.size() / 4, image.size() / 2, image.size() - 4}) {
+        CHECK_FALSE(readAstBinary(image.data(), cut));
+    }
+
+    auto version = image;
+    version[4] = static_cast<unsigned char>(astBinaryVersion + 1);
+    CHECK_FALSE(readAstBinary(version.data(), version.size()));
+
+    auto magic = image;
+    magic[0] = 'X';
+    CHECK_FALSE(readAstBinary(magic.data(), magic.size()));
+
+    // flipping any one byte either is refused or still reads as some unit; it
+    // never reads out of bounds
+    for (size_t i = 16; i < image.size(); i += 3) {
+        auto damaged = image;
+        damaged[i] ^= 0xff;
+        readAstBinary(damaged.data(), damaged.size());
+    }
+}
+
+TEST_CASE("AstBinary::save and load through a file") {
+    auto cu = buildUnit(sample);
+    REQUIRE(cu);
+    std::string path = "test_ast_binary.bast";
+    REQUIRE(saveAstBinary(*cu, path));
+    auto loaded = loadAstBinary(path);
+    std::remove(path.c_str());
+    REQUIRE(loaded);
+    CHECK_EQ(serializeAst(*loaded), serializeAst(*cu));
+    CHECK_FALSE(loadAstBinary("no_such_file.bast"));
+}
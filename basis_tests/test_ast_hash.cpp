@@ -0,0 +1,97 @@
+#include "doctest.h"
+
+#include "../AstBinary.h"
+#include "../AstHash.h"
+#include "test_ast_helpers.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace basis;
+
+namespace {
+
+    const std::string point = ".record Point: Int x, Int y\n";
+    const std::string run =
+        ".cmd run: Int n -> result =\n"
+        " .sub twice: Int k = work: k, k\n"
+        " result <- (n + 1)\n";
+    const std::string runFloat = ".cmd run: Float f = work: f\n";
+    const std::string test = ".test \"runs\" = run: 1\n";
+
+}
+
+TEST_CASE("hashDefinitions::positions do not count") {
+    auto a = buildUnit(point + run + test);
+    auto b = buildUnit(".alias Pad: Int\n\n\n" + point + "\n" + run + test);
+    REQUIRE(a);
+    REQUIRE(b);
+    hashDefinitions(*a);
+    hashDefinitions(*b);
+    REQUIRE_EQ(a->definitionHashes.size(), 3);
+    REQUIRE_EQ(b->definitionHashes.size(), 4);
+    CHECK_EQ(a->definitionHashes[0], b->definitionHashes[1]);
+    CHECK_EQ(a->definitionHashes[1], b->definitionHashes[2]);
+    CHECK_EQ(a->definitionHashes[2], b->definitionHashes[3]);
+    CHECK_NE(a->definitionHashes[0], a->definitionHashes[1]);
+
+    // bodies are hashed on the way, subs included
+    auto& body = *std::get<CmdDef>(a->definitions[1]).body;
+    CHECK_NE(body.hash, 0);
+    CHECK_NE(body.subs[0].body->hash, 0);
+    CHECK_NE(body.subs[0].body->hash, body.hash);
+    CHECK_EQ(body.hash, std::get<CmdDef>(b->definitions[2]).body->hash);
+
+    // and a loaded image hashes the same
+    auto image = writeAstBinary(*a);
+    auto loaded = readAstBinary(image.data(), image.size());
+    REQUIRE(loaded);
+    hashDefinitions(*loaded);
+    CHECK(std::vector<uint64_t>(loaded->definitionHashes.begin(), loaded->definitionHashes.end()) ==
+          std::vector<uint64_t>(a->definitionHashes.begin(), a->definitionHashes.end()));
+}
+
+TEST_CASE("diffDefinitions::added, removed and changed") {
+    auto before = buildUnit(point + run + test);
+    REQUIRE(before);
+
+    SUBCASE("reordered") {
+        auto after = buildUnit(test + run + point);
+        auto diff = diffDefinitions(*before, *after);
+        CHECK(diff.added.empty());
+        CHECK(diff.removed.empty());
+        CHECK(diff.changed.empty());
+        CHECK_EQ(diff.unchanged, 3);
+    }
+    SUBCASE("a body changed") {
+        auto after = buildUnit(point + ".cmd run: Int n -> result =\n .sub twice: Int k = work: k\n"
+                                   " result <- n\n" + test);
+        auto diff = diffDefinitions(*before, *after);
+        CHECK(diff.added.empty());
+        CHECK(diff.removed.empty());
+        CHECK_EQ(diff.changed, std::vector<std::pair<size_t, size_t>>{{1, 1}});
+        CHECK_EQ(diff.unchanged, 2);
+    }
+    SUBCASE("a field changed") {
+        auto after = buildUnit(".record Point: Int x, Float y\n" + run + test);
+        auto diff = diffDefinitions(*before, *after);
+        CHECK_EQ(diff.changed, std::vector<std::pair<size_t, size_t>>{{0, 0}});
+    }
+    SUBCASE("an overload added, a definition removed") {
+        auto after = buildUnit(point + run + runFloat);
+        auto diff = diffDefinitions(*before, *after);
+        CHECK_EQ(diff.added, std::vector<size_t>{2});
+        CHECK_EQ(diff.removed, std::vector<size_t>{2});
+        CHECK(diff.changed.empty());
+        CHECK_EQ(diff.unchanged, 2);
+    }
+    SUBCASE("a signature changed") {
+        auto after = buildUnit(point + ".cmd run: Int n, Int m -> result =\n .sub twice: Int k = work: k, k\n"
+                                   " result <- (n + 1)\n" + test);
+        auto diff = diffDefinitions(*before, *after);
+        CHECK_EQ(diff.added, std::vector<size_t>{1});
+        CHECK_EQ(diff.removed, std::vector<size_t>{1});
+        CHECK(diff.changed.empty());
+    }
+}
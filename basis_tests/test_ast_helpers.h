@@ -7,6 +7,7 @@
 #include "../Parsing2.h"
 #include "AstSerialize.h"
 
+#include <memory>
 #include <sstream>
 #include <string>
 #include <string_view>
@@ -26,9 +27,22 @@ namespace basis {
         return out;
     }
 
+    // Lex, parse and build `text`, which must parse whole as a COMPILATION_UNIT.
+    inline std::shared_ptr<CompilationUnit> buildUnit(const std::string& text) {
+        std::istringstream input(text);
+        Lexer lexer(input, discardDiagnostics());
+        REQUIRE(lexer.scan());
+        Parser parser(lexer.output, getGrammar().COMPILATION_UNIT);
+        REQUIRE(parser.parse());
+        REQUIRE(parser.allTokensConsumed());
+        return buildAst(parser.parseTree);
+    }
+
     // Parse `input` as a COMPILATION_UNIT, build the AST, serialize it, and
     // compare the (whitespace-stripped) result to `expected`. Returns true iff
     // every step succeeds and the serialized AST matches the expected form.
+    // The AST produced by parseAst from the same tokens must serialize identically,
+    // and Parser::parseWithStack must produce the same parse tree.
     //
     // The expected form should be written using the canonical AST text format
     // described in AstSerialize.h. C++ adjacent-string-literal concatenation
@@ -74,6 +88,27 @@ namespace basis {
                 << "\n  expected: " << stripWs(expected)
                 << "\n  actual:   " << got);
         }
+
+        // the explicit-stack engine must produce the same tree
+        Parser stacked(lexer.output, getGrammar().COMPILATION_UNIT);
+        if (!stacked.parseWithStack() || !stacked.parseTree || !(*stacked.parseTree == *parser.parseTree)) {
+            MESSAGE("parseWithStack tree differs for input: " << input);
+            ok = false;
+        }
+
+        // building from the grammar's actions during the parse must agree with buildAst
+        auto fused = parseAst(lexer.output, discardDiagnostics());
+        if (!fused) {
+            MESSAGE("parseAst returned null for input: " << input);
+            return false;
+        }
+        std::string fusedText = serializeAst(*fused);
+        if (fusedText != got) {
+            MESSAGE("parseAst mismatch for input: " << input
+                << "\n  buildAst: " << got
+                << "\n  parseAst: " << fusedText);
+            ok = false;
+        }
         return ok;
     }
 
@@ -1,9 +1,12 @@
 #include "doctest.h"
 
+#include "../AstBinary.h"
 #include "../AstBuilder.h"
 #include "../Grammar2.h"
 #include "../Lexer.h"
 #include "../Parsing2.h"
+#include "../ProgramGenerator.h"
+#include "AstSerialize.h"
 
 #include <sstream>
 #include <variant>
@@ -109,12 +112,15 @@ TEST_CASE("AstBuilder preserves exact binary operator text and suffix operators"
     REQUIRE(cu->definitions.size() == 1);
     const auto& test = requireAlt<TestDecl>(cu->definitions.front());
     const auto& stat = requireSingleExprStat(test);
+    // << binds tighter than <=
     const auto& expr = requireExpr<BinaryExpr>(stat.expr);
-    REQUIRE(expr.rest.size() == 2);
-    CHECK_EQ(expr.rest[0].op, "<<");
-    CHECK_EQ(expr.rest[1].op, "<=");
+    REQUIRE(expr.rest.size() == 1);
+    CHECK_EQ(expr.rest[0].op, "<=");
+    const auto& shift = requireExpr<BinaryExpr>(expr.first);
+    REQUIRE(shift.rest.size() == 1);
+    CHECK_EQ(shift.rest[0].op, "<<");
 
-    const auto& lhs = requireExpr<SuffixExpr>(expr.first);
+    const auto& lhs = requireExpr<SuffixExpr>(shift.first);
     CHECK_EQ(requireCommandTargetIdentifier(lhs.base).ident.name, "ptr");
     REQUIRE(lhs.suffixes.size() == 3);
     CHECK(lhs.suffixes[0].kind == SuffixOp::Kind::Deref);
@@ -122,11 +128,11 @@ TEST_CASE("AstBuilder preserves exact binary operator text and suffix operators"
     CHECK(lhs.suffixes[2].kind == SuffixOp::Kind::Addr);
     CHECK_EQ(requireExpr<LiteralExpr>(lhs.suffixes[1].indexLoc).text, "0");
 
-    const auto& middle = requireExpr<SuffixExpr>(expr.rest[0].term);
+    const auto& middle = requireExpr<SuffixExpr>(shift.rest[0].term);
     CHECK_EQ(requireCommandTargetIdentifier(middle.base).ident.name, "data");
     REQUIRE(middle.suffixes.size() == 1);
     CHECK(middle.suffixes[0].kind == SuffixOp::Kind::Addr);
-    CHECK_EQ(requireCommandTargetIdentifier(expr.rest[1].term).ident.name, "limit");
+    CHECK_EQ(requireCommandTargetIdentifier(expr.rest[0].term).ident.name, "limit");
 }
 
 TEST_CASE("AstBuilder preserves command literal kind") {
@@ -146,3 +152,62 @@ TEST_CASE("AstBuilder preserves command literal kind") {
     REQUIRE(range.element != nullptr);
     CHECK_EQ(requireType<NamedType>(range.element).name, "Int");
 }
+
+TEST_CASE("AstBuilder parseAst builds a unit without a parse tree") {
+    std::istringstream input(".module App\n.import Std::Core\n.alias A: Int\n.record P: Int x\n");
+    Lexer lexer(input, discardDiagnostics());
+    REQUIRE(lexer.scan());
+    auto cu = parseAst(lexer.output, discardDiagnostics());
+    REQUIRE(cu != nullptr);
+    REQUIRE(cu->module != nullptr);
+    CHECK_EQ(cu->module->name, "App");
+    CHECK_EQ(cu->imports.size(), 1);
+    CHECK_EQ(cu->definitions.size(), 2);
+    CHECK_EQ(cu->line, 1);
+
+    std::istringstream broken(".alias A: Int\n.alias B: =\n.alias C: Int\n");
+    Lexer brokenLexer(broken, discardDiagnostics());
+    REQUIRE(brokenLexer.scan());
+    Diagnostics diags;
+    CHECK(parseAst(brokenLexer.output, diags) == nullptr);
+    REQUIRE_EQ(diags.errorCount(), 1);
+    const Diagnostic& d = diags.all().front();
+    CHECK(d.phase == Phase::Parse);
+    CHECK_EQ(d.loc.line, 2);
+
+    // nesting past the parser's depth limit fails as parseWithStack does
+    std::istringstream deep(".test \"deep\" = a <- " + std::string(2000, '(') + "b" +
+                            std::string(2000, ')') + "\n");
+    Lexer deepLexer(deep, discardDiagnostics());
+    REQUIRE(deepLexer.scan());
+    Diagnostics deepDiags;
+    CHECK(parseAst(deepLexer.output, deepDiags) == nullptr);
+    REQUIRE_EQ(deepDiags.errorCount(), 1);
+    CHECK_EQ(deepDiags.all().front().message,
+             "nesting exceeds the parser depth limit of " + std::to_string(Parser::defaultMaxDepth));
+}
+
+TEST_CASE("AstBuilder parseAst builds generated units as buildAst does") {
+    for (uint64_t seed = 1; seed <= 8; ++seed) {
+        INFO("seed " << seed);
+        GeneratorOptions options;
+        options.seed = seed;
+        ProgramGenerator generator(getGrammar(), options);
+        std::ostringstream out;
+        generator.generate(out, 8000);
+        std::istringstream input(out.str());
+        Lexer lexer(input, discardDiagnostics());
+        REQUIRE(lexer.scan());
+        Parser parser(lexer.output, getGrammar().COMPILATION_UNIT);
+        REQUIRE(parser.parse());
+        auto built = buildAst(parser.parseTree);
+        auto fused = parseAst(lexer.output, discardDiagnostics());
+        REQUIRE(built);
+        REQUIRE(fused);
+        CHECK_EQ(serializeAst(*fused), serializeAst(*built));
+        // the same nodes, interned and numbered alike: nothing backed out of is kept
+        CHECK_EQ(fused->context->typeNodes.size(), built->context->typeNodes.size());
+        CHECK_EQ(fused->context->exprNodes.size(), built->context->exprNodes.size());
+        CHECK(writeAstBinary(*fused) == writeAstBinary(*built));
+    }
+}
@@ -0,0 +1,159 @@
+#include "doctest.h"
+
+#include "../AstBinary.h"
+#include "../BuildCache.h"
+#include "../compiler.h"
+#include "test_temp_dir.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace basis;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    // A cache directory, and sources beside it.
+    struct CacheDir : TempDir {
+        CacheDir() : TempDir("basis_test_build_cache") {}
+        std::string cache() const { return (root / "cache").string(); }
+        std::string write(const std::string& name, const std::string& text) const {
+            return TempDir::write("src/" + name, text);
+        }
+        size_t entries() const {
+            size_t count = 0;
+            std::error_code ec;
+            for (auto& entry : fs::directory_iterator(root / "cache", ec))
+                count += entry.path().extension() == ".bcache";
+            return count;
+        }
+    };
+
+    BuildCache::Key numbered(int n) { return BuildCache::key(std::to_string(n)); }
+
+}
+
+TEST_CASE("BuildCache::keys cover the source and the dependencies") {
+    CHECK_EQ(BuildCache::key("abc"), BuildCache::key("abc"));
+    CHECK_NE(BuildCache::key("abc"), BuildCache::key("abd"));
+    CHECK_NE(BuildCache::key("abc"), BuildCache::key("abc", {1}));
+    CHECK_NE(BuildCache::key("abc", {1, 2}), BuildCache::key("abc", {2, 1}));
+    CHECK_FALSE(BuildCache::buildId().empty());
+}
+
+TEST_CASE("BuildCache::a hit gives back the unit and the diagnostics") {
+    CacheDir dir;
+    auto good = dir.write("good.b", ".record Point: Int x, Int y\n.cmd run: Int n = work: n\n");
+    auto bad = dir.write("bad.b", ".alias A Int\n.alias B: Int\n");
+    BuildCache cache(dir.cache(), 1 << 20);
+    CompileOptions options;
+
+    FileResult first;
+    compileFile(good, options, first, &cache);
+    REQUIRE(first.unit);
+    CHECK_EQ(dir.entries(), 1);
+    FileResult second;
+    compileFile(good, options, second, &cache);
+    REQUIRE(second.unit);
+    CHECK_NE(second.unit, first.unit);
+    CHECK(writeAstBinary(*second.unit) == writeAstBinary(*first.unit));
+
+    FileResult broken;
+    compileFile(bad, options, broken, &cache);
+    REQUIRE(broken.diagnostics.hasErrors());
+    CHECK_FALSE(broken.unit);
+    FileResult replayed;
+    compileFile(bad, options, replayed, &cache);
+    REQUIRE_EQ(replayed.diagnostics.all().size(), broken.diagnostics.all().size());
+    CHECK_EQ(replayed.diagnostics.errorCount(), broken.diagnostics.errorCount());
+    for (size_t i = 0; i < broken.diagnostics.all().size(); ++i) {
+        auto& a = broken.diagnostics.all()[i];
+        auto& b = replayed.diagnostics.all()[i];
+        CHECK_EQ(a.message, b.message);
+        CHECK_EQ(a.loc.line, b.loc.line);
+        CHECK_EQ(a.loc.col, b.loc.col);
+        CHECK_EQ(a.related, b.related);
+    }
+    CHECK_EQ(dir.entries(), 2);
+
+    // a memory report needs the tokens, so it skips the cache
+    options.memReport = true;
+    FileResult measured;
+    compileFile(good, options, measured, &cache);
+    CHECK_GT(measured.memory.tokenCount(), 0);
+}
+
+TEST_CASE("BuildCache::damaged entries miss") {
+    CacheDir dir;
+    BuildCache cache(dir.cache(), 1 << 20);
+    CHECK_FALSE(cache.load(numbered(1)));
+    Diagnostics diagnostics;
+    diagnostics.warning(Phase::Parse, {3, 4}, "careful");
+    REQUIRE(cache.store(numbered(1), diagnostics, nullptr));
+    auto entry = cache.load(numbered(1));
+    REQUIRE(entry);
+    CHECK_FALSE(entry->unit);
+    REQUIRE_EQ(entry->diagnostics.all().size(), 1);
+    CHECK_EQ(entry->diagnostics.all()[0].severity, Severity::Warning);
+
+    fs::path path;
+    for (auto& e : fs::directory_iterator(dir.cache())) path = e.path();
+    fs::resize_file(path, fs::file_size(path) - 3);
+    CHECK_FALSE(cache.load(numbered(1)));
+    // an entry stored under another key does not answer for this one
+    REQUIRE(cache.store(numbered(2), diagnostics, nullptr));
+    fs::rename(cache.pathOf(numbered(2)), path);
+    CHECK_FALSE(cache.load(numbered(1)));
+}
+
+TEST_CASE("BuildCache::evicts the least recently used entries") {
+    CacheDir dir;
+    Diagnostics diagnostics;
+    diagnostics.error(Phase::Lex, {}, std::string(1000, 'x'));
+    BuildCache writer(dir.cache(), 1 << 20);
+    auto old = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    for (int n = 1; n <= 4; ++n) {
+        REQUIRE(writer.store(numbered(n), diagnostics, nullptr));
+        fs::last_write_time(writer.pathOf(numbered(n)), old + std::chrono::minutes(n));
+    }
+    std::ofstream(dir.root / "cache" / "stale.tmp") << "left by a compiler that died";
+    fs::last_write_time(dir.root / "cache" / "stale.tmp", old);
+    // using 1 makes 2 the oldest
+    REQUIRE(writer.load(numbered(1)));
+
+    size_t entrySize = fs::file_size(writer.pathOf(numbered(1)));
+    BuildCache(dir.cache(), 2 * entrySize + entrySize / 2).evict();
+    CHECK_EQ(dir.entries(), 2);
+    CHECK(writer.load(numbered(1)));
+    CHECK_FALSE(writer.load(numbered(2)));
+    CHECK_FALSE(writer.load(numbered(3)));
+    CHECK(writer.load(numbered(4)));
+    CHECK_FALSE(fs::exists(dir.root / "cache" / "stale.tmp"));
+}
+
+TEST_CASE("BuildCache::writers and readers at the same time") {
+    CacheDir dir;
+    BuildCache cache(dir.cache(), 1 << 20);
+    Diagnostics diagnostics;
+    diagnostics.note(Phase::Build, {1, 1}, "same entry from every writer");
+    std::vector<std::thread> threads;
+    std::atomic<int> damaged = 0;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 50; ++i) {
+                cache.store(numbered(7), diagnostics, nullptr);
+                auto entry = cache.load(numbered(7));
+                if (entry && entry->diagnostics.all().size() != 1) ++damaged;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    CHECK_EQ(damaged.load(), 0);
+    CHECK_EQ(dir.entries(), 1);
+    CHECK(cache.load(numbered(7)));
+}
@@ -0,0 +1,205 @@
+#include "doctest.h"
+
+#include "../CompileServer.h"
+#include "test_temp_dir.h"
+
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace basis;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    // Sources, and a socket path short enough for sun_path.
+    struct ServerDir : TempDir {
+        ServerDir() : TempDir("basis_test_server") {}
+        std::string socket() const { return (root / "s").string(); }
+    };
+
+#ifndef _WIN32
+    // A client that speaks the frames itself, to send what forwardCompile would not.
+    int connectTo(const std::string& socket) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, socket.c_str());
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        REQUIRE(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof address) == 0);
+        return fd;
+    }
+
+    void sendFrame(int fd, char kind, const std::string& data) {
+        std::string frame(1, kind);
+        for (int i = 0; i < 4; ++i) frame += static_cast<char>(data.size() >> (8 * i));
+        frame += data;
+        REQUIRE(::send(fd, frame.data(), frame.size(), 0) == static_cast<ssize_t>(frame.size()));
+    }
+
+    // Everything the server sends until it closes the connection.
+    std::string receiveAll(int fd) {
+        std::string got;
+        char buffer[4096];
+        for (ssize_t n; (n = ::recv(fd, buffer, sizeof buffer, 0)) > 0;) got.append(buffer, n);
+        return got;
+    }
+#endif
+
+}
+
+TEST_CASE("CompileServer::resident modules are kept until the file changes") {
+    ServerDir dir;
+    auto file = dir.write("a.b", ".record Point: Int x, Int y\n");
+    ResidentModules resident;
+    CompileOptions options;
+
+    FileResult first;
+    resident.compile(file, options, first);
+    REQUIRE(first.unit);
+    CHECK_EQ(resident.size(), 1);
+    CHECK_EQ(resident.hits(), 0);
+    FileResult second;
+    resident.compile(file, options, second);
+    CHECK_EQ(second.unit, first.unit);
+    CHECK_EQ(resident.hits(), 1);
+
+    // touched but not changed: read again, but not built again
+    fs::last_write_time(file, fs::last_write_time(file) + std::chrono::seconds(5));
+    FileResult touched;
+    resident.compile(file, options, touched);
+    CHECK_EQ(touched.unit, first.unit);
+    CHECK_EQ(resident.hits(), 2);
+
+    dir.write("a.b", ".record Point: Int x, Int y, Int z\n");
+    fs::last_write_time(file, fs::last_write_time(file) + std::chrono::seconds(10));
+    FileResult changed;
+    resident.compile(file, options, changed);
+    REQUIRE(changed.unit);
+    CHECK_NE(changed.unit, first.unit);
+    CHECK_EQ(resident.hits(), 2);
+    CHECK_EQ(resident.size(), 1);
+
+    dir.write("a.b", ".alias A Int\n");
+    fs::last_write_time(file, fs::last_write_time(file) + std::chrono::seconds(15));
+    FileResult broken;
+    resident.compile(file, options, broken);
+    CHECK(broken.diagnostics.hasErrors());
+    CHECK_FALSE(broken.unit);
+}
+
+TEST_CASE("CompileServer::clients compile through the server at once") {
+    ServerDir dir;
+    auto good = dir.write("good.b", ".record Point: Int x, Int y\n.cmd run: Int n = work: n\n");
+    auto bad = dir.write("bad.b", ".alias A Int\n");
+
+    CompileServer server(dir.socket());
+    std::string error;
+    REQUIRE(server.listen(error));
+    std::thread serving([&] { server.serve(); });
+
+    // a second server does not take over a live socket
+    CompileServer other(dir.socket());
+    CHECK_FALSE(other.listen(error));
+    CHECK_NE(error.find("already"), std::string::npos);
+
+    constexpr int clients = 6;
+    std::vector<int> statuses(clients);
+    std::vector<std::string> errors(clients);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clients; ++i) {
+        threads.emplace_back([&, i] {
+            std::ostringstream out, err;
+            statuses[i] = forwardCompile(dir.socket(), {"-file", i % 2 ? bad : good}, out, err);
+            errors[i] = err.str();
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    for (int i = 0; i < clients; ++i) {
+        CAPTURE(i);
+        if (i % 2) {
+            CHECK_NE(statuses[i], 0);
+            CHECK_NE(errors[i].find("error"), std::string::npos);
+        } else {
+            CHECK_EQ(statuses[i], 0);
+            CHECK_EQ(errors[i], "");
+        }
+    }
+    CHECK_EQ(server.modules().size(), 2);
+    CHECK_GE(server.modules().hits(), 1);
+
+    std::ostringstream out, err;
+    CHECK_NE(forwardCompile(dir.socket(), {"-no-such-option"}, out, err), 0);
+    CHECK_NE(out.str(), "");
+
+    server.stop();
+    serving.join();
+    CHECK_FALSE(fs::exists(dir.socket()));
+    CHECK_NE(forwardCompile(dir.socket(), {"-file", good}, out, err), 0);
+}
+
+#ifndef _WIN32
+TEST_CASE("CompileServer::an idle client does not hold up stop") {
+    ServerDir dir;
+    CompileServer server(dir.socket());
+    std::string error;
+    REQUIRE(server.listen(error));
+    std::thread serving([&] { server.serve(); });
+
+    // connects, and never sends a request
+    int idle = connectTo(dir.socket());
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    server.stop();
+    serving.join();
+    CHECK_FALSE(fs::exists(dir.socket()));
+    char byte;
+    CHECK_EQ(::recv(idle, &byte, 1, 0), 0);
+    ::close(idle);
+}
+
+TEST_CASE("CompileServer::relative paths are the client's") {
+    ServerDir dir;
+    dir.write("project/a.b", ".record Point: Int x, Int y\n");
+    dir.write("project/b.b", ".alias Grid: [4]^Int\n");
+    CompileServer server(dir.socket());
+    std::string error;
+    REQUIRE(server.listen(error));
+    std::thread serving([&] { server.serve(); });
+
+    // the server runs in another directory than the one the client sends
+    REQUIRE_NE(fs::current_path(), dir.root / "project");
+    int fd = connectTo(dir.socket());
+    sendFrame(fd, 'd', (dir.root / "project").string());
+    sendFrame(fd, 'a', "-file");
+    sendFrame(fd, 'a', "a.b");
+    sendFrame(fd, 'r', "");
+    std::string reply = receiveAll(fd);
+    ::close(fd);
+    CHECK_EQ(reply, std::string("x\1\0\0\0", 5) + "0");
+
+    // forwardCompile sends the directory it runs in; b.b is not resident yet, so
+    // it builds and goes in the cache
+    auto started = fs::current_path();
+    fs::current_path(dir.root / "project");
+    std::ostringstream out, err;
+    int status = forwardCompile(dir.socket(), {"-file", "b.b", "-cache", "cache"}, out, err);
+    fs::current_path(started);
+    CHECK_EQ(status, 0);
+    CHECK_EQ(err.str(), "");
+    CHECK(fs::is_directory(dir.root / "project" / "cache"));
+
+    server.stop();
+    serving.join();
+}
+#endif
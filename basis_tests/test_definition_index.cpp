@@ -0,0 +1,106 @@
+#include "doctest.h"
+
+#include "../DefinitionIndex.h"
+#include "test_ast_helpers.h"
+
+#include <string>
+#include <vector>
+
+using namespace basis;
+
+namespace {
+
+    const std::string shapes =
+        ".module Shapes\n"
+        ".enum Color: red, green = 4, blue\n"
+        ".record Point: Int x, Int y\n"
+        ".object Node: Int value, ^Node next\n"
+        ".alias Grid: [4]^Int\n"
+        ".decl Widget w:: render: Int x\n"
+        ".decl Buffer b:: render: Int x\n"
+        ".decl Widget w: Int x, Int y\n"
+        ".class Canvas:\n"
+        "  .decl Canvas c: Int size\n"
+        "  .cmd clear = wipe\n"
+        ".cmd run: Int n = work: n\n"
+        ".test \"runs\" = run: 1\n";
+
+}
+
+TEST_CASE("DefinitionIndex::finds definitions and their members") {
+    auto cu = buildUnit(shapes);
+    REQUIRE(cu);
+    DefinitionIndex index(*cu);
+
+    auto color = index.find("Shapes", "Color", DefinitionKind::Enum);
+    REQUIRE_EQ(color.size(), 1);
+    CHECK_EQ(color[0]->definition, &cu->definitions[0]);
+    CHECK_EQ(std::get<TopLevelDef*>(color[0]->node), &cu->definitions[0]);
+
+    auto green = index.find("Shapes", "green", DefinitionKind::EnumItem, "Color");
+    REQUIRE_EQ(green.size(), 1);
+    CHECK_EQ(std::get<EnumItem*>(green[0]->node)->value, "4");
+    CHECK(index.find("Shapes", "green", DefinitionKind::EnumItem).empty());
+
+    auto next = index.find("Shapes", "next", DefinitionKind::Field, "Node");
+    REQUIRE_EQ(next.size(), 1);
+    CHECK_EQ(std::get<FieldDecl*>(next[0]->node)->name, "next");
+    CHECK_EQ(index.find("Shapes", "y", DefinitionKind::Field, "Point").size(), 1);
+    CHECK_EQ(index.find("Shapes", "Grid", DefinitionKind::Alias).size(), 1);
+    CHECK(index.find("Shapes", "Grid", DefinitionKind::Record).empty());
+    CHECK(index.find("Other", "Grid", DefinitionKind::Alias).empty());
+    CHECK_EQ(index.find("Shapes", "runs", DefinitionKind::Test).size(), 1);
+
+    auto run = index.find("Shapes", "run", DefinitionKind::Command);
+    REQUIRE_EQ(run.size(), 1);
+    CHECK(std::holds_alternative<CmdDef>(*run[0]->definition));
+
+    auto clear = index.find("Shapes", "clear", DefinitionKind::Command, "Canvas");
+    REQUIRE_EQ(clear.size(), 1);
+    CHECK(std::holds_alternative<CmdDef>(*std::get<ClassMember*>(clear[0]->node)));
+    CHECK_EQ(index.find("Shapes", "", DefinitionKind::Constructor, "Canvas").size(), 1);
+}
+
+TEST_CASE("DefinitionIndex::tells overloads apart by receiver") {
+    auto cu = buildUnit(shapes);
+    REQUIRE(cu);
+    DefinitionIndex index(*cu);
+
+    auto render = index.find("Shapes", "render", DefinitionKind::Command);
+    REQUIRE_EQ(render.size(), 2);
+    REQUIRE_EQ(render[0]->receivers.size(), 1);
+    REQUIRE_EQ(render[1]->receivers.size(), 1);
+    CHECK_NE(render[0]->receivers[0], render[1]->receivers[0]);
+
+    // receiver hashes are structural, so a type from another unit finds them
+    auto other = buildUnit(".alias W: Widget\n");
+    REQUIRE(other);
+    uint64_t widget = std::get<AliasDecl>(other->definitions[0]).type->hash;
+    CHECK_EQ(index.findOverload("Shapes", "render", DefinitionKind::Command, {widget}), render[0]);
+    CHECK_EQ(index.findOverload("Shapes", "", DefinitionKind::Constructor, {widget})->definition,
+             &cu->definitions[6]);
+    CHECK_FALSE(index.findOverload("Shapes", "render", DefinitionKind::Command, {}));
+}
+
+TEST_CASE("DefinitionIndex::merges the indexes of several units") {
+    auto shapesUnit = buildUnit(shapes);
+    auto geometry = buildUnit(".module Geometry\n.record Point: Float x, Float y\n.cmd run: Float f = work: f\n");
+    auto loose = buildUnit(".alias Grid: Int\n");
+    REQUIRE(shapesUnit);
+    REQUIRE(geometry);
+    REQUIRE(loose);
+
+    DefinitionIndex index(*shapesUnit);
+    DefinitionIndex more(*geometry);
+    more.add(*loose);
+    index.merge(more);
+    CHECK_EQ(index.size(), DefinitionIndex(*shapesUnit).size() + more.size());
+
+    auto point = index.find("Geometry", "Point", DefinitionKind::Record);
+    REQUIRE_EQ(point.size(), 1);
+    CHECK_EQ(point[0]->unit, geometry.get());
+    CHECK_EQ(index.find("Shapes", "Point", DefinitionKind::Record)[0]->unit, shapesUnit.get());
+    CHECK_EQ(index.find("Geometry", "x", DefinitionKind::Field, "Point").size(), 1);
+    CHECK_EQ(index.find("", "Grid", DefinitionKind::Alias)[0]->unit, loose.get());
+    CHECK_EQ(index.find("Shapes", "run", DefinitionKind::Command).size(), 1);
+}
@@ -55,7 +55,7 @@ TEST_CASE("Diagnostics::clear and append") {
 
 TEST_CASE("Diagnostics::printer formats location and related info") {
     Diagnostic d{Severity::Error, Phase::Parse, {3, 7}, "boom",
-                 SourceLoc{1, 4}, "started here"};
+                 SourceLoc{1, 4}, "started here", {}};
     std::ostringstream os;
     printDiagnostic(os, d);
     std::string s = os.str();
@@ -93,3 +93,70 @@ TEST_CASE("Diagnostics::parser produces a structured diagnostic on failure") {
     CHECK_EQ(d.severity, Severity::Error);
     CHECK_FALSE(d.message.empty());
 }
+
+TEST_CASE("Diagnostics::recovering parse reports every broken definition") {
+    Diagnostics diags;
+    std::istringstream in(
+        ".alias A: Int\n"
+        ".record : Int x\n"
+        ".domain D: Int\n"
+        ".cmd missing equals\n"
+        ".alias B: Int\n");
+    Lexer lexer(in, diags);
+    REQUIRE(lexer.scan());
+    Parser parser(lexer.output, getGrammar().COMPILATION_UNIT_RECOVER);
+    REQUIRE(parser.parse());
+    CHECK(parser.allTokensConsumed());
+    CHECK_EQ(parser.reportErrors(diags), 2);
+    REQUIRE_EQ(diags.all().size(), 2);
+    CHECK_EQ(diags.all()[0].phase, Phase::Parse);
+    CHECK_EQ(diags.all()[0].relatedLoc.line, 2);
+    CHECK_EQ(diags.all()[1].relatedLoc.line, 4);
+    CHECK_EQ(diags.all()[1].loc.line, 4);
+
+    // the good definitions survive around the error nodes
+    int errors = 0, defs = 0;
+    for (auto c = parser.parseTree->spDown; c; c = c->spNext) {
+        if (c->production == Production::PARSE_ERROR) ++errors; else ++defs;
+    }
+    CHECK_EQ(errors, 2);
+    CHECK_EQ(defs, 3);
+}
+
+TEST_CASE("Diagnostics::recovering parse resynchronizes on a broken import") {
+    Diagnostics diags;
+    std::istringstream in(
+        ".import Std:\n"
+        ".alias A: Int\n");
+    Lexer lexer(in, diags);
+    REQUIRE(lexer.scan());
+    Parser parser(lexer.output, getGrammar().COMPILATION_UNIT_RECOVER);
+    REQUIRE(parser.parse());
+    CHECK_EQ(parser.reportErrors(diags), 1);
+    REQUIRE(parser.parseTree->spDown);
+    CHECK_EQ(parser.parseTree->spDown->production, Production::PARSE_ERROR);
+    CHECK_EQ(parser.parseTree->spDown->spNext->production, Production::DEF_ALIAS);
+}
+
+TEST_CASE("Diagnostics::recovering parse of a clean unit reports nothing") {
+    Diagnostics diags;
+    std::istringstream in(".alias A: Int\n.domain D: Int\n");
+    Lexer lexer(in, diags);
+    REQUIRE(lexer.scan());
+    Parser parser(lexer.output, getGrammar().COMPILATION_UNIT_RECOVER);
+    REQUIRE(parser.parse());
+    CHECK_EQ(parser.reportErrors(diags), 0);
+    CHECK_FALSE(diags.hasErrors());
+}
+
+TEST_CASE("Diagnostics::non-recovering parse reports trailing input") {
+    Diagnostics diags;
+    std::istringstream in(".alias A: Int\nfoo\n");
+    Lexer lexer(in, diags);
+    REQUIRE(lexer.scan());
+    Parser parser(lexer.output, getGrammar().COMPILATION_UNIT);
+    REQUIRE(parser.parse());
+    REQUIRE_FALSE(parser.allTokensConsumed());
+    CHECK_EQ(parser.reportErrors(diags), 1);
+    CHECK_EQ(diags.all()[0].loc.line, 2);
+}
@@ -0,0 +1,96 @@
+#include "doctest.h"
+
+#include "../Grammar2.h"
+#include "../GrammarLint.h"
+
+using namespace basis;
+
+namespace {
+
+    bool hasFinding(const GrammarLintReport& report, LintFinding::Severity severity,
+                    const std::string& rule, const std::string& text) {
+        for (auto& finding : report.findings) {
+            if (finding.severity == severity && finding.rule == rule
+                && finding.message.find(text) != std::string::npos) return true;
+        }
+        return false;
+    }
+
+    uint64_t factorOf(const GrammarLintReport& report, const std::string& rule) {
+        for (auto& cost : report.costs) {
+            if (cost.rule == rule) return cost.factor;
+        }
+        return 0;
+    }
+
+}
+
+TEST_CASE("GrammarLint::test grammar has no errors or shadowed alternatives") {
+    GrammarLintReport report = GrammarLint::lint(getGrammar());
+    for (auto& finding : report.findings) {
+        INFO(finding.rule << ": " << finding.message);
+        CHECK(finding.severity == LintFinding::Severity::Note);
+    }
+    CHECK(report.costs.size() > 100);
+    CHECK(factorOf(report, "COMMA") == 1);
+    CHECK(factorOf(report, "COMPILATION_UNIT") > 1);
+}
+
+TEST_CASE("GrammarLint::test nullable loops") {
+    SPPF loop = oneOrMore(maybe(discard(TokenType::COMMA)));
+    SPPF list = separated(maybe(discard(TokenType::IDENTIFIER)), maybe(discard(TokenType::COMMA)));
+    SPPF fine = separated(maybe(discard(TokenType::IDENTIFIER)), discard(TokenType::COMMA));
+    GrammarLint lint;
+    lint.addRule("LOOP", loop);
+    lint.addRule("LIST", list);
+    lint.addRule("FINE", fine);
+    GrammarLintReport report = lint.run();
+    CHECK(report.count(LintFinding::Severity::Error) == 2);
+    CHECK(hasFinding(report, LintFinding::Severity::Error, "LOOP", "never ends"));
+    CHECK(hasFinding(report, LintFinding::Severity::Error, "LIST", "never ends"));
+}
+
+TEST_CASE("GrammarLint::test left recursion") {
+    SPPF expr;
+    SPPF term = discard(TokenType::IDENTIFIER);
+    expr = any(all(forward(expr), discard(TokenType::PLUS), term), term);
+    SPPF guarded = all(discard(TokenType::LPAREN), forward(guarded), discard(TokenType::RPAREN));
+    GrammarLint lint;
+    lint.addRule("EXPR", expr);
+    lint.addRule("GUARDED", guarded);
+    GrammarLintReport report = lint.run();
+    CHECK(report.count(LintFinding::Severity::Error) == 1);
+    CHECK(hasFinding(report, LintFinding::Severity::Error, "EXPR", "left recursion: EXPR -> EXPR"));
+}
+
+TEST_CASE("GrammarLint::test shadowed alternatives") {
+    SPPF ident = discard(TokenType::IDENTIFIER);
+    SPPF call = all(discard(TokenType::IDENTIFIER), discard(TokenType::COLON));
+    SPPF paren = all(discard(TokenType::LPAREN), ident);
+    GrammarLint lint;
+    lint.addRule("SHADOWED", any(ident, call));
+    lint.addRule("REPEATED", any(paren, ident, paren));
+    lint.addRule("ALWAYS", any(maybe(ident), paren));
+    lint.addRule("OVERLAP", any(call, ident));
+    GrammarLintReport report = lint.run();
+    CHECK(hasFinding(report, LintFinding::Severity::Warning, "SHADOWED", "alternative 2 (all) is shadowed by alternative 1"));
+    CHECK(hasFinding(report, LintFinding::Severity::Warning, "REPEATED", "alternative 3 (all) repeats alternative 1"));
+    CHECK(hasFinding(report, LintFinding::Severity::Warning, "ALWAYS", "always succeeds"));
+    CHECK(hasFinding(report, LintFinding::Severity::Note, "OVERLAP", "can both start with IDENTIFIER"));
+    CHECK(report.count(LintFinding::Severity::Warning) == 3);
+    CHECK(report.count(LintFinding::Severity::Error) == 0);
+}
+
+TEST_CASE("GrammarLint::test re-scan factors multiply through nesting") {
+    SPPF leaf = any(discard(TokenType::IDENTIFIER), discard(TokenType::TYPENAME), discard(TokenType::NUMBER));
+    SPPF twice = any(all(leaf, discard(TokenType::COLON)), all(leaf, discard(TokenType::COMMA)));
+    SPPF optional = all(maybe(twice), leaf);
+    GrammarLint lint;
+    lint.addRule("LEAF", leaf);
+    lint.addRule("TWICE", twice);
+    lint.addRule("OPTIONAL", optional);
+    GrammarLintReport report = lint.run();
+    CHECK(factorOf(report, "LEAF") == 3);
+    CHECK(factorOf(report, "TWICE") == 6);
+    CHECK(factorOf(report, "OPTIONAL") == 9);
+}
@@ -0,0 +1,213 @@
+#include "doctest.h"
+
+#include "../Grammar2.h"
+#include "../IncrementalParse.h"
+#include "../Lexer.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+using namespace basis;
+
+namespace {
+
+    std::list<spToken> lex(const std::string& text) {
+        std::istringstream input(text);
+        Lexer lexer(input, discardDiagnostics());
+        REQUIRE(lexer.scan());
+        return lexer.output;
+    }
+
+    spParseTree parseAll(const std::list<spToken>& tokens, SPPF unit) {
+        Parser parser(tokens, unit);
+        REQUIRE(parser.parse());
+        REQUIRE(parser.allTokensConsumed());
+        return parser.parseTree;
+    }
+
+    bool sameTokens(const std::list<spToken>& a, const std::list<spToken>& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                          [](const spToken& x, const spToken& y) { return *x == *y; });
+    }
+
+    // Reparse `before`, parsed with `unit`, as `after`, and check the result against a
+    // full parse of `after`.
+    ReparseStats edit(const std::string& before, const std::string& after, const SPPF& unit,
+                      bool recovering = false) {
+        IncrementalUnit parsed(lex(before), recovering);
+        REQUIRE(parsed.tree());
+        auto newTokens = lex(after);
+        TokenEdit change = diffTokens(parsed.tokens(), newTokens);
+        ReparseStats stats;
+        REQUIRE(parsed.reparse(newTokens, change, &stats));
+        auto expected = lex(after);
+        CHECK(sameTokens(parsed.tokens(), expected));
+        CHECK(*parsed.tree() == *parseAll(expected, unit));
+        return stats;
+    }
+
+    const std::string before =
+        ".module App\n"
+        ".import Std::Core\n"
+        ".alias A: Int\n"
+        ".record Point: Int x, Int y\n"
+        ".cmd run = doit\n"
+        ".domain D: Int\n";
+
+}
+
+TEST_CASE("IncrementalParse::diffTokens finds the changed range") {
+    auto oldTokens = lex(".alias A: Int\n.alias B: Int\n");
+    auto newTokens = lex(".alias A: Int\n.alias B: ^Int\n");
+    TokenEdit edit = diffTokens(oldTokens, newTokens);
+    // Int moves right, so it is part of the edit
+    CHECK_EQ(edit.begin, 7);
+    CHECK_EQ(edit.removed, 1);
+    CHECK_EQ(edit.inserted, 2);
+
+    edit = diffTokens(oldTokens, oldTokens);
+    CHECK_EQ(edit.removed, 0);
+    CHECK_EQ(edit.inserted, 0);
+}
+
+TEST_CASE("IncrementalParse::diffTokens sees indentation") {
+    auto oldTokens = lex(".cmd run =\n    a <- 1\n    b <- 2\n");
+    auto newTokens = lex(".cmd run =\n    a <- 1\n      b <- 2\n");
+    TokenEdit edit = diffTokens(oldTokens, newTokens);
+    CHECK_EQ(edit.begin, 6);
+    CHECK_EQ(edit.removed, 3);
+    CHECK_EQ(edit.inserted, 3);
+}
+
+TEST_CASE("IncrementalParse::reparses only the edited definition") {
+    std::string after = before;
+    after.replace(after.find("Int x"), 5, "Int x, Int z");
+    auto stats = edit(before, after, getGrammar().COMPILATION_UNIT);
+    CHECK_FALSE(stats.fullParse);
+    // the columns of the rest of the line move, so the edit abuts the next definition
+    CHECK_EQ(stats.reparsed, 2);
+    CHECK_EQ(stats.reused, 4);
+}
+
+TEST_CASE("IncrementalParse::untouched subtrees are shared, not copied") {
+    IncrementalUnit parsed(lex(before));
+    REQUIRE(parsed.tree());
+    std::vector<ParseTree*> children;
+    for (auto c = parsed.tree()->spDown; c; c = c->spNext) children.push_back(c.get());
+    const Token* domain = parsed.tokens().back().get();
+
+    // two lines more above the definitions that follow, which move without changing
+    std::string after = before;
+    after.replace(after.find("Int y"), 5, "Int y, Int z\n\n");
+    auto newTokens = lex(after);
+    ReparseStats stats;
+    REQUIRE(parsed.reparse(newTokens, diffTokens(parsed.tokens(), newTokens), &stats));
+    CHECK_FALSE(stats.fullParse);
+    CHECK_EQ(stats.reparsed, 2);
+    std::vector<ParseTree*> now;
+    for (auto c = parsed.tree()->spDown; c; c = c->spNext) now.push_back(c.get());
+    REQUIRE_EQ(now.size(), children.size());
+    for (size_t i = 0; i < now.size(); ++i) CHECK_EQ(now[i] == children[i], i != 3 && i != 4);
+    CHECK_EQ(parsed.tokens().back().get(), domain);
+    CHECK_EQ(domain->lineNumber, 8);
+    CHECK_EQ(domain->index, parsed.tokens().size() - 1);
+    CHECK(sameTokens(parsed.tokens(), lex(after)));
+}
+
+TEST_CASE("IncrementalParse::moving lines parses nothing") {
+    IncrementalUnit parsed(lex(before));
+    auto old = parsed.tree();
+    std::string after = before;
+    after.insert(after.find(".record"), "\n\n");
+    auto newTokens = lex(after);
+    TokenEdit change = diffTokens(parsed.tokens(), newTokens);
+    CHECK_EQ(change.removed + change.inserted, 0);
+    ReparseStats stats;
+    REQUIRE(parsed.reparse(newTokens, change, &stats));
+    CHECK_EQ(parsed.tree(), old);
+    CHECK_EQ(stats.reparsed, 0);
+    CHECK_EQ(stats.reused, 6);
+    CHECK(sameTokens(parsed.tokens(), lex(after)));
+    CHECK(*parsed.tree() == *parseAll(lex(after), getGrammar().COMPILATION_UNIT));
+}
+
+TEST_CASE("IncrementalParse::handles inserted and deleted definitions") {
+    std::string inserted = before;
+    inserted.insert(inserted.find(".cmd"), ".alias B: [4]Int\n");
+    CHECK_FALSE(edit(before, inserted, getGrammar().COMPILATION_UNIT).fullParse);
+
+    std::string deleted = before;
+    deleted.erase(deleted.find(".alias"), std::string(".alias A: Int\n").size());
+    edit(before, deleted, getGrammar().COMPILATION_UNIT);
+}
+
+TEST_CASE("IncrementalParse::indentation edits are reparsed") {
+    const std::string nested = ".alias A: Int\n.cmd run =\n    a <- 1\n    b <- 2\n.alias B: Int\n";
+    std::string after = nested;
+    after.replace(after.find("    b"), 4, "      ");
+    IncrementalUnit parsed(lex(nested));
+    REQUIRE(parsed.tree());
+    auto newTokens = lex(after);
+    // whatever the full parse makes of the new text, the reparse makes the same
+    Parser full(lex(after), getGrammar().COMPILATION_UNIT);
+    bool parses = full.parse() && full.allTokensConsumed();
+    TokenEdit change = diffTokens(parsed.tokens(), newTokens);
+    CHECK_GT(change.removed, 0);
+    CHECK_EQ(parsed.reparse(newTokens, change), parses);
+    if (parses) CHECK(*parsed.tree() == *parseAll(lex(after), getGrammar().COMPILATION_UNIT));
+}
+
+TEST_CASE("IncrementalParse::header edits fall back to a full parse") {
+    std::string after = before;
+    after.replace(after.find("Std::Core"), 9, "Std::Io");
+    CHECK(edit(before, after, getGrammar().COMPILATION_UNIT).fullParse);
+}
+
+TEST_CASE("IncrementalParse::edits one after another") {
+    IncrementalUnit parsed(lex(before));
+    std::string text = before;
+    for (const char* name : {"P1", "P2", "P3"}) {
+        text.replace(text.find(".domain"), 0, std::string(".alias ") + name + ": Int\n");
+        auto newTokens = lex(text);
+        ReparseStats stats;
+        REQUIRE(parsed.reparse(newTokens, diffTokens(parsed.tokens(), newTokens), &stats));
+        CHECK_FALSE(stats.fullParse);
+        CHECK(sameTokens(parsed.tokens(), lex(text)));
+        CHECK(*parsed.tree() == *parseAll(lex(text), getGrammar().COMPILATION_UNIT));
+    }
+}
+
+TEST_CASE("IncrementalParse::recovering reparse keeps error nodes local") {
+    std::string after = before;
+    after.replace(after.find(".domain D: Int"), 14, ".domain D:");
+    IncrementalUnit parsed(lex(before), true);
+    auto newTokens = lex(after);
+    ReparseStats stats;
+    REQUIRE(parsed.reparse(newTokens, diffTokens(parsed.tokens(), newTokens), &stats));
+    CHECK_FALSE(stats.fullParse);
+    CHECK(*parsed.tree() == *parseAll(lex(after), getGrammar().COMPILATION_UNIT_RECOVER));
+    auto last = parsed.tree()->spDown;
+    while (last->spNext) last = last->spNext;
+    CHECK_EQ(last->production, Production::PARSE_ERROR);
+}
+
+TEST_CASE("IncrementalParse::edits anywhere keep the unit in step") {
+    IncrementalUnit parsed(lex(before));
+    std::string text = before;
+    auto step = [&](size_t at, size_t length, const std::string& with) {
+        text.replace(at, length, with);
+        auto newTokens = lex(text);
+        ReparseStats stats;
+        REQUIRE(parsed.reparse(newTokens, diffTokens(parsed.tokens(), newTokens), &stats));
+        CHECK_FALSE(stats.fullParse);
+        CHECK(sameTokens(parsed.tokens(), lex(text)));
+        CHECK(*parsed.tree() == *parseAll(lex(text), getGrammar().COMPILATION_UNIT));
+    };
+    step(text.find(".domain"), 0, ".alias Late: Int\n\n");
+    step(text.find(".cmd"), 0, ".alias Early: ^Int\n");
+    step(text.find("doit"), 4, "again\n    more");
+    step(text.find(".alias Late"), std::string(".alias Late: Int\n").size(), "");
+    step(text.find("Int x"), 3, "Real");
+    step(text.find(".alias Early"), std::string(".alias Early: ^Int\n").size(), "");
+}
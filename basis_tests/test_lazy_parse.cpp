@@ -0,0 +1,119 @@
+#include "doctest.h"
+
+#include "../AstBuilder.h"
+#include "../Grammar2.h"
+#include "../LazyParse.h"
+#include "../Lexer.h"
+
+#include <sstream>
+
+using namespace basis;
+
+namespace {
+
+    std::list<spToken> lex(const std::string& text) {
+        std::istringstream input(text);
+        Lexer lexer(input, discardDiagnostics());
+        REQUIRE(lexer.scan());
+        return lexer.output;
+    }
+
+    size_t countProduction(const spParseTree& pt, Production p) {
+        size_t count = 0;
+        for (auto node = pt; node; node = node->spNext) {
+            if (node->production == p) ++count;
+            count += countProduction(node->spDown, p);
+        }
+        return count;
+    }
+
+    const std::string unit =
+        ".module App\n"
+        ".import Std::Core\n"
+        ".record Point: Int x, Int y\n"
+        ".cmd parent: Int x =\n"
+        " .sub child: Int y =\n"
+        "  .sub grandchild: Int z = inner\n"
+        "  work\n"
+        " run\n"
+        ".class Shape:\n"
+        "    .decl area: Int n -> result\n"
+        "    .cmd draw: Int n = paint: n\n"
+        ".cmd last: Int n -> result =\n"
+        "    result <- (n + 1)\n";
+
+}
+
+TEST_CASE("LazyParse::signatures leave command bodies unparsed") {
+    auto tokens = lex(unit);
+    spParseTree signatures;
+    REQUIRE(parseSignatures(tokens, signatures));
+    CHECK_EQ(countProduction(signatures, Production::DEF_CMD_BODY_DEFERRED), 3);
+    CHECK_EQ(countProduction(signatures, Production::DEF_CMD_BODY), 0);
+    CHECK_EQ(countProduction(signatures, Production::DEF_SUB), 0);
+    CHECK_EQ(countProduction(signatures, Production::DEF_CMD), 3);
+    CHECK_EQ(countProduction(signatures, Production::DEF_RECORD), 1);
+
+    // the AST has every signature, and no bodies
+    auto cu = buildAst(signatures);
+    REQUIRE(cu);
+    REQUIRE_EQ(cu->definitions.size(), 4);
+    auto& parent = std::get<CmdDef>(cu->definitions[1]);
+    CHECK_EQ(std::get<RegularSig>(parent.signature).name, "parent");
+    CHECK(parent.body == nullptr);
+}
+
+TEST_CASE("LazyParse::deferred bodies parse to the full tree") {
+    auto tokens = lex(unit);
+    spParseTree signatures;
+    REQUIRE(parseSignatures(tokens, signatures));
+    CHECK_EQ(parseDeferredBodies(tokens, signatures), 0);
+    CHECK_EQ(countProduction(signatures, Production::DEF_CMD_BODY_DEFERRED), 0);
+
+    Parser full(tokens, getGrammar().COMPILATION_UNIT);
+    REQUIRE(full.parse());
+    REQUIRE(full.allTokensConsumed());
+    CHECK(*signatures == *full.parseTree);
+}
+
+TEST_CASE("LazyParse::a body is parsed only when asked for") {
+    auto tokens = lex(unit);
+    spParseTree signatures;
+    REQUIRE(parseSignatures(tokens, signatures));
+    TokenIndex index(tokens);
+
+    spParseTree parent = signatures->spDown->spNext->spNext->spNext;
+    REQUIRE_EQ(parent->production, Production::DEF_CMD);
+    spParseTree body = parent->spDown;
+    while (body->spNext) body = body->spNext;
+    REQUIRE_EQ(body->production, Production::DEF_CMD_BODY_DEFERRED);
+
+    REQUIRE(parseDeferredBody(index, body));
+    CHECK_EQ(body->production, Production::DEF_CMD_BODY);
+    CHECK_EQ(countProduction(body->spDown, Production::DEF_SUB), 2);
+    // the other commands stay deferred
+    CHECK_EQ(countProduction(signatures, Production::DEF_CMD_BODY_DEFERRED), 2);
+    // a parsed body is not parsed again
+    CHECK_FALSE(parseDeferredBody(index, body));
+}
+
+TEST_CASE("LazyParse::a broken body fails only when parsed") {
+    auto tokens = lex(".cmd good: Int n = run\n.cmd bad: Int n = run: ,\n");
+    spParseTree signatures;
+    REQUIRE(parseSignatures(tokens, signatures));
+    CHECK_EQ(countProduction(signatures, Production::DEF_CMD_BODY_DEFERRED), 2);
+    CHECK_EQ(parseDeferredBodies(tokens, signatures), 1);
+    CHECK_EQ(countProduction(signatures, Production::DEF_CMD_BODY_DEFERRED), 1);
+
+    Parser full(tokens, getGrammar().COMPILATION_UNIT);
+    CHECK_FALSE((full.parse() && full.allTokensConsumed()));
+}
+
+TEST_CASE("LazyParse::deferred bodies need the tokens they were parsed from") {
+    auto tokens = lex(unit);
+    spParseTree signatures;
+    REQUIRE(parseSignatures(tokens, signatures));
+    auto other = lex(unit);
+    CHECK_EQ(parseDeferredBodies(other, signatures), 3);
+    CHECK_EQ(countProduction(signatures, Production::DEF_CMD_BODY_DEFERRED), 3);
+}
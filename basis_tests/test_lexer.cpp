@@ -67,6 +67,7 @@ TEST_CASE("Lexer::test lex all token types") {
     testSingleToken("!", TokenType::BANG);
     testSingleToken("!{", TokenType::BANGBRACE);
     testSingleToken("!<", TokenType::BANGLANGLE);
+    testSingleToken("!=", TokenType::BANGEQUALS);
     testSingleToken("^", TokenType::CARAT);
     testSingleToken(",", TokenType::COMMA);
     testSingleToken("::", TokenType::DCOLON);
@@ -75,10 +76,12 @@ TEST_CASE("Lexer::test lex all token types") {
     testSingleToken(":", TokenType::COLON);
     testSingleToken("$", TokenType::DOLLAR);
     testSingleToken("=", TokenType::EQUALS);
+    testSingleToken("==", TokenType::DEQUALS);
     testSingleToken(">=", TokenType::GREQUALS);
     testSingleToken("<<", TokenType::DLANGLE);
     testSingleToken("<", TokenType::LANGLE);
     testSingleToken("<=", TokenType::LEQUALS);
+    testSingleToken("<>", TokenType::LRANGLE);
     testSingleToken("<-", TokenType::LARROW);
     testSingleToken("{", TokenType::LBRACE);
     testSingleToken("[", TokenType::LBRACKET);
@@ -173,6 +176,20 @@ TEST_CASE("Lexer::test lex boundary detection") {
     CHECK_EQ(tokens[4]->bound.get(), tokens[5]);
 }
 
+TEST_CASE("Lexer::test hex and binary literals bound by their own column") {
+    basis::Lexer lexer = lexInput(" a\n 0x1f\n b\n 0b00000001\n");
+    std::vector<Token*> tokens;
+    for (auto& token : lexer.output) {
+        tokens.push_back(token.get());
+    }
+    REQUIRE_EQ(tokens.size(), 4);
+    CHECK_EQ(tokens[1]->columnNumber, 2);
+    CHECK_EQ(tokens[3]->columnNumber, 2);
+    CHECK_EQ(tokens[0]->bound.get(), tokens[1]);
+    CHECK_EQ(tokens[1]->bound.get(), tokens[2]);
+    CHECK_EQ(tokens[2]->bound.get(), tokens[3]);
+}
+
 
 TEST_CASE("Lexer::test identifier vs typename") {
     // Identifiers: start with lowercase or apostrophe+lowercase
@@ -2,21 +2,166 @@
 #include "doctest.h"
 
 #include "../compiler.h"
+#include "test_temp_dir.h"
+
+#include <filesystem>
+#include <iostream>
+#include <sstream>
 
 TEST_CASE("Compiler::main read options") {
     CompileOptions options;
     std::vector<std::string> argv_good{"-file", "testfile"};
     CHECK(options.readCompileOptions( argv_good));
-    options.filename.clear();
+    options.files.clear();
     std::vector<std::string> argv_bad1{"-file"};
     CHECK_FALSE(options.readCompileOptions( argv_bad1));
-    options.filename.clear();
+    options.files.clear();
     std::vector<std::string> argv_bad2{"file", "testfile"};
     CHECK_FALSE(options.readCompileOptions( argv_bad2));
 }
 
-//TEST_CASE("Compiler::read input file") {
-//    CompilerContext ctx;
-//    ctx.options.filename = "test1.b";
-//   CHECK(openInputFile(ctx));
-//}
+TEST_CASE("Compiler::main read flag options") {
+    CompileOptions options;
+    std::vector<std::string> argv_flag{"-mem-report", "-file", "testfile"};
+    CHECK(options.readCompileOptions( argv_flag));
+    CHECK(options.memReport);
+    CHECK_EQ(options.files, std::vector<std::string>{"testfile"});
+    CompileOptions plain;
+    std::vector<std::string> argv_plain{"-file", "testfile"};
+    CHECK(plain.readCompileOptions( argv_plain));
+    CHECK_FALSE(plain.memReport);
+    CompileOptions missing;
+    std::vector<std::string> argv_bad{"-file", "testfile", "-file"};
+    CHECK_FALSE(missing.readCompileOptions( argv_bad));
+}
+
+TEST_CASE("Compiler::main read several files and jobs") {
+    CompileOptions options;
+    std::vector<std::string> argv{"-file", "a.b", "-j", "3", "-file", "dir"};
+    CHECK(options.readCompileOptions( argv));
+    CHECK_EQ(options.files, std::vector<std::string>{"a.b", "dir"});
+    CHECK_EQ(options.jobs, 3);
+    CompileOptions zero;
+    std::vector<std::string> argv_zero{"-file", "a.b", "-j", "0"};
+    CHECK_FALSE(zero.readCompileOptions( argv_zero));
+    CompileOptions word;
+    std::vector<std::string> argv_word{"-file", "a.b", "-j", "many"};
+    CHECK_FALSE(word.readCompileOptions( argv_word));
+}
+
+TEST_CASE("Compiler::input files from directories and patterns") {
+    TempDir tree("basis_test_main");
+    auto b = tree.write("b.b", ".alias B: Int\n");
+    auto a = tree.write("a.b", ".alias A: Int\n");
+    auto c = tree.write("sub/c.b", ".alias C: Int\n");
+    tree.write("notes.txt", "not a source\n");
+
+    CompileOptions options;
+    options.files = {tree.root.string()};
+    CHECK_EQ(options.inputFiles(discardDiagnostics()), std::vector<std::string>{a, b, c});
+
+    // a pattern matches in its own directory only; files named twice count once
+    options.files = {(tree.root / "?.b").string(), b, (tree.root / "*.txt").string()};
+    auto files = options.inputFiles(discardDiagnostics());
+    CHECK_EQ(files, std::vector<std::string>{a, b, (tree.root / "notes.txt").string()});
+
+    Diagnostics diagnostics;
+    options.files = {(tree.root / "missing.b").string(), (tree.root / "*.c").string()};
+    CHECK(options.inputFiles(diagnostics).empty());
+    REQUIRE_EQ(diagnostics.all().size(), 2);
+    CHECK_EQ(diagnostics.all()[0].file, options.files[0]);
+    CHECK_EQ(diagnostics.all()[1].message, "no input files match");
+}
+
+TEST_CASE("Compiler::compile several files in parallel") {
+    TempDir tree("basis_test_main");
+    tree.write("a.b", ".alias A: Int\n");
+    tree.write("b.b", ".alias B: Int\n.record\n");
+    tree.write("c.b", ".record C: Int x\n");
+    tree.write("sub/d.b", ".alias D Int\n");
+
+    std::vector<std::string> files{(tree.root / "b.b").string(), (tree.root / "sub/d.b").string()};
+    FileResult first, second;
+    CompileOptions plain;
+    compileFile(files[0], plain, first);
+    compileFile(files[1], plain, second);
+    CHECK(first.diagnostics.hasErrors());
+    CHECK(second.diagnostics.hasErrors());
+
+    // the same diagnostics in the same order, whatever the number of workers
+    std::string expected;
+    for ( const char* jobs : {"1", "4"} ) {
+        std::vector<std::string> argv{"-file", tree.root.string(), "-j", jobs};
+        std::ostringstream err;
+        auto* old = std::cerr.rdbuf(err.rdbuf());
+        int status = compile(argv);
+        std::cerr.rdbuf(old);
+        CHECK_EQ(status, 1);
+        auto text = err.str();
+        CHECK_LT(text.find(files[0] + ": "), text.find(files[1] + ": "));
+        CHECK_EQ(text.find("a.b"), std::string::npos);
+        if ( expected.empty() ) expected = text;
+        CHECK_EQ(text, expected);
+    }
+
+    FileResult clean;
+    CompileOptions options;
+    options.memReport = true;
+    compileFile((tree.root / "c.b").string(), options, clean);
+    CHECK_FALSE(clean.diagnostics.hasErrors());
+    CHECK_EQ(clean.memory.astNodes["RecordDecl"].count, 1);
+}
+
+TEST_CASE("Compiler::time the phases of every file") {
+    TempDir tree("basis_test_main");
+    tree.write("a.b", ".alias A: Int\n");
+    tree.write("b.b", ".record B: Int x\n");
+
+    CompileOptions options;
+    std::vector<std::string> flags{"-time-phases-json", "-file", "x"};
+    CHECK(options.readCompileOptions(flags));
+    CHECK_EQ(options.timePhases, PhaseTiming::Json);
+
+    std::vector<std::string> argv{"-time-phases", "-file", tree.root.string(), "-j", "2"};
+    std::ostringstream out, err;
+    CHECK_EQ(compile(argv, out, err), 0);
+    auto text = err.str();
+    CHECK_EQ(text.rfind("phase", 0), 0);
+    for ( const char* row : {"\ncompile ", "\n  inputs ", "\n  modules ", "\n  read ", "\n  lex ",
+                             "\n  parse ", "\n  build ast ", "\nprocess "} ) {
+        CAPTURE(row);
+        CHECK_NE(text.find(row), std::string::npos);
+    }
+    // one row for both files, run on different workers
+    auto file = text.find("\nfile ");
+    REQUIRE_NE(file, std::string::npos);
+    std::istringstream row(text.substr(file + 1));
+    std::string name;
+    size_t calls = 0;
+    row >> name >> calls;
+    CHECK_EQ(calls, 2);
+
+    CompileOptions untimed;
+    FileResult result;
+    compileFile((tree.root / "a.b").string(), untimed, result);
+    CHECK(result.times.empty());
+}
+
+TEST_CASE("Compiler::compile the files the inputs import") {
+    TempDir tree("basis_test_main");
+    auto main = tree.write("main.b", ".import Std::Core\n.import \"missing.b\"\n.alias M: Int\n");
+    tree.write("sub/Std/Core.b", ".alias C Int\n");
+
+    std::vector<std::string> argv{"-file", main, "-I", (tree.root / "sub").string()};
+    std::ostringstream err;
+    auto* old = std::cerr.rdbuf(err.rdbuf());
+    int status = compile(argv);
+    std::cerr.rdbuf(old);
+    CHECK_EQ(status, 1);
+    auto text = err.str();
+    auto imported = text.find("Core.b: [parse]");
+    auto missing = text.find("main.b: [import] error: (2:9) cannot find import \"missing.b\"");
+    CHECK_NE(imported, std::string::npos);
+    CHECK_NE(missing, std::string::npos);
+    CHECK_LT(missing, imported);
+}
@@ -0,0 +1,99 @@
+#include "doctest.h"
+
+#include "../AstBuilder.h"
+#include "../Grammar2.h"
+#include "../Lexer.h"
+#include "../MemoryReport.h"
+
+#include <sstream>
+#include <string>
+
+using namespace basis;
+
+namespace {
+
+    const std::string sample =
+        ".record Point: Int x, Int y\n"
+        ".alias Far: Point\n"
+        ".cmd run: Int n -> result =\n"
+        " .sub twice: Int k = work: k, k\n"
+        " result <- (n + 1)\n"
+        ".test \"a label long enough not to fit inside the string\" = run: 1\n";
+
+}
+
+TEST_CASE("MemoryReport::counts tokens, productions and AST nodes") {
+    std::istringstream input(sample);
+    Lexer lexer(input, discardDiagnostics());
+    REQUIRE(lexer.scan());
+    Parser parser(lexer.output, getGrammar().COMPILATION_UNIT);
+    REQUIRE(parser.parse());
+    REQUIRE(parser.allTokensConsumed());
+    auto cu = buildAst(parser.parseTree);
+    REQUIRE(cu);
+
+    MemoryReport report;
+    report.addTokens(lexer.output);
+    report.addParseTree(parser.parseTree);
+    report.addAst(*cu);
+
+    auto& record = report.tokens[static_cast<size_t>(TokenType::RECORD)];
+    CHECK_EQ(record.count, 1);
+    CHECK_EQ(record.textBytes, std::string(".record").size());
+    CHECK_EQ(report.tokenCount(), lexer.output.size());
+    CHECK_EQ(report.productions[static_cast<size_t>(Production::COMPILATION_UNIT)], 1);
+    CHECK_EQ(report.productions[static_cast<size_t>(Production::DEF_RECORD)], 1);
+    CHECK_EQ(report.productions[static_cast<size_t>(Production::DEF_RECORD_FIELD)], 2);
+
+    CHECK_EQ(report.astNodes["CompilationUnit"].count, 1);
+    CHECK_EQ(report.astNodes["RecordDecl"].count, 1);
+    CHECK_EQ(report.astNodes["FieldDecl"].count, 2);
+    CHECK_EQ(report.astNodes["FieldDecl"].bytes, 2 * sizeof(FieldDecl));
+    CHECK_EQ(report.astNodes["CmdBody"].count, 2);
+    // Int and Point are interned: one node each, however often they appear
+    CHECK_EQ(report.astNodes["NamedType"].count, cu->context->typeNodes.size());
+    CHECK_EQ(report.astNodes["NamedType"].count, 2);
+    // the label is too long for the string itself, so its heap counts
+    CHECK_GT(report.astNodes["TestDecl"].bytes, sizeof(TopLevelDef) + 40);
+    CHECK_GT(report.astBytes(), report.astNodes["FieldDecl"].bytes);
+    CHECK_GT(report.arenaAllocated, 0);
+
+    // adding again accumulates
+    report.addAst(*cu);
+    CHECK_EQ(report.astNodes["CompilationUnit"].count, 2);
+}
+
+TEST_CASE("MemoryReport::prints each section") {
+    std::istringstream input(sample);
+    Lexer lexer(input, discardDiagnostics());
+    REQUIRE(lexer.scan());
+    Parser parser(lexer.output, getGrammar().COMPILATION_UNIT);
+    REQUIRE(parser.parse());
+    auto cu = buildAst(parser.parseTree);
+    REQUIRE(cu);
+
+    MemoryReport report;
+    std::ostringstream empty;
+    printMemoryReport(empty, report);
+    CHECK(empty.str().empty());
+
+    report.addTokens(lexer.output);
+    report.addParseTree(parser.parseTree);
+    report.addAst(*cu);
+    std::ostringstream os;
+    printMemoryReport(os, report);
+    auto text = os.str();
+    CHECK_NE(text.find("IDENTIFIER"), std::string::npos);
+    CHECK_NE(text.find("DEF_RECORD_FIELD"), std::string::npos);
+    CHECK_NE(text.find("FieldDecl"), std::string::npos);
+    CHECK_NE(text.find("ast arenas:"), std::string::npos);
+}
+
+TEST_CASE("MemoryReport::names line up with the enumerators") {
+    CHECK_EQ(std::string(productionName(Production::DECIMAL)), "DECIMAL");
+    CHECK_EQ(std::string(productionName(Production::DEF_RECORD_FIELD)), "DEF_RECORD_FIELD");
+    CHECK_EQ(std::string(productionName(Production::COMPILATION_UNIT)), "COMPILATION_UNIT");
+    CHECK_EQ(std::string(tokenTypeName(TokenType::_NOTHING)), "_NOTHING");
+    CHECK_EQ(std::string(tokenTypeName(TokenType::RECORD)), "RECORD");
+    CHECK_EQ(std::string(tokenTypeName(TokenType::UNDERSCORE)), "UNDERSCORE");
+}
@@ -0,0 +1,142 @@
+#include "doctest.h"
+
+#include "../ModuleLoader.h"
+#include "../compiler.h"
+#include "test_temp_dir.h"
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace basis;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    // A directory of sources, with a search path for the standard modules.
+    struct SourceTree : TempDir {
+        SourceTree() : TempDir("basis_test_module_loader") {
+            fs::create_directories(root / "lib" / "Std");
+        }
+        std::string lib() const { return (root / "lib").string(); }
+    };
+
+    void frontend(size_t, Module& module) {
+        FileResult result;
+        compileFile(module.path, CompileOptions(), result);
+        module.unit = std::move(result.unit);
+        module.diagnostics = std::move(result.diagnostics);
+    }
+
+    size_t indexOf(const ModuleLoader& loader, const std::string& name) {
+        auto& modules = loader.modules();
+        for (size_t i = 0; i < modules.size(); ++i) {
+            if (fs::path(modules[i].path).filename() == name) return i;
+        }
+        FAIL("no module " << name);
+        return 0;
+    }
+
+}
+
+TEST_CASE("ModuleLoader::resolves file and standard imports") {
+    SourceTree tree;
+    auto main = tree.write("main.b", ".import \"shapes.b\"\n.import Std::Core\n.alias M: Int\n");
+    tree.write("shapes.b", ".import Std::Core\n.alias S: Int\n");
+    tree.write("lib/Std/Core.b", ".alias C: Int\n");
+
+    ModuleLoader loader({tree.lib()}, frontend);
+    WorkStealingPool pool(2);
+    loader.load({main}, pool);
+
+    auto& modules = loader.modules();
+    REQUIRE_EQ(modules.size(), 3);
+    // discovered in waves, imports in source order
+    CHECK_EQ(fs::path(modules[0].path).filename(), "main.b");
+    CHECK_EQ(fs::path(modules[1].path).filename(), "shapes.b");
+    CHECK_EQ(fs::path(modules[2].path).filename(), "Core.b");
+    REQUIRE_EQ(modules[0].imports.size(), 2);
+    CHECK_EQ(modules[0].imports[0].module, 1);
+    CHECK_EQ(modules[0].imports[1].module, 2);
+    CHECK_EQ(modules[1].imports[0].module, 2);
+    for (auto& module : modules) CHECK_FALSE(module.diagnostics.hasErrors());
+    CHECK_EQ(loader.importOrder(), std::vector<size_t>{2, 1, 0});
+}
+
+TEST_CASE("ModuleLoader::reports imports it cannot find") {
+    SourceTree tree;
+    auto main = tree.write("main.b", ".import \"nowhere.b\"\n.import Std::Missing\n.alias M: Int\n");
+    ModuleLoader loader({tree.lib()}, frontend);
+    WorkStealingPool pool(1);
+    loader.load({main}, pool);
+
+    REQUIRE_EQ(loader.modules().size(), 1);
+    auto& diags = loader.modules()[0].diagnostics.all();
+    REQUIRE_EQ(diags.size(), 2);
+    CHECK_EQ(diags[0].phase, Phase::Import);
+    CHECK_EQ(diags[0].message, "cannot find import \"nowhere.b\"");
+    CHECK_EQ(diags[0].loc.line, 1);
+    CHECK_EQ(diags[1].message, "cannot find import Std::Missing");
+    CHECK_EQ(diags[1].loc.line, 2);
+}
+
+TEST_CASE("ModuleLoader::reports import cycles at the import that closes them") {
+    SourceTree tree;
+    auto main = tree.write("main.b", ".import \"a.b\"\n.import \"leaf.b\"\n");
+    tree.write("a.b", ".import \"b.b\"\n");
+    tree.write("b.b", ".import \"leaf.b\"\n.import \"a.b\"\n");
+    tree.write("leaf.b", ".alias L: Int\n");
+
+    ModuleLoader loader({}, frontend);
+    WorkStealingPool pool(2);
+    loader.load({main}, pool);
+
+    size_t a = indexOf(loader, "a.b"), b = indexOf(loader, "b.b"), leaf = indexOf(loader, "leaf.b");
+    CHECK_FALSE(loader.modules()[a].diagnostics.hasErrors());
+    auto& diags = loader.modules()[b].diagnostics.all();
+    REQUIRE_EQ(diags.size(), 1);
+    CHECK_EQ(diags[0].message, "import cycle through \"a.b\"");
+    CHECK_EQ(diags[0].loc.line, 2);
+    CHECK_NE(diags[0].related.find("a.b imports "), std::string::npos);
+    CHECK_NE(diags[0].related.find("b.b imports "), std::string::npos);
+    // only what is outside the cycle, and imports nothing in it, is ordered
+    CHECK_EQ(loader.importOrder(), std::vector<size_t>{leaf});
+}
+
+TEST_CASE("ModuleLoader::runs a phase after the phase of every import") {
+    SourceTree tree;
+    auto main = tree.write("main.b", ".import \"a.b\"\n.import \"b.b\"\n.import \"c.b\"\n");
+    tree.write("a.b", ".import \"base.b\"\n");
+    tree.write("b.b", ".import \"base.b\"\n");
+    tree.write("c.b", ".import \"b.b\"\n");
+    tree.write("base.b", ".alias Base: Int\n");
+
+    ModuleLoader loader({}, frontend);
+    WorkStealingPool pool(3);
+    loader.load({main}, pool);
+    auto& modules = loader.modules();
+    REQUIRE_EQ(modules.size(), 5);
+    REQUIRE_EQ(loader.importOrder().size(), 5);
+
+    std::mutex mutex;
+    std::vector<size_t> finished;
+    loader.runInImportOrder(pool, [&](size_t index, Module& module) {
+        std::lock_guard lock(mutex);
+        for (auto& import : module.imports) {
+            CHECK(std::find(finished.begin(), finished.end(), import.module) != finished.end());
+        }
+        finished.push_back(index);
+    });
+    CHECK_EQ(finished.size(), 5);
+
+    std::atomic<size_t> ran = 0;
+    CHECK_THROWS_AS(loader.runInImportOrder(pool, [&](size_t index, Module&) {
+        ++ran;
+        if (index == indexOf(loader, "base.b")) throw std::runtime_error("phase");
+    }), std::runtime_error);
+    CHECK_EQ(ran.load(), 1);
+}
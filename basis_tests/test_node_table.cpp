@@ -0,0 +1,88 @@
+#include "doctest.h"
+
+#include "../NodeTable.h"
+#include "test_ast_helpers.h"
+
+#include <set>
+#include <string>
+
+using namespace basis;
+
+namespace {
+
+    // Counts the ExprNode alternatives a walk reaches, and the distinct TypeNode
+    // ones: types are interned, so a walk reaches a shared type once per use.
+    struct CountNodes : Traverser {
+        std::set<const void*> types;
+        size_t exprs = 0;
+        void visit(NamedType& n) override         { types.insert(&n); }
+        void visit(PtrType& n) override           { types.insert(&n); }
+        void visit(RangeType& n) override         { types.insert(&n); }
+        void visit(CmdType& n) override           { types.insert(&n); }
+        void visit(InlineRecordType& n) override  { types.insert(&n); }
+        void visit(InlineObjectType& n) override  { types.insert(&n); }
+        void visit(InlineUnionType& n) override   { types.insert(&n); }
+        void visit(InlineVariantType& n) override { types.insert(&n); }
+        void visit(LiteralExpr&) override         { ++exprs; }
+        void visit(IdentifierExpr&) override      { ++exprs; }
+        void visit(EnumDerefExpr&) override       { ++exprs; }
+        void visit(CallCommandExpr&) override     { ++exprs; }
+        void visit(CallConstructorExpr&) override { ++exprs; }
+        void visit(CallVCommandExpr&) override    { ++exprs; }
+        void visit(CallFailExpr&) override        { ++exprs; }
+        void visit(SuffixExpr&) override          { ++exprs; }
+        void visit(BinaryExpr&) override          { ++exprs; }
+        void visit(QuoteExpr&) override           { ++exprs; }
+        void visit(CmdLiteralExpr&) override      { ++exprs; }
+    };
+
+    const std::string unit =
+        ".module App\n"
+        ".import Std::Core\n"
+        ".alias Grid: [4][4]^Int\n"
+        ".record Point: Int x, Int y, [8]String names\n"
+        ".cmd run: Int n, ^Point p -> result =\n"
+        "    result <- (n + 1 * 2)\n"
+        "    print: p^, \"done\"\n";
+
+}
+
+TEST_CASE("NodeTable::buildAst numbers every node densely") {
+    auto cu = buildUnit(unit);
+    REQUIRE(cu);
+    auto& context = *cu->context;
+    CountNodes count;
+    count.traverse(*cu);
+    CHECK(count.types.size() > 5);
+    CHECK(count.exprs > 5);
+    CHECK_EQ(context.typeNodes.size(), count.types.size());
+    CHECK_EQ(context.exprNodes.size(), count.exprs);
+    for (NodeId id = 0; id < context.typeNodes.size(); ++id) CHECK_EQ(context.typeNodes[id]->id, id);
+    for (NodeId id = 0; id < context.exprNodes.size(); ++id) CHECK_EQ(context.exprNodes[id]->id, id);
+
+    // the same input is numbered the same way
+    auto again = buildUnit(unit);
+    REQUIRE_EQ(again->context->exprNodes.size(), context.exprNodes.size());
+    for (NodeId id = 0; id < context.exprNodes.size(); ++id)
+        CHECK_EQ(again->context->exprNodes[id]->v.index(), context.exprNodes[id]->v.index());
+}
+
+TEST_CASE("NodeTable::columns hold one value per node") {
+    auto cu = buildUnit(unit);
+    auto& context = *cu->context;
+
+    ExprTable<bool> literal(context);
+    CHECK_EQ(literal.size(), context.exprNodes.size());
+    literal.forEach([](ExprNode& node, auto&& value) {
+        value = std::holds_alternative<LiteralExpr>(node.v);
+    });
+    size_t literals = 0;
+    for (bool b : literal) literals += b;
+    CHECK_EQ(literals, 3);
+
+    TypeTable<std::string> names(context, "?");
+    auto& record = std::get<RecordDecl>(cu->definitions[1]);
+    names[*record.fields[0].type] = "x";
+    CHECK_EQ(names[record.fields[0].type->id], "x");
+    CHECK_EQ(names[*record.fields[2].type], "?");
+}
@@ -0,0 +1,143 @@
+#include "doctest.h"
+
+#include "../AstBinary.h"
+#include "../AstBuilder.h"
+#include "../Grammar2.h"
+#include "../Lexer.h"
+#include "../ProgramGenerator.h"
+#include "../WorkStealingPool.h"
+#include "AstSerialize.h"
+
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace basis;
+
+namespace {
+
+    // Parses text and keeps the tokens the parse tree points into.
+    struct Parsed {
+        explicit Parsed(const std::string& text) {
+            std::istringstream input(text);
+            Lexer lexer(input, discardDiagnostics());
+            REQUIRE(lexer.scan());
+            tokens = lexer.output;
+            Parser parser(tokens, getGrammar().COMPILATION_UNIT);
+            REQUIRE(parser.parse());
+            REQUIRE(parser.allTokensConsumed());
+            tree = parser.parseTree;
+        }
+        std::list<spToken> tokens;
+        spParseTree tree;
+    };
+
+    std::string generated(uint64_t seed) {
+        GeneratorOptions options;
+        options.seed = seed;
+        ProgramGenerator generator(getGrammar(), options);
+        std::ostringstream out;
+        generator.generate(out, 8000);
+        return out.str();
+    }
+
+    void checkSameAst(const CompilationUnit& parallel, const CompilationUnit& sequential) {
+        CHECK_EQ(serializeAst(parallel), serializeAst(sequential));
+        REQUIRE_EQ(parallel.context->typeNodes.size(), sequential.context->typeNodes.size());
+        CHECK_EQ(parallel.context->exprNodes.size(), sequential.context->exprNodes.size());
+        for (size_t i = 0; i < parallel.context->typeNodes.size(); ++i) {
+            CHECK_EQ(parallel.context->typeNodes[i]->id, i);
+            CHECK_EQ(parallel.context->typeNodes[i]->hash, sequential.context->typeNodes[i]->hash);
+        }
+        for (size_t i = 0; i < parallel.context->exprNodes.size(); ++i) {
+            CHECK_EQ(parallel.context->exprNodes[i]->id, i);
+        }
+        // the image holds every field, position and NodeId reference
+        CHECK(writeAstBinary(parallel) == writeAstBinary(sequential));
+    }
+
+}
+
+TEST_CASE("WorkStealingPool::runs every index once") {
+    for (unsigned workers : {1u, 2u, 4u}) {
+        WorkStealingPool pool(workers);
+        CHECK_EQ(pool.workers(), workers);
+        for (size_t count : {0u, 1u, 3u, 100u}) {
+            std::vector<std::atomic<int>> runs(count);
+            std::atomic<bool> workerInRange = true;
+            pool.run(count, [&](size_t i, unsigned worker) {
+                runs[i]++;
+                if (worker >= workers) workerInRange = false;
+            });
+            for (auto& r : runs) CHECK_EQ(r.load(), 1);
+            CHECK(workerInRange);
+        }
+    }
+}
+
+TEST_CASE("WorkStealingPool::rethrows the failure of the lowest index") {
+    WorkStealingPool pool(4);
+    for (int round = 0; round < 20; ++round) {
+        CHECK_THROWS_WITH_AS(pool.run(64, [](size_t i, unsigned) {
+            if (i == 50 || i == 17 || i == 33) throw std::runtime_error(std::to_string(i));
+        }), "17", std::runtime_error);
+    }
+    // the pool is still usable after a failed run
+    std::atomic<size_t> sum = 0;
+    pool.run(10, [&](size_t i, unsigned) { sum += i; });
+    CHECK_EQ(sum.load(), 45);
+}
+
+TEST_CASE("AstBuilder::parallel build makes the sequential AST") {
+    WorkStealingPool pool(4);
+    Parsed sample(
+        ".module Shapes\n"
+        ".import Std::Core\n"
+        ".alias Grid: [4]^Int\n"
+        ".object Point: Int x, Int y, Grid cells, ^Int p\n"
+        ".cmd move: Int dx, ^Int dy -> result =\n"
+        " .sub inner: [4]^Int z = work: z\n"
+        " result <- (dx + 1)\n"
+        ".record Pair: Int a, Float b\n"
+        ".test \"moves\" = move: 1, 2\n");
+    auto sequential = buildAst(sample.tree);
+    auto parallel = buildAst(sample.tree, pool);
+    REQUIRE(sequential);
+    REQUIRE(parallel);
+    checkSameAst(*parallel, *sequential);
+    // types are still shared across definitions
+    auto& point = std::get<ObjectDecl>(parallel->definitions[1]);
+    auto& pair = std::get<RecordDecl>(parallel->definitions[3]);
+    CHECK_EQ(point.fields[0].type, pair.fields[0].type);
+
+    for (uint64_t seed = 1; seed <= 6; ++seed) {
+        INFO("seed " << seed);
+        Parsed unit(generated(seed));
+        auto seq = buildAst(unit.tree);
+        auto par = buildAst(unit.tree, pool);
+        REQUIRE(seq);
+        REQUIRE(par);
+        checkSameAst(*par, *seq);
+    }
+}
+
+TEST_CASE("AstBuilder::parallel build reports the first failing definition") {
+    Parsed unit(".alias A: Int\n.alias B: Int\n.alias C: Int\n.alias D: Int\n");
+    // B loses its type and C its name; both fail, B comes first
+    auto b = unit.tree->spDown->spNext;
+    REQUIRE_EQ(b->production, Production::DEF_ALIAS);
+    for (auto c = b->spDown; c; c = c->spNext) {
+        if (c->spNext && c->spNext->production == Production::TYPE_EXPR) c->spNext = c->spNext->spNext;
+    }
+    b->spNext->spDown = nullptr;
+
+    CHECK_THROWS_WITH_AS(buildAst(unit.tree), "AstBuilder: DEF_ALIAS missing TYPE_EXPR", std::logic_error);
+    for (unsigned workers : {1u, 2u, 4u}) {
+        WorkStealingPool pool(workers);
+        for (int round = 0; round < 10; ++round) {
+            CHECK_THROWS_WITH_AS(buildAst(unit.tree, pool), "AstBuilder: DEF_ALIAS missing TYPE_EXPR",
+                                 std::logic_error);
+        }
+    }
+}
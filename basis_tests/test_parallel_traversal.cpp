@@ -0,0 +1,134 @@
+#include "doctest.h"
+
+#include "../ParallelTraversal.h"
+#include "../ProgramGenerator.h"
+#include "test_ast_helpers.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace basis;
+
+namespace {
+
+    // Assignments per command, by command name.
+    struct AssignmentsPerCommand : StaticTraverser<AssignmentsPerCommand> {
+        std::map<std::string, size_t> counts;
+        std::vector<std::string> open;
+        void visit(CmdDef& n) {
+            auto* sig = std::get_if<RegularSig>(&n.signature);
+            open.push_back(sig ? sig->name : std::string());
+        }
+        void revisit(CmdDef&) { open.pop_back(); }
+        void visit(AssignStat&) { if (!open.empty()) ++counts[open.back()]; }
+    };
+
+    // An else block must follow a when block in its call group. Problems are
+    // collected with their position and sorted when the workers' are merged.
+    struct ElseAfterWhen : Traverser {
+        std::vector<std::pair<size_t, size_t>> problems;
+        void visit(CallGroup& n) override {
+            bool afterWhen = false;
+            for (auto& s : n.statements) {
+                auto* block = std::get_if<Block>(&s.v);
+                if (block && block->kind == Block::Kind::DoElse && !afterWhen)
+                    problems.emplace_back(block->line, block->col);
+                afterWhen = block && (block->kind == Block::Kind::DoWhen ||
+                                      block->kind == Block::Kind::DoWhenMulti);
+            }
+        }
+    };
+
+    struct CountNodes : StaticTraverser<CountNodes> {
+        size_t exprs = 0, groups = 0;
+        void visit(LiteralExpr&)     { ++exprs; }
+        void visit(IdentifierExpr&)  { ++exprs; }
+        void visit(CallCommandExpr&) { ++exprs; }
+        void visit(BinaryExpr&)      { ++exprs; }
+        void visit(CallGroup&)       { ++groups; }
+    };
+
+    const std::string unit =
+        ".record Point: Int x, Int y\n"
+        ".cmd one: Int n =\n"
+        " a <- n\n"
+        " b <- (n + 1)\n"
+        ".class Shape:\n"
+        " .cmd area: Int w -> r =\n"
+        "  r <- (w * w)\n"
+        " .cmd perimeter: Int w -> r =\n"
+        "  r <- (w * 4)\n"
+        "  s <- r\n"
+        "  t <- s\n"
+        ".cmd two: Int n =\n"
+        " .sub inner: Int k = c <- k\n"
+        " d <- n\n";
+
+}
+
+TEST_CASE("traverseDefinitions::reduces the workers' passes") {
+    auto cu = buildUnit(unit);
+    REQUIRE(cu);
+    auto merge = [](AssignmentsPerCommand& into, AssignmentsPerCommand& part) {
+        for (auto& [name, count] : part.counts) into.counts[name] += count;
+    };
+    for (unsigned workers : {1u, 3u}) {
+        WorkStealingPool pool(workers);
+        auto result = traverseDefinitions(*cu, pool, AssignmentsPerCommand{}, merge);
+        CHECK_EQ(result.counts, std::map<std::string, size_t>{
+            {"one", 2}, {"area", 1}, {"perimeter", 3}, {"two", 1}, {"inner", 1}});
+    }
+}
+
+TEST_CASE("traverseDefinitions::walks what a serial walk walks") {
+    for (uint64_t seed = 1; seed <= 4; ++seed) {
+        INFO("seed " << seed);
+        GeneratorOptions options;
+        options.seed = seed;
+        ProgramGenerator generator(getGrammar(), options);
+        std::ostringstream out;
+        generator.generate(out, 8000);
+        auto cu = buildUnit(out.str());
+        REQUIRE(cu);
+
+        CountNodes serial;
+        serial.traverse(*cu);
+        WorkStealingPool pool(4);
+        auto parallel = traverseDefinitions(*cu, pool, CountNodes{}, [](CountNodes& into, CountNodes& part) {
+            into.exprs += part.exprs;
+            into.groups += part.groups;
+        });
+        CHECK_EQ(parallel.exprs, serial.exprs);
+        CHECK_EQ(parallel.groups, serial.groups);
+
+        ElseAfterWhen serialCheck;
+        serialCheck.traverse(*cu);
+        auto merge = [](ElseAfterWhen& into, ElseAfterWhen& part) {
+            into.problems.insert(into.problems.end(), part.problems.begin(), part.problems.end());
+        };
+        auto check = traverseDefinitions(*cu, pool, ElseAfterWhen{}, merge);
+        std::sort(check.problems.begin(), check.problems.end());
+        CHECK_EQ(check.problems, serialCheck.problems);
+    }
+}
+
+TEST_CASE("traverseDefinitions::rethrows the first failure in source order") {
+    struct Refuse : StaticTraverser<Refuse> {
+        void visit(CmdDef& n) {
+            auto* sig = std::get_if<RegularSig>(&n.signature);
+            if (sig && (sig->name == "perimeter" || sig->name == "two")) throw std::runtime_error(sig->name);
+        }
+    };
+    auto cu = buildUnit(unit);
+    REQUIRE(cu);
+    WorkStealingPool pool(4);
+    for (int round = 0; round < 10; ++round) {
+        CHECK_THROWS_WITH_AS(traverseDefinitions(*cu, pool, Refuse{}, [](Refuse&, Refuse&) {}), "perimeter",
+                             std::runtime_error);
+    }
+}
@@ -0,0 +1,149 @@
+#include "doctest.h"
+
+#include "../AstBinary.h"
+#include "../AstBuilder.h"
+#include "../AstHash.h"
+#include "../Grammar2.h"
+#include "../Lexer.h"
+#include "../ParseMachine.h"
+#include "../compiler.h"
+#include "AstSerialize.h"
+
+#include <sstream>
+#include <stdexcept>
+
+using namespace basis;
+
+namespace {
+
+    std::list<spToken> lex(const std::string& text) {
+        std::istringstream input(text);
+        Lexer lexer(input, discardDiagnostics());
+        REQUIRE(lexer.scan());
+        return lexer.output;
+    }
+
+    // `.test "deep" = a <- ((...(b)...))` with `depth` parentheses
+    std::string nestedParens(size_t depth) {
+        return ".test \"deep\" = a <- " + std::string(depth, '(') + "b" + std::string(depth, ')') + "\n";
+    }
+
+    // `.test "deep" = a <- ({f}: ({f}: ...b))` with `depth` calls
+    std::string nestedCalls(size_t depth) {
+        std::string text = ".test \"deep\" = a <- ";
+        for (size_t i = 0; i < depth; ++i) text += "({f}: ";
+        return text + "b" + std::string(depth, ')') + "\n";
+    }
+
+    // The deepest nesting the parser takes under its default limit.
+    size_t deepestAccepted(std::string (*nest)(size_t)) {
+        auto parses = [&](size_t depth) {
+            auto tokens = lex(nest(depth));
+            Parser parser(tokens, getGrammar().COMPILATION_UNIT);
+            return parser.parseWithStack() && parser.allTokensConsumed();
+        };
+        size_t accepted = 1, rejected = Parser::defaultMaxDepth;
+        REQUIRE(parses(accepted));
+        REQUIRE_FALSE(parses(rejected));
+        while (rejected - accepted > 1) {
+            size_t middle = accepted + (rejected - accepted) / 2;
+            if (parses(middle)) accepted = middle;
+            else rejected = middle;
+        }
+        return accepted;
+    }
+
+    const std::string program =
+        ".module App\n"
+        ".import Std::Core\n"
+        ".enum Color: red = 1, green, blue\n"
+        ".record Point: Int x, Int y\n"
+        ".cmd run: Int n -> Int r =\n"
+        "    r <- n + 1 * 2\n"
+        "    print: r\n"
+        ".test \"run\" = a <- ({doIt}: data)\n";
+
+}
+
+TEST_CASE("ParseMachine::matches recursive parse trees") {
+    for (const std::string& text : {program, nestedParens(4), std::string(".alias A:\n")}) {
+        auto tokens = lex(text);
+        Parser recursive(tokens, getGrammar().COMPILATION_UNIT_RECOVER);
+        Parser stacked(tokens, getGrammar().COMPILATION_UNIT_RECOVER);
+        bool a = recursive.parse();
+        bool b = stacked.parseWithStack();
+        CHECK_EQ(a, b);
+        CHECK_EQ(recursive.allTokensConsumed(), stacked.allTokensConsumed());
+        REQUIRE(recursive.parseTree);
+        REQUIRE(stacked.parseTree);
+        CHECK(*recursive.parseTree == *stacked.parseTree);
+        CHECK_EQ(recursive.getError(), stacked.getError());
+    }
+}
+
+TEST_CASE("ParseMachine::reports nesting beyond the depth limit") {
+    auto tokens = lex(nestedParens(64));
+    Parser parser(tokens, getGrammar().COMPILATION_UNIT);
+    CHECK(parser.parseWithStack());
+    CHECK(parser.allTokensConsumed());
+
+    CHECK_FALSE(parser.parseWithStack(200));
+    Diagnostics diags;
+    CHECK_EQ(parser.reportErrors(diags), 1);
+    REQUIRE(diags.all().size() == 1);
+    CHECK_EQ(diags.all()[0].message, "nesting exceeds the parser depth limit of 200");
+    CHECK_EQ(diags.all()[0].loc.line, 1);
+}
+
+TEST_CASE("ParseMachine::keeps deep nesting on the heap") {
+    auto lexed = lex(nestedParens(5000));
+    TokenIndex tokens(lexed);
+    ParseMachine machine(tokens, 10000000);
+    spParseTree tree;
+    spParseTree* pTree = &tree;
+    TokenPos pos = 0;
+    TokenPos furthest = 0;
+    const ParseFn* furthestParser = nullptr;
+    CHECK(machine.run(getGrammar().COMPILATION_UNIT.get(), &pTree, &pos, tokens.end(), &furthest, &furthestParser));
+    CHECK(pos == tokens.end());
+    CHECK_FALSE(machine.depthExceeded());
+    CHECK_GT(machine.peakDepth(), 5000 * 4);
+}
+
+TEST_CASE("ParseMachine::every phase takes the deepest nesting the parser accepts") {
+    for (auto nest : {nestedParens, nestedCalls}) {
+        size_t depth = deepestAccepted(nest);
+        CompileOptions options;
+        options.memReport = true;
+        FileResult result;
+        compileSource(nest(depth), options, result);
+        CHECK_FALSE(result.diagnostics.hasErrors());
+        REQUIRE(result.unit);
+        std::string text = serializeAst(*result.unit);
+        hashDefinitions(*result.unit);
+        auto binary = writeAstBinary(*result.unit);
+        auto read = readAstBinary(binary.data(), binary.size());
+        REQUIRE(read);
+        CHECK_EQ(serializeAst(*read), text);
+
+        // one level more is a diagnostic, not a crash
+        FileResult deeper;
+        compileSource(nest(depth + 1), options, deeper);
+        CHECK(deeper.diagnostics.hasErrors());
+        CHECK_FALSE(deeper.unit);
+    }
+}
+
+TEST_CASE("ParseMachine::trees nested past the build limit fail to build") {
+    auto lexed = lex(nestedParens(maxBuildNesting));
+    TokenIndex tokens(lexed);
+    ParseMachine machine(tokens, 10000000);
+    spParseTree tree;
+    spParseTree* pTree = &tree;
+    TokenPos pos = 0;
+    TokenPos furthest = 0;
+    const ParseFn* furthestParser = nullptr;
+    REQUIRE(machine.run(getGrammar().COMPILATION_UNIT.get(), &pTree, &pos, tokens.end(), &furthest,
+                        &furthestParser));
+    CHECK_THROWS_AS(buildAst(tree), std::logic_error);
+}
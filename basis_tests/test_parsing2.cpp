@@ -401,3 +401,15 @@ TEST_CASE("Parsing2::test prefix") {
     CHECK_FALSE( parser7c.parse() );  // IDENT present, prefix present but no NUMBER - FAIL
 }
 
+TEST_CASE("Parsing2::test discards share one leaf per token type") {
+    // one constant-initialized leaf per token type, not owned by any grammar
+    CHECK( discard(TokenType::COMMA).get() == discardComma.get() );
+    CHECK( discard(TokenType::COMMA).use_count() == 0 );
+    CHECK( discard(TokenType::COMMA).get() != discard(TokenType::COLON).get() );
+
+    std::list<spToken> tokens;
+    addTokens(tokens, { TokenType::IDENTIFIER, TokenType::COMMA, TokenType::IDENTIFIER });
+    Parser parser(tokens, all(discardIdent, discard(TokenType::COMMA), discardIdent));
+    CHECK( parser.parse() );
+    CHECK( parser.allTokensConsumed() );
+}
@@ -0,0 +1,109 @@
+#include "doctest.h"
+
+#include "../PhaseTimer.h"
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace basis;
+
+namespace {
+
+    const TimeReport::Phase* find(const std::vector<TimeReport::Phase>& phases, const std::string& name) {
+        for (auto& phase : phases)
+            if (phase.name == name) return &phase;
+        return nullptr;
+    }
+
+    void spin(std::chrono::milliseconds duration) {
+        auto until = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < until) {}
+    }
+
+}
+
+TEST_CASE("PhaseTimer::phases nest and repeat") {
+    TimeReport report;
+    for (int i = 0; i < 3; ++i) {
+        ScopedPhase file(&report, "file");
+        { ScopedPhase lex(&report, "lex"); spin(std::chrono::milliseconds(2)); }
+        { ScopedPhase parse(&report, "parse"); }
+    }
+    ScopedPhase nothing(nullptr, "not timed");
+
+    REQUIRE_EQ(report.phases().size(), 1);
+    auto& file = report.phases()[0];
+    CHECK_EQ(file.name, "file");
+    CHECK_EQ(file.time.calls, 3);
+    REQUIRE_EQ(file.children.size(), 2);
+    CHECK_EQ(file.children[0].name, "lex");
+    CHECK_EQ(file.children[1].name, "parse");
+    auto& lex = file.children[0].time;
+    CHECK_EQ(lex.calls, 3);
+    CHECK_GE(lex.wallNs, 6'000'000u);
+    // spinning uses the CPU all along
+    CHECK_GE(lex.cpuNs, 3'000'000u);
+    CHECK_GE(file.time.wallNs, lex.wallNs + file.children[1].time.wallNs);
+}
+
+TEST_CASE("PhaseTimer::reports of threads merge by name") {
+    constexpr int threads = 4;
+    std::vector<TimeReport> reports(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            ScopedPhase file(&reports[t], "file");
+            ScopedPhase lex(&reports[t], "lex");
+            spin(std::chrono::milliseconds(5));
+            if (t == 0) ScopedPhase only(&reports[t], "only here");
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    TimeReport total;
+    total.begin("run");
+    total.end();
+    for (auto& report : reports) total.merge(report);
+    REQUIRE_EQ(total.phases().size(), 2);
+    auto file = find(total.phases(), "file");
+    REQUIRE(file);
+    CHECK_EQ(file->time.calls, threads);
+    auto lex = find(file->children, "lex");
+    REQUIRE(lex);
+    CHECK_EQ(lex->time.calls, threads);
+    // CPU is counted per thread, so it adds up across threads running at once
+    CHECK_GE(lex->time.cpuNs, threads * 2'500'000u);
+    auto only = find(lex->children, "only here");
+    REQUIRE(only);
+    CHECK_EQ(only->time.calls, 1);
+}
+
+TEST_CASE("PhaseTimer::table and JSON") {
+    ProcessTimer run;
+    TimeReport report;
+    {
+        ScopedPhase file(&report, "file");
+        ScopedPhase lex(&report, "lex");
+    }
+    report.process = run.elapsed();
+    CHECK_EQ(report.process.calls, 1);
+
+    std::ostringstream table;
+    printTimeReport(table, report);
+    std::string text = table.str();
+    CHECK_EQ(text.rfind("phase", 0), 0);
+    CHECK_NE(text.find("\nfile "), std::string::npos);
+    CHECK_NE(text.find("\n  lex "), std::string::npos);
+    CHECK_NE(text.find("\nprocess "), std::string::npos);
+
+    std::ostringstream json;
+    printTimeReportJson(json, report);
+    text = json.str();
+    CHECK_EQ(text.rfind("{\"phases\": [{\"name\": \"file\", \"calls\": 1, ", 0), 0);
+    CHECK_NE(text.find("\"children\": [{\"name\": \"lex\""), std::string::npos);
+    CHECK_NE(text.find("\"process\": {\"calls\": 1, "), std::string::npos);
+    CHECK_EQ(text.substr(text.size() - 3), "}}\n");
+}
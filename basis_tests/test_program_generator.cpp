@@ -0,0 +1,82 @@
+#include "doctest.h"
+
+#include "../AstBuilder.h"
+#include "../Grammar2.h"
+#include "../LazyParse.h"
+#include "../Lexer.h"
+#include "../ProgramGenerator.h"
+
+#include <sstream>
+
+using namespace basis;
+
+namespace {
+
+    std::list<spToken> lex(const std::string& text) {
+        std::istringstream input(text);
+        Lexer lexer(input, discardDiagnostics());
+        REQUIRE(lexer.scan());
+        return lexer.output;
+    }
+
+    std::string unit(uint64_t seed, size_t bytes) {
+        GeneratorOptions options;
+        options.seed = seed;
+        ProgramGenerator generator(getGrammar(), options);
+        std::ostringstream out;
+        CHECK(generator.generate(out, bytes) >= bytes);
+        return out.str();
+    }
+
+}
+
+TEST_CASE("ProgramGenerator::the same seed writes the same program") {
+    CHECK_EQ(unit(7, 2000), unit(7, 2000));
+    CHECK_NE(unit(7, 2000), unit(8, 2000));
+
+    ProgramGenerator generator(getGrammar());
+    for (int i = 0; i < 20; ++i) {
+        std::string definition = generator.definition();
+        REQUIRE_FALSE(definition.empty());
+        CHECK_EQ(definition[0], '.');
+        CHECK_EQ(definition.back(), '\n');
+    }
+    CHECK_EQ(generator.definitionsGenerated(), 20);
+}
+
+TEST_CASE("ProgramGenerator::generated units parse alike in every engine") {
+    for (uint64_t seed = 1; seed <= 8; ++seed) {
+        INFO("seed " << seed);
+        auto tokens = lex(unit(seed, 8000));
+
+        Parser recursive(tokens, getGrammar().COMPILATION_UNIT);
+        REQUIRE(recursive.parse());
+        REQUIRE(recursive.allTokensConsumed());
+
+        Parser stacked(tokens, getGrammar().COMPILATION_UNIT);
+        REQUIRE(stacked.parseWithStack());
+        CHECK(stacked.allTokensConsumed());
+        CHECK(*recursive.parseTree == *stacked.parseTree);
+
+        spParseTree signatures;
+        REQUIRE(parseSignatures(tokens, signatures));
+        CHECK_EQ(parseDeferredBodies(tokens, signatures), 0);
+        CHECK(*signatures == *recursive.parseTree);
+
+        CHECK(buildAst(recursive.parseTree));
+    }
+}
+
+TEST_CASE("ProgramGenerator::weights select top-level definitions") {
+    const Grammar2& grammar = getGrammar();
+    ProgramGenerator generator(grammar);
+    for (auto& rule : {grammar.DEF_ALIAS, grammar.DEF_CLASS, grammar.DEF_CMD, grammar.DEF_CMD_DECL,
+                       grammar.DEF_CMD_INTRINSIC, grammar.DEF_DOMAIN, grammar.DEF_INSTANCE,
+                       grammar.DEF_OBJECT, grammar.DEF_PROGRAM, grammar.DEF_RECORD, grammar.DEF_TEST,
+                       grammar.DEF_UNION, grammar.DEF_VARIANT}) {
+        generator.setWeight(rule, 0);
+    }
+    for (int i = 0; i < 10; ++i) {
+        CHECK(generator.definition().rfind(".enum", 0) == 0);
+    }
+}
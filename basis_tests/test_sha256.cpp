@@ -0,0 +1,46 @@
+#include "doctest.h"
+
+#include "../Sha256.h"
+
+#include <algorithm>
+#include <string>
+
+using namespace basis;
+
+namespace {
+
+    std::string hex(const Sha256::Digest& digest) {
+        std::string out;
+        for (unsigned char byte : digest) {
+            out += "0123456789abcdef"[byte >> 4];
+            out += "0123456789abcdef"[byte & 15];
+        }
+        return out;
+    }
+
+    std::string sha256(const std::string& text) {
+        Sha256 h;
+        h.bytes(text.data(), text.size());
+        return hex(h.digest());
+    }
+
+}
+
+TEST_CASE("Sha256::matches the FIPS 180-4 examples") {
+    CHECK_EQ(sha256(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    CHECK_EQ(sha256("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    // padding spills into a second block
+    CHECK_EQ(sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+             "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    CHECK_EQ(sha256(std::string(1000000, 'a')),
+             "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+TEST_CASE("Sha256::does not depend on how the input is split") {
+    std::string text(300, 'x');
+    for (size_t i = 0; i < text.size(); ++i) text[i] = static_cast<char>('a' + i % 26);
+    Sha256 pieces;
+    for (size_t at = 0, step = 1; at < text.size(); at += step, step = step % 70 + 1)
+        pieces.bytes(text.data() + at, std::min(step, text.size() - at));
+    CHECK_EQ(hex(pieces.digest()), sha256(text));
+}
@@ -0,0 +1,101 @@
+#include "doctest.h"
+#include "test_ast_helpers.h"
+
+
+#include <string>
+#include <vector>
+
+using namespace basis;
+
+namespace {
+
+    const std::string unit =
+        ".module App\n"
+        ".import Std::Core\n"
+        ".alias Grid: [4][4]^Int\n"
+        ".record Point: Int x, Int y\n"
+        ".cmd run: Int n, ^Point p -> result =\n"
+        " .sub helper: Int k = work: k\n"
+        " result <- (n + 1 * 2)\n"
+        " print: p^, \"done\"\n"
+        ".test \"runs\" = run: 1, 2\n";
+
+    struct VirtualCount : Traverser {
+        size_t calls = 0, binaries = 0, groupsLeft = 0;
+        void visit(CallCommandExpr&) override { ++calls; }
+        void visit(BinaryExpr&) override      { ++binaries; }
+        void revisit(CallGroup&) override     { ++groupsLeft; }
+    };
+
+    struct StaticCount : StaticTraverser<StaticCount> {
+        size_t calls = 0, binaries = 0, groupsLeft = 0;
+        void visit(CallCommandExpr&) { ++calls; }
+        void visit(BinaryExpr&)      { ++binaries; }
+        void revisit(CallGroup&)     { ++groupsLeft; }
+    };
+
+    // Records the order of its hooks, tagged with its name.
+    struct Trace {
+        std::string name;
+        std::vector<std::string>& log;
+        void visit(CmdDef& n)   { log.push_back(name + " visit " + std::get<RegularSig>(n.signature).name); }
+        void revisit(CmdDef& n) { log.push_back(name + " revisit " + std::get<RegularSig>(n.signature).name); }
+        void visit(RecordDecl& n) { log.push_back(name + " visit " + n.name); }
+    };
+
+    struct TraceOnly : StaticTraverser<TraceOnly> {
+        Trace trace;
+        void visit(CmdDef& n)     { trace.visit(n); }
+        void revisit(CmdDef& n)   { trace.revisit(n); }
+        void visit(RecordDecl& n) { trace.visit(n); }
+    };
+
+}
+
+TEST_CASE("StaticTraverser::calls the hooks the virtual Traverser calls") {
+    auto cu = buildUnit(unit);
+    REQUIRE(cu);
+    VirtualCount dynamic;
+    dynamic.traverse(*cu);
+    StaticCount fixed;
+    fixed.traverse(*cu);
+    CHECK_EQ(fixed.calls, dynamic.calls);
+    CHECK_EQ(fixed.binaries, dynamic.binaries);
+    CHECK_EQ(fixed.groupsLeft, dynamic.groupsLeft);
+    CHECK(fixed.calls > 0);
+    CHECK(fixed.binaries > 0);
+    CHECK_EQ(fixed.groupsLeft, 3);  // helper, run and the test
+}
+
+TEST_CASE("FusedTraverser::each pass sees what a walk of its own shows it") {
+    auto cu = buildUnit(unit);
+    REQUIRE(cu);
+
+    std::vector<std::string> alone;
+    TraceOnly single{{}, {"a", alone}};
+    single.traverse(*cu);
+
+    std::vector<std::string> log;
+    Trace a{"a", log}, b{"b", log};
+    StaticCount counts;
+    VirtualCount virtualCounts;
+    FusedTraverser fused(a, b, counts, virtualCounts);
+    fused.traverse(*cu);
+
+    CHECK_EQ(log, std::vector<std::string>{
+        "a visit Point", "b visit Point",
+        "a visit run", "b visit run",
+        "a visit helper", "b visit helper",
+        "a revisit helper", "b revisit helper",
+        "a revisit run", "b revisit run"});
+    std::vector<std::string> onlyA;
+    for (auto& entry : log) if (entry[0] == 'a') onlyA.push_back(entry);
+    CHECK_EQ(onlyA, alone);
+
+    StaticCount separate;
+    separate.traverse(*cu);
+    CHECK_EQ(counts.calls, separate.calls);
+    CHECK_EQ(counts.groupsLeft, separate.groupsLeft);
+    CHECK_EQ(virtualCounts.calls, separate.calls);
+    CHECK_EQ(virtualCounts.binaries, separate.binaries);
+}
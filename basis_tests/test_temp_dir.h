@@ -0,0 +1,41 @@
+#ifndef TEST_TEMP_DIR_H
+#define TEST_TEMP_DIR_H
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace basis {
+
+    // A new directory under the system temp directory, removed with the test.
+    // Its name ends in a random number and is taken only if nothing has it yet,
+    // so tests that run at the same time each get their own.
+    class TempDir {
+    public:
+        explicit TempDir(const std::string& prefix) {
+            std::random_device random;
+            do {
+                root = std::filesystem::temp_directory_path() / (prefix + "_" + std::to_string(random()));
+            } while (!std::filesystem::create_directory(root));
+        }
+        ~TempDir() {
+            std::error_code ignored;
+            std::filesystem::remove_all(root, ignored);
+        }
+        TempDir(const TempDir&) = delete;
+        TempDir& operator=(const TempDir&) = delete;
+
+        // Write `text` to `name`, a path below the directory, and return the full path.
+        std::string write(const std::string& name, const std::string& text) const {
+            std::filesystem::create_directories((root / name).parent_path());
+            std::ofstream(root / name) << text;
+            return (root / name).string();
+        }
+
+        std::filesystem::path root;
+    };
+
+}
+
+#endif // TEST_TEMP_DIR_H
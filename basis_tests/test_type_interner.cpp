@@ -0,0 +1,92 @@
+#include "doctest.h"
+
+#include "../TypeInterner.h"
+#include "test_ast_helpers.h"
+
+#include <string>
+
+using namespace basis;
+
+TEST_CASE("TypeInterner::equal types share one node") {
+    auto cu = buildUnit(
+        ".alias Grid: [4]^Int\n"
+        ".object Point: Int x, Int y, [4]^Int cells, ^Int p, [8]^Int more\n"
+        ".cmd move: Int dx, ^Int dy -> result = result <- dx\n");
+    REQUIRE(cu);
+    auto& alias = std::get<AliasDecl>(cu->definitions[0]);
+    auto& fields = std::get<ObjectDecl>(cu->definitions[1]).fields;
+    auto& params = std::get<RegularSig>(std::get<CmdDef>(cu->definitions[2]).signature).params;
+
+    CHECK_EQ(fields[0].type, fields[1].type);
+    CHECK_EQ(fields[0].type, params[0].type);
+    CHECK_EQ(fields[3].type, params[1].type);
+    CHECK_EQ(alias.type, fields[2].type);
+    CHECK_NE(fields[2].type, fields[4].type);
+    CHECK_NE(fields[0].type, fields[3].type);
+
+    // the element of [8]^Int is the ^Int of p
+    auto& more = std::get<RangeType>(fields[4].type->v);
+    CHECK_EQ(more.element, fields[3].type);
+    CHECK_EQ(std::get<PtrType>(fields[3].type->v).inner, fields[0].type);
+
+    auto& types = cu->context->types;
+    CHECK_EQ(types.size(), cu->context->typeNodes.size());
+    CHECK_EQ(types.size(), 4);      // Int, ^Int, [4]^Int and [8]^Int
+    CHECK(types.uses() > types.size());
+}
+
+TEST_CASE("TypeInterner::hashes tell fields apart") {
+    NamedType a; a.name = "Int";
+    NamedType b; b.name = "Int";
+    NamedType c; c.name = "Int"; c.writeable = true;
+    NamedType d; d.name = "Float";
+    TypeNode::Variant va(a), vb(b), vc(c), vd(d);
+    CHECK(TypeInterner::equal(va, vb));
+    CHECK_EQ(TypeInterner::hash(va), TypeInterner::hash(vb));
+    CHECK_FALSE(TypeInterner::equal(va, vc));
+    CHECK_NE(TypeInterner::hash(va), TypeInterner::hash(vc));
+    CHECK_FALSE(TypeInterner::equal(va, vd));
+    CHECK_NE(TypeInterner::hash(va), TypeInterner::hash(vd));
+
+    RangeType r; r.size = "Int";
+    CHECK_FALSE(TypeInterner::equal(va, TypeNode::Variant(r)));
+    CHECK_NE(TypeInterner::hash(va), TypeInterner::hash(TypeNode::Variant(r)));
+}
+
+TEST_CASE("TypeInterner::uses of a shared type keep their own positions") {
+    auto cu = buildUnit(
+        ".cmd move: Int dx, Int dy -> result = result <- dx\n"
+        ".cmd jump:\n    Int dx -> result = result <- dx\n");
+    REQUIRE(cu);
+    auto params = [&](size_t i) {
+        return std::get<RegularSig>(std::get<CmdDef>(cu->definitions[i]).signature).params;
+    };
+    REQUIRE_EQ(params(0).size(), 2);
+    REQUIRE_EQ(params(1).size(), 1);
+    CHECK_EQ(params(0)[0].type, params(1)[0].type);
+    CHECK_EQ(params(0)[0].line, 1);
+    CHECK_EQ(params(1)[0].line, 3);
+    CHECK_NE(params(0)[0].col, params(0)[1].col);
+}
+
+TEST_CASE("TypeInterner::inline and command types intern by their members") {
+    auto cu = buildUnit(
+        ".alias A: .record Int x, Int y\n"
+        ".alias B: .record Int x, Int y\n"
+        ".alias C: .record Int x, Int z\n"
+        ".alias D: ^:<Int>\n"
+        ".object O: :<Int> run, ^:<Int> next\n");
+    REQUIRE(cu);
+    auto type = [&](size_t i) { return std::get<AliasDecl>(cu->definitions[i]).type; };
+    // written on different lines, still one type
+    CHECK_EQ(type(0), type(1));
+    CHECK_NE(type(0), type(2));
+    CHECK_EQ(std::get<InlineRecordType>(type(1)->v).fields[0].line, 0);
+
+    auto& fields = std::get<ObjectDecl>(cu->definitions[4]).fields;
+    CHECK_EQ(type(3), fields[1].type);
+    CHECK_EQ(std::get<PtrType>(type(3)->v).inner, fields[0].type);
+    // the uses keep their places
+    CHECK_EQ(std::get<AliasDecl>(cu->definitions[3]).line, 4);
+    CHECK_EQ(fields[1].line, 5);
+}
@@ -1,5 +1,14 @@
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "compiler.h"
@@ -7,41 +16,170 @@
 #include "Lexer.h"
 #include "Parsing2.h"
 #include "Grammar2.h"
+#include "AstBuilder.h"
+#include "BuildCache.h"
+#include "CompileServer.h"
+#include "MemoryReport.h"
+#include "ModuleLoader.h"
+#include "PhaseTimer.h"
+#include "WorkStealingPool.h"
 
 
 int compile(std::vector<std::string> arguments) {
+    return compile(std::move(arguments), std::cout, std::cerr);
+}
+
+int compile(std::vector<std::string> arguments, std::ostream& out, std::ostream& err,
+            ResidentModules* resident) {
+    ProcessTimer run;
     CompilerContext ctx;
     if ( !ctx.options.readCompileOptions(arguments) ) {
-        usage();
+        usage(out);
         return 1;
     }
-    if ( !openInputFile(ctx) ) {
-        std::cerr << "Error opening input file: " << ctx.options.filename << std::endl;
-        return 1;
+    // the phases of the run here, those of each file in its FileResult
+    TimeReport times;
+    TimeReport* timing = ctx.options.timePhases != PhaseTiming::None ? &times : nullptr;
+    if ( timing ) times.begin("compile");
+    std::vector<std::string> files;
+    {
+        ScopedPhase phase(timing, "inputs");
+        files = ctx.options.inputFiles(ctx.diagnostics);
     }
 
-    Lexer lexer(ctx.inputFile, ctx.diagnostics);
-    lexer.scan();
-
-    if ( !ctx.diagnostics.hasFatal() ) {
-        Parser parser(lexer.output, getGrammar().COMPILATION_UNIT);
-        if ( !parser.parse() ) {
-            ctx.diagnostics.report(parser.getErrorDiagnostic());
+    // each module on its own, the modules a wave imports in the next wave;
+    // results are merged in module order, so the output does not depend on which
+    // worker finished first
+    std::mutex reportLock;
+    std::map<size_t, MemoryReport> memories;
+    std::map<size_t, TimeReport> fileTimes;
+    std::optional<BuildCache> cache;
+    if ( !ctx.options.cacheDir.empty() ) cache.emplace(ctx.options.cacheDir, ctx.options.cacheBytes);
+    ModuleLoader loader(ctx.options.importPaths, [&](size_t index, Module& module) {
+        FileResult result;
+        {
+            ScopedPhase phase(timing ? &result.times : nullptr, "file");
+            if ( resident ) resident->compile(module.path, ctx.options, result, cache ? &*cache : nullptr);
+            else compileFile(module.path, ctx.options, result, cache ? &*cache : nullptr);
         }
+        module.unit = std::move(result.unit);
+        module.diagnostics = std::move(result.diagnostics);
+        std::lock_guard lock(reportLock);
+        if ( ctx.options.memReport ) memories.emplace(index, std::move(result.memory));
+        if ( timing ) fileTimes.emplace(index, std::move(result.times));
+    });
+    if ( !files.empty() ) {
+        unsigned workers = ctx.options.jobs ? ctx.options.jobs : std::thread::hardware_concurrency();
+        WorkStealingPool pool(std::max(workers, 1u));
+        ScopedPhase phase(timing, "modules");
+        loader.load(files, pool);
+    }
+    if ( cache ) {
+        ScopedPhase phase(timing, "evict");
+        cache->evict();
     }
 
-    printDiagnostics(std::cerr, ctx.diagnostics);
+    MemoryReport memory;
+    auto& modules = loader.modules();
+    for ( size_t i = 0; i < modules.size(); ++i ) {
+        if ( modules.size() > 1 ) modules[i].diagnostics.setFile(modules[i].path);
+        ctx.diagnostics.append(std::move(modules[i].diagnostics));
+    }
+    for ( auto& [index, report] : memories ) memory.merge(report);
+
+    printDiagnostics(err, ctx.diagnostics);
+    if ( ctx.options.memReport ) printMemoryReport(out, memory);
+    if ( timing ) {
+        // files ran on the workers, each in its own report, so they are a phase of
+        // their own and not one of "modules"
+        times.end();
+        for ( auto& [index, report] : fileTimes ) times.merge(report);
+        times.process = run.elapsed();
+        if ( ctx.options.timePhases == PhaseTiming::Json ) printTimeReportJson(err, times);
+        else printTimeReport(err, times);
+    }
     return ctx.diagnostics.hasErrors() ? 1 : 0;
 }
 
-void usage() {
-    std::cout << "Usage: basis <options>" << std::endl;
-    std::cout << "Options:" << std::endl;
-    std::cout << "  -file <file>" << std::endl;
+void compileFile(const std::string& file, const CompileOptions& options, FileResult& result,
+                 const BuildCache* cache) {
+    std::string source;
+    {
+        ScopedPhase phase(options.timePhases != PhaseTiming::None ? &result.times : nullptr, "read");
+        std::ifstream input(file, std::ios::binary);
+        if ( !input.is_open() ) {
+            result.diagnostics.fatal(Phase::Lex, {}, "cannot open input file " + file);
+            return;
+        }
+        source.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+    compileSource(source, options, result, cache);
 }
 
-bool openInputFile(CompilerContext& ctx) {
-    ctx.inputFile.open(ctx.options.filename);
-    return ctx.inputFile.is_open();
+void compileSource(const std::string& source, const CompileOptions& options, FileResult& result,
+                   const BuildCache* cache) {
+    // the cache keeps the AST and the diagnostics, not the tokens and the parse
+    // tree a memory report needs
+    if ( options.memReport ) cache = nullptr;
+    // a pass added here gets a ScopedPhase of its own
+    TimeReport* timing = options.timePhases != PhaseTiming::None ? &result.times : nullptr;
+    BuildCache::Key key = cache ? BuildCache::key(source) : BuildCache::Key{};
+    if ( cache ) {
+        ScopedPhase phase(timing, "cache load");
+        if ( auto entry = cache->load(key) ) {
+            result.diagnostics = std::move(entry->diagnostics);
+            result.unit = std::move(entry->unit);
+            return;
+        }
+    }
+
+    std::istringstream text(source);
+    Lexer lexer(text, result.diagnostics);
+    {
+        ScopedPhase phase(timing, "lex");
+        lexer.scan();
+    }
+    if ( options.memReport ) result.memory.addTokens(lexer.output);
+
+    if ( !result.diagnostics.hasFatal() ) {
+        // recover at each top-level definition so one run reports every broken one;
+        // the explicit-stack engine turns runaway nesting into a diagnostic
+        Parser parser(lexer.output, getGrammar().COMPILATION_UNIT_RECOVER);
+        {
+            ScopedPhase phase(timing, "parse");
+            parser.parseWithStack();
+            parser.reportErrors(result.diagnostics);
+        }
+        if ( options.memReport ) result.memory.addParseTree(parser.parseTree);
+
+        if ( !result.diagnostics.hasErrors() ) {
+            try {
+                ScopedPhase phase(timing, "build ast");
+                result.unit = buildAst(parser.parseTree);
+            } catch ( std::logic_error& e ) {
+                result.diagnostics.error(Phase::Build, {}, e.what());
+            }
+            if ( options.memReport && result.unit ) result.memory.addAst(*result.unit);
+        }
+    }
+
+    if ( cache ) {
+        ScopedPhase phase(timing, "cache store");
+        cache->store(key, result.diagnostics, result.unit.get());
+    }
 }
 
+void usage(std::ostream& os) {
+    os << "Usage: basis <options>" << std::endl;
+    os << "       basis --server <socket>" << std::endl;
+    os << "       basis --connect <socket> <options>" << std::endl;
+    os << "Options:" << std::endl;
+    os << "  -file <file|directory|pattern>   (repeatable)" << std::endl;
+    os << "  -I <directory>                   (repeatable)" << std::endl;
+    os << "  -j <jobs>" << std::endl;
+    os << "  -cache <directory>" << std::endl;
+    os << "  -cache-size <megabytes>          (default 512)" << std::endl;
+    os << "  -mem-report" << std::endl;
+    os << "  -time-phases                     (table on stderr)" << std::endl;
+    os << "  -time-phases-json                (JSON on stderr)" << std::endl;
+}
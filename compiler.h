@@ -1,16 +1,42 @@
 #ifndef COMPILER_H
 #define COMPILER_H
 
+#include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "BuildCache.h"
 #include "CompileOptions.h"
 #include "CompilerContext.h"
+#include "MemoryReport.h"
+#include "PhaseTimer.h"
 
 using namespace basis;
 
+// What compiling one input file left behind.
+struct FileResult {
+    Diagnostics                      diagnostics;
+    MemoryReport                     memory;    // filled in with -mem-report
+    TimeReport                       times;     // filled in with -time-phases
+    std::shared_ptr<CompilationUnit> unit;      // null when the file did not build
+};
+
+namespace basis { class ResidentModules; }   // CompileServer.h
+
+// The arguments without the program name. Compiles the input files and the
+// files they import, which are looked up beside them and in the -I directories.
 int compile(std::vector<std::string> arguments);
-void usage();
-bool openInputFile(CompilerContext& ctx);
+// The same, writing to `out` and `err`, and taking unchanged files from
+// `resident` when there is one.
+int compile(std::vector<std::string> arguments, std::ostream& out, std::ostream& err,
+            ResidentModules* resident = nullptr);
+void usage(std::ostream& os = std::cout);
+// Lex, parse and build one file, or take what that made from the cache if there
+// is one. Safe to call for different files at once.
+void compileFile(const std::string& file, const CompileOptions& options, FileResult& result,
+                 const BuildCache* cache = nullptr);
+void compileSource(const std::string& source, const CompileOptions& options, FileResult& result,
+                   const BuildCache* cache = nullptr);
 
 #endif